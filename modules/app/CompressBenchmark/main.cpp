@@ -5,6 +5,12 @@
  * 2. Convert YUYV to BGR using OpenCV, then compress BGR image using turbo-jpeg, finally write to file
  * 3. Compress YUYV to JPG using jpeg-lib, then write to file
  * 4. Convert YUYV(YUV422 Packed) to YUV(YUV422 Planar), then compress using TurboJpeg, and finally write to file
+ * 5. Compress YUYV using YuyvJpegEncoder in direct mode, which converts one MCU row each time and feed to libjpeg without
+ *    full frame YUV422 Planar buffer, then write to file
+ *
+ * And the throughput of YUYV(YUV422 Packed) to YUV(YUV422 Planar) conversion kernel and 2x2 binning kernel for each
+ * supported SIMD level, and the per-frame encode latency of direct mode and stripe mode, for both YUV422 and
+ * grayscale(Y only) output.
  */
 
 #include <fmt/format.h>
@@ -16,14 +22,18 @@
 #include <fstream>
 #include <iostream>
 #include <numeric>
+#include <thread>
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
+#include "libra/io.hpp"
 #include "libra/util.hpp"
 
 using namespace std;
 using namespace std::chrono;
 using namespace cv;
+using namespace libra::core;
 using namespace libra::util;
+using namespace libra::io;
 
 int main(int argc, char* argv[]) {
     cout << Title("YUYV Compress Benchmark") << endl;
@@ -49,9 +59,9 @@ int main(int argc, char* argv[]) {
     fs.close();
 
     constexpr size_t kRepeatNum{100};  // repeat num
-    constexpr size_t kAlgNum{4};       // algorithm num
+    constexpr size_t kAlgNum{5};       // algorithm num
     vector<string> saveFiles{"./data/OpenCV.png", "./data/OpenCVTurboJpeg.jpg", "./data/jpeg.jpg",
-                             "./data/TurboJpeg.jpg"};
+                             "./data/TurboJpeg.jpg", "./data/YuyvJpegEncoder.jpg"};
 
     vector<array<double, kAlgNum>> usedTime(kRepeatNum);
     vector<unsigned char> yuvData;  // YUV data for turbojpeg
@@ -59,6 +69,8 @@ int main(int argc, char* argv[]) {
     int maxBufferSize = tjBufSize(width, height, TJSAMP_422);
     unsigned char* dest4 = new unsigned char[maxBufferSize];  // dest buffer
     unsigned long destSize4 = maxBufferSize;                  // dest size
+    YuyvJpegEncoder encoder;                                  // YUYV encoder with direct mode
+    bool sameOutput{true};                                    // the output of algorithm 4 and 5 is the same
     for (size_t i = 0; i < kRepeatNum; i++) {
         {
             // 1. Convert YUYV to BGR using OpenCV, then write to file
@@ -212,12 +224,40 @@ int main(int argc, char* argv[]) {
             auto t1 = steady_clock::now();
             auto dt = duration_cast<duration<double>>(t1 - t0).count();
             auto dt2 = duration_cast<duration<double>>(t2 - t0).count();
-            cout << fmt::format(", TurboJpeg = {:.5f}/{:.5f} s", dt2, dt) << endl;
+            cout << fmt::format(", TurboJpeg = {:.5f}/{:.5f} s", dt2, dt);
             usedTime[i][3] = dt;
 
             // destory compressor
             tjDestroy(compressor);
         }
+
+        {
+            // 5. compress YUYV using YuyvJpegEncoder in direct mode, then write to file
+            auto t0 = steady_clock::now();
+            unsigned char* dest = nullptr;  // dest buffer
+            unsigned long destSize{0};      // dest size
+            encoder.encode(raw.data(), width, height, 2 * width, &dest, &destSize);
+
+            // write to file
+            fstream fs(saveFiles[4], ios::out | ios::binary);
+            if (!fs.is_open()) {
+                LOG(ERROR) << fmt::format("cannot create file \"{}\"", saveFiles[4]);
+            }
+            fs.write(reinterpret_cast<const char*>(dest), destSize);
+            fs.close();
+
+            // record time
+            auto t1 = steady_clock::now();
+            auto dt = duration_cast<duration<double>>(t1 - t0).count();
+            cout << fmt::format(", Direct = {:.5f} s", dt) << endl;
+            usedTime[i][4] = dt;
+
+            // check the output is the same with algorithm 4
+            sameOutput = sameOutput && destSize == destSize4 && equal(dest, dest + destSize, dest4);
+
+            // release turbo jpeg data buffer
+            tjFree(dest);
+        }
     }
 
     // free buffer
@@ -231,10 +271,81 @@ int main(int argc, char* argv[]) {
                          kRepeatNum;
     }
     cout << endl
-         << fmt::format(
-                "Average: OpenCV = {:.5f} s, OpenCV+TurboJpeg = {:.5f} s, JPEG = {:.5f} s, TurboJpeg = {:.5f} s",
-                averageTime[0], averageTime[1], averageTime[2], averageTime[3])
+         << fmt::format("Average: OpenCV = {:.5f} s, OpenCV+TurboJpeg = {:.5f} s, JPEG = {:.5f} s, TurboJpeg = {:.5f} "
+                        "s, Direct = {:.5f} s",
+                        averageTime[0], averageTime[1], averageTime[2], averageTime[3], averageTime[4])
          << endl;
+    cout << fmt::format("output of TurboJpeg and Direct is the same: {}", sameOutput) << endl;
+
+    // throughput of YUYV to YUV422 planar conversion kernel
+    cout << Section("YUYV to YUV422 Planar Conversion");
+    yuvData.resize(2 * width * height);
+    for (auto level : {SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::NEON}) {
+        if (!isSimdSupported(level)) {
+            continue;
+        }
+        auto t0 = steady_clock::now();
+        for (size_t i = 0; i < kRepeatNum; ++i) {
+            yuyvToYuv422p(raw.data(), width, height, 2 * width, yuvData.data(), level);
+        }
+        auto t1 = steady_clock::now();
+        auto dt = duration_cast<duration<double>>(t1 - t0).count() / kRepeatNum;
+        cout << fmt::format("{:>6}{}: {:.5f} ms/frame, {:.3f} ns/pixel, {:.1f} MB/s", toString(level),
+                            level == bestSimdLevel() ? "*" : " ", dt * 1.E3, dt * 1.E9 / (width * height),
+                            raw.size() / dt * 1.E-6)
+             << endl;
+    }
+
+    // throughput of 2x2 binning kernel, which outputs half size YUV422 planar
+    cout << Section("YUYV 2x2 Binning");
+    for (auto level : {SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::NEON}) {
+        if (!isSimdSupported(level)) {
+            continue;
+        }
+        unsigned char* y = yuvData.data();
+        unsigned char* u = y + width / 2 * height / 2;
+        unsigned char* v = u + width / 4 * height / 2;
+        auto t0 = steady_clock::now();
+        for (size_t i = 0; i < kRepeatNum; ++i) {
+            for (int r = 0; r < height / 2; ++r) {
+                const unsigned char* src = raw.data() + 2 * r * 2 * width;
+                yuyvBin2x2Row(src, src + 2 * width, width, y + r * width / 2, u + r * width / 4, v + r * width / 4,
+                              level);
+            }
+        }
+        auto t1 = steady_clock::now();
+        auto dt = duration_cast<duration<double>>(t1 - t0).count() / kRepeatNum;
+        cout << fmt::format("{:>6}{}: {:.5f} ms/frame, {:.3f} ns/pixel, {:.1f} MB/s", toString(level),
+                            level == bestSimdLevel() ? "*" : " ", dt * 1.E3, dt * 1.E9 / (width * height),
+                            raw.size() / dt * 1.E-6)
+             << endl;
+    }
+
+    // per-frame encode latency of direct mode and stripe mode for YUV422 and grayscale, the stripes are encoded in
+    // parallel on thread pool
+    cout << Section("Encode Latency");
+    auto threadPool = make_shared<ThreadPool>(max(1U, thread::hardware_concurrency()));
+    vector<unsigned char> jpegBuffer(YuyvJpegEncoder::bufferSize(width, height));
+    for (auto subsampling : {JpegSubsampling::S422, JpegSubsampling::Gray}) {
+        for (auto mode : {YuyvEncodeMode::Direct, YuyvEncodeMode::Stripe}) {
+            YuyvEncodeParams params;
+            params.mode = mode;
+            params.subsampling = subsampling;
+            YuyvJpegEncoder stripeEncoder(params, threadPool);
+            unsigned long jpegSize{0};
+            auto t0 = steady_clock::now();
+            for (size_t i = 0; i < kRepeatNum; ++i) {
+                stripeEncoder.encodeTo(raw.data(), width, height, 2 * width, jpegBuffer.data(), jpegBuffer.size(),
+                                       &jpegSize);
+            }
+            auto t1 = steady_clock::now();
+            auto dt = duration_cast<duration<double>>(t1 - t0).count() / kRepeatNum;
+            cout << fmt::format("{:>6} {:>4}: {:.5f} ms/frame, size = {} bytes, thread num = {}",
+                                mode == YuyvEncodeMode::Direct ? "Direct" : "Stripe", toString(subsampling),
+                                dt * 1.E3, jpegSize, mode == YuyvEncodeMode::Direct ? 1 : threadPool->threadNum())
+                 << endl;
+        }
+    }
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,88 @@
+/**
+ * @brief Export the record folder saved with image containers to kalibr format, i.e., `left/` and `right/` folder with
+ * the images named by timestamp in ns, and `imu.csv`, so the existing tools could be used for the record
+ */
+
+#include <fmt/format.h>
+#include <glog/logging.h>
+#include <boost/filesystem.hpp>
+#include <cxxopts.hpp>
+#include <iostream>
+#include "libra/io.hpp"
+
+using namespace std;
+using namespace fmt;
+using namespace libra::core;
+using namespace libra::io;
+using namespace libra::util;
+namespace fs = boost::filesystem;
+
+int main(int argc, char* argv[]) {
+    cout << Title("Container Exporter") << endl;
+    // init glog
+    google::InitGoogleLogging(argv[0]);
+    FLAGS_alsologtostderr = true;
+    FLAGS_colorlogtostderr = true;
+
+    // argument parser
+    cxxopts::Options options(argv[0], "Export record folder with image containers to kalibr format");
+    // clang-format off
+    options.add_options()
+        ("i,input", "input record folder", cxxopts::value<string>()->default_value("./data/record"))
+        ("o,output", "output folder in kalibr format", cxxopts::value<string>()->default_value("./data/kalibr"))
+        ("h,help", "help message");
+    // clang-format on
+    auto result = options.parse(argc, argv);
+    if (result.count("help")) {
+        cout << options.help() << endl;
+        return 0;
+    }
+    fs::path inputPath = fs::weakly_canonical(result["input"].as<string>());
+    fs::path outputPath = fs::weakly_canonical(result["output"].as<string>());
+    CHECK(fs::is_directory(inputPath)) << format("input folder \"{}\" doesn't exist", inputPath.string());
+    CHECK(inputPath != outputPath) << "output folder should be different with input folder";
+    cout << Section("Input Parameters");
+    cout << format("input folder: {}", inputPath.string()) << endl;
+    cout << format("output folder: {}", outputPath.string()) << endl;
+    fs::create_directories(outputPath);
+
+    // export images
+    cout << Section("Export");
+    for (const char* side : {"left", "right"}) {
+        fs::path containerPath = inputPath / format("{}.container", side);
+        if (!fs::is_directory(containerPath)) {
+            continue;
+        }
+        ImageContainerReader reader;
+        CHECK(reader.open(containerPath.string())) << format("cannot open container \"{}\"", containerPath.string());
+        size_t num = reader.exportKalibr((outputPath / side).string());
+        cout << format("export {}/{} {} images to \"{}\"", num, reader.entries().size(), side,
+                       (outputPath / side).string())
+             << endl;
+    }
+
+    // convert binary IMU to CSV, and copy other files
+    for (const auto& entry : fs::directory_iterator(inputPath)) {
+        if (!fs::is_regular_file(entry.path())) {
+            continue;
+        }
+        if (entry.path().filename() == "imu.bin") {
+            vector<ImuRecord> imus;
+            CHECK(ImuCsvWriter::readBinary(entry.path().string(), imus))
+                << format("cannot read IMU file \"{}\"", entry.path().string());
+            ImuCsvWriter writer;
+            CHECK(writer.open((outputPath / "imu.csv").string()));
+            for (const auto& imu : imus) {
+                writer.write(imu);
+            }
+            writer.close();
+            cout << format("convert {} IMU to \"{}\"", imus.size(), (outputPath / "imu.csv").string()) << endl;
+        } else {
+            fs::copy_file(entry.path(), outputPath / entry.path().filename(), fs::copy_option::overwrite_if_exists);
+            cout << format("copy \"{}\"", entry.path().filename().string()) << endl;
+        }
+    }
+
+    google::ShutdownGoogleLogging();
+    return 0;
+}
@@ -0,0 +1,380 @@
+/**
+ * @brief Benchmark suite for YUYV JPEG encoder
+ *
+ * The encode parameters are swept in a matrix of frame size, quality, subsampling(4:2:2, 4:2:0 and gray), DCT method,
+ * restart interval and thread number. The direct mode is used for one thread, and the stripe mode with the same stripe
+ * number is used for more threads. For each case, the median encode time per pixel, the output size and the PSNR of
+ * decoded image are reported, and saved as JSON.
+ *
+ * The PSNR of luma is calculated for all subsampling, and the PSNR of RGB is calculated for color image, whose
+ * reference is converted from the YUYV image with BT.601 full range formula, the same with JPEG.
+ *
+ * With a baseline JSON file saved before, the results of the same cases are compared, and the program exits with 1 if
+ * any case is slower, larger or has lower PSNR than the baseline beyond the tolerances.
+ */
+
+#include <fmt/format.h>
+#include <glog/logging.h>
+#include <turbojpeg.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cxxopts.hpp>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <nlohmann/json.hpp>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+#include "libra/io.hpp"
+
+using namespace std;
+using namespace fmt;
+using namespace libra::core;
+using namespace libra::io;
+using namespace libra::util;
+using json = nlohmann::json;
+
+/**
+ * @brief Benchmark case
+ */
+struct Case {
+    int width = 1280;                                     // image width
+    int height = 720;                                     // image height
+    int quality = 95;                                     // JPEG quality
+    JpegSubsampling subsampling = JpegSubsampling::S422;  // subsampling
+    JpegDctMethod dctMethod = JpegDctMethod::Auto;        // DCT method
+    int restartRows = 0;                                  // restart interval in MCU rows
+    int threadNum = 1;                                    // thread number
+
+    /**
+     * @brief Get the key of case to compare with baseline
+     */
+    string key() const {
+        return format("{}x{}/q{}/{}/{}/r{}/t{}", width, height, quality, toString(subsampling), toString(dctMethod),
+                      restartRows, threadNum);
+    }
+};
+
+/**
+ * @brief Convert YUYV image to RGB with BT.601 full range formula
+ *
+ * @param yuyv      YUYV image
+ * @param width     Image width
+ * @param height    Image height
+ * @return RGB image
+ */
+vector<unsigned char> toRgb(const vector<unsigned char>& yuyv, int width, int height) {
+    auto clamp = [](double v) { return static_cast<unsigned char>(min(255.0, max(0.0, round(v)))); };
+    vector<unsigned char> rgb(3 * width * height);
+    for (size_t i = 0; i < static_cast<size_t>(width) * height; ++i) {
+        double y = yuyv[2 * i];
+        double u = yuyv[4 * (i / 2) + 1] - 128.0;
+        double v = yuyv[4 * (i / 2) + 3] - 128.0;
+        rgb[3 * i + 0] = clamp(y + 1.402 * v);
+        rgb[3 * i + 1] = clamp(y - 0.344136 * u - 0.714136 * v);
+        rgb[3 * i + 2] = clamp(y + 1.772 * u);
+    }
+    return rgb;
+}
+
+/**
+ * @brief Calculate the PSNR of image
+ *
+ * @param image     Image data
+ * @param ref       Reference image data
+ * @param step      Step of elements to compare in reference, 2 to compare the Y channel of YUYV image
+ * @return PSNR, dB. It's 99 if the image is the same with reference
+ */
+double psnr(const vector<unsigned char>& image, const vector<unsigned char>& ref, size_t step = 1) {
+    double sum{0};
+    for (size_t i = 0; i < image.size(); ++i) {
+        double d = static_cast<double>(image[i]) - ref[i * step];
+        sum += d * d;
+    }
+    double mse = sum / image.size();
+    return mse == 0 ? 99.0 : 10 * log10(255.0 * 255.0 / mse);
+}
+
+/**
+ * @brief Run benchmark for one case
+ *
+ * @param c             Benchmark case
+ * @param yuyv          YUYV image
+ * @param rgb           Reference RGB image
+ * @param repeatNum     Repeat number
+ * @param threadPool    Thread pool to encode stripes
+ * @return Benchmark result
+ */
+json benchmark(const Case& c, const vector<unsigned char>& yuyv, const vector<unsigned char>& rgb, int repeatNum,
+               const shared_ptr<ThreadPool>& threadPool) {
+    YuyvEncodeParams params;
+    params.mode = c.threadNum > 1 ? YuyvEncodeMode::Stripe : YuyvEncodeMode::Direct;
+    params.quality = c.quality;
+    params.subsampling = c.subsampling;
+    params.dctMethod = c.dctMethod;
+    params.restartRows = c.restartRows;
+    params.stripeNum = c.threadNum;
+    YuyvJpegEncoder encoder(params, threadPool);
+
+    // encode several times, the first one is warm up
+    vector<unsigned char> buffer(YuyvJpegEncoder::bufferSize(c.width, c.height));
+    unsigned long size{0};
+    vector<double> usedTimes;
+    for (int n = 0; n <= repeatNum; ++n) {
+        auto t0 = chrono::steady_clock::now();
+        CHECK(encoder.encodeTo(yuyv.data(), c.width, c.height, 2 * c.width, buffer.data(), buffer.size(), &size))
+            << format("encode failed, case = {}", c.key());
+        auto t1 = chrono::steady_clock::now();
+        if (n > 0) {
+            usedTimes.emplace_back(chrono::duration<double, nano>(t1 - t0).count());
+        }
+    }
+    sort(usedTimes.begin(), usedTimes.end());
+    const double pixelNum = static_cast<double>(c.width) * c.height;
+    double mean = accumulate(usedTimes.begin(), usedTimes.end(), 0.0) / usedTimes.size();
+
+    // decode and calculate PSNR
+    tjhandle decompressor = tjInitDecompress();
+    vector<unsigned char> gray(c.width * c.height);
+    CHECK_EQ(tjDecompress2(decompressor, buffer.data(), size, gray.data(), c.width, 0, c.height, TJPF_GRAY, 0), 0)
+        << format("decode failed, case = {}", c.key());
+    json psnrRgb;
+    if (c.subsampling != JpegSubsampling::Gray) {
+        vector<unsigned char> image(3 * c.width * c.height);
+        CHECK_EQ(tjDecompress2(decompressor, buffer.data(), size, image.data(), c.width, 0, c.height, TJPF_RGB, 0), 0)
+            << format("decode failed, case = {}", c.key());
+        psnrRgb = psnr(image, rgb);
+    }
+    tjDestroy(decompressor);
+
+    json j;
+    j["key"] = c.key();
+    j["width"] = c.width;
+    j["height"] = c.height;
+    j["quality"] = c.quality;
+    j["subsampling"] = toString(c.subsampling);
+    j["dctMethod"] = toString(c.dctMethod);
+    j["restartRows"] = c.restartRows;
+    j["threadNum"] = c.threadNum;
+    j["nsPerPixel"] = usedTimes[usedTimes.size() / 2] / pixelNum;
+    j["meanNsPerPixel"] = mean / pixelNum;
+    j["bytes"] = size;
+    j["psnrY"] = psnr(gray, yuyv, 2);
+    j["psnrRgb"] = psnrRgb;
+    return j;
+}
+
+/**
+ * @brief Compare results with baseline
+ *
+ * @param results           Benchmark results
+ * @param baseline          Baseline results
+ * @param timeTolerance     Relative tolerance of encode time
+ * @param sizeTolerance     Relative tolerance of output size
+ * @param psnrTolerance     Tolerance of PSNR, dB
+ * @return True if there is no regression
+ */
+bool compare(const json& results, const json& baseline, double timeTolerance, double sizeTolerance,
+             double psnrTolerance) {
+    map<string, json> baselineResults;
+    for (auto& r : baseline["results"]) {
+        baselineResults[r["key"].get<string>()] = r;
+    }
+
+    cout << format("{:<40s}{:>12s}{:>12s}{:>12s}{:>12s}", "Case", "Time", "Size", "PSNR(dB)", "Result") << endl;
+    bool pass{true};
+    size_t compareNum{0};
+    for (auto& r : results) {
+        string key = r["key"].get<string>();
+        auto it = baselineResults.find(key);
+        if (it == baselineResults.end()) {
+            cout << format("{:<40s}{:>48s}", key, "no baseline") << endl;
+            continue;
+        }
+        const json& b = it->second;
+        double timeRatio = r["nsPerPixel"].get<double>() / b["nsPerPixel"].get<double>();
+        double sizeRatio = r["bytes"].get<double>() / b["bytes"].get<double>();
+        double psnrDiff = r["psnrY"].get<double>() - b["psnrY"].get<double>();
+        if (!r["psnrRgb"].is_null() && !b["psnrRgb"].is_null()) {
+            psnrDiff = min(psnrDiff, r["psnrRgb"].get<double>() - b["psnrRgb"].get<double>());
+        }
+        bool regression = timeRatio > 1 + timeTolerance || sizeRatio > 1 + sizeTolerance || psnrDiff < -psnrTolerance;
+        pass = pass && !regression;
+        ++compareNum;
+        cout << format("{:<40s}{:>+11.1f}%{:>+11.2f}%{:>+12.2f}{:>12s}", key, 100 * (timeRatio - 1),
+                       100 * (sizeRatio - 1), psnrDiff, regression ? "REGRESSION" : "OK")
+             << endl;
+    }
+    cout << format("compared case number = {}, result: {}", compareNum, pass ? "PASS" : "FAIL") << endl;
+    return pass;
+}
+
+int main(int argc, char* argv[]) {
+    cout << Title("YUYV Encode Benchmark") << endl;
+    // init glog
+    google::InitGoogleLogging(argv[0]);
+    FLAGS_alsologtostderr = true;
+    FLAGS_colorlogtostderr = true;
+
+    // argument parser
+    cxxopts::Options options(argv[0], "YUYV Encode Benchmark");
+    // clang-format off
+    options.add_options()
+        ("i,input", "input YUYV image file, use synthetic images of the sweep sizes if it's empty",
+            cxxopts::value<string>()->default_value(""))
+        ("width", "image width of input file", cxxopts::value<int>()->default_value("1280"))
+        ("height", "image height of input file", cxxopts::value<int>()->default_value("720"))
+        ("size", "synthetic image sizes, WxH", cxxopts::value<vector<string>>()->default_value("640x480,1280x720"))
+        ("quality", "JPEG quality list", cxxopts::value<vector<int>>()->default_value("75,95"))
+        ("subsampling", "subsampling list, \"422\", \"420\" or \"gray\"",
+            cxxopts::value<vector<string>>()->default_value("422,420,gray"))
+        ("dct", "DCT method list, \"auto\", \"slow\", \"fast\" or \"float\"",
+            cxxopts::value<vector<string>>()->default_value("slow,fast,float"))
+        ("restart", "restart interval list in MCU rows, 0 to disable",
+            cxxopts::value<vector<int>>()->default_value("0,4"))
+        ("thread", "thread number list, direct mode for 1 and stripe mode for others",
+            cxxopts::value<vector<int>>()->default_value("1,4"))
+        ("repeat", "repeat number of each case", cxxopts::value<int>()->default_value("20"))
+        ("o,output", "output JSON file, don't save if it's empty", cxxopts::value<string>()->default_value(""))
+        ("b,baseline", "baseline JSON file to compare, don't compare if it's empty",
+            cxxopts::value<string>()->default_value(""))
+        ("timeTolerance", "relative tolerance of encode time", cxxopts::value<double>()->default_value("0.1"))
+        ("sizeTolerance", "relative tolerance of output size", cxxopts::value<double>()->default_value("0.01"))
+        ("psnrTolerance", "tolerance of PSNR, dB", cxxopts::value<double>()->default_value("0.1"))
+        ("h,help", "help message");
+    // clang-format on
+    auto result = options.parse(argc, argv);
+    if (result.count("help")) {
+        cout << options.help() << endl;
+        return 0;
+    }
+    string inputFile = result["input"].as<string>();
+    int repeatNum = result["repeat"].as<int>();
+    string outputFile = result["output"].as<string>();
+    string baselineFile = result["baseline"].as<string>();
+    CHECK_GT(repeatNum, 0) << "repeat number should be larger than 0";
+
+    // parse sweep parameters
+    vector<pair<int, int>> sizes;
+    if (inputFile.empty()) {
+        for (auto& s : result["size"].as<vector<string>>()) {
+            int width{0}, height{0};
+            CHECK(sscanf(s.c_str(), "%dx%d", &width, &height) == 2 && width > 0 && width % 2 == 0 && height > 0)
+                << format("invalid image size \"{}\"", s);
+            sizes.emplace_back(width, height);
+        }
+    } else {
+        sizes.emplace_back(result["width"].as<int>(), result["height"].as<int>());
+    }
+    map<string, JpegSubsampling> subsamplingNames;
+    for (auto s : {JpegSubsampling::S422, JpegSubsampling::S420, JpegSubsampling::Gray}) {
+        subsamplingNames[toString(s)] = s;
+    }
+    vector<JpegSubsampling> subsamplings;
+    for (auto& s : result["subsampling"].as<vector<string>>()) {
+        CHECK(subsamplingNames.count(s)) << format("invalid subsampling \"{}\"", s);
+        subsamplings.emplace_back(subsamplingNames[s]);
+    }
+    map<string, JpegDctMethod> dctNames;
+    for (auto m : {JpegDctMethod::Auto, JpegDctMethod::Slow, JpegDctMethod::Fast, JpegDctMethod::Float}) {
+        dctNames[toString(m)] = m;
+    }
+    vector<JpegDctMethod> dctMethods;
+    for (auto& s : result["dct"].as<vector<string>>()) {
+        CHECK(dctNames.count(s)) << format("invalid DCT method \"{}\"", s);
+        dctMethods.emplace_back(dctNames[s]);
+    }
+    vector<int> qualities = result["quality"].as<vector<int>>();
+    vector<int> restartRows = result["restart"].as<vector<int>>();
+    vector<int> threadNums = result["thread"].as<vector<int>>();
+
+    // print input parameters
+    cout << Section("Input Parameters");
+    cout << format("input file: {}", inputFile) << endl;
+    for (auto& s : sizes) {
+        cout << format("image size = {}x{}", s.first, s.second) << endl;
+    }
+    cout << format("quality = {}", join(qualities, ", ")) << endl;
+    cout << format("subsampling = {}", join(result["subsampling"].as<vector<string>>(), ", ")) << endl;
+    cout << format("DCT method = {}", join(result["dct"].as<vector<string>>(), ", ")) << endl;
+    cout << format("restart rows = {}", join(restartRows, ", ")) << endl;
+    cout << format("thread number = {}", join(threadNums, ", ")) << endl;
+    cout << format("repeat number = {}", repeatNum) << endl;
+    cout << format("output file: {}", outputFile) << endl;
+    cout << format("baseline file: {}", baselineFile) << endl;
+
+    // run benchmark
+    cout << Section("Benchmark");
+    cout << format("{:<40s}{:>12s}{:>12s}{:>12s}{:>12s}", "Case", "ns/pixel", "Size(KB)", "PSNR-Y", "PSNR-RGB")
+         << endl;
+    json j;
+    j["input"] = inputFile;
+    j["repeat"] = repeatNum;
+    j["hardwareConcurrency"] = thread::hardware_concurrency();
+    j["results"] = json::array();
+    map<int, shared_ptr<ThreadPool>> threadPools;  // thread pool for each thread number
+    for (auto& size : sizes) {
+        const int width = size.first, height = size.second;
+        vector<unsigned char> yuyv;
+        if (inputFile.empty()) {
+            mt19937 rng(0);
+            yuyv.resize(2 * width * height);
+            SyntheticRecorder::generatePattern(width, height, 0, rng, yuyv.data());
+        } else {
+            fstream fs(inputFile, ios::in | ios::binary);
+            CHECK(fs.is_open()) << format("cannot open file \"{}\"", inputFile);
+            yuyv = vector<unsigned char>(istreambuf_iterator<char>(fs), {});
+            CHECK_GE(yuyv.size(), 2UL * width * height) << "the input file is smaller than image size";
+        }
+        vector<unsigned char> rgb = toRgb(yuyv, width, height);
+
+        for (int threadNum : threadNums) {
+            if (threadNum > 1 && !threadPools.count(threadNum)) {
+                threadPools[threadNum] = make_shared<ThreadPool>(threadNum);
+            }
+            for (int quality : qualities) {
+                for (auto subsampling : subsamplings) {
+                    for (auto dctMethod : dctMethods) {
+                        for (int restart : restartRows) {
+                            Case c{width, height, quality, subsampling, dctMethod, restart, threadNum};
+                            json r = benchmark(c, yuyv, rgb, repeatNum, threadPools[threadNum]);
+                            cout << format("{:<40s}{:>12.3f}{:>12.1f}{:>12.2f}{:>12s}", c.key(),
+                                           r["nsPerPixel"].get<double>(), r["bytes"].get<double>() / 1024.0,
+                                           r["psnrY"].get<double>(),
+                                           r["psnrRgb"].is_null() ? "-"
+                                                                  : format("{:.2f}", r["psnrRgb"].get<double>()))
+                                 << endl;
+                            j["results"].emplace_back(move(r));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // save result
+    if (!outputFile.empty()) {
+        fstream fs(outputFile, ios::out);
+        CHECK(fs.is_open()) << format("cannot open file \"{}\" to save result", outputFile);
+        fs << j.dump(4) << endl;
+        cout << format("save result to \"{}\"", outputFile) << endl;
+    }
+
+    // compare with baseline
+    if (!baselineFile.empty()) {
+        cout << Section("Compare with Baseline");
+        fstream fs(baselineFile, ios::in);
+        CHECK(fs.is_open()) << format("cannot open baseline file \"{}\"", baselineFile);
+        json baseline;
+        fs >> baseline;
+        if (!compare(j["results"], baseline, result["timeTolerance"].as<double>(),
+                     result["sizeTolerance"].as<double>(), result["psnrTolerance"].as<double>())) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
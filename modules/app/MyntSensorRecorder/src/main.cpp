@@ -5,12 +5,13 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
 #include <condition_variable>
+#include <csignal>
 #include <cxxopts.hpp>
 #include <iostream>
 #include <mutex>
 #include <opencv2/highgui.hpp>
-#include <opencv2/imgcodecs.hpp>
 #include "libra/io.hpp"
+#include "libra/util/Serialization.hpp"
 
 using namespace std;
 using namespace fmt;
@@ -19,12 +20,25 @@ using namespace libra::io;
 using namespace libra::util;
 namespace fs = boost::filesystem;
 
+namespace {
+
+TriggerBuffer* triggerBuffer = nullptr;  // pre-trigger buffer, which is triggered by SIGUSR1
+
+void onTriggerSignal(int) {
+    if (triggerBuffer != nullptr) {
+        triggerBuffer->trigger();
+    }
+}
+
+}  // namespace
+
 /**
  * @brief Image save format
  */
 enum class ImageSaveFormat {
-    Kalibr,  // kalibr format, <timestamp(ns)>
-    Index,   // index
+    Kalibr,     // kalibr format, <timestamp(ns)>
+    Index,      // index
+    Container,  // append-only image container, see `ImageContainerWriter`
 };
 
 int main(int argc, char* argv[]) {
@@ -36,8 +50,33 @@ int main(int argc, char* argv[]) {
         ("streamMode", "stream mode", cxxopts::value<string>()->default_value("1280x720"))
         ("streamFormat", "stream format", cxxopts::value<string>()->default_value("MJPG"))
         ("saverThreadNum", "thread number to save images for each camera", cxxopts::value<int>()->default_value("2"))
+        ("gray", "only encode the Y channel into grayscale JPEG, for monochrome calibration and SLAM. It's only used "
+            "with YUYV stream format", cxxopts::value<bool>())
+        ("binning", "bin 2x2 pixels into one before encoding, 1 or 2. It's only used with YUYV stream format",
+            cxxopts::value<int>()->default_value("1"))
+        ("roi", "region of image to encode before binning, \"x,y,width,height\" in pixels, the whole image if it's "
+            "not set. It's only used with YUYV stream format", cxxopts::value<vector<int>>())
         ("onlyLeft", "only process left camera", cxxopts::value<bool>())
         ("showImage", "show image or not", cxxopts::value<bool>())
+        ("previewScale", "downscale factor of shown image, 1, 2, 4 or 8", cxxopts::value<int>()->default_value("4"))
+        ("container", "save images into append-only container instead of one file for each image",
+            cxxopts::value<bool>())
+        ("asyncSink", "write images by asynchronous file sink, so the saver threads don't wait for storage",
+            cxxopts::value<bool>())
+        ("directIo", "write image container with O_DIRECT, only used with container and async sink",
+            cxxopts::value<bool>())
+        ("rollingBudget", "disk budget of each image container for rolling record, the oldest segments are deleted if "
+            "it's exceeded, GB, 0 for unlimited. It implies container", cxxopts::value<double>()->default_value("0"))
+        ("segmentDuration", "maximum time span of container segment, s, 0 for unlimited",
+            cxxopts::value<double>()->default_value("60"))
+        ("imuBinary", "save IMU to binary file \"imu.bin\" instead of CSV file", cxxopts::value<bool>())
+        ("preTrigger", "keep the last seconds in memory and only save the data around trigger, which is triggered by "
+            "SIGUSR1 or IMU threshold, s, 0 to save all", cxxopts::value<double>()->default_value("0"))
+        ("postTrigger", "time window to save after trigger, s", cxxopts::value<double>()->default_value("5"))
+        ("triggerBudget", "memory budget of buffered images before trigger, MB",
+            cxxopts::value<double>()->default_value("256"))
+        ("accThreshold", "trigger if the norm of acc exceeds it, m/s^2, 0 to disable",
+            cxxopts::value<double>()->default_value("0"))
         ("h,help", "help message");
     // clang-format on
     auto result = options.parse(argc, argv);
@@ -50,9 +89,33 @@ int main(int argc, char* argv[]) {
     string streamModeName = result["streamMode"].as<string>();
     string streamFormatName = result["streamFormat"].as<string>();
     int saverThreadNum = result["saverThreadNum"].as<int>();
+    bool gray = result["gray"].as<bool>();
+    int binning = result["binning"].as<int>();
+    ImageRoi roi;
+    if (result.count("roi")) {
+        auto v = result["roi"].as<vector<int>>();
+        if (v.size() != 4) {
+            cout << "ROI should be \"x,y,width,height\"" << endl << endl;
+            cout << options.help() << endl;
+            return 0;
+        }
+        roi = ImageRoi{v[0], v[1], v[2], v[3]};
+    }
     // this option only used for RP4+YUYV, which cannot open only left camera
     bool onlyLeft = result["onlyLeft"].as<bool>();
     bool showImage = result["showImage"].as<bool>();
+    int previewScale = result["previewScale"].as<int>();
+    bool imuBinary = result["imuBinary"].as<bool>();
+    double rollingBudget = result["rollingBudget"].as<double>();
+    double segmentDuration = result["segmentDuration"].as<double>();
+    bool container = result["container"].as<bool>() || rollingBudget > 0;
+    bool asyncSink = result["asyncSink"].as<bool>();
+    bool directIo = result["directIo"].as<bool>();
+    TriggerParams triggerParams;
+    triggerParams.preTrigger = result["preTrigger"].as<double>();
+    triggerParams.postTrigger = result["postTrigger"].as<double>();
+    triggerParams.byteBudget = static_cast<size_t>(result["triggerBudget"].as<double>() * 1024 * 1024);
+    triggerParams.accThreshold = result["accThreshold"].as<double>();
 
     // check stream mode
     vector<string> streamModeNames = {"2560x720", "1280x720", "1280x480", "640x480"};
@@ -77,9 +140,18 @@ int main(int argc, char* argv[]) {
     cout << format("stream mode: {}", streamModeName) << endl;
     cout << format("stream format: {}", streamFormatName) << endl;
     cout << format("saver thread number = {}", saverThreadNum) << endl;
+    cout << format("gray encode: {}", gray) << endl;
+    cout << format("ROI = ({}, {}, {}, {}), binning = {}", roi.x, roi.y, roi.width, roi.height, binning) << endl;
     cout << format("only process left camera = {}", onlyLeft) << endl;
-    cout << format("show image = {}", showImage) << endl;
-    ImageSaveFormat saveFormat = ImageSaveFormat::Kalibr;  // save format
+    cout << format("show image = {}, preview scale = 1/{}", showImage, previewScale) << endl;
+    cout << format("save to container = {}", container) << endl;
+    cout << format("async sink = {}, direct IO = {}", asyncSink, directIo) << endl;
+    cout << format("rolling budget = {} GB, segment duration = {} s", rollingBudget, segmentDuration) << endl;
+    cout << format("pre-trigger = {} s, post-trigger = {} s, trigger budget = {} MB, acc threshold = {} m/s^2",
+                   triggerParams.preTrigger, triggerParams.postTrigger, triggerParams.byteBudget / 1024. / 1024,
+                   triggerParams.accThreshold)
+         << endl;
+    ImageSaveFormat saveFormat = container ? ImageSaveFormat::Container : ImageSaveFormat::Kalibr;  // save format
 
     // init glog
     google::InitGoogleLogging(argv[0]);
@@ -127,6 +199,11 @@ int main(int argc, char* argv[]) {
     recorder->setStreamMode(streamMode);
     recorder->setStreamFormat(streamFormat);
     recorder->setSaverThreadNum(saverThreadNum);
+    YuyvEncodeParams encodeParams;
+    encodeParams.subsampling = gray ? JpegSubsampling::Gray : JpegSubsampling::S422;
+    encodeParams.roi = roi;
+    encodeParams.binning = binning;
+    recorder->setEncodeParams(encodeParams);
 
     // init
     recorder->init();
@@ -138,9 +215,9 @@ int main(int argc, char* argv[]) {
     if (!fs::exists(rootPath)) {
         fs::create_directories(rootPath);
     }
-    auto leftImageSavePath = fs::weakly_canonical(rootPath / "left");
-    auto rightImageSavePath = fs::weakly_canonical(rootPath / "right");
-    auto imuSavePath = rootPath / "imu.csv";
+    auto leftImageSavePath = fs::weakly_canonical(rootPath / (container ? "left.container" : "left"));
+    auto rightImageSavePath = fs::weakly_canonical(rootPath / (container ? "right.container" : "right"));
+    auto imuSavePath = rootPath / (imuBinary ? "imu.bin" : "imu.csv");
 
     // remove old files
     fs::remove_all(rootPath);
@@ -159,9 +236,25 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    // IMU file stream
+    // geometry of encoded image, which gives the intrinsics after ROI crop and binning
+    auto geometrySavePath = rootPath / "geometry.json";
+    cout << format("geometry path: {}", geometrySavePath.string()) << endl;
+    saveJson(recorder->encodeGeometry(), geometrySavePath.string());
+
+    // IMU writer
     cout << format("IMU path: {}", imuSavePath.string()) << endl;
-    fstream imuFileStream;
+    ImuWriterParams imuWriterParams;
+    imuWriterParams.format = imuBinary ? ImuFileFormat::Binary : ImuFileFormat::Csv;
+    ImuCsvWriter imuWriter(imuWriterParams);
+    // async file sink and image container
+    shared_ptr<AsyncFileSink> sink = asyncSink ? make_shared<AsyncFileSink>() : nullptr;
+    ContainerParams containerParams;
+    containerParams.directIo = directIo;
+    containerParams.segmentDuration = segmentDuration;
+    containerParams.rollingBudget = static_cast<uint64_t>(rollingBudget * 1024 * 1024 * 1024);
+    ImageContainerWriter leftContainer(containerParams), rightContainer(containerParams);
+    leftContainer.setSink(sink);
+    rightContainer.setSink(sink);
 
     // some variables
     atomic_long leftImageIndex{0};  // image index
@@ -171,71 +264,101 @@ int main(int argc, char* argv[]) {
     mutex showImageMutex;
     condition_variable showImageCv;
     cv::Mat leftImage, rightImage;
+    // downscaled preview decoded in low priority thread, it's only subscribed if the image is shown
+    PreviewParams previewParams;
+    previewParams.scaleDenom = previewScale;
+    PreviewStage preview(previewParams);
+    if (showImage) {
+        preview.subscribe([&](const PreviewImage& image) {
+            cv::Mat mat(image.height, image.width, image.channels == 1 ? CV_8UC1 : CV_8UC3,
+                        const_cast<unsigned char*>(image.data.data()));
+            unique_lock<mutex> lock(showImageMutex);
+            (image.camera == 0 ? leftImage : rightImage) = mat.clone();
+            showImageReady = true;
+            showImageCv.notify_one();
+        });
+    }
 
     // set callback function
     recorder->addCallback(MyntEyeRecorder::CallBackStarted, [&]() {
         // open IMU file
-        imuFileStream.open(imuSavePath.string(), ios::out);
-        CHECK(imuFileStream.is_open()) << format("cannot open file \"{}\" to save IMU data", imuSavePath.string());
-        // write header
-        imuFileStream << "#SensorTimestamp[ns],SystemTimestamp[ns],GyroX[rad/s],GyroY[rad/s],GyroZ[rad/s]"
-                         ",AccX[m/s^2],AccY[m/s^2],AccZ[m/s^2]"
-                      << endl;
+        CHECK(imuWriter.open(imuSavePath.string()))
+            << format("cannot open file \"{}\" to save IMU data", imuSavePath.string());
+        // open image container
+        if (container) {
+            CHECK(leftContainer.open(leftImageSavePath.string()))
+                << format("cannot open container \"{}\" to save left image", leftImageSavePath.string());
+        }
+        if (container && !onlyLeft && recorder->isRightCamEnabled()) {
+            CHECK(rightContainer.open(rightImageSavePath.string()))
+                << format("cannot open container \"{}\" to save right image", rightImageSavePath.string());
+        }
     });
 
     // close file when finished
-    recorder->addCallback(MyntEyeRecorder::CallBackFinished, [&] { imuFileStream.close(); });
-
-    // set process function for left camera
-    recorder->setProcessFunction([&](const RawImageRecord& raw) {
-        LOG_EVERY_N(INFO, 100) << fmt::format("process left image, index = {}, timestamp = {:.5f} s", leftImageIndex,
-                                              raw.timestamp());
+    recorder->addCallback(MyntEyeRecorder::CallBackFinished, [&] {
+        imuWriter.close();
+        leftContainer.close();
+        rightContainer.close();
+        if (sink) {
+            sink->wait();
+        }
+    });
 
+    // save image of left(0) or right(1) camera, and IMU
+    auto saveImage = [&](const RawImageRecord& raw, size_t camera) {
+        const fs::path& savePath = camera == 0 ? leftImageSavePath : rightImageSavePath;
         // save file name
         string fileName;
         switch (saveFormat) {
             case ImageSaveFormat::Kalibr:
-                fileName = format("{}/{:.0f}.jpg", leftImageSavePath.string(), raw.timestamp() * 1E9);
+                fileName = format("{}/{:.0f}.jpg", savePath.string(), raw.timestamp() * 1E9);
+                break;
+            case ImageSaveFormat::Container:
+                (camera == 0 ? leftContainer : rightContainer)
+                    .append(raw.timestamp(), raw.reading().buffer(), raw.reading().size());
                 break;
             case ImageSaveFormat::Index: {
-                fileName = format("{}/{:06d}.jpg", leftImageSavePath.string(), leftImageIndex);
+                fileName = format("{}/{:06d}.jpg", savePath.string(),
+                                  camera == 0 ? leftImageIndex.load() : rightImageIndex.load());
             }
             default:
                 break;
         }
-        // save to file
-        fstream fs(fileName, ios::out | ios::binary);
-        if (!fs.is_open()) {
-            LOG(ERROR) << format("cannot create file \"{}\"", fileName);
-        }
-        fs.write(reinterpret_cast<const char*>(raw.reading().buffer()), raw.reading().size());
-        fs.close();
-
-        // send image per 10 images
-        if (0 == leftImageIndex % 10) {
-            cv::Mat buf(1, raw.reading().size(), CV_8UC1, (void*)raw.reading().buffer());
-            leftImage = cv::imdecode(buf, cv::IMREAD_UNCHANGED);
-
-            unique_lock<mutex> lock(showImageMutex);
-            showImageReady = true;
-            showImageCv.notify_one();
+        // save to file, the image is appended to container if the file name is empty
+        if (!fileName.empty() && sink) {
+            sink->writeFile(fileName, raw.reading());
+        } else if (!fileName.empty()) {
+            fstream fs(fileName, ios::out | ios::binary);
+            if (!fs.is_open()) {
+                LOG(ERROR) << format("cannot create file \"{}\"", fileName);
+            }
+            fs.write(reinterpret_cast<const char*>(raw.reading().buffer()), raw.reading().size());
+            fs.close();
         }
+    };
+    auto saveImu = [&](const ImuRecord& imu) { imuWriter.write(imu); };
+
+    // pre-trigger buffer, the data is saved through it if enabled
+    unique_ptr<TriggerBuffer> trigger;
+    if (triggerParams.preTrigger > 0) {
+        trigger = make_unique<TriggerBuffer>(triggerParams, saveImage, saveImu);
+        triggerBuffer = trigger.get();
+        signal(SIGUSR1, onTriggerSignal);
+    }
 
-#if true
-        // remove old files
-        if (leftImageIndex != 0 && leftImageIndex % 200000 == 0) {
-            LOG(WARNING) << fmt::format("remove old left images, index = {}", leftImageIndex);
-            // remove old files
-            fs::remove_all(leftImageSavePath);
-
-            // create left save folder
-            cout << format("left image path: {}", leftImageSavePath.string()) << endl;
-            if (!fs::create_directories(leftImageSavePath)) {
-                LOG(ERROR) << format("cannot create folder \"{}\" to save left image", leftImageSavePath.string());
-            }
+    // set process function for left camera
+    recorder->setProcessFunction([&](const RawImageRecord& raw) {
+        LOG_EVERY_N(INFO, 100) << fmt::format("process left image, index = {}, timestamp = {:.5f} s", leftImageIndex,
+                                              raw.timestamp());
+        if (trigger) {
+            trigger->push(raw, 0);
+        } else {
+            saveImage(raw, 0);
         }
 
-#endif
+        // preview image, it does nothing if the image isn't shown
+        preview.push(raw, 0);
 
         ++leftImageIndex;
     });
@@ -246,35 +369,14 @@ int main(int argc, char* argv[]) {
         recorder->setRightProcessFunction([&](const RawImageRecord& raw) {
             LOG_EVERY_N(INFO, 100) << fmt::format("process right image, index = {}, timestamp = {:.5f} s",
                                                   rightImageIndex, raw.timestamp());
-            // save file name
-            string fileName;
-            switch (saveFormat) {
-                case ImageSaveFormat::Kalibr:
-                    fileName = format("{}/{:.0f}.jpg", rightImageSavePath.string(), raw.timestamp() * 1.0E9);
-                    break;
-                case ImageSaveFormat::Index: {
-                    fileName = format("{}/{:06d}.jpg", rightImageSavePath.string(), rightImageIndex);
-                }
-                default:
-                    break;
-            }
-            // save to file
-            fstream fs(fileName, ios::out | ios::binary);
-            if (!fs.is_open()) {
-                LOG(ERROR) << format("cannot create file \"{}\"", fileName);
+            if (trigger) {
+                trigger->push(raw, 1);
+            } else {
+                saveImage(raw, 1);
             }
-            fs.write(reinterpret_cast<const char*>(raw.reading().buffer()), raw.reading().size());
-            fs.close();
-
-            // send image per 10 images
-            if (0 == rightImageIndex % 10) {
-                cv::Mat buf(1, raw.reading().size(), CV_8UC1, (void*)raw.reading().buffer());
-                rightImage = cv::imdecode(buf, cv::IMREAD_UNCHANGED);
 
-                unique_lock<mutex> lock(showImageMutex);
-                showImageReady = true;
-                showImageCv.notify_one();
-            }
+            // preview image, it does nothing if the image isn't shown
+            preview.push(raw, 1);
 
             ++rightImageIndex;
         });
@@ -282,38 +384,43 @@ int main(int argc, char* argv[]) {
 
     // set process funcion for IMU
     recorder->setProcessFunction([&](const ImuRecord& imu) {
-        // format: sensor timestamp(ns), system timstamp(ns), gyro(rad/s), acc(m/s^2)
-        imuFileStream << format("{:.0f},{:.0f},{:.10f},{:.10f},{:.10f},{:.10f},{:.10f},{:.10f}",
-                                imu.timestamp() * 1.0E9, imu.systemTimestamp().value_or(0) * 1.0E9,
-                                imu.reading().gyro()[0], imu.reading().gyro()[1], imu.reading().gyro()[2],
-                                imu.reading().acc()[0], imu.reading().acc()[1], imu.reading().acc()[2])
-                      << endl;
+        if (trigger) {
+            trigger->push(imu);
+        } else {
+            saveImu(imu);
+        }
     });
 
     // start
     recorder->start();
 
-    // wait stop
-    while (true) {
+    // wait stop, the recorder runs until it's killed if the image isn't shown
+    if (!showImage) {
+        recorder->wait();
+    }
+    while (showImage) {
+        cv::Mat left, right;
         {
             unique_lock<mutex> lock(showImageMutex);
             showImageCv.wait(lock, [&]() { return showImageReady; });
             showImageReady = false;
+            left = leftImage;
+            right = rightImage;
         }
 
         // show image
-        if (showImage) {
-            cv::imshow("Left Image", leftImage);
-            if (!onlyLeft && recorder->isRightCamEnabled()) {
-                cv::imshow("Right Image", rightImage);
-            }
-            int ret = cv::waitKey(1);
+        if (!left.empty()) {
+            cv::imshow("Left Image", left);
+        }
+        if (!onlyLeft && recorder->isRightCamEnabled() && !right.empty()) {
+            cv::imshow("Right Image", right);
+        }
+        int ret = cv::waitKey(1);
 
-            if (ret == 'Q' || ret == 'q') {
-                recorder->stop();
-                recorder->wait();
-                break;
-            }
+        if (ret == 'Q' || ret == 'q') {
+            recorder->stop();
+            recorder->wait();
+            break;
         }
     }
 
@@ -0,0 +1,402 @@
+/**
+ * @brief Benchmark code for the end-to-end recording pipeline
+ *
+ * The real recorder stages(capture => queue => encode => sink) are driven by `SyntheticRecorder` at real time, and the
+ * resolution, FPS, saver thread number and sink type are swept. For each case, the sustained FPS, the percentiles of
+ * capture-to-write latency, the dropped frames and the CPU usage of each stage are reported, and saved as JSON.
+ *
+ * The recorded folder could also be replayed by `ReplayRecorder` at real time as the source, which measures the
+ * read => sink stages with the real images, and only the sink type is swept.
+ *
+ * The CPU usage is the percent of one core. The CPU time of saver threads is taken in the process function, the sink
+ * time is measured around the writing, and the encode time is the rest of saver threads. The capture stage includes the
+ * image generator(or replay), the IMU thread and the other overhead of process.
+ */
+
+#include <fmt/format.h>
+#include <glog/logging.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <algorithm>
+#include <atomic>
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <cmath>
+#include <cxxopts.hpp>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <thread>
+#include <vector>
+#include "libra/io.hpp"
+
+using namespace std;
+using namespace fmt;
+using namespace libra::core;
+using namespace libra::io;
+using namespace libra::util;
+namespace fs = boost::filesystem;
+using json = nlohmann::json;
+
+/**
+ * @brief Benchmark case
+ */
+struct Case {
+    int width = 1280;           // image width
+    int height = 720;           // image height
+    double fps = 30;            // FPS
+    size_t saverThreadNum = 2;  // saver thread number
+    string sink = "null";       // sink type, "null" or "file"
+};
+
+/**
+ * @brief Benchmark result
+ */
+struct Result {
+    size_t generatedNum = 0;    // generated(or replayed) frame number
+    size_t writtenNum = 0;      // written frame number
+    size_t droppedNum = 0;      // dropped frame number in image queue
+    double usedTime = 0;        // used time, s
+    vector<double> latencies;   // capture-to-write latency of each frame, ms
+    double captureCpuTime = 0;  // CPU time of capture stage, s
+    double encodeCpuTime = 0;   // CPU time of encode stage, s
+    double sinkCpuTime = 0;     // CPU time of sink stage, s
+    double totalCpuTime = 0;    // CPU time of process, s
+    string stages;              // latency of pipeline stages in JSON, ms
+};
+
+/**
+ * @brief Get the system time in seconds, which is the same clock with the image timestamp of synthetic recorder
+ */
+double systemTime() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count() * 1.0E-9;
+}
+
+/**
+ * @brief Get the CPU time of current thread in seconds
+ */
+double threadCpuTime() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1.0E-9;
+}
+
+/**
+ * @brief Get the CPU time of current process in seconds, include user and system time
+ */
+double processCpuTime() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1.0E-6;
+}
+
+/**
+ * @brief Get the percentile of sorted values
+ *
+ * @param values    Sorted values
+ * @param p         Percentile, [0, 1]
+ * @return Percentile value, 0 if the values is empty
+ */
+double percentile(const vector<double>& values, double p) {
+    if (values.empty()) {
+        return 0;
+    }
+    size_t index = static_cast<size_t>(ceil(p * values.size()));
+    return values[min(values.size() - 1, index == 0 ? 0 : index - 1)];
+}
+
+/**
+ * @brief Sink which writes the JPEG image, and collects the latency and CPU time of writing. It's called by multiple
+ * saver threads
+ */
+class Sink {
+  public:
+    /**
+     * @brief Constructor
+     *
+     * @param type      Sink type, "null" to discard the image, "file" to write each image into one file in folder
+     * @param folder    Folder to save images
+     */
+    Sink(const string& type, const fs::path& folder) : type_(type), folder_(folder) {
+        if (type_ == "file") {
+            fs::remove_all(folder_);
+            fs::create_directories(folder_);
+        } else {
+            CHECK_EQ(type_, "null") << format("unknown sink type \"{}\"", type_);
+        }
+    }
+
+    /**
+     * @brief Write image, and record the latency from the capture time
+     *
+     * @param raw           Raw image record
+     * @param captureTime   Capture time of image in system clock, s
+     */
+    void write(const RawImageRecord& raw, double captureTime) {
+        double cpu0 = threadCpuTime();
+        if (type_ == "file") {
+            // name by sequence number, the left and right image from replay source have the same timestamp
+            string fileName = format("{}/{}.jpg", folder_.string(), fileIndex_++);
+            fstream fs(fileName, ios::out | ios::binary);
+            if (!fs.is_open()) {
+                LOG(ERROR) << format("cannot create file \"{}\"", fileName);
+            }
+            fs.write(reinterpret_cast<const char*>(raw.reading().buffer()), raw.reading().size());
+        }
+        double cpu1 = threadCpuTime();
+        double latency = systemTime() - captureTime;
+
+        lock_guard<mutex> lock(mutex_);
+        latencies_.emplace_back(latency * 1.0E3);
+        sinkCpuTime_ += cpu1 - cpu0;
+        // the CPU time of saver thread is accumulated, keep the latest one
+        threadCpuTimes_[this_thread::get_id()] = cpu1;
+    }
+
+    /**
+     * @brief Fill the latency and CPU time into result, the latencies are sorted
+     *
+     * @param result    Benchmark result
+     */
+    void fill(Result& result) {
+        lock_guard<mutex> lock(mutex_);
+        sort(latencies_.begin(), latencies_.end());
+        result.writtenNum = latencies_.size();
+        result.latencies = latencies_;
+        result.sinkCpuTime = sinkCpuTime_;
+        double saverCpuTime{0};
+        for (auto& v : threadCpuTimes_) {
+            saverCpuTime += v.second;
+        }
+        result.encodeCpuTime = max(0.0, saverCpuTime - sinkCpuTime_);
+    }
+
+  private:
+    string type_;                             // sink type
+    fs::path folder_;                         // folder to save images
+    mutex mutex_;                             // mutex for statistics
+    vector<double> latencies_;                // latency of each image, ms
+    double sinkCpuTime_{0};                   // CPU time of writing, s
+    atomic<size_t> fileIndex_{0};             // index of written file
+    map<thread::id, double> threadCpuTimes_;  // CPU time of each saver thread, s
+};
+
+/**
+ * @brief Run the pipeline with synthetic source
+ *
+ * @param c         Benchmark case
+ * @param duration  Duration of each case, s
+ * @param folder    Folder to save images
+ * @return Benchmark result
+ */
+Result runSynthetic(const Case& c, double duration, const fs::path& folder) {
+    SyntheticParams params;
+    params.width = c.width;
+    params.height = c.height;
+    params.fps = c.fps;
+    params.realTime = true;
+    params.frameNum = max<size_t>(1, static_cast<size_t>(duration * c.fps));
+    auto recorder = make_shared<SyntheticRecorder>(params, c.saverThreadNum);
+    Sink sink(c.sink, folder);
+    // the image timestamp is the capture time in system clock
+    recorder->setProcessFunction([&](const RawImageRecord& raw) { sink.write(raw, raw.timestamp()); });
+    recorder->init();
+
+    Result result;
+    double cpu0 = processCpuTime();
+    auto t0 = chrono::steady_clock::now();
+    recorder->start();
+    recorder->wait();
+    result.usedTime = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    result.totalCpuTime = processCpuTime() - cpu0;
+    result.generatedNum = recorder->generatedFrameNum();
+    result.droppedNum = recorder->imageQueueStats().dropNum + recorder->droppedFrameNum();
+    sink.fill(result);
+    result.captureCpuTime = max(0.0, result.totalCpuTime - result.encodeCpuTime - result.sinkCpuTime);
+    result.stages = recorder->frameTracer()->toJson();
+    return result;
+}
+
+/**
+ * @brief Run the pipeline with replay source at real time
+ *
+ * @param c             Benchmark case
+ * @param replayFolder  Recorded folder to replay
+ * @param folder        Folder to save images
+ * @return Benchmark result
+ */
+Result runReplay(const Case& c, const string& replayFolder, const fs::path& folder) {
+    ReplayParams params;
+    params.folder = replayFolder;
+    auto recorder = make_shared<ReplayRecorder>(params);
+    Sink sink(c.sink, folder);
+    // the capture time is estimated from the replay start time, which assumes no latency for the first image
+    double startTime{-1}, startTimestamp{0};
+    auto process = [&](const RawImageRecord& raw) {
+        if (startTime < 0) {
+            startTime = systemTime();
+            startTimestamp = raw.timestamp();
+        }
+        sink.write(raw, startTime + raw.timestamp() - startTimestamp);
+    };
+    recorder->setProcessFunction(process);
+    recorder->setRightProcessFunction(process);
+    recorder->init();
+
+    Result result;
+    double cpu0 = processCpuTime();
+    auto t0 = chrono::steady_clock::now();
+    recorder->start();
+    recorder->wait();
+    result.usedTime = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    result.totalCpuTime = processCpuTime() - cpu0;
+    result.generatedNum = recorder->imageNum();
+    sink.fill(result);
+    // there is no encode stage, the sink is called in replay thread
+    result.encodeCpuTime = 0;
+    result.captureCpuTime = max(0.0, result.totalCpuTime - result.sinkCpuTime);
+    result.stages = recorder->frameTracer()->toJson();
+    return result;
+}
+
+/**
+ * @brief Convert benchmark case and result to JSON
+ */
+json toJson(const Case& c, const Result& r) {
+    auto cpuPercent = [&](double cpuTime) { return r.usedTime > 0 ? 100 * cpuTime / r.usedTime : 0.; };
+    json j;
+    j["width"] = c.width;
+    j["height"] = c.height;
+    j["fps"] = c.fps;
+    j["saverThreadNum"] = c.saverThreadNum;
+    j["sink"] = c.sink;
+    j["generated"] = r.generatedNum;
+    j["written"] = r.writtenNum;
+    j["dropped"] = r.droppedNum;
+    j["usedTime"] = r.usedTime;
+    j["sustainedFps"] = r.usedTime > 0 ? r.writtenNum / r.usedTime : 0.;
+    j["latencyMs"] = {{"p50", percentile(r.latencies, 0.5)},
+                      {"p99", percentile(r.latencies, 0.99)},
+                      {"p999", percentile(r.latencies, 0.999)},
+                      {"max", r.latencies.empty() ? 0. : r.latencies.back()}};
+    j["cpuPercent"] = {{"capture", cpuPercent(r.captureCpuTime)},
+                       {"encode", cpuPercent(r.encodeCpuTime)},
+                       {"sink", cpuPercent(r.sinkCpuTime)},
+                       {"total", cpuPercent(r.totalCpuTime)}};
+    j["stagesMs"] = json::parse(r.stages);
+    return j;
+}
+
+int main(int argc, char* argv[]) {
+    cout << Title("Pipeline Benchmark") << endl;
+    // init glog
+    google::InitGoogleLogging(argv[0]);
+    FLAGS_alsologtostderr = false;
+
+    // argument parser
+    cxxopts::Options options(argv[0], "Pipeline Benchmark");
+    // clang-format off
+    options.add_options()
+        ("source", "source type, \"synthetic\" or \"replay\"", cxxopts::value<string>()->default_value("synthetic"))
+        ("replayFolder", "recorded folder to replay for replay source", cxxopts::value<string>()->default_value(""))
+        ("resolution", "image resolutions, WxH", cxxopts::value<vector<string>>()->default_value("640x480,1280x720"))
+        ("fps", "FPS list", cxxopts::value<vector<double>>()->default_value("30,60"))
+        ("saverThreadNum", "saver thread number list", cxxopts::value<vector<size_t>>()->default_value("1,2,4"))
+        ("sink", "sink type list, \"null\" or \"file\"", cxxopts::value<vector<string>>()->default_value("null,file"))
+        ("duration", "duration of each case, s", cxxopts::value<double>()->default_value("5"))
+        ("f,folder", "folder to save images for file sink",
+            cxxopts::value<string>()->default_value((fs::temp_directory_path() / "PipelineBenchmark").string()))
+        ("o,output", "output JSON file, don't save if it's empty", cxxopts::value<string>()->default_value(""))
+        ("h,help", "help message");
+    // clang-format on
+    auto result = options.parse(argc, argv);
+    if (result.count("help")) {
+        cout << options.help() << endl;
+        return 0;
+    }
+    string source = result["source"].as<string>();
+    string replayFolder = result["replayFolder"].as<string>();
+    double duration = result["duration"].as<double>();
+    fs::path saveFolder = result["folder"].as<string>();
+    string outputFile = result["output"].as<string>();
+    CHECK(source == "synthetic" || source == "replay") << format("unknown source type \"{}\"", source);
+    CHECK(source != "replay" || !replayFolder.empty()) << "replay folder should be set for replay source";
+
+    // generate benchmark cases, only the sink is swept for replay source
+    vector<Case> cases;
+    for (auto& sink : result["sink"].as<vector<string>>()) {
+        if (source == "replay") {
+            Case c;
+            c.width = c.height = 0;
+            c.fps = 0;
+            c.saverThreadNum = 0;
+            c.sink = sink;
+            cases.emplace_back(c);
+            continue;
+        }
+        for (auto& resolution : result["resolution"].as<vector<string>>()) {
+            Case c;
+            CHECK_EQ(sscanf(resolution.c_str(), "%dx%d", &c.width, &c.height), 2)
+                << format("invalid resolution \"{}\"", resolution);
+            c.sink = sink;
+            for (auto& fps : result["fps"].as<vector<double>>()) {
+                c.fps = fps;
+                for (auto& saverThreadNum : result["saverThreadNum"].as<vector<size_t>>()) {
+                    c.saverThreadNum = saverThreadNum;
+                    cases.emplace_back(c);
+                }
+            }
+        }
+    }
+
+    // print input parameters
+    cout << Section("Input Parameters");
+    cout << format("source: {}", source) << endl;
+    if (source == "replay") {
+        cout << format("replay folder: {}", replayFolder) << endl;
+    } else {
+        cout << format("duration = {} s", duration) << endl;
+    }
+    cout << format("save folder: {}", saveFolder.string()) << endl;
+    cout << format("output file: {}", outputFile) << endl;
+    cout << format("case number = {}", cases.size()) << endl;
+
+    // run benchmark
+    cout << Section("Benchmark");
+    cout << format("{:>10s}{:>6s}{:>8s}{:>6s}{:>10s}{:>10s}{:>10s}{:>10s}{:>10s}{:>10s}{:>10s}{:>10s}{:>10s}", "Size",
+                   "FPS", "Thread", "Sink", "Written", "Dropped", "FPS", "P50(ms)", "P99(ms)", "P999(ms)", "Capture%",
+                   "Encode%", "Sink%")
+         << endl;
+    json j;
+    j["source"] = source;
+    j["replayFolder"] = replayFolder;
+    j["duration"] = duration;
+    j["hardwareConcurrency"] = thread::hardware_concurrency();
+    j["results"] = json::array();
+    for (auto& c : cases) {
+        Result r = source == "replay" ? runReplay(c, replayFolder, saveFolder) : runSynthetic(c, duration, saveFolder);
+        json jr = toJson(c, r);
+        cout << format("{:>10s}{:>6.0f}{:>8d}{:>6s}{:>10d}{:>10d}{:>10.2f}{:>10.2f}{:>10.2f}{:>10.2f}{:>10.1f}{:>10.1f}"
+                       "{:>10.1f}",
+                       format("{}x{}", c.width, c.height), c.fps, c.saverThreadNum, c.sink, r.writtenNum,
+                       r.droppedNum, jr["sustainedFps"].get<double>(), jr["latencyMs"]["p50"].get<double>(),
+                       jr["latencyMs"]["p99"].get<double>(), jr["latencyMs"]["p999"].get<double>(),
+                       jr["cpuPercent"]["capture"].get<double>(), jr["cpuPercent"]["encode"].get<double>(),
+                       jr["cpuPercent"]["sink"].get<double>())
+             << endl;
+        j["results"].emplace_back(move(jr));
+    }
+    fs::remove_all(saveFolder);
+
+    // save result
+    if (!outputFile.empty()) {
+        fstream fs(outputFile, ios::out);
+        CHECK(fs.is_open()) << format("cannot open file \"{}\" to save result", outputFile);
+        fs << j.dump(4) << endl;
+        cout << format("save result to \"{}\"", outputFile) << endl;
+    }
+
+    return 0;
+}
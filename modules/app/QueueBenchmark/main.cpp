@@ -0,0 +1,152 @@
+/**
+ * @brief Benchmark code for job queues
+ *
+ * One producer pushes image-frame-like jobs(shared pointer to buffer) to the queue, and 1 - 16 consumers pop and do some
+ * work on them, which is the same with the image queue in recorders. The throughput and the push latency of `JobQueue`
+ * and `MpmcQueue` are compared.
+ */
+
+#include <fmt/format.h>
+#include <glog/logging.h>
+#include <algorithm>
+#include <chrono>
+#include <cxxopts.hpp>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "libra/util.hpp"
+
+using namespace std;
+using namespace std::chrono;
+using namespace libra::util;
+
+/**
+ * @brief Benchmark result
+ */
+struct Result {
+    double throughput = 0;    // throughput, job/s
+    double meanPushTime = 0;  // mean push time, us
+    double maxPushTime = 0;   // max push time, us
+};
+
+/**
+ * @brief Simulate the work of consumer, touch the job buffer for some iterations
+ *
+ * @param data  Job buffer
+ * @param work  Work iterations
+ * @return Dummy result to avoid optimized out
+ */
+unsigned int doWork(const vector<unsigned char>& data, int work) {
+    unsigned int sum{0};
+    for (int i = 0; i < work; ++i) {
+        sum += data[i % data.size()] * i;
+    }
+    return sum;
+}
+
+/**
+ * @brief Run benchmark for one queue
+ *
+ * @tparam Queue        Queue type
+ * @param consumerNum   Consumer thread number
+ * @param jobNum        Job number
+ * @param capacity      Queue capacity
+ * @param work          Work iterations for each job in consumer
+ * @return Benchmark result
+ */
+template <typename Queue>
+Result benchmark(int consumerNum, int jobNum, int capacity, int work) {
+    Queue queue(capacity);
+    auto buffer = make_shared<vector<unsigned char>>(1024, 1);  // shared job data, like the image frame
+
+    // consumers
+    vector<thread> consumers;
+    vector<unsigned int> sums(consumerNum);
+    for (int n = 0; n < consumerNum; ++n) {
+        consumers.emplace_back([&, n]() {
+            while (true) {
+                auto job = queue.pop();
+                if (!job.isValid()) {
+                    break;
+                }
+                sums[n] += doWork(*job.data(), work);
+            }
+        });
+    }
+
+    // producer
+    double sumPushTime{0}, maxPushTime{0};
+    auto t0 = steady_clock::now();
+    for (int i = 0; i < jobNum; ++i) {
+        auto data = buffer;
+        auto t1 = steady_clock::now();
+        queue.push(move(data));
+        double dt = duration_cast<duration<double, micro>>(steady_clock::now() - t1).count();
+        sumPushTime += dt;
+        maxPushTime = max(maxPushTime, dt);
+    }
+    queue.wait();
+    double usedTime = duration_cast<duration<double>>(steady_clock::now() - t0).count();
+    queue.stop();
+    for (auto& t : consumers) {
+        t.join();
+    }
+
+    Result result;
+    result.throughput = jobNum / usedTime;
+    result.meanPushTime = sumPushTime / jobNum;
+    result.maxPushTime = maxPushTime;
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    cout << Title("Job Queue Benchmark") << endl;
+    // init glog, and suppress the warning of `JobQueue` when queue is full, which isn't the cost of queue itself
+    google::InitGoogleLogging(argv[0]);
+    FLAGS_alsologtostderr = true;
+    FLAGS_colorlogtostderr = true;
+    FLAGS_minloglevel = google::GLOG_ERROR;
+
+    // argument parser
+    cxxopts::Options options(argv[0], "Job Queue Benchmark");
+    // clang-format off
+    options.add_options()
+        ("jobNum", "job number for each test", cxxopts::value<int>()->default_value("200000"))
+        ("capacity", "queue capacity", cxxopts::value<int>()->default_value("1024"))
+        ("work", "work iterations for each job in consumer", cxxopts::value<int>()->default_value("100"))
+        ("h,help", "help message");
+    // clang-format on
+    auto result = options.parse(argc, argv);
+    if (result.count("help")) {
+        cout << options.help() << endl;
+        return 0;
+    }
+    int jobNum = result["jobNum"].as<int>();
+    int capacity = result["capacity"].as<int>();
+    int work = result["work"].as<int>();
+
+    // print input parameters
+    cout << Section("Input Parameters");
+    cout << fmt::format("job number = {}", jobNum) << endl;
+    cout << fmt::format("queue capacity = {}", capacity) << endl;
+    cout << fmt::format("work iterations = {}", work) << endl;
+    cout << fmt::format("hardware concurrency = {}", thread::hardware_concurrency()) << endl;
+
+    // run benchmark
+    using Job = shared_ptr<vector<unsigned char>>;
+    cout << Section("Benchmark");
+    cout << fmt::format("{:>9} | {:>28} | {:>28} | {:>7}", "consumer", "JobQueue(job/s, push us)",
+                        "MpmcQueue(job/s, push us)", "speedup")
+         << endl;
+    for (int consumerNum : {1, 2, 4, 8, 16}) {
+        Result r0 = benchmark<JobQueue<Job>>(consumerNum, jobNum, capacity, work);
+        Result r1 = benchmark<MpmcQueue<Job>>(consumerNum, jobNum, capacity, work);
+        cout << fmt::format("{:>9} | {:>10.0f}, {:>7.3f}/{:>8.1f} | {:>10.0f}, {:>7.3f}/{:>8.1f} | {:>7.2f}", consumerNum,
+                            r0.throughput, r0.meanPushTime, r0.maxPushTime, r1.throughput, r1.meanPushTime,
+                            r1.maxPushTime, r1.throughput / r0.throughput)
+             << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,321 @@
+/**
+ * @brief Sensor recorder using synthetic YUYV images and IMU, which runs the same capture => encode => save pipeline with
+ * camera recorders, used as a repeatable load generator and soak test on the machine without device
+ */
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+#include <glog/logging.h>
+#include <atomic>
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <csignal>
+#include <cxxopts.hpp>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include "libra/io.hpp"
+#include "libra/util/Serialization.hpp"
+
+using namespace std;
+using namespace fmt;
+using namespace libra::core;
+using namespace libra::io;
+using namespace libra::util;
+namespace fs = boost::filesystem;
+
+namespace {
+
+TriggerBuffer* triggerBuffer = nullptr;  // pre-trigger buffer, which is triggered by SIGUSR1
+
+void onTriggerSignal(int) {
+    if (triggerBuffer != nullptr) {
+        triggerBuffer->trigger();
+    }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    cout << Title("Synthetic Sensor Recorder") << endl;
+    // init glog
+    google::InitGoogleLogging(argv[0]);
+    FLAGS_alsologtostderr = true;
+    FLAGS_colorlogtostderr = true;
+
+    // argument parser
+    cxxopts::Options options(argv[0], "Synthetic Sensor Recorder");
+    // clang-format off
+    options.add_options()
+        ("f,folder", "save folder, don't save if it's empty", cxxopts::value<string>()->default_value(""))
+        ("width", "image width", cxxopts::value<int>()->default_value("1280"))
+        ("height", "image height", cxxopts::value<int>()->default_value("720"))
+        ("fps", "FPS", cxxopts::value<double>()->default_value("30"))
+        ("imuRate", "IMU rate, Hz", cxxopts::value<double>()->default_value("200"))
+        ("seed", "random seed", cxxopts::value<unsigned int>()->default_value("0"))
+        ("jitter", "standard deviation of image arrival jitter, ms", cxxopts::value<double>()->default_value("0"))
+        ("frameDropRate", "probability to drop frame at sensor", cxxopts::value<double>()->default_value("0"))
+        ("imuDropRate", "probability to drop IMU at sensor", cxxopts::value<double>()->default_value("0"))
+        ("frameNum", "frame number to generate, 0 for unlimited", cxxopts::value<size_t>()->default_value("300"))
+        ("fullSpeed", "generate data as fast as the pipeline could go instead of real time", cxxopts::value<bool>())
+        ("saverThreadNum", "thread number to save images", cxxopts::value<int>()->default_value("2"))
+        ("stripe", "encode each image in parallel stripes to reduce latency", cxxopts::value<bool>())
+        ("gray", "only encode the Y channel into grayscale JPEG, for monochrome calibration and SLAM",
+            cxxopts::value<bool>())
+        ("binning", "bin 2x2 pixels into one before encoding, 1 or 2", cxxopts::value<int>()->default_value("1"))
+        ("roi", "region of image to encode before binning, \"x,y,width,height\" in pixels, the whole image if it's "
+            "not set", cxxopts::value<vector<int>>())
+        ("adaptive", "adjust encode quality by the image queue size and encode time", cxxopts::value<bool>())
+        ("container", "save images into append-only container instead of one file for each image",
+            cxxopts::value<bool>())
+        ("asyncSink", "write images by asynchronous file sink, so the saver threads don't wait for storage",
+            cxxopts::value<bool>())
+        ("directIo", "write image container with O_DIRECT, only used with container and async sink",
+            cxxopts::value<bool>())
+        ("rollingBudget", "disk budget of image container for rolling record, the oldest segments are deleted if "
+            "it's exceeded, GB, 0 for unlimited. It implies container", cxxopts::value<double>()->default_value("0"))
+        ("segmentDuration", "maximum time span of container segment, s, 0 for unlimited",
+            cxxopts::value<double>()->default_value("60"))
+        ("imuBinary", "save IMU to binary file \"imu.bin\" instead of CSV file", cxxopts::value<bool>())
+        ("preTrigger", "keep the last seconds in memory and only save the data around trigger, which is triggered by "
+            "SIGUSR1 or IMU threshold, s, 0 to save all", cxxopts::value<double>()->default_value("0"))
+        ("postTrigger", "time window to save after trigger, s", cxxopts::value<double>()->default_value("5"))
+        ("triggerBudget", "memory budget of buffered images before trigger, MB",
+            cxxopts::value<double>()->default_value("256"))
+        ("accThreshold", "trigger if the norm of acc exceeds it, m/s^2, 0 to disable",
+            cxxopts::value<double>()->default_value("0"))
+        ("trace", "JSON file to save the latency of image pipeline stages, don't save if it's empty",
+            cxxopts::value<string>()->default_value(""))
+        ("timeline", "Chrome trace JSON file to save the timeline of recorder threads, don't trace if it's empty",
+            cxxopts::value<string>()->default_value(""))
+        ("h,help", "help message");
+    // clang-format on
+    auto result = options.parse(argc, argv);
+    if (result.count("help")) {
+        cout << options.help() << endl;
+        return 0;
+    }
+    string saveRootFolder = result["folder"].as<string>();
+    SyntheticParams params;
+    params.width = result["width"].as<int>();
+    params.height = result["height"].as<int>();
+    params.fps = result["fps"].as<double>();
+    params.imuRate = result["imuRate"].as<double>();
+    params.seed = result["seed"].as<unsigned int>();
+    params.jitter = result["jitter"].as<double>() * 1.0E-3;
+    params.frameDropRate = result["frameDropRate"].as<double>();
+    params.imuDropRate = result["imuDropRate"].as<double>();
+    params.frameNum = result["frameNum"].as<size_t>();
+    params.realTime = !result["fullSpeed"].as<bool>();
+    int saverThreadNum = result["saverThreadNum"].as<int>();
+    bool stripe = result["stripe"].as<bool>();
+    bool gray = result["gray"].as<bool>();
+    int binning = result["binning"].as<int>();
+    ImageRoi roi;
+    if (result.count("roi")) {
+        auto v = result["roi"].as<vector<int>>();
+        if (v.size() != 4) {
+            cout << "ROI should be \"x,y,width,height\"" << endl << endl;
+            cout << options.help() << endl;
+            return 0;
+        }
+        roi = ImageRoi{v[0], v[1], v[2], v[3]};
+    }
+    bool adaptive = result["adaptive"].as<bool>();
+    double rollingBudget = result["rollingBudget"].as<double>();
+    double segmentDuration = result["segmentDuration"].as<double>();
+    bool container = result["container"].as<bool>() || rollingBudget > 0;
+    bool asyncSink = result["asyncSink"].as<bool>();
+    bool directIo = result["directIo"].as<bool>();
+    bool imuBinary = result["imuBinary"].as<bool>();
+    TriggerParams triggerParams;
+    triggerParams.preTrigger = result["preTrigger"].as<double>();
+    triggerParams.postTrigger = result["postTrigger"].as<double>();
+    triggerParams.byteBudget = static_cast<size_t>(result["triggerBudget"].as<double>() * 1024 * 1024);
+    triggerParams.accThreshold = result["accThreshold"].as<double>();
+    string traceFile = result["trace"].as<string>();
+    string timelineFile = result["timeline"].as<string>();
+
+    // print input parameters
+    cout << Section("Input Parameters");
+    cout << format("save folder: {}", saveRootFolder) << endl;
+    cout << format("image size = {}x{}", params.width, params.height) << endl;
+    cout << format("FPS = {} Hz", params.fps) << endl;
+    cout << format("IMU rate = {} Hz", params.imuRate) << endl;
+    cout << format("seed = {}", params.seed) << endl;
+    cout << format("jitter = {} ms", params.jitter * 1.0E3) << endl;
+    cout << format("frame drop rate = {}", params.frameDropRate) << endl;
+    cout << format("IMU drop rate = {}", params.imuDropRate) << endl;
+    cout << format("frame number = {}", params.frameNum) << endl;
+    cout << format("real time: {}", params.realTime) << endl;
+    cout << format("saver thread number = {}", saverThreadNum) << endl;
+    cout << format("stripe encode: {}", stripe) << endl;
+    cout << format("gray encode: {}", gray) << endl;
+    cout << format("ROI = ({}, {}, {}, {}), binning = {}", roi.x, roi.y, roi.width, roi.height, binning) << endl;
+    cout << format("adaptive encode: {}", adaptive) << endl;
+    cout << format("rolling budget = {} GB, segment duration = {} s", rollingBudget, segmentDuration) << endl;
+    cout << format("pre-trigger = {} s, post-trigger = {} s, trigger budget = {} MB, acc threshold = {} m/s^2",
+                   triggerParams.preTrigger, triggerParams.postTrigger, triggerParams.byteBudget / 1024. / 1024,
+                   triggerParams.accThreshold)
+         << endl;
+    cout << format("trace file: {}", traceFile) << endl;
+    cout << format("timeline file: {}", timelineFile) << endl;
+
+    // set and init
+    cout << Section("Start Recorder");
+    TraceRecorder::instance().setEnabled(!timelineFile.empty());
+    auto recorder = make_shared<SyntheticRecorder>(params, saverThreadNum);
+    YuyvEncodeParams encodeParams;
+    encodeParams.mode = stripe ? YuyvEncodeMode::Stripe : YuyvEncodeMode::Direct;
+    encodeParams.subsampling = gray ? JpegSubsampling::Gray : JpegSubsampling::S422;
+    encodeParams.roi = roi;
+    encodeParams.binning = binning;
+    recorder->setEncodeParams(encodeParams);
+    if (adaptive) {
+        // each saver thread encodes one of every N frames, leave some time for saving
+        AdaptiveEncodeParams adaptiveParams;
+        adaptiveParams.encodeBudget = 0.8 * saverThreadNum / params.fps;
+        adaptiveParams.gray = gray;
+        recorder->setEncodeController(make_shared<AdaptiveEncodeController>(adaptiveParams));
+    }
+    recorder->init();
+
+    // create save folder
+    bool save = !saveRootFolder.empty();
+    fs::path rootPath, imageSavePath, imuSavePath;
+    ImuWriterParams imuWriterParams;
+    imuWriterParams.format = imuBinary ? ImuFileFormat::Binary : ImuFileFormat::Csv;
+    ImuCsvWriter imuWriter(imuWriterParams);
+    shared_ptr<AsyncFileSink> sink = asyncSink ? make_shared<AsyncFileSink>() : nullptr;
+    ContainerParams containerParams;
+    containerParams.directIo = directIo;
+    containerParams.segmentDuration = segmentDuration;
+    containerParams.rollingBudget = static_cast<uint64_t>(rollingBudget * 1024 * 1024 * 1024);
+    ImageContainerWriter imageContainer(containerParams);
+    imageContainer.setSink(sink);
+    if (save) {
+        rootPath = fs::weakly_canonical(saveRootFolder);
+        imageSavePath = rootPath / (container ? "left.container" : "left");
+        imuSavePath = rootPath / (imuBinary ? "imu.bin" : "imu.csv");
+        fs::remove_all(rootPath);
+        cout << format("image path: {}", imageSavePath.string()) << endl;
+        if (!fs::create_directories(imageSavePath)) {
+            LOG(ERROR) << format("cannot create folder \"{}\" to save image", imageSavePath.string());
+        }
+        // geometry of encoded image, which gives the intrinsics after ROI crop and binning
+        saveJson(recorder->encodeGeometry(), (rootPath / "geometry.json").string());
+        if (container) {
+            CHECK(imageContainer.open(imageSavePath.string()))
+                << format("cannot open container \"{}\" to save image", imageSavePath.string());
+        }
+        CHECK(imuWriter.open(imuSavePath.string()))
+            << format("cannot open file \"{}\" to save IMU data", imuSavePath.string());
+    }
+
+    // save image and IMU
+    auto saveImage = [&](const RawImageRecord& raw, size_t) {
+        if (save && container) {
+            imageContainer.append(raw.timestamp(), raw.reading().buffer(), raw.reading().size());
+        } else if (save && sink) {
+            sink->writeFile(format("{}/{:.0f}.jpg", imageSavePath.string(), raw.timestamp() * 1E9), raw.reading());
+        } else if (save) {
+            string fileName = format("{}/{:.0f}.jpg", imageSavePath.string(), raw.timestamp() * 1E9);
+            fstream fs(fileName, ios::out | ios::binary);
+            if (!fs.is_open()) {
+                LOG(ERROR) << format("cannot create file \"{}\"", fileName);
+            }
+            fs.write(reinterpret_cast<const char*>(raw.reading().buffer()), raw.reading().size());
+            fs.close();
+        }
+    };
+    auto saveImu = [&](const ImuRecord& imu) {
+        if (save) {
+            imuWriter.write(imu);
+        }
+    };
+
+    // pre-trigger buffer, the data is saved through it if enabled
+    unique_ptr<TriggerBuffer> trigger;
+    if (triggerParams.preTrigger > 0) {
+        trigger = make_unique<TriggerBuffer>(triggerParams, saveImage, saveImu);
+        triggerBuffer = trigger.get();
+        signal(SIGUSR1, onTriggerSignal);
+    }
+
+    // set process function for image
+    atomic<size_t> imageNum{0};    // processed image number
+    atomic<size_t> imageBytes{0};  // total JPEG size
+    recorder->setProcessFunction([&](const RawImageRecord& raw) {
+        ++imageNum;
+        imageBytes += raw.reading().size();
+        if (trigger) {
+            trigger->push(raw);
+        } else {
+            saveImage(raw, 0);
+        }
+    });
+
+    // set process function for IMU
+    atomic<size_t> imuNum{0};  // processed IMU number
+    recorder->setProcessFunction([&](const ImuRecord& imu) {
+        ++imuNum;
+        if (trigger) {
+            trigger->push(imu);
+        } else {
+            saveImu(imu);
+        }
+    });
+
+    // run until all frames are generated
+    auto t0 = chrono::steady_clock::now();
+    recorder->start();
+    recorder->wait();
+    double usedTime = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    imuWriter.close();
+    imageContainer.close();
+    if (sink) {
+        sink->wait();
+    }
+
+    // print statistics
+    cout << Section("Statistics");
+    cout << format("used time = {:.3f} s", usedTime) << endl;
+    cout << format("generated frame = {}, dropped at sensor = {}", recorder->generatedFrameNum(),
+                   recorder->droppedFrameNum())
+         << endl;
+    cout << format("processed image = {}, FPS = {:.2f} Hz, average size = {:.1f} KB", imageNum.load(),
+                   imageNum / usedTime, imageNum == 0 ? 0. : imageBytes / 1024.0 / imageNum)
+         << endl;
+    cout << format("processed IMU = {}", imuNum.load()) << endl;
+    cout << format("image queue: {}", recorder->imageQueueStats()) << endl;
+    cout << format("IMU queue: {}", recorder->imuQueueStats()) << endl;
+    if (recorder->encodeController()) {
+        cout << format("encode level = {}, change number = {}", recorder->encodeController()->level(),
+                       recorder->encodeController()->changeNum())
+             << endl;
+    }
+    if (trigger) {
+        cout << format("trigger number = {}, dropped image by budget = {}", trigger->triggerNum(),
+                       trigger->droppedImageNum())
+             << endl;
+    }
+    if (container) {
+        cout << format("image container: segment = {}, deleted segment = {}", imageContainer.segmentNum(),
+                       imageContainer.deletedSegmentNum())
+             << endl;
+    }
+    if (sink) {
+        cout << format("async sink: backend = {}, completed write = {}, failed write = {}", toString(sink->backend()),
+                       sink->completedNum(), sink->errorNum())
+             << endl;
+    }
+    cout << format("image pipeline latency:\n{}", *recorder->frameTracer()) << endl;
+    if (!traceFile.empty()) {
+        recorder->frameTracer()->save(traceFile);
+    }
+    if (!timelineFile.empty()) {
+        TraceRecorder::instance().save(timelineFile);
+    }
+
+    return 0;
+}
@@ -0,0 +1,211 @@
+/**
+ * @brief Benchmark code for thread pool
+ *
+ * One thread submits a lot of small tasks to the thread pool with 1 - 8 workers, which is like the per-frame or
+ * per-stripe work in recorders. The throughput and the latency from submitting to starting task are compared between
+ * the previous thread pool(one global queue of `std::function` and one `shared_ptr<packaged_task>` per task) and the
+ * work-stealing `ThreadPool` with `addTask()` and `post()`.
+ */
+
+#include <fmt/format.h>
+#include <glog/logging.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cxxopts.hpp>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#include "libra/util.hpp"
+
+using namespace std;
+using namespace std::chrono;
+using namespace libra::util;
+
+/**
+ * @brief The previous thread pool, with one global task queue and mutex, used as baseline
+ */
+class LegacyThreadPool {
+  public:
+    explicit LegacyThreadPool(size_t threadNum) {
+        for (size_t i = 0; i < threadNum; ++i) {
+            workers_.emplace_back([this] {
+                while (true) {
+                    function<void()> task;
+                    {
+                        unique_lock<mutex> lock(mutex_);
+                        taskCondition_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+                        if (stop_ && tasks_.empty()) {
+                            return;
+                        }
+                        task = move(tasks_.front());
+                        tasks_.pop();
+                        ++activeWorkerNum_;
+                    }
+                    task();
+                    {
+                        unique_lock<mutex> lock(mutex_);
+                        --activeWorkerNum_;
+                    }
+                    finishCondition_.notify_all();
+                }
+            });
+        }
+    }
+
+    ~LegacyThreadPool() {
+        {
+            unique_lock<mutex> lock(mutex_);
+            stop_ = true;
+        }
+        taskCondition_.notify_all();
+        for (auto& w : workers_) {
+            w.join();
+        }
+    }
+
+    template <class F>
+    future<result_of_t<F()>> addTask(F&& f) {
+        auto task = make_shared<packaged_task<result_of_t<F()>()>>(forward<F>(f));
+        auto result = task->get_future();
+        {
+            unique_lock<mutex> lock(mutex_);
+            tasks_.emplace([task]() { (*task)(); });
+        }
+        taskCondition_.notify_one();
+        return result;
+    }
+
+    void wait() {
+        unique_lock<mutex> lock(mutex_);
+        finishCondition_.wait(lock, [this] { return tasks_.empty() && activeWorkerNum_ == 0; });
+    }
+
+  private:
+    vector<thread> workers_;
+    queue<function<void()>> tasks_;
+    bool stop_ = false;
+    int activeWorkerNum_ = 0;
+    mutex mutex_;
+    condition_variable taskCondition_;
+    condition_variable finishCondition_;
+};
+
+/**
+ * @brief Benchmark result
+ */
+struct Result {
+    double throughput = 0;  // throughput, task/s
+    double p50 = 0;         // 50th percentile latency from submitting to starting, us
+    double p99 = 0;         // 99th percentile latency, us
+    double max = 0;         // maximum latency, us
+};
+
+/**
+ * @brief Simulate the work of task
+ *
+ * @param work  Work iterations
+ * @return Dummy result to avoid optimized out
+ */
+unsigned int doWork(int work) {
+    unsigned int sum{0};
+    for (int i = 0; i < work; ++i) {
+        sum += i * i;
+    }
+    return sum;
+}
+
+/**
+ * @brief Run benchmark for one pool
+ *
+ * @tparam Submit   Function to submit one task to pool
+ * @param pool      Thread pool
+ * @param submit    Function to submit one task, with the signature `void(Pool&, Task)`
+ * @param taskNum   Task number
+ * @param work      Work iterations for each task
+ * @return Benchmark result
+ */
+template <typename Pool, typename Submit>
+Result benchmark(Pool& pool, Submit submit, int taskNum, int work) {
+    vector<double> latency(taskNum);
+    atomic<unsigned int> sum{0};
+    auto t0 = steady_clock::now();
+    for (int i = 0; i < taskNum; ++i) {
+        auto t = steady_clock::now();
+        // capture 3 pointers and one time point, which fits in the inline buffer of `Task`
+        submit(pool, [&latency, &sum, i, t, work]() {
+            latency[i] = duration_cast<duration<double, micro>>(steady_clock::now() - t).count();
+            sum.fetch_add(doWork(work), memory_order_relaxed);
+        });
+    }
+    pool.wait();
+    double usedTime = duration_cast<duration<double>>(steady_clock::now() - t0).count();
+
+    Result result;
+    result.throughput = taskNum / usedTime;
+    sort(latency.begin(), latency.end());
+    result.p50 = latency[taskNum / 2];
+    result.p99 = latency[static_cast<size_t>(taskNum * 0.99)];
+    result.max = latency.back();
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    cout << Title("Thread Pool Benchmark") << endl;
+    google::InitGoogleLogging(argv[0]);
+    FLAGS_alsologtostderr = true;
+    FLAGS_colorlogtostderr = true;
+
+    // argument parser
+    cxxopts::Options options(argv[0], "Thread Pool Benchmark");
+    // clang-format off
+    options.add_options()
+        ("taskNum", "task number for each test", cxxopts::value<int>()->default_value("200000"))
+        ("work", "work iterations for each task", cxxopts::value<int>()->default_value("100"))
+        ("h,help", "help message");
+    // clang-format on
+    auto result = options.parse(argc, argv);
+    if (result.count("help")) {
+        cout << options.help() << endl;
+        return 0;
+    }
+    int taskNum = result["taskNum"].as<int>();
+    int work = result["work"].as<int>();
+
+    // print input parameters
+    cout << Section("Input Parameters");
+    cout << fmt::format("task number = {}", taskNum) << endl;
+    cout << fmt::format("work iterations = {}", work) << endl;
+    cout << fmt::format("hardware concurrency = {}", thread::hardware_concurrency()) << endl;
+
+    // run benchmark
+    cout << Section("Benchmark");
+    cout << fmt::format("{:>7} | {:>18} | {:>10} | {:>10} | {:>10} | {:>10}", "thread", "pool", "task/s", "p50(us)",
+                        "p99(us)", "max(us)")
+         << endl;
+    auto print = [](size_t threadNum, const string& name, const Result& r) {
+        cout << fmt::format("{:>7} | {:>18} | {:>10.0f} | {:>10.2f} | {:>10.2f} | {:>10.1f}", threadNum, name,
+                            r.throughput, r.p50, r.p99, r.max)
+             << endl;
+    };
+    for (size_t threadNum : {1, 2, 4, 8}) {
+        {
+            LegacyThreadPool pool(threadNum);
+            print(threadNum, "legacy addTask",
+                  benchmark(pool, [](LegacyThreadPool& p, auto&& f) { p.addTask(move(f)); }, taskNum, work));
+        }
+        {
+            ThreadPool pool(threadNum);
+            print(threadNum, "addTask", benchmark(pool, [](ThreadPool& p, auto&& f) { p.addTask(move(f)); }, taskNum,
+                                                  work));
+            print(threadNum, "post", benchmark(pool, [](ThreadPool& p, auto&& f) { p.post(move(f)); }, taskNum, work));
+        }
+    }
+
+    return 0;
+}
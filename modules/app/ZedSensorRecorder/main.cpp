@@ -9,8 +9,8 @@
 #include <iostream>
 #include <mutex>
 #include <opencv2/highgui.hpp>
-#include <opencv2/imgcodecs.hpp>
 #include "libra/io.hpp"
+#include "libra/util/Serialization.hpp"
 
 using namespace std;
 using namespace fmt;
@@ -24,8 +24,9 @@ namespace fs = boost::filesystem;
  * @brief Image save format
  */
 enum class ImageSaveFormat {
-    Kalibr,  // kalibr format, <timestamp(ns)>
-    Index,   // index
+    Kalibr,     // kalibr format, <timestamp(ns)>
+    Index,      // index
+    Container,  // append-only image container, see `ImageContainerWriter`
 };
 
 int main(int argc, char* argv[]) {
@@ -43,7 +44,26 @@ int main(int argc, char* argv[]) {
         ("fps", "FPS", cxxopts::value<int>()->default_value("30"))
         ("resolution", "resolution", cxxopts::value<string>()->default_value("HD720"))
         ("saverThreadNum", "thread number to save images for each camera", cxxopts::value<int>()->default_value("2"))
+        ("stripe", "encode each image in parallel stripes to reduce latency", cxxopts::value<bool>())
+        ("gray", "only encode the Y channel into grayscale JPEG, for monochrome calibration and SLAM",
+            cxxopts::value<bool>())
+        ("binning", "bin 2x2 pixels into one before encoding, 1 or 2", cxxopts::value<int>()->default_value("1"))
+        ("roi", "region of image to encode before binning, \"x,y,width,height\" in pixels, the whole image if it's "
+            "not set", cxxopts::value<vector<int>>())
+        ("adaptive", "adjust encode quality by the image queue size and encode time", cxxopts::value<bool>())
         ("showImage", "show image", cxxopts::value<bool>())
+        ("previewScale", "downscale factor of shown image, 1, 2, 4 or 8", cxxopts::value<int>()->default_value("4"))
+        ("container", "save images into append-only container instead of one file for each image",
+            cxxopts::value<bool>())
+        ("asyncSink", "write images by asynchronous file sink, so the saver threads don't wait for storage",
+            cxxopts::value<bool>())
+        ("directIo", "write image container with O_DIRECT, only used with container and async sink",
+            cxxopts::value<bool>())
+        ("imuBinary", "save IMU to binary file \"imu.bin\" instead of CSV file", cxxopts::value<bool>())
+        ("trace", "JSON file to save the latency of image pipeline stages at shutdown, don't save if it's empty",
+            cxxopts::value<string>()->default_value(""))
+        ("timeline", "Chrome trace JSON file to save the timeline of recorder threads at shutdown, don't trace if it's"
+            " empty", cxxopts::value<string>()->default_value(""))
         ("h,help", "help message");
     // clang-format on
     auto result = options.parse(argc, argv);
@@ -55,7 +75,28 @@ int main(int argc, char* argv[]) {
     int fps = result["fps"].as<int>();
     string resolution = result["resolution"].as<string>();
     int saverThreadNum = result["saverThreadNum"].as<int>();
+    bool stripe = result["stripe"].as<bool>();
+    bool gray = result["gray"].as<bool>();
+    int binning = result["binning"].as<int>();
+    ImageRoi roi;
+    if (result.count("roi")) {
+        auto v = result["roi"].as<vector<int>>();
+        if (v.size() != 4) {
+            cout << "ROI should be \"x,y,width,height\"" << endl << endl;
+            cout << options.help() << endl;
+            return 0;
+        }
+        roi = ImageRoi{v[0], v[1], v[2], v[3]};
+    }
+    bool adaptive = result["adaptive"].as<bool>();
     bool showImage = result["showImage"].as<bool>();
+    int previewScale = result["previewScale"].as<int>();
+    bool imuBinary = result["imuBinary"].as<bool>();
+    bool container = result["container"].as<bool>();
+    bool asyncSink = result["asyncSink"].as<bool>();
+    bool directIo = result["directIo"].as<bool>();
+    string traceFile = result["trace"].as<string>();
+    string timelineFile = result["timeline"].as<string>();
 
     // check fps
     vector<int> fpsList = {15, 30, 60, 100};
@@ -80,8 +121,16 @@ int main(int argc, char* argv[]) {
     cout << fmt::format("FPS = {} Hz", fps) << endl;
     cout << fmt::format("resolution = {}", resolution) << endl;
     cout << fmt::format("saver thread number = {}", saverThreadNum) << endl;
-    cout << fmt::format("show image: {}", showImage) << endl;
-    ImageSaveFormat saveFormat = ImageSaveFormat::Kalibr;  // save format
+    cout << fmt::format("stripe encode: {}", stripe) << endl;
+    cout << fmt::format("gray encode: {}", gray) << endl;
+    cout << fmt::format("ROI = ({}, {}, {}, {}), binning = {}", roi.x, roi.y, roi.width, roi.height, binning) << endl;
+    cout << fmt::format("adaptive encode: {}", adaptive) << endl;
+    cout << fmt::format("show image: {}, preview scale: 1/{}", showImage, previewScale) << endl;
+    cout << fmt::format("save to container: {}", container) << endl;
+    cout << fmt::format("async sink: {}, direct IO: {}", asyncSink, directIo) << endl;
+    cout << fmt::format("trace file: {}", traceFile) << endl;
+    cout << fmt::format("timeline file: {}", timelineFile) << endl;
+    ImageSaveFormat saveFormat = container ? ImageSaveFormat::Container : ImageSaveFormat::Kalibr;  // save format
 
     // parse resolution
     video::RESOLUTION res;
@@ -115,10 +164,24 @@ int main(int argc, char* argv[]) {
 
     // set and init
     cout << Section("Start Camera");
+    TraceRecorder::instance().setEnabled(!timelineFile.empty());
     auto recorder = make_shared<ZedOpenRecorder>(devices[0].first);
     recorder->setFps(static_cast<video::FPS>(fps));
     recorder->setResolution(res);
     recorder->setSaverThreadNum(saverThreadNum);
+    YuyvEncodeParams encodeParams;
+    encodeParams.mode = stripe ? YuyvEncodeMode::Stripe : YuyvEncodeMode::Direct;
+    encodeParams.subsampling = gray ? JpegSubsampling::Gray : JpegSubsampling::S422;
+    encodeParams.roi = roi;
+    encodeParams.binning = binning;
+    recorder->setEncodeParams(encodeParams);
+    if (adaptive) {
+        // each saver thread encodes one of every N frames, leave some time for saving
+        AdaptiveEncodeParams adaptiveParams;
+        adaptiveParams.encodeBudget = 0.8 * saverThreadNum / fps;
+        adaptiveParams.gray = gray;
+        recorder->setEncodeController(make_shared<AdaptiveEncodeController>(adaptiveParams));
+    }
 
     // init
     recorder->init();
@@ -130,9 +193,10 @@ int main(int argc, char* argv[]) {
     if (!fs::exists(rootPath)) {
         fs::create_directories(rootPath);
     }
-    auto leftImageSavePath = fs::weakly_canonical(rootPath / "left");
-    auto rightImageSavePath = fs::weakly_canonical(rootPath / "right");
-    auto imuSavePath = rootPath / "imu.csv";
+    auto leftImageSavePath = fs::weakly_canonical(rootPath / (container ? "left.container" : "left"));
+    auto rightImageSavePath = fs::weakly_canonical(rootPath / (container ? "right.container" : "right"));
+    auto imuSavePath = rootPath / (imuBinary ? "imu.bin" : "imu.csv");
+    auto encodeSavePath = rootPath / "encode.csv";
 
     // remove old files
     fs::remove_all(rootPath);
@@ -151,9 +215,27 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    // IMU file stream
+    // geometry of encoded image, which gives the intrinsics after ROI crop and binning
+    auto geometrySavePath = rootPath / "geometry.json";
+    cout << format("geometry path: {}", geometrySavePath.string()) << endl;
+    saveJson(recorder->encodeGeometry(), geometrySavePath.string());
+
+    // IMU writer
     cout << format("IMU path: {}", imuSavePath.string()) << endl;
-    fstream imuFileStream;
+    ImuWriterParams imuWriterParams;
+    imuWriterParams.format = imuBinary ? ImuFileFormat::Binary : ImuFileFormat::Csv;
+    ImuCsvWriter imuWriter(imuWriterParams);
+    // async file sink and image container
+    shared_ptr<AsyncFileSink> sink = asyncSink ? make_shared<AsyncFileSink>() : nullptr;
+    ContainerParams containerParams;
+    containerParams.directIo = directIo;
+    ImageContainerWriter leftContainer(containerParams), rightContainer(containerParams);
+    leftContainer.setSink(sink);
+    rightContainer.setSink(sink);
+    // encode information file stream, the encode information is saved when it's changed
+    fstream encodeFileStream;
+    EncodeInfo lastEncodeInfo;  // encode information of last saved image
+    mutex encodeFileMutex;
 
     // some variables
     atomic_long leftImageIndex{0};  // image index
@@ -163,20 +245,64 @@ int main(int argc, char* argv[]) {
     mutex showImageMutex;
     condition_variable showImageCv;
     cv::Mat leftImage, rightImage;
+    // downscaled preview decoded in low priority thread, it's only subscribed if the image is shown
+    PreviewParams previewParams;
+    previewParams.scaleDenom = previewScale;
+    PreviewStage preview(previewParams);
+    if (showImage) {
+        preview.subscribe([&](const PreviewImage& image) {
+            cv::Mat mat(image.height, image.width, image.channels == 1 ? CV_8UC1 : CV_8UC3,
+                        const_cast<unsigned char*>(image.data.data()));
+            unique_lock<mutex> lock(showImageMutex);
+            (image.camera == 0 ? leftImage : rightImage) = mat.clone();
+            showImageReady = true;
+            showImageCv.notify_one();
+        });
+    }
 
     // set callback function
     recorder->addCallback(ZedOpenRecorder::CallBackStarted, [&]() {
         // open IMU file
-        imuFileStream.open(imuSavePath.string(), ios::out);
-        CHECK(imuFileStream.is_open()) << format("cannot open file \"{}\" to save IMU data", imuSavePath.string());
-        // write header
-        imuFileStream << "#SensorTimestamp[ns],SystemTimestamp[ns],GyroX[rad/s],GyroY[rad/s],GyroZ[rad/s]"
-                         ",AccX[m/s^2],AccY[m/s^2],AccZ[m/s^2]"
-                      << endl;
+        CHECK(imuWriter.open(imuSavePath.string()))
+            << format("cannot open file \"{}\" to save IMU data", imuSavePath.string());
+        // open image container
+        if (container) {
+            CHECK(leftContainer.open(leftImageSavePath.string()))
+                << format("cannot open container \"{}\" to save left image", leftImageSavePath.string());
+        }
+        if (container && false && recorder->isRightCamEnabled()) {
+            CHECK(rightContainer.open(rightImageSavePath.string()))
+                << format("cannot open container \"{}\" to save right image", rightImageSavePath.string());
+        }
+
+        // open encode information file
+        if (adaptive) {
+            encodeFileStream.open(encodeSavePath.string(), ios::out);
+            CHECK(encodeFileStream.is_open())
+                << format("cannot open file \"{}\" to save encode information", encodeSavePath.string());
+            encodeFileStream << "#Timestamp[ns],Level,Quality,Subsampling" << endl;
+        }
     });
 
     // close file when finished
-    recorder->addCallback(ZedOpenRecorder::CallBackFinished, [&] { imuFileStream.close(); });
+    recorder->addCallback(ZedOpenRecorder::CallBackFinished, [&] {
+        imuWriter.close();
+        leftContainer.close();
+        rightContainer.close();
+        if (sink) {
+            sink->wait();
+        }
+        if (encodeFileStream.is_open()) {
+            encodeFileStream.close();
+        }
+        // save the latency of image pipeline stages
+        if (!traceFile.empty()) {
+            recorder->frameTracer()->save(traceFile);
+        }
+        if (!timelineFile.empty()) {
+            TraceRecorder::instance().save(timelineFile);
+        }
+    });
 
     // set process function for left camera
     recorder->setProcessFunction([&](const RawImageRecord& raw) {
@@ -189,30 +315,42 @@ int main(int argc, char* argv[]) {
             case ImageSaveFormat::Kalibr:
                 fileName = format("{}/{:.0f}.jpg", leftImageSavePath.string(), raw.timestamp() * 1E9);
                 break;
+            case ImageSaveFormat::Container:
+                leftContainer.append(raw.timestamp(), raw.reading().buffer(), raw.reading().size());
+                break;
             case ImageSaveFormat::Index: {
                 fileName = format("{}/{:06d}.jpg", leftImageSavePath.string(), leftImageIndex);
             }
             default:
                 break;
         }
-        // save to file
-        fstream fs(fileName, ios::out | ios::binary);
-        if (!fs.is_open()) {
-            LOG(ERROR) << format("cannot create file \"{}\"", fileName);
+        // save to file, the image is appended to container if the file name is empty
+        if (!fileName.empty() && sink) {
+            sink->writeFile(fileName, raw.reading());
+        } else if (!fileName.empty()) {
+            fstream fs(fileName, ios::out | ios::binary);
+            if (!fs.is_open()) {
+                LOG(ERROR) << format("cannot create file \"{}\"", fileName);
+            }
+            fs.write(reinterpret_cast<const char*>(raw.reading().buffer()), raw.reading().size());
+            fs.close();
         }
-        fs.write(reinterpret_cast<const char*>(raw.reading().buffer()), raw.reading().size());
-        fs.close();
-
-        // send image per 10 images
-        if (0 == leftImageIndex % 10) {
-            cv::Mat buf(1, raw.reading().size(), CV_8UC1, (void*)raw.reading().buffer());
-            leftImage = cv::imdecode(buf, cv::IMREAD_UNCHANGED);
 
-            unique_lock<mutex> lock(showImageMutex);
-            showImageReady = true;
-            showImageCv.notify_one();
+        // save encode information if it's changed
+        if (adaptive) {
+            lock_guard<mutex> lock(encodeFileMutex);
+            const EncodeInfo& info = raw.reading().encodeInfo();
+            if (info != lastEncodeInfo) {
+                encodeFileStream << format("{:.0f},{},{},{}", raw.timestamp() * 1E9, info.level, info.quality,
+                                           toString(info.subsampling))
+                                 << endl;
+                lastEncodeInfo = info;
+            }
         }
 
+        // preview image, it does nothing if the image isn't shown
+        preview.push(raw, 0);
+
 #if false
         // remove old files
         if (leftImageIndex != 0 && leftImageIndex % 200000 == 0) {
@@ -244,29 +382,29 @@ int main(int argc, char* argv[]) {
                 case ImageSaveFormat::Kalibr:
                     fileName = format("{}/{:.0f}.jpg", rightImageSavePath.string(), raw.timestamp() * 1.0E9);
                     break;
+                case ImageSaveFormat::Container:
+                    rightContainer.append(raw.timestamp(), raw.reading().buffer(), raw.reading().size());
+                    break;
                 case ImageSaveFormat::Index: {
                     fileName = format("{}/{:06d}.jpg", rightImageSavePath.string(), rightImageIndex);
                 }
                 default:
                     break;
             }
-            // save to file
-            fstream fs(fileName, ios::out | ios::binary);
-            if (!fs.is_open()) {
-                LOG(ERROR) << format("cannot create file \"{}\"", fileName);
+            // save to file, the image is appended to container if the file name is empty
+            if (!fileName.empty() && sink) {
+                sink->writeFile(fileName, raw.reading());
+            } else if (!fileName.empty()) {
+                fstream fs(fileName, ios::out | ios::binary);
+                if (!fs.is_open()) {
+                    LOG(ERROR) << format("cannot create file \"{}\"", fileName);
+                }
+                fs.write(reinterpret_cast<const char*>(raw.reading().buffer()), raw.reading().size());
+                fs.close();
             }
-            fs.write(reinterpret_cast<const char*>(raw.reading().buffer()), raw.reading().size());
-            fs.close();
 
-            // send image per 10 images
-            if (0 == rightImageIndex % 10) {
-                cv::Mat buf(1, raw.reading().size(), CV_8UC1, (void*)raw.reading().buffer());
-                rightImage = cv::imdecode(buf, cv::IMREAD_UNCHANGED);
-
-                unique_lock<mutex> lock(showImageMutex);
-                showImageReady = true;
-                showImageCv.notify_one();
-            }
+            // preview image, it does nothing if the image isn't shown
+            preview.push(raw, 1);
 
             ++rightImageIndex;
         });
@@ -274,38 +412,39 @@ int main(int argc, char* argv[]) {
 
     // set process funcion for IMU
     recorder->setProcessFunction([&](const ImuRecord& imu) {
-        // format: sensor timestamp(ns), system timstamp(ns), gyro(rad/s), acc(m/s^2)
-        imuFileStream << format("{:.0f},{:.0f},{:.10f},{:.10f},{:.10f},{:.10f},{:.10f},{:.10f}",
-                                imu.timestamp() * 1.0E9, imu.systemTimestamp().value_or(0) * 1.0E9,
-                                imu.reading().gyro()[0], imu.reading().gyro()[1], imu.reading().gyro()[2],
-                                imu.reading().acc()[0], imu.reading().acc()[1], imu.reading().acc()[2])
-                      << endl;
+        imuWriter.write(imu);
     });
 
     // start
     recorder->start();
 
-    // wait stop
-    while (true) {
+    // wait stop, the recorder runs until it's killed if the image isn't shown
+    if (!showImage) {
+        recorder->wait();
+    }
+    while (showImage) {
+        cv::Mat left, right;
         {
             unique_lock<mutex> lock(showImageMutex);
             showImageCv.wait(lock, [&]() { return showImageReady; });
             showImageReady = false;
+            left = leftImage;
+            right = rightImage;
         }
 
         // show image
-        if (showImage) {
-            cv::imshow("Left Image", leftImage);
-            if (recorder->isRightCamEnabled()) {
-                cv::imshow("Right Image", rightImage);
-            }
-            int ret = cv::waitKey(1);
+        if (!left.empty()) {
+            cv::imshow("Left Image", left);
+        }
+        if (recorder->isRightCamEnabled() && !right.empty()) {
+            cv::imshow("Right Image", right);
+        }
+        int ret = cv::waitKey(1);
 
-            if (ret == 'Q' || ret == 'q') {
-                recorder->stop();
-                recorder->wait();
-                break;
-            }
+        if (ret == 'Q' || ret == 'q') {
+            recorder->stop();
+            recorder->wait();
+            break;
         }
     }
 
@@ -0,0 +1,32 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+namespace libra {
+namespace core {
+
+/**
+ * @brief Monotonic timestamps of one frame when it passes each stage of recording pipeline, used to find where the
+ * frame spends its time. The unit is ns of steady clock, and 0 means the stage isn't reached or traced
+ */
+struct FrameTrace {
+    std::int64_t capture = 0;  //!< the frame is captured from device or generated
+    std::int64_t enqueue = 0;  //!< the frame is pushed into image queue
+    std::int64_t dequeue = 0;  //!< the frame is popped from image queue by saver thread
+    std::int64_t convert = 0;  //!< the frame is converted from YUYV, the same with dequeue if it's fused with encode
+    std::int64_t encode = 0;   //!< the frame is encoded to JPEG
+    std::int64_t sink = 0;     //!< the process function of frame returns, i.e., the frame is written by app
+
+    /**
+     * @brief Get the current time of steady clock
+     *
+     * @return Current time, ns
+     */
+    static inline std::int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+};
+
+}  // namespace core
+}  // namespace libra
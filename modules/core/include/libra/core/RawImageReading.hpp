@@ -1,12 +1,63 @@
 #pragma once
 #include <fmt/format.h>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
 #include <utility>
+#include "FrameTrace.hpp"
 
 namespace libra {
 namespace core {
 
 /**
- * @brief Raw image reading, include a raw image buffer pointer and its corresponding size
+ * @brief Chroma subsampling of JPEG image
+ */
+enum class JpegSubsampling {
+    S422,  //!< YUV 4:2:2, the same with YUYV input
+    S420,  //!< YUV 4:2:0, the chroma of two rows are averaged
+    Gray,  //!< grayscale, only the Y channel
+};
+
+/**
+ * @brief Convert chroma subsampling to string
+ * @param subsampling   Chroma subsampling
+ * @return Subsampling string
+ */
+inline std::string toString(JpegSubsampling subsampling) {
+    switch (subsampling) {
+        case JpegSubsampling::S420:
+            return "420";
+        case JpegSubsampling::Gray:
+            return "gray";
+        default:
+            return "422";
+    }
+}
+
+/**
+ * @brief Encode information of one JPEG image, which records the quality used for this frame if the encode quality is
+ * adjusted during recording
+ */
+struct EncodeInfo {
+    int quality = 0;                                      //!< JPEG quality, 0 if unknown
+    JpegSubsampling subsampling = JpegSubsampling::S422;  //!< chroma subsampling
+    int level = 0;                                        //!< adaptive encode level, 0 for the best quality
+
+    inline bool operator==(const EncodeInfo& info) const {
+        return quality == info.quality && subsampling == info.subsampling && level == info.level;
+    }
+    inline bool operator!=(const EncodeInfo& info) const { return !(*this == info); }
+};
+
+/**
+ * @brief Raw image reading, include a raw image buffer pointer and its corresponding size.
+ *
+ * The reading could optionally own the buffer by a ref-counted handle with custom releaser, for example, a buffer leased
+ * from buffer pool, a buffer allocated by turbojpeg and released by `tjFree()`, or the image object of camera SDK which
+ * holds the buffer. Then the buffer will be valid until the last copy of this reading is destroyed, and the reading
+ * could be passed through queues or to several sinks without copying the buffer. Otherwise the buffer is only valid in
+ * the process function of recorder, use `owned()` to get an owning copy if the buffer should be kept longer.
  */
 class RawImageReading {
   public:
@@ -19,6 +70,40 @@ class RawImageReading {
     explicit RawImageReading(unsigned char* buffer = nullptr, const unsigned long& size = 0)
         : buffer_(buffer), size_(size) {}
 
+    /**
+     * @brief Construct raw image reading with shared data buffer and its corresponding size
+     *
+     * @param data    Shared raw image buffer
+     * @param size    Buffer size
+     */
+    explicit RawImageReading(std::shared_ptr<unsigned char> data, const unsigned long& size)
+        : buffer_(data.get()), size_(size), data_(std::move(data)) {}
+
+    /**
+     * @brief Construct raw image reading which owns the data buffer, the releaser will be called to release the buffer
+     * when the last copy of reading is destroyed
+     *
+     * @param buffer    Raw image buffer pointer
+     * @param size      Buffer size
+     * @param releaser  Function to release the buffer, for example, `tjFree`
+     */
+    explicit RawImageReading(unsigned char* buffer, const unsigned long& size,
+                             std::function<void(unsigned char*)> releaser)
+        : buffer_(buffer), size_(size), data_(buffer, std::move(releaser)) {}
+
+    /**
+     * @brief Construct raw image reading which keeps the owner of data buffer alive, for example, the image of camera
+     * SDK. No extra allocation for the releaser, the reference count of owner is shared
+     *
+     * @tparam T        Owner type
+     * @param owner     Owner of the data buffer
+     * @param buffer    Raw image buffer pointer, which is owned by owner
+     * @param size      Buffer size
+     */
+    template <typename T>
+    explicit RawImageReading(const std::shared_ptr<T>& owner, unsigned char* buffer, const unsigned long& size)
+        : buffer_(buffer), size_(size), data_(owner, buffer) {}
+
     /**
      * @brief Destructor
      */
@@ -30,6 +115,57 @@ class RawImageReading {
     inline unsigned char*& buffer() { return buffer_; }
     inline const unsigned long& size() const { return size_; }
     inline unsigned long& size() { return size_; }
+    inline const std::shared_ptr<unsigned char>& data() const { return data_; }
+    inline const EncodeInfo& encodeInfo() const { return encodeInfo_; }
+    inline const FrameTrace& trace() const { return trace_; }
+
+    /**
+     * @brief Check whether the data buffer is owned by this reading, then it's valid as long as this reading is alive
+     * @return True if the data buffer is owned
+     */
+    inline bool isOwned() const { return data_.use_count() != 0 && data_.get() == buffer_; }
+
+    /**
+     * @brief Get the reading which owns the data buffer. Return itself if it has owned the buffer, otherwise copy the
+     * buffer into a new allocated one
+     *
+     * @return Raw image reading owns the data buffer
+     */
+    RawImageReading owned() const {
+        if (isOwned() || buffer_ == nullptr) {
+            return *this;
+        }
+        std::shared_ptr<unsigned char> data(new unsigned char[size_], std::default_delete<unsigned char[]>());
+        std::memcpy(data.get(), buffer_, size_);
+        RawImageReading reading(std::move(data), size_);
+        reading.encodeInfo_ = encodeInfo_;
+        reading.trace_ = trace_;
+        return reading;
+    }
+
+    /**
+     * @brief Set the shared data buffer and its corresponding size, the buffer pointer will point to the shared buffer
+     *
+     * @param data    Shared raw image buffer
+     * @param size    Buffer size
+     */
+    void setData(std::shared_ptr<unsigned char> data, const unsigned long& size) {
+        buffer_ = data.get();
+        size_ = size;
+        data_ = std::move(data);
+    }
+
+    /**
+     * @brief Set the encode information of image
+     * @param info  Encode information
+     */
+    void setEncodeInfo(const EncodeInfo& info) { encodeInfo_ = info; }
+
+    /**
+     * @brief Set the timestamps of pipeline stages of image
+     * @param trace Frame trace
+     */
+    void setTrace(const FrameTrace& trace) { trace_ = trace; }
 
     /**
      * @brief Print raw image reading to output stream
@@ -39,12 +175,19 @@ class RawImageReading {
      */
     friend std::ostream& operator<<(std::ostream& os, const RawImageReading& imageReading) {
         os << fmt::format("size = {}", imageReading.size());
+        if (imageReading.encodeInfo_.quality != 0) {
+            os << fmt::format(", quality = {}, subsampling = {}, level = {}", imageReading.encodeInfo_.quality,
+                              toString(imageReading.encodeInfo_.subsampling), imageReading.encodeInfo_.level);
+        }
         return os;
     }
 
   private:
-    unsigned char* buffer_;  // image buffer
-    unsigned long size_;     // image buffer size
+    unsigned char* buffer_;                // image buffer
+    unsigned long size_;                   // image buffer size
+    std::shared_ptr<unsigned char> data_;  // owner handle of image buffer, could be empty if the buffer isn't owned
+    EncodeInfo encodeInfo_;                // encode information
+    FrameTrace trace_;                     // timestamps of pipeline stages
 };
 
 }  // namespace core
@@ -73,7 +73,7 @@ class Record {
      * @brief Set sensor reading
      * @param reading Sensor reading
      */
-    void setReading(const T& reading) { reading_ = reading_; }
+    void setReading(const T& reading) { reading_ = reading; }
 
     /**
      * @brief Set timestamp using move syntax
@@ -91,7 +91,7 @@ class Record {
      * @brief Set sensor reading using move syntax
      * @param reading Sensor reading
      */
-    void setReading(T&& reading) { reading_ = move(reading_); }
+    void setReading(T&& reading) { reading_ = std::move(reading); }
 
     /**
      * @brief Print record to output stream
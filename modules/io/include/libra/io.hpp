@@ -1,5 +1,18 @@
 #pragma once
+#include "io/AsyncFileSink.h"
 #include "io/IRecorder.hpp"
+#include "io/ImageContainer.h"
+#include "io/ImuCsvWriter.h"
+#include "io/ReplayRecorder.h"
+#include "io/TriggerBuffer.h"
+
+#ifdef WITH_TURBOJPEG
+#include "io/AdaptiveEncodeController.h"
+#include "io/FrameEncoder.h"
+#include "io/PreviewStage.h"
+#include "io/SyntheticRecorder.h"
+#include "io/YuyvJpegEncoder.h"
+#endif
 
 #ifdef WITH_MYNTEYE_DEPTH
 #include "io/MyntEyeRecorder.h"
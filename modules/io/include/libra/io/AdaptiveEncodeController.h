@@ -0,0 +1,113 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "libra/core/RawImageReading.hpp"
+#include "libra/io/YuyvJpegEncoder.h"
+
+namespace libra {
+namespace io {
+
+/**
+ * @brief One encode level of adaptive encode controller
+ */
+struct EncodeLevel {
+    int quality = 95;                                                 //!< JPEG quality, [1, 100]
+    core::JpegSubsampling subsampling = core::JpegSubsampling::S422;  //!< chroma subsampling
+};
+
+/**
+ * @brief Parameters for adaptive encode controller
+ */
+struct AdaptiveEncodeParams {
+    //! encode levels from the best quality to the fastest, the level is stepped one by one
+    std::vector<EncodeLevel> levels = {
+        {95, core::JpegSubsampling::S422}, {85, core::JpegSubsampling::S422}, {75, core::JpegSubsampling::S422},
+        {75, core::JpegSubsampling::S420}, {60, core::JpegSubsampling::S420}, {60, core::JpegSubsampling::Gray},
+    };
+    std::size_t highWaterSize = 10;  //!< the encoder is overloaded if the queue size is larger than it
+    std::size_t lowWaterSize = 2;    //!< the encoder is idle if the queue size isn't larger than it
+    double encodeBudget = 0;  //!< time budget to encode one frame in one saver thread, s. 0 to only check queue size
+    int downFrameNum = 5;     //!< step down if the encoder is overloaded for this number of consecutive frames
+    int upFrameNum = 90;      //!< step up if the encoder is idle for this number of consecutive frames
+    //! keep grayscale in all levels for monochrome recording, only the quality is adjusted and the consecutive levels
+    //! with the same quality are collapsed into one
+    bool gray = false;
+};
+
+/**
+ * @brief Controller to adjust the encode quality by the depth of image queue and the encode time, so the recorder
+ * degrades the image quality gracefully instead of dropping frames when the CPU or disk falls behind.
+ *
+ * The image saver threads apply the current level to encoder before encoding each frame, then report the queue size and
+ * encode time after encoding. If the encoder is overloaded for several consecutive frames, it steps down to a faster
+ * level(lower quality, YUV420 or grayscale), and steps up after the encoder is idle for a longer time. The encode
+ * information of each frame is recorded in `RawImageReading::encodeInfo()`.
+ *
+ * @note The controller is thread safe, and could be shared by the saver threads of all cameras
+ */
+class AdaptiveEncodeController {
+  public:
+    /**
+     * @brief Constructor
+     * @param params    Adaptive encode parameters, the levels shouldn't be empty
+     */
+    explicit AdaptiveEncodeController(const AdaptiveEncodeParams& params = AdaptiveEncodeParams());
+
+    // non-copyable
+    AdaptiveEncodeController(const AdaptiveEncodeController&) = delete;
+    AdaptiveEncodeController& operator=(const AdaptiveEncodeController&) = delete;
+
+  public:
+    /**
+     * @brief Get the adaptive encode parameters, the levels are collapsed in grayscale mode
+     * @return Adaptive encode parameters
+     */
+    inline const AdaptiveEncodeParams& params() const { return params_; }
+
+    /**
+     * @brief Get the current level, 0 for the best quality
+     * @return Current level
+     */
+    inline int level() const { return level_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get the number of level changes
+     * @return Level change number
+     */
+    inline std::size_t changeNum() const { return changeNum_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get the encode information of current level
+     * @return Encode information
+     */
+    core::EncodeInfo encodeInfo() const;
+
+    /**
+     * @brief Apply the current level to encode parameters
+     * @param params    Encode parameters, the quality and subsampling are changed
+     * @return Encode information of current level
+     */
+    core::EncodeInfo apply(YuyvEncodeParams& params) const;
+
+    /**
+     * @brief Update the controller after encoding one frame
+     * @param queueSize     Size of image queue after popping this frame
+     * @param encodeTime    Time to encode this frame, s
+     * @return True if the level is changed
+     */
+    bool update(std::size_t queueSize, double encodeTime);
+
+  private:
+    AdaptiveEncodeParams params_;         // parameters
+    std::atomic<int> level_;              // current level
+    std::atomic<std::size_t> changeNum_;  // level change number
+
+    std::mutex mutex_;   // mutex for the states below
+    double encodeTime_;  // moving average of encode time in current level, s. Negative if no frame is encoded yet
+    int overloadNum_;    // number of consecutive overloaded frames
+    int idleNum_;        // number of consecutive idle frames
+};
+
+}  // namespace io
+}  // namespace libra
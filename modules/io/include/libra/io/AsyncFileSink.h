@@ -0,0 +1,171 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "libra/core/RawImageReading.hpp"
+#include "libra/util/ThreadPool.h"
+
+namespace libra {
+namespace io {
+
+/**
+ * @brief Backend of asynchronous file sink
+ */
+enum class AsyncSinkBackend {
+    ThreadPool,  //!< blocking writes in thread pool
+    IoUring,     //!< batched writes through io_uring
+};
+
+/**
+ * @brief Get the name of sink backend
+ *
+ * @param backend   Sink backend
+ * @return Name of sink backend
+ */
+std::string toString(AsyncSinkBackend backend);
+
+/**
+ * @brief Parameters of asynchronous file sink
+ */
+struct AsyncSinkParams {
+    std::size_t threadNum = 2;    //!< worker thread number for file writes, and positional writes without io_uring
+    std::size_t queueDepth = 64;  //!< maximum in-flight write number, the submission blocks if it's reached
+    bool useIoUring = true;       //!< use io_uring for positional writes if it's supported by kernel
+};
+
+/**
+ * @brief Asynchronous file sink, which moves the storage I/O out of the saver threads, so the encoding doesn't wait for
+ * the disk unless the in-flight writes reach the queue depth.
+ *
+ * There are two kinds of writes. `writeFile()` creates one file for the image, which is metadata bound and done by the
+ * blocking syscalls in thread pool. `write()` writes the buffer to opened file at offset, which is used by the image
+ * container. It's submitted to io_uring in batch if it's compiled with `WITH_IO_URING` and supported by kernel,
+ * otherwise it falls back to the thread pool. The callback is called in the sink thread after the write is completed,
+ * and the image reading held by sink is released before it, so the pooled buffer is recycled as soon as it's written.
+ * The callback should be short and shouldn't submit new writes, which may block the sink thread.
+ */
+class AsyncFileSink {
+  public:
+    /**
+     * @brief Callback after write is completed
+     * @param success   True if all the data is written
+     */
+    using Callback = std::function<void(bool success)>;
+
+  public:
+    /**
+     * @brief Constructor
+     * @param params    Sink parameters
+     */
+    explicit AsyncFileSink(const AsyncSinkParams& params = AsyncSinkParams());
+
+    /**
+     * @brief Destructor, wait all the writes are completed
+     */
+    ~AsyncFileSink();
+
+    // non-copyable
+    AsyncFileSink(const AsyncFileSink&) = delete;
+    AsyncFileSink& operator=(const AsyncFileSink&) = delete;
+
+  public:
+    /**
+     * @brief Get the sink parameters
+     * @return Sink parameters
+     */
+    inline const AsyncSinkParams& params() const { return params_; }
+
+    /**
+     * @brief Get the backend used for positional writes
+     * @return Sink backend
+     */
+    inline AsyncSinkBackend backend() const { return backend_; }
+
+    /**
+     * @brief Get the number of in-flight writes
+     * @return In-flight write number
+     */
+    std::size_t inflightNum() const;
+
+    /**
+     * @brief Get the number of completed writes
+     * @return Completed write number
+     */
+    inline std::size_t completedNum() const { return completedNum_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get the number of failed writes
+     * @return Failed write number
+     */
+    inline std::size_t errorNum() const { return errorNum_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Create the file and write the image into it asynchronously. The reading is copied if it doesn't own the
+     * buffer, and is held by sink until the write is completed
+     *
+     * @param file      File path
+     * @param reading   Image reading
+     * @param callback  Callback after write is completed, could be empty
+     */
+    void writeFile(const std::string& file, const core::RawImageReading& reading, Callback callback = nullptr);
+
+    /**
+     * @brief Write the buffer to file at offset asynchronously, the buffer and file descriptor should be valid until
+     * the callback is called
+     *
+     * @param fd        File descriptor
+     * @param data      Data buffer
+     * @param size      Data size, bytes
+     * @param offset    File offset, bytes
+     * @param callback  Callback after write is completed, could be empty
+     */
+    void write(int fd, const void* data, std::size_t size, std::uint64_t offset, Callback callback = nullptr);
+
+    /**
+     * @brief Wait all the submitted writes are completed
+     */
+    void wait();
+
+  private:
+    struct IoUring;  // io_uring instance
+    struct Request;  // positional write request
+
+    /**
+     * @brief Wait for a free slot of in-flight writes, and occupy it
+     */
+    void acquire();
+
+    /**
+     * @brief Release the slot of in-flight write after it's completed, and run its callback
+     *
+     * @param success   True if the write is success
+     * @param callback  Callback of write, it's destroyed before releasing the slot
+     */
+    void complete(bool success, Callback callback);
+
+    /**
+     * @brief Loop of io_uring thread, which submits the pending requests and reaps the completions
+     */
+    void ringLoop();
+
+  private:
+    AsyncSinkParams params_;                  // sink parameters
+    AsyncSinkBackend backend_;                // backend for positional writes
+    std::unique_ptr<util::ThreadPool> pool_;  // thread pool for blocking writes
+    std::unique_ptr<IoUring> ring_;           // io_uring instance, null if not used
+    std::thread ringThread_;                  // thread to submit and reap io_uring requests
+
+    mutable std::mutex mutex_;               // mutex for in-flight count
+    std::condition_variable inflightCv_;     // condition variable for in-flight count
+    std::size_t inflightNum_;                // in-flight write number
+    std::atomic<std::size_t> completedNum_;  // completed write number
+    std::atomic<std::size_t> errorNum_;      // failed write number
+};
+
+}  // namespace io
+}  // namespace libra
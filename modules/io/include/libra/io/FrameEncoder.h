@@ -0,0 +1,67 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include "libra/core/FrameTrace.hpp"
+#include "libra/core/Record.hpp"
+#include "libra/io/AdaptiveEncodeController.h"
+#include "libra/io/YuyvJpegEncoder.h"
+#include "libra/util/BufferPool.h"
+#include "libra/util/ThreadPool.h"
+
+namespace libra {
+namespace io {
+
+/**
+ * @brief Encoder of the image saver threads in recorders, which encodes one YUYV frame into the buffer leased from
+ * pool.
+ *
+ * The level of adaptive encode controller is applied before encoding, and the queue size and encode time are reported
+ * after encoding. The encoded record carries the encode information and the frame trace with convert and encode time.
+ * Each saver thread owns one frame encoder, while the pools and controller are shared.
+ */
+class FrameEncoder {
+  public:
+    using QueueSize = std::function<std::size_t()>;  //!< function to get the size of image queue
+
+  public:
+    /**
+     * @brief Constructor
+     *
+     * @param params        Encode parameters, the quality and subsampling are overridden by controller if it's set
+     * @param bufferPool    Pool of output JPEG buffer
+     * @param threadPool    Thread pool to encode stripes, could be null
+     * @param controller    Adaptive encode controller, could be null
+     */
+    FrameEncoder(const YuyvEncodeParams& params, std::shared_ptr<util::BufferPool> bufferPool,
+                 std::shared_ptr<util::ThreadPool> threadPool = nullptr,
+                 std::shared_ptr<AdaptiveEncodeController> controller = nullptr);
+
+    // non-copyable
+    FrameEncoder(const FrameEncoder&) = delete;
+    FrameEncoder& operator=(const FrameEncoder&) = delete;
+
+  public:
+    /**
+     * @brief Encode YUYV frame into the record, whose timestamp should be set by caller
+     *
+     * @param yuyv      YUYV image
+     * @param width     Image width
+     * @param height    Image height
+     * @param stride    Row stride of YUYV image in bytes
+     * @param queueSize Function to get the size of image queue after encoding, reported to controller
+     * @param trace     Frame trace, the convert and encode time are set
+     * @param record    Output record, the data, encode information and trace are set
+     * @return True if encode success
+     */
+    bool encode(const unsigned char* yuyv, int width, int height, int stride, const QueueSize& queueSize,
+                core::FrameTrace& trace, core::RawImageRecord& record);
+
+  private:
+    YuyvEncodeParams params_;                               // encode parameters
+    YuyvJpegEncoder encoder_;                               // YUYV JPEG encoder
+    std::shared_ptr<util::BufferPool> bufferPool_;          // pool of output JPEG buffer
+    std::shared_ptr<AdaptiveEncodeController> controller_;  // adaptive encode controller
+};
+
+}  // namespace io
+}  // namespace libra
@@ -0,0 +1,107 @@
+#pragma once
+#include <array>
+#include <ostream>
+#include <string>
+#include "libra/core/FrameTrace.hpp"
+#include "libra/util/LatencyHistogram.h"
+
+namespace libra {
+namespace io {
+
+/**
+ * @brief Stage of recording pipeline, which is the interval between two timestamps of frame trace
+ */
+enum class PipelineStage {
+    Enqueue,  //!< capture => enqueue, copy the frame and push it into queue
+    Queue,    //!< enqueue => dequeue, wait in queue
+    Convert,  //!< dequeue => convert, convert from YUYV
+    Encode,   //!< convert => encode, encode to JPEG
+    Sink,     //!< encode(or dequeue if not encoded) => sink, process function of app, e.g., write to disk
+    Total,    //!< capture => sink
+};
+
+/**
+ * @brief Get the name of pipeline stage
+ *
+ * @param stage Pipeline stage
+ * @return Name of pipeline stage
+ */
+std::string toString(PipelineStage stage);
+
+/**
+ * @brief Aggregate the frame traces into the latency histogram of each pipeline stage.
+ *
+ * The frame traces are added by the saver threads without lock, and the statistics could be read or exported at any
+ * time. The stage is skipped if any of its timestamps is 0, except that the sink stage starts at dequeue if the frame
+ * isn't encoded by recorder.
+ */
+class FrameTracer {
+  public:
+    static constexpr std::size_t kStageNum = 6;  //!< pipeline stage number
+
+  public:
+    /**
+     * @brief Constructor
+     */
+    FrameTracer() = default;
+
+    /**
+     * @brief Destructor
+     */
+    ~FrameTracer() = default;
+
+    // non-copyable
+    FrameTracer(const FrameTracer&) = delete;
+    FrameTracer& operator=(const FrameTracer&) = delete;
+
+  public:
+    /**
+     * @brief Get the latency histogram of pipeline stage
+     *
+     * @param stage Pipeline stage
+     * @return Latency histogram
+     */
+    inline const util::LatencyHistogram& histogram(PipelineStage stage) const {
+        return histograms_[static_cast<std::size_t>(stage)];
+    }
+
+    /**
+     * @brief Add the trace of one frame
+     *
+     * @param trace Frame trace
+     */
+    void add(const core::FrameTrace& trace);
+
+    /**
+     * @brief Clear all the traces, it shouldn't be called with `add()` at the same time
+     */
+    void reset();
+
+    /**
+     * @brief Export the statistics of all stages as JSON, the unit is ms
+     *
+     * @return JSON string
+     */
+    std::string toJson() const;
+
+    /**
+     * @brief Save the statistics of all stages to JSON file
+     *
+     * @param file  JSON file
+     */
+    void save(const std::string& file) const;
+
+    /**
+     * @brief Print the statistics of all stages to output stream, one line for each stage
+     * @param os        Output stream
+     * @param tracer    Frame tracer
+     * @return Output stream
+     */
+    friend std::ostream& operator<<(std::ostream& os, const FrameTracer& tracer);
+
+  private:
+    std::array<util::LatencyHistogram, kStageNum> histograms_;  // latency histogram of each stage
+};
+
+}  // namespace io
+}  // namespace libra
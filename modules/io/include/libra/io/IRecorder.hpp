@@ -1,6 +1,8 @@
 #pragma once
 #include <functional>
+#include <memory>
 #include "libra/core/Record.hpp"
+#include "libra/io/FrameTracer.h"
 #include "libra/util.hpp"
 
 namespace libra {
@@ -40,10 +42,17 @@ class IRecorder : public libra::util::Thread {
      */
     void setProcessFunction(const std::function<void(const core::ImuRecord&)>& func) { processImu_ = func; }
 
+    /**
+     * @brief Get the tracer which aggregates the latency of pipeline stages of images
+     * @return Frame tracer
+     */
+    const std::shared_ptr<FrameTracer>& frameTracer() const { return frameTracer_; }
+
   protected:
     std::function<void(const core::ImageRecord&)> processImg_;        //!< image record process function
     std::function<void(const core::RawImageRecord&)> processRawImg_;  //!< raw image record process function
     std::function<void(const core::ImuRecord&)> processImu_;          //!< IMU record process function
+    std::shared_ptr<FrameTracer> frameTracer_ = std::make_shared<FrameTracer>();  //!< latency tracer of image pipeline
 };
 
 }  // namespace io
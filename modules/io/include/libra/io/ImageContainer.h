@@ -0,0 +1,260 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "libra/io/AsyncFileSink.h"
+#include "libra/util/BufferPool.h"
+#include "libra/util/ThreadPool.h"
+
+namespace libra {
+namespace io {
+
+/**
+ * @brief Parameters of image container
+ */
+struct ContainerParams {
+    std::size_t segmentSize = 256 * 1024 * 1024;  //!< segment file size, bytes
+    bool preallocate = true;                      //!< preallocate the segment file on disk when it's created
+    std::size_t blockSize = 1024 * 1024;          //!< block size to write with async sink, multiple of 4096 bytes
+    bool directIo = false;                        //!< open segment with O_DIRECT, only used with async sink
+    double segmentDuration = 0;                   //!< maximum time span of images in segment, s, 0 for unlimited
+    std::uint64_t rollingBudget = 0;              //!< maximum disk size of segments for rolling record, bytes, 0 for
+                                                  //!< unlimited. The oldest segments are deleted if it's exceeded
+};
+
+/**
+ * @brief Index entry of one image in container
+ */
+struct ContainerEntry {
+    std::int64_t timestamp = 0;  //!< image timestamp, ns
+    std::uint64_t offset = 0;    //!< offset of image data in segment, bytes
+    std::uint32_t segment = 0;   //!< segment index
+    std::uint32_t size = 0;      //!< image data size, bytes
+};
+
+/**
+ * @brief Writer of append-only image container, which appends the encoded images into large segment files instead of
+ * creating one file for each image, so recording for hours doesn't create millions of small files.
+ *
+ * The container is a folder with segment files `segment-000000.dat`, `segment-000001.dat`... and the index file
+ * `index.bin`. Each record in segment is a 16 bytes header of magic "LREC"(uint32), data size(uint32) and timestamp
+ * (int64, ns), then the image data. The segment file is preallocated when it's created and truncated to the used size
+ * when it's closed, the next segment is created if the record cannot fit into current one. The index file is an 16
+ * bytes header of magic "LIBRAIDX", version(uint32) and entry size(uint32), then the `ContainerEntry` of each record in
+ * the append order. All the numbers are in native byte order, and the records could be recovered by scanning the
+ * segments if the index is lost.
+ *
+ * The images could be appended from multiple saver threads, the append is serialized by mutex. The segment is written
+ * by `pwrite()` in the saver thread by default. If the async sink is set, the records are copied into aligned blocks,
+ * and the full block is written by sink, so the saver thread only waits for storage if the in-flight writes of sink are
+ * full. The block is aligned to 4096 bytes in memory and file, so the segment could be opened with `O_DIRECT` to bypass
+ * the page cache, and the last partial block is padded and then truncated when the segment is closed.
+ *
+ * For the continuous recording like flight recorder, the segment could be bounded by the time span of its images, and
+ * the rolling budget could be set. When a new segment is created and the size of closed segments plus the new one
+ * exceeds the budget, the oldest segments are deleted by a background thread. So the disk usage is bounded and the
+ * history is dropped one segment each time, without the long blocking delete in saver thread. The index entries of
+ * deleted segments are kept in index file, and are skipped by reader.
+ */
+class ImageContainerWriter {
+  public:
+    /**
+     * @brief Constructor
+     * @param params Container parameters
+     */
+    explicit ImageContainerWriter(const ContainerParams& params = ContainerParams());
+
+    /**
+     * @brief Destructor, close the container
+     */
+    ~ImageContainerWriter();
+
+    // non-copyable
+    ImageContainerWriter(const ImageContainerWriter&) = delete;
+    ImageContainerWriter& operator=(const ImageContainerWriter&) = delete;
+
+  public:
+    /**
+     * @brief Get the container parameters
+     * @return Container parameters
+     */
+    inline const ContainerParams& params() const { return params_; }
+
+    /**
+     * @brief Set the async sink to write the segments, it should be set before opening container
+     * @param sink  Async file sink, null to write in the saver thread
+     */
+    void setSink(std::shared_ptr<AsyncFileSink> sink);
+
+    /**
+     * @brief Check whether the container is opened
+     * @return True if opened
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Get the number of appended images
+     * @return Image number
+     */
+    std::size_t recordNum() const;
+
+    /**
+     * @brief Get the number of created segment files, including the deleted ones in rolling record
+     * @return Segment number
+     */
+    std::size_t segmentNum() const;
+
+    /**
+     * @brief Get the number of segments deleted in rolling record
+     * @return Deleted segment number
+     */
+    std::size_t deletedSegmentNum() const;
+
+    /**
+     * @brief Get the used size of the segments not deleted
+     * @return Used size, bytes
+     */
+    std::uint64_t diskSize() const;
+
+    /**
+     * @brief Open the container folder and create the first segment, the folder is created if not exist, and the old
+     * container in it is overwritten
+     * @param folder    Container folder
+     * @return True if success
+     */
+    bool open(const std::string& folder);
+
+    /**
+     * @brief Append one image into container
+     *
+     * @param timestamp Image timestamp, s
+     * @param data      Image data
+     * @param size      Image data size, bytes
+     * @return True if success
+     */
+    bool append(double timestamp, const unsigned char* data, std::size_t size);
+
+    /**
+     * @brief Flush the index, truncate the segment to used size and close the container. It waits the writes of async
+     * sink are completed
+     */
+    void close();
+
+  private:
+    struct Segment;  // opened segment file
+
+    /**
+     * @brief Write data to current segment directly, or copy it into block for async sink, the mutex should be locked
+     *
+     * @param data  Data buffer
+     * @param size  Data size, bytes
+     * @return True if success
+     */
+    bool writeSegment(const void* data, std::size_t size);
+
+    /**
+     * @brief Submit current block to async sink, the mutex should be locked
+     */
+    void submitBlock();
+
+    /**
+     * @brief Close current segment and create the next one, the mutex should be locked
+     * @return True if success
+     */
+    bool nextSegment();
+
+    /**
+     * @brief Close current segment and truncate it to used size, the mutex should be locked
+     */
+    void closeSegment();
+
+    /**
+     * @brief Delete the oldest closed segments in background until the rolling budget is satisfied, the mutex should
+     * be locked
+     */
+    void rollSegments();
+
+  private:
+    ContainerParams params_;                // container parameters
+    std::shared_ptr<AsyncFileSink> sink_;   // async file sink, null to write in saver thread
+    util::BufferPool blockPool_;            // pool of block buffers for async sink
+    mutable std::mutex mutex_;              // mutex for writing
+    std::string folder_;                    // container folder
+    std::fstream indexStream_;              // index file stream
+    std::shared_ptr<Segment> segment_;      // current segment, null if not opened
+    std::uint32_t segmentIndex_;            // index of current segment
+    std::uint64_t segmentOffset_;           // used size of current segment, bytes
+    std::shared_ptr<unsigned char> block_;  // current block buffer, null if no data in block
+    unsigned char* blockData_;              // aligned data pointer of current block
+    std::uint64_t blockOffset_;             // segment offset of current block, bytes
+    std::size_t blockUsed_;                 // used size of current block, bytes
+    std::size_t recordNum_;                 // appended image number
+
+    double segmentStartTime_;                                    // timestamp of first image in current segment, s
+    std::deque<std::pair<std::uint32_t, std::uint64_t>> closed_;  // index and size of closed segments not deleted
+    std::uint64_t closedSize_;                                   // total size of closed segments not deleted, bytes
+    std::size_t deletedNum_;                                     // deleted segment number
+    std::unique_ptr<util::ThreadPool> deleter_;                  // thread to delete segments, null if not rolling
+};
+
+/**
+ * @brief Reader of image container written by `ImageContainerWriter`, which could read the image by index entry and
+ * export the images back to the folder in kalibr format, i.e., the images named by timestamp in ns.
+ */
+class ImageContainerReader {
+  public:
+    /**
+     * @brief Open the container folder and load the index, the index is rebuilt by scanning the segments if the index
+     * file is missing or invalid
+     * @param folder    Container folder
+     * @return True if success
+     */
+    bool open(const std::string& folder);
+
+    /**
+     * @brief Get the index entries sorted by timestamp
+     * @return Index entries
+     */
+    inline const std::vector<ContainerEntry>& entries() const { return entries_; }
+
+    /**
+     * @brief Find the first entry whose timestamp isn't earlier than the given timestamp
+     * @param timestamp Timestamp, s
+     * @return Entry pointer, nullptr if not found
+     */
+    const ContainerEntry* find(double timestamp) const;
+
+    /**
+     * @brief Read the image data of entry
+     *
+     * @param entry Index entry
+     * @param data  Image data
+     * @return True if success
+     */
+    bool read(const ContainerEntry& entry, std::vector<unsigned char>& data) const;
+
+    /**
+     * @brief Export all the images to folder in kalibr format, the folder is created if not exist
+     * @param folder    Export folder
+     * @return Exported image number
+     */
+    std::size_t exportKalibr(const std::string& folder) const;
+
+  private:
+    /**
+     * @brief Rebuild the index by scanning the records in segments
+     */
+    void scanSegments();
+
+  private:
+    std::string folder_;                   // container folder
+    std::vector<std::string> segments_;    // segment files by index, empty if it's deleted in rolling record
+    std::vector<ContainerEntry> entries_;  // index entries sorted by timestamp
+};
+
+}  // namespace io
+}  // namespace libra
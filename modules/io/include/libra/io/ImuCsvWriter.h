@@ -0,0 +1,131 @@
+#pragma once
+#include <fmt/format.h>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "libra/core/Record.hpp"
+
+namespace libra {
+namespace io {
+
+/**
+ * @brief File format of IMU writer
+ */
+enum class ImuFileFormat {
+    Csv,     //!< text CSV, one IMU each line
+    Binary,  //!< fixed size binary record, see `ImuCsvWriter` for the layout
+};
+
+/**
+ * @brief Parameters of IMU writer
+ */
+struct ImuWriterParams {
+    ImuFileFormat format = ImuFileFormat::Csv;  //!< file format
+    std::size_t flushSize = 64 * 1024;         //!< flush when the buffered data is larger than this size, bytes
+    double flushInterval = 1.0;                //!< flush when the last flush is older than this interval, s
+};
+
+/**
+ * @brief Buffered IMU writer, which formats the IMU into memory buffer and writes the file in large blocks, so the
+ * full-rate IMU doesn't cost one syscall for each sample.
+ *
+ * The CSV format is the same with recorder apps, each line is "sensor timestamp(ns), system timestamp(ns), gyro(rad/s),
+ * acc(m/s^2)" with the header line starting with '#'. The binary format is an 16 bytes header of the magic "LIBRAIMU",
+ * version(uint32) and record size(uint32), then the records of sensor timestamp(int64, ns), system timestamp(int64,
+ * ns), gyro(3 double) and acc(3 double) in native byte order.
+ *
+ * The buffer is flushed when it's larger than the flush size or the last flush is older than the flush interval, the
+ * interval is only checked when writing. It isn't thread-safe, and should be written in one thread, such as the IMU
+ * process function of recorder.
+ */
+class ImuCsvWriter {
+  public:
+    static constexpr char kBinaryMagic[8] = {'L', 'I', 'B', 'R', 'A', 'I', 'M', 'U'};  //!< magic of binary file
+    static constexpr std::uint32_t kBinaryVersion = 1;                               //!< version of binary format
+    static constexpr std::uint32_t kBinaryRecordSize = 64;                           //!< record size in binary, bytes
+
+  public:
+    /**
+     * @brief Constructor
+     * @param params Writer parameters
+     */
+    explicit ImuCsvWriter(const ImuWriterParams& params = ImuWriterParams());
+
+    /**
+     * @brief Destructor, flush and close the file
+     */
+    ~ImuCsvWriter();
+
+    // non-copyable
+    ImuCsvWriter(const ImuCsvWriter&) = delete;
+    ImuCsvWriter& operator=(const ImuCsvWriter&) = delete;
+
+  public:
+    /**
+     * @brief Get the writer parameters
+     * @return Writer parameters
+     */
+    inline const ImuWriterParams& params() const { return params_; }
+
+    /**
+     * @brief Check whether the file is opened
+     * @return True if opened
+     */
+    inline bool isOpen() const { return fs_.is_open(); }
+
+    /**
+     * @brief Get the number of written IMU
+     * @return Written IMU number
+     */
+    inline std::size_t writtenNum() const { return writtenNum_; }
+
+    /**
+     * @brief Get the number of flushes to file
+     * @return Flush number
+     */
+    inline std::size_t flushNum() const { return flushNum_; }
+
+    /**
+     * @brief Open file and write the header, the previous file is closed
+     * @param file  File path
+     * @return True if success
+     */
+    bool open(const std::string& file);
+
+    /**
+     * @brief Write one IMU into buffer, and flush if the flush policy is met
+     * @param imu   IMU record
+     */
+    void write(const core::ImuRecord& imu);
+
+    /**
+     * @brief Write all the buffered data to file
+     */
+    void flush();
+
+    /**
+     * @brief Flush and close the file
+     */
+    void close();
+
+    /**
+     * @brief Read the IMU from binary file
+     * @param file  Binary file path
+     * @param imus  IMU records
+     * @return True if success
+     */
+    static bool readBinary(const std::string& file, std::vector<core::ImuRecord>& imus);
+
+  private:
+    ImuWriterParams params_;                           // writer parameters
+    std::fstream fs_;                                  // file stream
+    fmt::memory_buffer buffer_;                        // buffered data not written to file
+    std::chrono::steady_clock::time_point flushTime_;  // time of last flush
+    std::size_t writtenNum_;                           // written IMU number
+    std::size_t flushNum_;                             // flush number
+};
+
+}  // namespace io
+}  // namespace libra
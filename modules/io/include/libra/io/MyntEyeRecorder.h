@@ -1,8 +1,9 @@
 #pragma once
 #include <mynteyed/camera.h>
 #include <Eigen/Core>
+#include "libra/io/AdaptiveEncodeController.h"
 #include "libra/io/IRecorder.hpp"
-#include "turbojpeg.h"
+#include "libra/io/YuyvJpegEncoder.h"
 
 namespace libra {
 namespace io {
@@ -30,6 +31,7 @@ class MyntEyeRecorder : public IRecorder {
     struct RawImage {
         std::shared_ptr<mynteyed::Image> img;  // image data pointer
         std::uint32_t timestamp = 0;           // sensor timestamp, 0.01 ms
+        core::FrameTrace trace;                // timestamps of pipeline stages
     };
 
     /**
@@ -99,6 +101,27 @@ class MyntEyeRecorder : public IRecorder {
      */
     inline const std::size_t& saverThreadNum() const { return saverThreadNum_; }
 
+    /**
+     * @brief Get the parameters to encode YUYV image
+     *
+     * @return  Encode parameters
+     */
+    inline const YuyvEncodeParams& encodeParams() const { return encodeParams_; }
+
+    /**
+     * @brief Get the geometry of encoded image after ROI crop and binning, it's valid after `init()`
+     *
+     * @return  Encode geometry, which gives the intrinsics of encoded image
+     */
+    inline const EncodeGeometry& encodeGeometry() const { return encodeGeometry_; }
+
+    /**
+     * @brief Get the controller to adjust encode quality
+     *
+     * @return  Adaptive encode controller, null if the encode quality is fixed
+     */
+    inline const std::shared_ptr<AdaptiveEncodeController>& encodeController() const { return encodeController_; }
+
     /**
      * @brief Is the right camera is enabled
      *
@@ -141,6 +164,21 @@ class MyntEyeRecorder : public IRecorder {
      */
     void setSaverThreadNum(const std::size_t& saverThreadNum);
 
+    /**
+     * @brief Set the parameters to encode YUYV image, should be set before `init()`
+     *
+     * @param params  Encode parameters
+     */
+    void setEncodeParams(const YuyvEncodeParams& params);
+
+    /**
+     * @brief Set the controller to adjust encode quality by the image queue size and encode time, should be set before
+     * `init()`. The quality and subsampling of encode parameters are overridden by the controller
+     *
+     * @param controller  Adaptive encode controller, null to use fixed encode quality
+     */
+    void setEncodeController(const std::shared_ptr<AdaptiveEncodeController>& controller);
+
     /**
      * @brief Set process function for raw image record of right camera
      * @param func Process function for raw image record of right camera
@@ -185,18 +223,23 @@ class MyntEyeRecorder : public IRecorder {
     mynteyed::StreamMode streamMode_;      // stream mode, could set image size and camera num(left or left + right)
     mynteyed::StreamFormat streamFormat_;  // stream format, the format used for data transferring
     std::size_t saverThreadNum_;           // image saver thread number
+    YuyvEncodeParams encodeParams_;        // parameters to encode YUYV image
+    EncodeGeometry encodeGeometry_;        // geometry of encoded image
+    std::shared_ptr<AdaptiveEncodeController> encodeController_;  // controller to adjust encode quality
+    std::shared_ptr<util::BufferPool> jpegBufferPool_;    // pool of output JPEG buffers for image saver threads
+    std::shared_ptr<util::ThreadPool> encodeThreadPool_;  // thread pool to encode stripes in stripe mode
     // raw image record process function for right camera
     std::function<void(const core::RawImageRecord&)> processRightRawImg_;
 
     // camera pointer, cannot use object due to the watch dog in MyntEye SDK(device.h)
     std::shared_ptr<mynteyed::Camera> cam_;
-    bool isRightCamEnabled_;                                     // right camera is enable or not
-    std::shared_ptr<util::JobQueue<RawImage>> leftImageQueue_;   // left raw image queue
-    std::shared_ptr<util::JobQueue<RawImage>> rightImageQueue_;  // right raw image queue
-    std::shared_ptr<util::JobQueue<RawImu>> imuQueue_;           // raw IMU queue
-    std::vector<std::thread> leftImageSaverThreads_;             // image saver threads
-    std::vector<std::thread> rightImageSaverThreads_;            // image saver threads
-    std::thread imuSaverThread_;                                 // IMU saver thread
+    bool isRightCamEnabled_;                                      // right camera is enable or not
+    std::shared_ptr<util::MpmcQueue<RawImage>> leftImageQueue_;   // left raw image queue
+    std::shared_ptr<util::MpmcQueue<RawImage>> rightImageQueue_;  // right raw image queue
+    std::shared_ptr<util::SpscQueue<RawImu>> imuQueue_;           // raw IMU queue
+    std::vector<std::thread> leftImageSaverThreads_;              // image saver threads
+    std::vector<std::thread> rightImageSaverThreads_;             // image saver threads
+    std::thread imuSaverThread_;                                  // IMU saver thread
 };
 
 }  // namespace io
@@ -0,0 +1,150 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "libra/core/Record.hpp"
+
+namespace libra {
+namespace io {
+
+/**
+ * @brief Parameters of preview stage
+ */
+struct PreviewParams {
+    int scaleDenom = 4;     //!< downscale factor of preview, 1, 2, 4 or 8
+    bool gray = false;      //!< decode to gray image, otherwise to BGR image
+    double interval = 0.2;  //!< minimum time interval between the previews of each camera, s
+    int nice = 10;          //!< nice value of preview thread, the larger the lower priority
+};
+
+/**
+ * @brief Downscaled preview image
+ */
+struct PreviewImage {
+    double timestamp = 0;             //!< image timestamp, s
+    std::size_t camera = 0;           //!< camera index
+    int width = 0;                    //!< image width
+    int height = 0;                   //!< image height
+    int channels = 0;                 //!< channel number, 1 for gray and 3 for BGR
+    std::vector<unsigned char> data;  //!< image data, row major without padding
+};
+
+/**
+ * @brief Preview stage, which decodes the downscaled preview of encoded JPEG images in a low priority thread, so the
+ * saver threads don't decode the full image for display.
+ *
+ * The images are pushed from the process functions of recorder. The push returns immediately if there is no subscriber
+ * or the preview interval of this camera isn't reached, otherwise the image is held in the slot of its camera. The
+ * preview thread decodes the latest image in each slot with the scaled decode of turbojpeg, which only runs the IDCT
+ * for the downscaled size, and the older image not decoded yet is replaced. So the preview costs nothing if nobody
+ * watches, and never backs up the recorder if the preview thread is slow. The subscribers are called in preview thread.
+ */
+class PreviewStage {
+  public:
+    using Callback = std::function<void(const PreviewImage& image)>;  //!< callback of preview image
+
+  public:
+    /**
+     * @brief Constructor, start the preview thread
+     * @param params    Preview parameters
+     */
+    explicit PreviewStage(const PreviewParams& params = PreviewParams());
+
+    /**
+     * @brief Destructor, stop the preview thread
+     */
+    ~PreviewStage();
+
+    // non-copyable
+    PreviewStage(const PreviewStage&) = delete;
+    PreviewStage& operator=(const PreviewStage&) = delete;
+
+  public:
+    /**
+     * @brief Get the preview parameters
+     * @return Preview parameters
+     */
+    inline const PreviewParams& params() const { return params_; }
+
+    /**
+     * @brief Check whether there is any subscriber
+     * @return True if subscribed
+     */
+    inline bool isSubscribed() const { return subscriberNum_.load(std::memory_order_relaxed) > 0; }
+
+    /**
+     * @brief Get the number of decoded previews
+     * @return Decoded preview number
+     */
+    inline std::size_t decodedNum() const { return decodedNum_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get the number of images replaced by newer ones before they're decoded
+     * @return Replaced image number
+     */
+    inline std::size_t replacedNum() const { return replacedNum_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Subscribe the preview images
+     * @param callback  Callback of preview image, which is called in preview thread and shouldn't subscribe or
+     * unsubscribe
+     * @return Subscriber ID to unsubscribe
+     */
+    std::size_t subscribe(Callback callback);
+
+    /**
+     * @brief Unsubscribe the preview images, the callback isn't called after return
+     * @param id    Subscriber ID
+     */
+    void unsubscribe(std::size_t id);
+
+    /**
+     * @brief Push the encoded JPEG image, it's held for preview only if subscribed and the interval is reached
+     *
+     * @param raw       Image record
+     * @param camera    Camera index
+     */
+    void push(const core::RawImageRecord& raw, std::size_t camera = 0);
+
+  private:
+    /**
+     * @brief Loop of preview thread
+     */
+    void run();
+
+    /**
+     * @brief Decode the downscaled preview of JPEG image
+     *
+     * @param raw       Image record
+     * @param camera    Camera index
+     * @param image     Preview image
+     * @return True if success
+     */
+    bool decode(const core::RawImageRecord& raw, std::size_t camera, PreviewImage& image);
+
+  private:
+    PreviewParams params_;                    // preview parameters
+    void* decompressor_;                      // turbojpeg decompressor, only used in preview thread
+    std::atomic<std::size_t> subscriberNum_;  // subscriber number
+    std::atomic<std::size_t> decodedNum_;     // decoded preview number
+    std::atomic<std::size_t> replacedNum_;    // replaced image number
+
+    std::mutex mutex_;                             // mutex for slots and stop flag
+    std::condition_variable condition_;            // condition variable when image is pushed
+    std::vector<core::RawImageRecord> slots_;      // latest image of each camera to decode
+    std::vector<bool> pending_;                    // whether the slot of each camera is waiting for decode
+    std::vector<double> lastTime_;                 // timestamp of last held image of each camera, s
+    bool stop_;                                    // stop flag
+    std::mutex subscriberMutex_;                   // mutex for subscribers, held when calling them
+    std::map<std::size_t, Callback> subscribers_;  // subscribers by ID
+    std::size_t nextId_;                           // next subscriber ID
+    std::thread thread_;                           // preview thread
+};
+
+}  // namespace io
+}  // namespace libra
@@ -0,0 +1,143 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "libra/io/IRecorder.hpp"
+
+namespace libra {
+namespace io {
+
+/**
+ * @brief Parameters for replay recorder
+ */
+struct ReplayParams {
+    std::string folder;            //!< record folder, which has `left/`, `right/` and `imu.csv`
+    double speed = 1;              //!< replay speed, 1 for real time, N for N times, 0 for as fast as possible
+    std::size_t prefetchNum = 32;  //!< maximum number of images read ahead
+};
+
+/**
+ * @brief Recorder which replays the record folder in kalibr format saved by sensor recorders, i.e., `left/` and
+ * `right/` folder with the images named by timestamp in ns, and `imu.csv` with sensor timestamp, system timestamp, gyro
+ * and acc in each row.
+ *
+ * The records are passed to the process functions in the order of timestamp, and are paced to the original timestamps
+ * scaled by the replay speed. The IMU is loaded into memory in `init()`, and the image files are read ahead by a
+ * prefetch thread into a bounded queue, so the disk reading doesn't delay the pacing unless the disk is slower than the
+ * replay speed on average. The recorder finishes itself after all records are replayed.
+ */
+class ReplayRecorder : public IRecorder {
+  private:
+    /**
+     * @brief Image file in record folder
+     */
+    struct ImageFile {
+        double timestamp = 0;  // timestamp parsed from file name, s
+        bool isLeft = true;    // left or right image
+        std::string path;      // file path
+    };
+
+  public:
+    /**
+     * @brief Constructor
+     * @param params    Replay parameters
+     */
+    explicit ReplayRecorder(const ReplayParams& params = ReplayParams());
+
+    /**
+     * @brief Destructor
+     */
+    ~ReplayRecorder() override;
+
+  public:
+    /**
+     * @brief Get the replay parameters
+     *
+     * @return  Replay parameters
+     */
+    inline const ReplayParams& params() const { return params_; }
+
+    /**
+     * @brief Get the number of replayed images, include left and right images
+     *
+     * @return  Replayed image number
+     */
+    inline std::size_t imageNum() const { return imageNum_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get the number of replayed IMU
+     *
+     * @return  Replayed IMU number
+     */
+    inline std::size_t imuNum() const { return imuNum_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get the number of images which isn't read ahead when it's time to replay, the replay is delayed by disk
+     *
+     * @return  Stall number
+     */
+    inline std::size_t stallNum() const { return stallNum_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Set the replay parameters, should be set before `init()`
+     *
+     * @param params  Replay parameters
+     */
+    void setParams(const ReplayParams& params);
+
+    /**
+     * @brief Set process function for raw image record of right camera
+     *
+     * @param func Process function for raw image record of right camera
+     */
+    void setRightProcessFunction(const std::function<void(const core::RawImageRecord&)>& func);
+
+    /**
+     * @brief Initialize recorder, list the image files and load IMU
+     */
+    void init() override;
+
+  protected:
+    /**
+     * @brief The main run function, replay images and IMU in the order of timestamp
+     */
+    void run() override;
+
+    /**
+     * @brief List the image files in folder, the files not named by timestamp are ignored
+     *
+     * @param folder    Image folder
+     * @param isLeft    Left or right image
+     */
+    void listImages(const std::string& folder, bool isLeft);
+
+    /**
+     * @brief Load IMU from CSV file
+     *
+     * @param file  IMU file
+     */
+    void loadImu(const std::string& file);
+
+    /**
+     * @brief Create thread to read image files ahead
+     */
+    void createPrefetchThread();
+
+  private:
+    ReplayParams params_;  // replay parameters
+    // raw image record process function for right camera
+    std::function<void(const core::RawImageRecord&)> processRightRawImg_;
+
+    std::vector<ImageFile> imageFiles_;                                  // image files sorted by timestamp
+    std::vector<core::ImuRecord> imus_;                                  // IMU sorted by timestamp
+    std::shared_ptr<util::BufferPool> bufferPool_;                       // pool of image buffers
+    std::shared_ptr<util::SpscQueue<core::RawImageRecord>> imageQueue_;  // queue of read ahead images
+    std::thread prefetchThread_;                                         // thread to read image files
+    std::atomic<std::size_t> imageNum_;                                  // replayed image number
+    std::atomic<std::size_t> imuNum_;                                    // replayed IMU number
+    std::atomic<std::size_t> stallNum_;                                  // number of images not read ahead in time
+};
+
+}  // namespace io
+}  // namespace libra
@@ -0,0 +1,231 @@
+#pragma once
+#include <Eigen/Core>
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "libra/io/AdaptiveEncodeController.h"
+#include "libra/io/IRecorder.hpp"
+#include "libra/io/YuyvJpegEncoder.h"
+
+namespace libra {
+namespace io {
+
+/**
+ * @brief Parameters for synthetic recorder
+ */
+struct SyntheticParams {
+    int width = 1280;          //!< image width, should be even
+    int height = 720;          //!< image height
+    double fps = 30;           //!< frame rate, Hz
+    double imuRate = 200;      //!< IMU rate, Hz. 0 to disable IMU
+    std::uint32_t seed = 0;    //!< random seed for image content, IMU noise, jitter and drop
+    double jitter = 0;         //!< standard deviation of the arrival time jitter of image, s
+    double frameDropRate = 0;  //!< probability to drop one frame at sensor, [0, 1]
+    double imuDropRate = 0;    //!< probability to drop one IMU sample at sensor, [0, 1]
+    bool realTime = true;      //!< generate data at real time, otherwise generate as fast as the saver threads could go
+    std::size_t frameNum = 0;  //!< stop after generating this number of frames, 0 for unlimited
+};
+
+/**
+ * @brief Recorder which generates synthetic YUYV images and IMU, used to benchmark and test the pipeline without
+ * device.
+ *
+ * The image is compressed and passed to the process function by the image saver threads, the same as
+ * `ZedOpenRecorder`, so it could be used as a repeatable load generator of the capture => encode => save pipeline.
+ *
+ * The content is deterministic for the same seed. The images are copied from several pre-generated YUYV patterns into
+ * the buffers leased from pool, which simulates the copy from camera SDK. The timestamps of image and IMU are the ideal
+ * sensor time from the start time, the jitter only delays or advances the time of image arriving the queue. The dropped
+ * image or IMU isn't pushed to queue, which leaves a gap in the timestamps.
+ *
+ * In real time mode, the oldest image is dropped if the queue is full, which is the same with camera recorders. In non
+ * real time mode, the generator waits for free slot in queue, so the throughput of pipeline could be measured.
+ */
+class SyntheticRecorder : public IRecorder {
+  private:
+    /**
+     * @brief Raw image generated by recorder
+     */
+    struct RawImage {
+        std::shared_ptr<unsigned char> data;  // YUYV image data, leased from pool
+        double timestamp = 0;                 // sensor timestamp, s
+        core::FrameTrace trace;               // timestamps of pipeline stages
+    };
+
+    /**
+     * @brief Raw IMU generated by recorder
+     */
+    struct RawImu {
+        double timestamp = 0;        // sensor timestamp, s
+        double systemTimestamp = 0;  // system timestamp when the IMU is generated, s
+        Eigen::Vector3d acc;         // accelerometer, m/s^2
+        Eigen::Vector3d gyro;        // gyroscope, rad/s
+    };
+
+  public:
+    /**
+     * @brief Constructor
+     * @param params            Synthetic parameters
+     * @param saverThreadNum    Image saver thread number
+     */
+    explicit SyntheticRecorder(const SyntheticParams& params = SyntheticParams(),
+                               const std::size_t& saverThreadNum = 2);
+
+    /**
+     * @brief Destructor
+     */
+    ~SyntheticRecorder() override;
+
+  public:
+    /**
+     * @brief Get the synthetic parameters
+     *
+     * @return  Synthetic parameters
+     */
+    inline const SyntheticParams& params() const { return params_; }
+
+    /**
+     * @brief Get the image saver thread number
+     *
+     * @return  Image saver thread number
+     */
+    inline const std::size_t& saverThreadNum() const { return saverThreadNum_; }
+
+    /**
+     * @brief Get the parameters to encode YUYV image
+     *
+     * @return  Encode parameters
+     */
+    inline const YuyvEncodeParams& encodeParams() const { return encodeParams_; }
+
+    /**
+     * @brief Get the geometry of encoded image after ROI crop and binning, it's valid after `init()`
+     *
+     * @return  Encode geometry, which gives the intrinsics of encoded image
+     */
+    inline const EncodeGeometry& encodeGeometry() const { return encodeGeometry_; }
+
+    /**
+     * @brief Get the controller to adjust encode quality
+     *
+     * @return  Adaptive encode controller, null if the encode quality is fixed
+     */
+    inline const std::shared_ptr<AdaptiveEncodeController>& encodeController() const { return encodeController_; }
+
+    /**
+     * @brief Get the number of generated frames, include the dropped frames at sensor
+     *
+     * @return  Generated frame number
+     */
+    inline std::size_t generatedFrameNum() const { return generatedFrameNum_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get the number of frames dropped at sensor
+     *
+     * @return  Dropped frame number
+     */
+    inline std::size_t droppedFrameNum() const { return droppedFrameNum_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get the statistics of image queue, should be called after `init()`
+     *
+     * @return  Image queue statistics
+     */
+    util::QueueStats imageQueueStats() const;
+
+    /**
+     * @brief Get the statistics of IMU queue, should be called after `init()`
+     *
+     * @return  IMU queue statistics
+     */
+    util::QueueStats imuQueueStats() const;
+
+    /**
+     * @brief Set the synthetic parameters, should be set before `init()`
+     *
+     * @param params  Synthetic parameters
+     */
+    void setParams(const SyntheticParams& params);
+
+    /**
+     * @brief Set the saver thread number, should be set before `init()`
+     *
+     * @param saverThreadNum  Saver thread number
+     */
+    void setSaverThreadNum(const std::size_t& saverThreadNum);
+
+    /**
+     * @brief Set the parameters to encode YUYV image, should be set before `init()`
+     *
+     * @param params  Encode parameters
+     */
+    void setEncodeParams(const YuyvEncodeParams& params);
+
+    /**
+     * @brief Set the controller to adjust encode quality by the image queue size and encode time, should be set before
+     * `init()`
+     *
+     * @param controller  Adaptive encode controller, null to use fixed encode quality
+     */
+    void setEncodeController(const std::shared_ptr<AdaptiveEncodeController>& controller);
+
+    /**
+     * @brief Initialize recorder, generate image patterns and create saver threads
+     */
+    void init() override;
+
+    /**
+     * @brief Generate one YUYV image pattern, which is a smooth gradient with noise and has the similar compression
+     * ratio with real image
+     *
+     * @param width     Image width, should be even
+     * @param height    Image height
+     * @param shift     Shift of the gradient in pixels, used to move the pattern between frames
+     * @param rng       Random number generator of noise
+     * @param yuyv      Output YUYV image, the size should be at least 2 * width * height
+     */
+    static void generatePattern(int width, int height, int shift, std::mt19937& rng, unsigned char* yuyv);
+
+  protected:
+    /**
+     * @brief The main run function, generate image and IMU
+     */
+    void run() override;
+
+    /**
+     * @brief Generate the YUYV image patterns
+     */
+    void generatePatterns();
+
+    /**
+     * @brief Create thread for save image
+     */
+    void createImageSaverThread();
+
+    /**
+     * @brief Create thread for save IMU
+     */
+    void createImuSaverThread();
+
+  private:
+    SyntheticParams params_;                                      // synthetic parameters
+    std::size_t saverThreadNum_;                                  // image saver thread number
+    YuyvEncodeParams encodeParams_;                               // parameters to encode YUYV image
+    EncodeGeometry encodeGeometry_;                               // geometry of encoded image
+    std::shared_ptr<AdaptiveEncodeController> encodeController_;  // controller to adjust encode quality
+    std::shared_ptr<util::BufferPool> imageBufferPool_;           // pool of YUYV image buffers
+    std::shared_ptr<util::BufferPool> jpegBufferPool_;            // pool of output JPEG buffers
+    std::shared_ptr<util::ThreadPool> encodeThreadPool_;          // thread pool to encode stripes in stripe mode
+    std::vector<std::vector<unsigned char>> patterns_;            // YUYV image patterns
+
+    std::shared_ptr<util::MpmcQueue<RawImage>> imageQueue_;  // raw image queue
+    std::shared_ptr<util::SpscQueue<RawImu>> imuQueue_;      // raw IMU queue
+    std::vector<std::thread> imageSaverThreads_;             // image saver threads
+    std::thread imuSaverThread_;                             // IMU saver thread
+    std::atomic<std::size_t> generatedFrameNum_;             // generated frame number
+    std::atomic<std::size_t> droppedFrameNum_;               // frame number dropped at sensor
+};
+
+}  // namespace io
+}  // namespace libra
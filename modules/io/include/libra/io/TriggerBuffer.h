@@ -0,0 +1,145 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include "libra/core/Record.hpp"
+#include "libra/util/BufferPool.h"
+
+namespace libra {
+namespace io {
+
+/**
+ * @brief Parameters of pre-trigger buffer
+ */
+struct TriggerParams {
+    double preTrigger = 10.0;                    //!< time window kept in memory before trigger, s
+    double postTrigger = 5.0;                    //!< time window saved after trigger, s
+    std::size_t byteBudget = 256 * 1024 * 1024;  //!< maximum size of buffered images, bytes
+    double accThreshold = 0;                     //!< trigger if the norm of acc exceeds it, m/s^2, 0 to disable
+    double gyroThreshold = 0;                    //!< trigger if the norm of gyro exceeds it, rad/s, 0 to disable
+};
+
+/**
+ * @brief Pre-trigger buffer, which keeps the last seconds of encoded images and IMU in memory, and saves them only
+ * around the trigger events, so the recorder in field doesn't write everything to disk.
+ *
+ * The images and IMU are pushed from the process functions of recorder. Before trigger, they are kept in memory ring
+ * within the pre-trigger window and the byte budget of images, the oldest ones are dropped first. The image whose
+ * buffer is owned by reading, e.g., the pooled JPEG buffer, is held without copying, otherwise it's copied into pooled
+ * buffer. When triggered, the buffered data in the pre-trigger window is flushed to the handlers, and then the data is
+ * passed to handlers directly until the post-trigger window ends, the window is extended if it's triggered again.
+ *
+ * The trigger could be requested by `trigger()`, which only sets an atomic flag and could be called from signal
+ * handler, or by the IMU exceeding the thresholds. The request is handled at the next push, and the trigger time is the
+ * latest timestamp of pushed data. The images and IMU should have the same clock. The image handler is called from the
+ * threads pushing images, which could be several saver threads, and the IMU handler is only called from the thread
+ * pushing IMU, so the IMU writer doesn't need to be thread-safe. The images of several cameras could be pushed with the
+ * camera index, and they share the byte budget.
+ */
+class TriggerBuffer {
+  public:
+    using ImageHandler = std::function<void(const core::RawImageRecord&, std::size_t camera)>;  //!< save image
+    using ImuHandler = std::function<void(const core::ImuRecord&)>;                             //!< save IMU
+
+  public:
+    /**
+     * @brief Constructor
+     *
+     * @param params        Trigger parameters
+     * @param imageHandler  Handler to save image
+     * @param imuHandler    Handler to save IMU
+     */
+    explicit TriggerBuffer(const TriggerParams& params, ImageHandler imageHandler, ImuHandler imuHandler);
+
+    // non-copyable
+    TriggerBuffer(const TriggerBuffer&) = delete;
+    TriggerBuffer& operator=(const TriggerBuffer&) = delete;
+
+  public:
+    /**
+     * @brief Get the trigger parameters
+     * @return Trigger parameters
+     */
+    inline const TriggerParams& params() const { return params_; }
+
+    /**
+     * @brief Request a trigger, it's async-signal-safe and handled at the next push
+     */
+    inline void trigger() { triggerRequest_.store(true, std::memory_order_release); }
+
+    /**
+     * @brief Push image, it's saved or buffered by the trigger state
+     * @param raw       Image record
+     * @param camera    Camera index, which is passed to image handler
+     */
+    void push(const core::RawImageRecord& raw, std::size_t camera = 0);
+
+    /**
+     * @brief Push IMU, it's saved or buffered by the trigger state, and the trigger is requested if it exceeds the
+     * thresholds
+     * @param imu   IMU record
+     */
+    void push(const core::ImuRecord& imu);
+
+    /**
+     * @brief Check whether it's in the post-trigger window
+     * @return True if triggered
+     */
+    bool isTriggered() const;
+
+    /**
+     * @brief Get the number of triggers, the trigger in the post-trigger window isn't counted
+     * @return Trigger number
+     */
+    std::size_t triggerNum() const;
+
+    /**
+     * @brief Get the number of buffered images
+     * @return Buffered image number
+     */
+    std::size_t bufferedImageNum() const;
+
+    /**
+     * @brief Get the size of buffered images
+     * @return Buffered image size, bytes
+     */
+    std::size_t bufferedBytes() const;
+
+    /**
+     * @brief Get the number of images dropped by byte budget before they leave the pre-trigger window
+     * @return Dropped image number
+     */
+    std::size_t droppedImageNum() const;
+
+  private:
+    /**
+     * @brief Update the latest timestamp and handle the trigger request, the mutex should be locked
+     * @param timestamp Timestamp of pushed data, s
+     */
+    void update(double timestamp);
+
+  private:
+    TriggerParams params_;              // trigger parameters
+    ImageHandler imageHandler_;         // handler to save image
+    ImuHandler imuHandler_;             // handler to save IMU
+    util::BufferPool pool_;             // pool of buffers to copy the image not owned by reading
+    std::atomic<bool> triggerRequest_;  // trigger request
+
+    mutable std::mutex mutex_;                                         // mutex for buffers and trigger state
+    std::deque<std::pair<core::RawImageRecord, std::size_t>> images_;  // buffered images and camera index
+    std::deque<core::ImuRecord> imus_;                                 // buffered IMU
+    std::size_t imageBytes_;                                           // size of buffered images, bytes
+    double latestTime_;                                                // latest timestamp of pushed data, s
+    double triggerTime_;                                               // time of last trigger, s
+    double postEnd_;                                                   // end time of post-trigger window, s
+    bool imageFlush_;                                                  // the buffered images should be flushed
+    bool imuFlush_;                                                    // the buffered IMU should be flushed
+    std::size_t triggerNum_;                                           // trigger number
+    std::size_t droppedImageNum_;                                      // number of images dropped by budget
+};
+
+}  // namespace io
+}  // namespace libra
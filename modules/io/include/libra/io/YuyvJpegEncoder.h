@@ -0,0 +1,277 @@
+#pragma once
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+#include "libra/core/RawImageReading.hpp"
+#include "libra/util/ThreadPool.h"
+#include "turbojpeg.h"
+
+namespace libra {
+namespace io {
+
+/**
+ * @brief Encode mode for YUYV JPEG encoder
+ */
+enum class YuyvEncodeMode {
+    Planar,  //!< convert the whole frame to YUV422 planar buffer, then compress using `tjCompressFromYUV()`
+    Direct,  //!< convert one MCU row each time into a small buffer, and feed to the raw data API of libjpeg
+    Stripe,  //!< split frame into stripes of whole MCU rows, encode them in parallel with direct mode and stitch them
+             //!< into one JPEG with restart markers between stripes
+};
+
+/**
+ * @brief DCT method for JPEG encoding
+ */
+enum class JpegDctMethod {
+    Auto,   //!< same with `TJFLAG_FASTDCT` of turbojpeg, the slow integer DCT for quality >= 96, otherwise the fast one
+    Slow,   //!< accurate integer DCT
+    Fast,   //!< fast integer DCT, which is less accurate. It's the same with `Auto` in planar mode
+    Float,  //!< floating-point DCT, it's the same with `Slow` in planar mode which isn't supported by turbojpeg
+};
+
+/**
+ * @brief Get the name of DCT method
+ *
+ * @param method    DCT method
+ * @return  Name of DCT method
+ */
+inline std::string toString(JpegDctMethod method) {
+    switch (method) {
+        case JpegDctMethod::Slow:
+            return "slow";
+        case JpegDctMethod::Fast:
+            return "fast";
+        case JpegDctMethod::Float:
+            return "float";
+        default:
+            return "auto";
+    }
+}
+
+/**
+ * @brief Region of interest of image
+ */
+struct ImageRoi {
+    int x = 0;       //!< left column, should be even for YUYV image
+    int y = 0;       //!< top row
+    int width = 0;   //!< ROI width, 0 to the right border of image
+    int height = 0;  //!< ROI height, 0 to the bottom border of image
+};
+
+/**
+ * @brief Geometry of the encoded image after ROI crop and binning.
+ *
+ * The pixel coordinate of input image is transformed to the encoded image by u' = scale * u + offsetX and
+ * v' = scale * v + offsetY, with the origin at the center of top-left pixel. So the intrinsics of encoded image are
+ * fx' = scale * fx, fy' = scale * fy, cx' = scale * cx + offsetX and cy' = scale * cy + offsetY, and the distortion
+ * parameters are unchanged.
+ */
+struct EncodeGeometry {
+    int inputWidth = 0;   //!< input image width
+    int inputHeight = 0;  //!< input image height
+    ImageRoi roi;         //!< ROI in input image, the size is resolved and rounded to the multiple of binning
+    int binning = 1;      //!< binning factor
+    int width = 0;        //!< encoded image width
+    int height = 0;       //!< encoded image height
+    double scale = 1;     //!< scale of pixel coordinate
+    double offsetX = 0;   //!< offset of x coordinate, pixel
+    double offsetY = 0;   //!< offset of y coordinate, pixel
+};
+
+/**
+ * @brief Convert encode geometry to json
+ * @param j         Json
+ * @param geometry  Encode geometry
+ */
+void to_json(nlohmann::json& j, const EncodeGeometry& geometry);
+
+/**
+ * @brief Convert json to encode geometry
+ * @param j         Json
+ * @param geometry  Encode geometry
+ */
+void from_json(const nlohmann::json& j, EncodeGeometry& geometry);
+
+/**
+ * @brief Parameters for YUYV JPEG encoder
+ */
+struct YuyvEncodeParams {
+    YuyvEncodeMode mode = YuyvEncodeMode::Direct;                     //!< encode mode
+    int quality = 95;                                                 //!< JPEG quality, [1, 100]
+    core::JpegSubsampling subsampling = core::JpegSubsampling::S422;  //!< chroma subsampling of output JPEG
+    JpegDctMethod dctMethod = JpegDctMethod::Auto;                    //!< DCT method
+    int stripeNum = 0;  //!< stripe number in stripe mode, 0 for the thread number of pool
+    int restartRows = 0;  //!< restart interval in MCU rows, 0 to disable. It isn't supported in planar mode, and the
+                          //!< stripe height is rounded up to the multiple of it in stripe mode
+    ImageRoi roi;         //!< ROI to crop before encoding, the whole image by default
+    int binning = 1;      //!< binning factor after crop, 1 or 2. The 2x2 pixels are averaged into one if it's 2
+};
+
+/**
+ * @brief JPEG encoder for YUYV(YUV422 Packed) image, the output is YUV422 JPEG by default, and could be YUV420 or
+ * grayscale JPEG to reduce the encode time and size.
+ *
+ * The output of planar and direct mode are the same with `tjCompressFromYUV(..., TJSAMP_422, ..., TJFLAG_FASTDCT)`.
+ * For YUV420 output, the chroma of two neighbor rows are averaged with rounding, and the grayscale output only encodes
+ * the Y channel. The direct mode doesn't need the full frame planar buffer, which saves an extra write and read of
+ * 2 * W * H bytes per frame and keeps the working buffer in cache.
+ *
+ * The stripe mode encodes the stripes of one frame on thread pool, which reduces the encode latency of one frame by the
+ * thread number. Each stripe is a restart interval, so the stripes are encoded independently, and the output is a valid
+ * JPEG with DRI marker and RST markers, which decodes to the same image with direct mode. The stripes are encoded one
+ * by one in the calling thread if the thread pool isn't set. If restart is enabled, each stripe has several restart
+ * intervals, and the output is the same with direct mode.
+ *
+ * The ROI crop and 2x2 binning are fused into the conversion of each row in all modes, so the encoder only converts
+ * and compresses the pixels to keep. The binned output is the same with encoding the averaged YUV422 image, see
+ * `util::yuyvBin2x2Row()`, and `geometry()` gives the transform of pixel coordinates for the intrinsics.
+ *
+ * @note The encoder is not thread safe, each thread should have its own encoder
+ */
+class YuyvJpegEncoder {
+  public:
+    /**
+     * @brief Constructor
+     * @param params        Encode parameters
+     * @param threadPool    Thread pool to encode stripes in stripe mode, it could be shared by several encoders
+     */
+    explicit YuyvJpegEncoder(const YuyvEncodeParams& params = YuyvEncodeParams(),
+                             const std::shared_ptr<util::ThreadPool>& threadPool = nullptr);
+
+    /**
+     * @brief Destructor
+     */
+    ~YuyvJpegEncoder();
+
+    // non-copyable
+    YuyvJpegEncoder(const YuyvJpegEncoder&) = delete;
+    YuyvJpegEncoder& operator=(const YuyvJpegEncoder&) = delete;
+
+  public:
+    /**
+     * @brief Get the encode parameters
+     * @return Encode parameters
+     */
+    inline const YuyvEncodeParams& params() const { return params_; }
+
+    /**
+     * @brief Set the encode parameters
+     * @param params Encode parameters
+     */
+    void setParams(const YuyvEncodeParams& params);
+
+    /**
+     * @brief Get the thread pool to encode stripes
+     * @return Thread pool
+     */
+    inline const std::shared_ptr<util::ThreadPool>& threadPool() const { return threadPool_; }
+
+    /**
+     * @brief Set the thread pool to encode stripes in stripe mode
+     * @param threadPool Thread pool, the stripes are encoded in calling thread if it's null
+     */
+    void setThreadPool(const std::shared_ptr<util::ThreadPool>& threadPool);
+
+    /**
+     * @brief Get the steady clock time when the YUYV conversion of last encoded frame is done. The conversion is fused
+     * with compression in direct and stripe mode, so it's the start time of encoding in these modes
+     * @return Conversion done time, ns
+     */
+    inline std::int64_t convertDoneTime() const { return convertDoneTime_; }
+
+    /**
+     * @brief Compress YUYV image to JPEG
+     *
+     * @param yuyv      YUYV image
+     * @param width     Image width, should be even
+     * @param height    Image height
+     * @param stride    Row stride of YUYV image in bytes, could be larger than 2 * width to compress only the left part
+     * of a side-by-side stereo image
+     * @param jpegBuf   Output JPEG buffer, it's allocated by encoder and should be released by `tjFree()`
+     * @param jpegSize  Output JPEG size
+     * @return True if compress success, otherwise return false and the JPEG buffer will be released
+     */
+    bool encode(const unsigned char* yuyv, int width, int height, int stride, unsigned char** jpegBuf,
+                unsigned long* jpegSize);
+
+    /**
+     * @brief Compress YUYV image to JPEG into a preallocated buffer, the buffer won't be reallocated by encoder. It's
+     * used to compress into the pooled buffer to avoid allocating output buffer for each frame
+     *
+     * @param yuyv      YUYV image
+     * @param width     Image width, should be even
+     * @param height    Image height
+     * @param stride    Row stride of YUYV image in bytes
+     * @param jpegBuf   Preallocated output JPEG buffer, its size should be at least `bufferSize(width, height)`
+     * @param capacity  Size of the output JPEG buffer in bytes
+     * @param jpegSize  Output JPEG size
+     * @return True if compress success, otherwise return false
+     */
+    bool encodeTo(const unsigned char* yuyv, int width, int height, int stride, unsigned char* jpegBuf,
+                  unsigned long capacity, unsigned long* jpegSize);
+
+    /**
+     * @brief Get the worst case JPEG buffer size for the image with specified size
+     *
+     * @param width     Image width
+     * @param height    Image height
+     * @return Maximum JPEG size in bytes
+     */
+    static unsigned long bufferSize(int width, int height);
+
+    /**
+     * @brief Get the geometry of encoded image after ROI crop and binning. The ROI width is rounded down to the
+     * multiple of 2 * binning and the height to the multiple of binning, so the encoded YUYV image has even width
+     *
+     * @param params    Encode parameters
+     * @param width     Input image width
+     * @param height    Input image height
+     * @param geometry  Output encode geometry
+     * @return True if the ROI and binning are valid for the image size, otherwise return false
+     */
+    static bool geometry(const YuyvEncodeParams& params, int width, int height, EncodeGeometry* geometry);
+
+  private:
+    struct DirectCompressor;  // libjpeg compressor for direct mode
+    struct Stripe;            // compressor and output buffer of one stripe
+
+    /**
+     * @brief Crop the ROI of input image, the image pointer is moved to the top-left of ROI and the size is changed to
+     * the output size. The binning is done with the conversion of each row in compress functions
+     * @return True if the ROI and binning are valid
+     */
+    bool crop(const unsigned char** yuyv, int* width, int* height, int stride) const;
+
+    /**
+     * @brief Compress using planar mode, the output buffer won't be reallocated if capacity isn't zero
+     */
+    bool encodePlanar(const unsigned char* yuyv, int width, int height, int stride, unsigned char** jpegBuf,
+                      unsigned long* jpegSize, unsigned long capacity);
+
+    /**
+     * @brief Compress using direct mode with the specified compressor, the output buffer won't be reallocated if
+     * capacity isn't zero. It could be called in several threads with different compressors. The restart interval is
+     * passed separately because the stripes in stripe mode use their own
+     */
+    bool encodeDirect(DirectCompressor& direct, const unsigned char* yuyv, int width, int height, int stride,
+                      unsigned char** jpegBuf, unsigned long* jpegSize, unsigned long capacity, int restartRows);
+
+    /**
+     * @brief Compress using stripe mode, the output buffer won't be reallocated if capacity isn't zero
+     */
+    bool encodeStripe(const unsigned char* yuyv, int width, int height, int stride, unsigned char** jpegBuf,
+                      unsigned long* jpegSize, unsigned long capacity);
+
+  private:
+    YuyvEncodeParams params_;                       // encode parameters
+    tjhandle compressor_;                           // turbojpeg compressor for planar mode
+    std::vector<unsigned char> yuvData_;            // YUV422 planar buffer for planar mode
+    std::unique_ptr<DirectCompressor> direct_;      // libjpeg compressor for direct mode
+    std::shared_ptr<util::ThreadPool> threadPool_;  // thread pool to encode stripes
+    std::vector<std::unique_ptr<Stripe>> stripes_;  // stripes for stripe mode
+    std::int64_t convertDoneTime_;                  // time when the conversion of last frame is done, ns
+};
+
+}  // namespace io
+}  // namespace libra
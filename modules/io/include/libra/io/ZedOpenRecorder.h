@@ -2,8 +2,9 @@
 #include <Eigen/Core>
 #include <zed-open-capture/sensorcapture.hpp>
 #include <zed-open-capture/videocapture.hpp>
+#include "libra/io/AdaptiveEncodeController.h"
 #include "libra/io/IRecorder.hpp"
-#include "turbojpeg.h"
+#include "libra/io/YuyvJpegEncoder.h"
 
 namespace libra {
 namespace io {
@@ -30,6 +31,14 @@ class ZedOpenRecorder : public IRecorder {
         std::chrono::time_point<std::chrono::system_clock> systemTime;  // system time point
     };
 
+    /**
+     * @brief Raw image frame captured from SDK with the timestamps of pipeline stages
+     */
+    struct RawImage {
+        std::shared_ptr<sl_oc::video::ImageFrame> frame;  // image frame
+        core::FrameTrace trace;                           // timestamps of pipeline stages
+    };
+
   public:
     /**
      * @brief Constructor
@@ -79,6 +88,27 @@ class ZedOpenRecorder : public IRecorder {
      */
     inline const std::size_t& saverThreadNum() const { return saverThreadNum_; }
 
+    /**
+     * @brief Get the parameters to encode YUYV image
+     *
+     * @return  Encode parameters
+     */
+    inline const YuyvEncodeParams& encodeParams() const { return encodeParams_; }
+
+    /**
+     * @brief Get the geometry of encoded image after ROI crop and binning, it's valid after `init()`
+     *
+     * @return  Encode geometry, which gives the intrinsics of encoded image
+     */
+    inline const EncodeGeometry& encodeGeometry() const { return encodeGeometry_; }
+
+    /**
+     * @brief Get the controller to adjust encode quality
+     *
+     * @return  Adaptive encode controller, null if the encode quality is fixed
+     */
+    inline const std::shared_ptr<AdaptiveEncodeController>& encodeController() const { return encodeController_; }
+
     /**
      * @brief Is the right camera is enabled
      *
@@ -114,6 +144,21 @@ class ZedOpenRecorder : public IRecorder {
      */
     void setSaverThreadNum(const std::size_t& saverThreadNum);
 
+    /**
+     * @brief Set the parameters to encode YUYV image, should be set before `init()`
+     *
+     * @param params  Encode parameters
+     */
+    void setEncodeParams(const YuyvEncodeParams& params);
+
+    /**
+     * @brief Set the controller to adjust encode quality by the image queue size and encode time, should be set before
+     * `init()`. The quality and subsampling of encode parameters are overridden by the controller
+     *
+     * @param controller  Adaptive encode controller, null to use fixed encode quality
+     */
+    void setEncodeController(const std::shared_ptr<AdaptiveEncodeController>& controller);
+
     /**
      * @brief Set process function for raw image record of right camera
      *
@@ -158,6 +203,11 @@ class ZedOpenRecorder : public IRecorder {
     sl_oc::video::FPS fps_;                // frame rate, Hz
     sl_oc::video::RESOLUTION resolution_;  // resolution
     std::size_t saverThreadNum_;           // image saver thread number
+    YuyvEncodeParams encodeParams_;        // parameters to encode YUYV image
+    EncodeGeometry encodeGeometry_;        // geometry of encoded image
+    std::shared_ptr<AdaptiveEncodeController> encodeController_;  // controller to adjust encode quality
+    std::shared_ptr<util::BufferPool> jpegBufferPool_;    // pool of output JPEG buffers for image saver threads
+    std::shared_ptr<util::ThreadPool> encodeThreadPool_;  // thread pool to encode stripes in stripe mode
 
     // raw image record process function for right camera
     std::function<void(const core::RawImageRecord&)> processRightRawImg_;
@@ -167,13 +217,13 @@ class ZedOpenRecorder : public IRecorder {
     std::shared_ptr<sl_oc::video::VideoCapture> cameraCapture_;  // video(camera) capture
     std::thread imuCaptureThread_;                               // thread to capture IMU
     // left raw image queue
-    std::shared_ptr<util::JobQueue<std::shared_ptr<sl_oc::video::ImageFrame>>> leftImageQueue_;
+    std::shared_ptr<util::MpmcQueue<RawImage>> leftImageQueue_;
     // right raw image queue
-    std::shared_ptr<util::JobQueue<std::shared_ptr<sl_oc::video::ImageFrame>>> rightImageQueue_;
-    std::shared_ptr<util::JobQueue<RawImu>> imuQueue_;  // raw IMU queue
-    std::vector<std::thread> leftImageSaverThreads_;    // image saver threads
-    std::vector<std::thread> rightImageSaverThreads_;   // image saver threads
-    std::thread imuSaverThread_;                        // IMU saver thread
+    std::shared_ptr<util::MpmcQueue<RawImage>> rightImageQueue_;
+    std::shared_ptr<util::SpscQueue<RawImu>> imuQueue_;  // raw IMU queue
+    std::vector<std::thread> leftImageSaverThreads_;     // image saver threads
+    std::vector<std::thread> rightImageSaverThreads_;    // image saver threads
+    std::thread imuSaverThread_;                         // IMU saver thread
 };
 
 }  // namespace io
@@ -0,0 +1,86 @@
+#include "libra/io/AdaptiveEncodeController.h"
+#include <fmt/format.h>
+#include <glog/logging.h>
+#include <algorithm>
+
+using namespace std;
+using namespace libra::core;
+using namespace libra::io;
+
+namespace {
+
+constexpr double kSmoothFactor = 0.1;  // factor of exponential moving average of encode time
+constexpr double kIdleRatio = 0.7;     // the encoder is idle if the encode time is less than this ratio of budget
+
+}  // namespace
+
+// Constructor
+AdaptiveEncodeController::AdaptiveEncodeController(const AdaptiveEncodeParams& params)
+    : params_(params), level_(0), changeNum_(0), encodeTime_(-1), overloadNum_(0), idleNum_(0) {
+    CHECK(!params_.levels.empty()) << "the levels of adaptive encode controller shouldn't be empty";
+    CHECK_LE(params_.lowWaterSize, params_.highWaterSize) << "low water size should be less than high water size";
+    // in grayscale mode, the levels only differ by subsampling are the same, so they're collapsed into one
+    if (params_.gray) {
+        for (auto& level : params_.levels) {
+            level.subsampling = JpegSubsampling::Gray;
+        }
+        params_.levels.erase(unique(params_.levels.begin(), params_.levels.end(),
+                                    [](const EncodeLevel& a, const EncodeLevel& b) { return a.quality == b.quality; }),
+                             params_.levels.end());
+    }
+}
+
+// Get the encode information of current level
+EncodeInfo AdaptiveEncodeController::encodeInfo() const {
+    int level = level_.load(memory_order_relaxed);
+    EncodeInfo info;
+    info.quality = params_.levels[level].quality;
+    info.subsampling = params_.levels[level].subsampling;
+    info.level = level;
+    return info;
+}
+
+// Apply the current level to encode parameters
+EncodeInfo AdaptiveEncodeController::apply(YuyvEncodeParams& params) const {
+    EncodeInfo info = encodeInfo();
+    params.quality = info.quality;
+    params.subsampling = info.subsampling;
+    return info;
+}
+
+// Update the controller after encoding one frame
+bool AdaptiveEncodeController::update(size_t queueSize, double encodeTime) {
+    lock_guard<mutex> lock(mutex_);
+    encodeTime_ = encodeTime_ < 0 ? encodeTime : kSmoothFactor * encodeTime + (1 - kSmoothFactor) * encodeTime_;
+
+    // check the encoder is overloaded or idle
+    const bool hasBudget = params_.encodeBudget > 0;
+    bool overload = queueSize > params_.highWaterSize || (hasBudget && encodeTime_ > params_.encodeBudget);
+    bool idle = queueSize <= params_.lowWaterSize && (!hasBudget || encodeTime_ < kIdleRatio * params_.encodeBudget);
+    overloadNum_ = overload ? overloadNum_ + 1 : 0;
+    idleNum_ = idle ? idleNum_ + 1 : 0;
+
+    // step down or up
+    const int lastLevel = level_.load(memory_order_relaxed);
+    int level = lastLevel;
+    if (overloadNum_ >= params_.downFrameNum && level + 1 < static_cast<int>(params_.levels.size())) {
+        ++level;
+    } else if (idleNum_ >= params_.upFrameNum && level > 0) {
+        --level;
+    } else {
+        return false;
+    }
+
+    // the encode time of new level is different, so restart the average and counting
+    level_.store(level, memory_order_relaxed);
+    changeNum_.fetch_add(1, memory_order_relaxed);
+    encodeTime_ = -1;
+    overloadNum_ = 0;
+    idleNum_ = 0;
+    const EncodeInfo info = encodeInfo();
+    LOG(INFO) << fmt::format("{} encode level {} => {}, quality = {}, subsampling = {}, queue size = {}, "
+                             "encode time = {:.2f} ms",
+                             level > lastLevel ? "step down" : "step up", lastLevel, level, info.quality,
+                             toString(info.subsampling), queueSize, encodeTime * 1.0E3);
+    return true;
+}
@@ -0,0 +1,376 @@
+#include "libra/io/AsyncFileSink.h"
+#include <fcntl.h>
+#include <fmt/format.h>
+#include <glog/logging.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <vector>
+#include "libra/util/TraceRecorder.h"
+#if defined(WITH_IO_URING)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+using namespace std;
+using namespace libra::core;
+using namespace libra::util;
+using namespace libra::io;
+
+namespace {
+
+/**
+ * @brief Write all the data to file descriptor at offset, retry if it's interrupted or partially written
+ */
+bool writeAll(int fd, const char* data, size_t size, uint64_t offset) {
+    while (size > 0) {
+        ssize_t n = pwrite(fd, data, size, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+}  // namespace
+
+/**
+ * @brief Positional write request
+ */
+struct AsyncFileSink::Request {
+    int fd = -1;                 // file descriptor
+    const char* data = nullptr;  // data buffer
+    size_t size = 0;             // data size
+    uint64_t offset = 0;         // file offset
+    Callback callback;           // callback after completed
+    struct iovec iov {};         // IO vector for io_uring, it should be valid until completed
+};
+
+/**
+ * @brief io_uring instance with the mapped submission and completion queue. The requests are pushed into pending queue
+ * by the submission threads, and only the ring thread touches the rings
+ */
+struct AsyncFileSink::IoUring {
+#if defined(WITH_IO_URING)
+    int fd = -1;                                // io_uring file descriptor
+    unsigned entries = 0;                       // queue entry number
+    void* sqRing = MAP_FAILED;                  // mapped submission queue ring
+    size_t sqRingSize = 0;                      // submission queue ring size
+    void* cqRing = MAP_FAILED;                  // mapped completion queue ring
+    size_t cqRingSize = 0;                      // completion queue ring size
+    struct io_uring_sqe* sqes = nullptr;        // submission queue entries
+    size_t sqesSize = 0;                        // size of submission queue entries
+    unsigned *sqHead{}, *sqTail{};              // submission queue head and tail
+    unsigned *sqMask{}, *sqArray{};             // submission queue mask and index array
+    unsigned *cqHead{}, *cqTail{}, *cqMask{};   // completion queue pointers
+    struct io_uring_cqe* cqes = nullptr;        // completion queue entries
+    size_t submittedNum = 0;                    // requests in submission queue or kernel and not completed
+#endif
+    mutex pendingMutex;                  // mutex for pending requests
+    condition_variable pendingCv;        // condition variable for pending requests
+    deque<unique_ptr<Request>> pending;  // requests not submitted
+    bool stop = false;                   // flag to stop ring thread
+
+    // setup io_uring and map the rings, return false if it's not supported
+    bool init(unsigned entryNum) {
+#if defined(WITH_IO_URING) && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+        struct io_uring_params p;
+        memset(&p, 0, sizeof(p));
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, entryNum, &p));
+        if (fd < 0) {
+            LOG(WARNING) << fmt::format("io_uring isn't supported: {}", strerror(errno));
+            return false;
+        }
+        entries = p.sq_entries;
+        sqRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cqRingSize = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+        bool singleMap{false};
+#if defined(IORING_FEAT_SINGLE_MMAP)
+        if (p.features & IORING_FEAT_SINGLE_MMAP) {
+            singleMap = true;
+            sqRingSize = cqRingSize = max(sqRingSize, cqRingSize);
+        }
+#endif
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED) {
+            return false;
+        }
+        cqRing = singleMap ? sqRing
+                           : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                                  IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) {
+            return false;
+        }
+        sqesSize = p.sq_entries * sizeof(struct io_uring_sqe);
+        void* sqesMap = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if (sqesMap == MAP_FAILED) {
+            return false;
+        }
+        sqes = static_cast<struct io_uring_sqe*>(sqesMap);
+
+        char* sq = static_cast<char*>(sqRing);
+        char* cq = static_cast<char*>(cqRing);
+        sqHead = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+        cqHead = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+        cqes = reinterpret_cast<struct io_uring_cqe*>(cq + p.cq_off.cqes);
+        return true;
+#else
+        (void)entryNum;
+        LOG(WARNING) << "io_uring isn't compiled";
+        return false;
+#endif
+    }
+
+    ~IoUring() {
+#if defined(WITH_IO_URING)
+        if (sqes) {
+            munmap(sqes, sqesSize);
+        }
+        if (cqRing != MAP_FAILED && cqRing != sqRing) {
+            munmap(cqRing, cqRingSize);
+        }
+        if (sqRing != MAP_FAILED) {
+            munmap(sqRing, sqRingSize);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+#endif
+    }
+};
+
+// Get the name of sink backend
+string libra::io::toString(AsyncSinkBackend backend) {
+    switch (backend) {
+        case AsyncSinkBackend::ThreadPool:
+            return "ThreadPool";
+        case AsyncSinkBackend::IoUring:
+            return "IoUring";
+        default:
+            return "Unknown";
+    }
+}
+
+// Constructor
+AsyncFileSink::AsyncFileSink(const AsyncSinkParams& params)
+    : params_(params), backend_(AsyncSinkBackend::ThreadPool), inflightNum_(0), completedNum_(0), errorNum_(0) {
+    CHECK_GT(params_.threadNum, 0) << "thread number should be larger than 0";
+    CHECK_GT(params_.queueDepth, 0) << "queue depth should be larger than 0";
+    pool_ = make_unique<ThreadPool>(params_.threadNum);
+    if (params_.useIoUring) {
+        auto ring = make_unique<IoUring>();
+        if (ring->init(static_cast<unsigned>(params_.queueDepth))) {
+            ring_ = move(ring);
+            backend_ = AsyncSinkBackend::IoUring;
+            ringThread_ = thread(&AsyncFileSink::ringLoop, this);
+        }
+    }
+    LOG(INFO) << fmt::format("async file sink backend: {}", toString(backend_));
+}
+
+// Destructor
+AsyncFileSink::~AsyncFileSink() {
+    wait();
+    if (ring_) {
+        {
+            lock_guard<mutex> lock(ring_->pendingMutex);
+            ring_->stop = true;
+        }
+        ring_->pendingCv.notify_one();
+        ringThread_.join();
+    }
+    pool_.reset();
+}
+
+// Get the number of in-flight writes
+size_t AsyncFileSink::inflightNum() const {
+    lock_guard<mutex> lock(mutex_);
+    return inflightNum_;
+}
+
+// Create the file and write the image into it asynchronously
+void AsyncFileSink::writeFile(const string& file, const RawImageReading& reading, Callback callback) {
+    acquire();
+    pool_->post([this, file, owned = reading.owned(), callback = move(callback)]() mutable {
+        LIBRA_TRACE_SCOPE("AsyncFileSink::writeFile");
+        bool success{false};
+        int fd = open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            LOG(ERROR) << fmt::format("cannot create file \"{}\": {}", file, strerror(errno));
+        } else {
+            success = writeAll(fd, reinterpret_cast<const char*>(owned.buffer()), owned.size(), 0);
+            LOG_IF(ERROR, !success) << fmt::format("failed to write file \"{}\": {}", file, strerror(errno));
+            close(fd);
+        }
+        // release the buffer before callback, so it could be recycled
+        owned = RawImageReading();
+        complete(success, move(callback));
+    });
+}
+
+// Write the buffer to file at offset asynchronously
+void AsyncFileSink::write(int fd, const void* data, size_t size, uint64_t offset, Callback callback) {
+    acquire();
+    if (ring_) {
+        auto request = make_unique<Request>();
+        request->fd = fd;
+        request->data = static_cast<const char*>(data);
+        request->size = size;
+        request->offset = offset;
+        request->callback = move(callback);
+        {
+            lock_guard<mutex> lock(ring_->pendingMutex);
+            ring_->pending.emplace_back(move(request));
+        }
+        ring_->pendingCv.notify_one();
+        return;
+    }
+
+    pool_->post([this, fd, data, size, offset, callback = move(callback)]() mutable {
+        LIBRA_TRACE_SCOPE("AsyncFileSink::write");
+        bool success = writeAll(fd, static_cast<const char*>(data), size, offset);
+        LOG_IF(ERROR, !success) << fmt::format("failed to write {} bytes at offset {}: {}", size, offset,
+                                               strerror(errno));
+        complete(success, move(callback));
+    });
+}
+
+// Wait all the submitted writes are completed
+void AsyncFileSink::wait() {
+    unique_lock<mutex> lock(mutex_);
+    inflightCv_.wait(lock, [&]() { return inflightNum_ == 0; });
+}
+
+// Wait for a free slot of in-flight writes
+void AsyncFileSink::acquire() {
+    unique_lock<mutex> lock(mutex_);
+    if (inflightNum_ >= params_.queueDepth) {
+        LIBRA_TRACE_SCOPE("AsyncFileSink::acquire");
+        inflightCv_.wait(lock, [&]() { return inflightNum_ < params_.queueDepth; });
+    }
+    ++inflightNum_;
+}
+
+// Release the slot of in-flight write, and run its callback. The callback is destroyed before releasing the slot, so
+// the resources captured by it are released when `wait()` returns
+void AsyncFileSink::complete(bool success, Callback callback) {
+    if (!success) {
+        errorNum_.fetch_add(1, memory_order_relaxed);
+    }
+    if (callback) {
+        callback(success);
+        callback = nullptr;
+    }
+    completedNum_.fetch_add(1, memory_order_relaxed);
+    {
+        lock_guard<mutex> lock(mutex_);
+        --inflightNum_;
+    }
+    inflightCv_.notify_all();
+}
+
+// Loop of io_uring thread. The pending requests are submitted in batch with one syscall, which also reaps the
+// completions. It blocks for one completion if there is nothing to submit, or waits for pending requests if nothing is
+// in flight
+void AsyncFileSink::ringLoop() {
+#if defined(WITH_IO_URING) && defined(__NR_io_uring_enter)
+    LIBRA_TRACE_THREAD("AsyncFileSink");
+    IoUring& ring = *ring_;
+    vector<unique_ptr<Request>> submitted(ring.entries);  // requests in kernel, indexed by slot
+    vector<unsigned> freeSlots;                           // free slots of requests
+    for (unsigned i = 0; i < ring.entries; ++i) {
+        freeSlots.emplace_back(ring.entries - 1 - i);
+    }
+
+    while (true) {
+        // take pending requests
+        vector<unique_ptr<Request>> batch;
+        {
+            unique_lock<mutex> lock(ring.pendingMutex);
+            if (ring.submittedNum == 0) {
+                ring.pendingCv.wait(lock, [&]() { return ring.stop || !ring.pending.empty(); });
+            }
+            if (ring.stop && ring.pending.empty() && ring.submittedNum == 0) {
+                break;
+            }
+            while (!ring.pending.empty() && batch.size() < freeSlots.size()) {
+                batch.emplace_back(move(ring.pending.front()));
+                ring.pending.pop_front();
+            }
+        }
+
+        // fill submission queue, the ring thread is the only producer
+        unsigned tail = *ring.sqTail;
+        for (auto& r : batch) {
+            unsigned slot = freeSlots.back();
+            freeSlots.pop_back();
+            r->iov.iov_base = const_cast<char*>(r->data);
+            r->iov.iov_len = r->size;
+            const unsigned index = tail & *ring.sqMask;
+            struct io_uring_sqe* sqe = &ring.sqes[index];
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_WRITEV;
+            sqe->fd = r->fd;
+            sqe->addr = reinterpret_cast<uint64_t>(&r->iov);
+            sqe->len = 1;
+            sqe->off = r->offset;
+            sqe->user_data = slot;
+            ring.sqArray[index] = index;
+            submitted[slot] = move(r);
+            ++tail;
+        }
+        __atomic_store_n(ring.sqTail, tail, __ATOMIC_RELEASE);
+        ring.submittedNum += batch.size();
+
+        // submit and wait completion. The kernel may consume fewer entries than requested, e.g., on EAGAIN or EBUSY,
+        // so all the entries after the kernel head are submitted, including the ones left by previous calls. It only
+        // blocks for completion if nothing is left to submit
+        {
+            LIBRA_TRACE_SCOPE("AsyncFileSink::enter");
+            const unsigned toSubmit = tail - __atomic_load_n(ring.sqHead, __ATOMIC_ACQUIRE);
+            const unsigned minComplete = toSubmit == 0 ? 1 : 0;
+            if (syscall(__NR_io_uring_enter, ring.fd, toSubmit, minComplete, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 &&
+                errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                LOG(ERROR) << fmt::format("io_uring_enter failed: {}", strerror(errno));
+            }
+        }
+
+        // reap completions
+        unsigned head = *ring.cqHead;
+        const unsigned cqTail = __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE);
+        for (; head != cqTail; ++head) {
+            const struct io_uring_cqe& cqe = ring.cqes[head & *ring.cqMask];
+            const auto slot = static_cast<unsigned>(cqe.user_data);
+            unique_ptr<Request> r = move(submitted[slot]);
+            freeSlots.emplace_back(slot);
+            --ring.submittedNum;
+
+            // finish the partial write synchronously, it's rare for regular file
+            bool success{false};
+            if (cqe.res < 0) {
+                LOG(ERROR) << fmt::format("failed to write {} bytes at offset {}: {}", r->size, r->offset,
+                                          strerror(-cqe.res));
+            } else {
+                const auto n = static_cast<size_t>(cqe.res);
+                success = n == r->size || writeAll(r->fd, r->data + n, r->size - n, r->offset + n);
+            }
+            complete(success, move(r->callback));
+        }
+        __atomic_store_n(ring.cqHead, head, __ATOMIC_RELEASE);
+    }
+#endif
+}
@@ -0,0 +1,43 @@
+#include "libra/io/FrameEncoder.h"
+#include <chrono>
+
+using namespace std;
+using namespace libra::util;
+using namespace libra::core;
+using namespace libra::io;
+
+// Constructor
+FrameEncoder::FrameEncoder(const YuyvEncodeParams& params, shared_ptr<BufferPool> bufferPool,
+                           shared_ptr<ThreadPool> threadPool, shared_ptr<AdaptiveEncodeController> controller)
+    : params_(params),
+      encoder_(params, move(threadPool)),
+      bufferPool_(move(bufferPool)),
+      controller_(move(controller)) {}
+
+// Encode YUYV frame into the record
+bool FrameEncoder::encode(const unsigned char* yuyv, int width, int height, int stride, const QueueSize& queueSize,
+                          FrameTrace& trace, RawImageRecord& record) {
+    // lease the output buffer from pool, it's returned to pool when all copies of record are destroyed
+    unsigned long capacity = YuyvJpegEncoder::bufferSize(width, height);
+    shared_ptr<unsigned char> buffer = bufferPool_->lease(capacity);
+    unsigned long size{0};
+    // apply the quality of adaptive encode controller, and report the queue size and encode time to it
+    EncodeInfo encodeInfo{params_.quality, params_.subsampling, 0};
+    if (controller_) {
+        encodeInfo = controller_->apply(params_);
+        encoder_.setParams(params_);
+    }
+    auto t0 = chrono::steady_clock::now();
+    if (!encoder_.encodeTo(yuyv, width, height, stride, buffer.get(), capacity, &size)) {
+        return false;
+    }
+    trace.convert = encoder_.convertDoneTime();
+    trace.encode = FrameTrace::now();
+    if (controller_) {
+        controller_->update(queueSize(), chrono::duration<double>(chrono::steady_clock::now() - t0).count());
+    }
+    record.reading().setData(move(buffer), size);
+    record.reading().setEncodeInfo(encodeInfo);
+    record.reading().setTrace(trace);
+    return true;
+}
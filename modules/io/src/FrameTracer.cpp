@@ -0,0 +1,92 @@
+#include "libra/io/FrameTracer.h"
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+#include <glog/logging.h>
+#include <fstream>
+#include <nlohmann/json.hpp>
+
+using namespace std;
+using namespace libra::util;
+using namespace libra::core;
+using namespace libra::io;
+
+namespace libra {
+namespace io {
+
+// Get the name of pipeline stage
+string toString(PipelineStage stage) {
+    switch (stage) {
+        case PipelineStage::Enqueue:
+            return "enqueue";
+        case PipelineStage::Queue:
+            return "queue";
+        case PipelineStage::Convert:
+            return "convert";
+        case PipelineStage::Encode:
+            return "encode";
+        case PipelineStage::Sink:
+            return "sink";
+        default:
+            return "total";
+    }
+}
+
+// Print the statistics of all stages to output stream
+ostream& operator<<(ostream& os, const FrameTracer& tracer) {
+    for (size_t i = 0; i < FrameTracer::kStageNum; ++i) {
+        if (i != 0) {
+            os << endl;
+        }
+        os << fmt::format("{:>8s}: {}", toString(static_cast<PipelineStage>(i)), tracer.histograms_[i].stats());
+    }
+    return os;
+}
+
+}  // namespace io
+}  // namespace libra
+
+// Add the trace of one frame
+void FrameTracer::add(const FrameTrace& trace) {
+    auto record = [&](PipelineStage stage, int64_t start, int64_t end) {
+        if (start != 0 && end != 0) {
+            histograms_[static_cast<size_t>(stage)].record(end - start);
+        }
+    };
+    record(PipelineStage::Enqueue, trace.capture, trace.enqueue);
+    record(PipelineStage::Queue, trace.enqueue, trace.dequeue);
+    record(PipelineStage::Convert, trace.dequeue, trace.convert);
+    record(PipelineStage::Encode, trace.convert, trace.encode);
+    // the frame may be not encoded by recorder, e.g., MJPG stream or replayed file, then the sink starts at dequeue
+    record(PipelineStage::Sink, trace.encode != 0 ? trace.encode : trace.dequeue, trace.sink);
+    record(PipelineStage::Total, trace.capture, trace.sink);
+}
+
+// Clear all the traces
+void FrameTracer::reset() {
+    for (auto& h : histograms_) {
+        h.reset();
+    }
+}
+
+// Export the statistics of all stages as JSON
+string FrameTracer::toJson() const {
+    nlohmann::json j;
+    for (size_t i = 0; i < kStageNum; ++i) {
+        LatencyStats stats = histograms_[i].stats();
+        j[toString(static_cast<PipelineStage>(i))] = {
+            {"count", stats.count},        {"mean", stats.mean * 1.0E-6}, {"min", stats.min * 1.0E-6},
+            {"p50", stats.p50 * 1.0E-6},   {"p90", stats.p90 * 1.0E-6},   {"p99", stats.p99 * 1.0E-6},
+            {"p999", stats.p999 * 1.0E-6}, {"max", stats.max * 1.0E-6}};
+    }
+    return j.dump(4);
+}
+
+// Save the statistics of all stages to JSON file
+void FrameTracer::save(const string& file) const {
+    fstream fs(file, ios::out);
+    if (!fs.is_open()) {
+        LOG(ERROR) << fmt::format("cannot open file \"{}\" to save frame trace", file);
+        return;
+    }
+    fs << toJson() << endl;
+}
@@ -0,0 +1,491 @@
+#include "libra/io/ImageContainer.h"
+#include <fcntl.h>
+#include <fmt/format.h>
+#include <glog/logging.h>
+#include <unistd.h>
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+using namespace libra::io;
+namespace fs = boost::filesystem;
+
+namespace {
+
+constexpr char kIndexMagic[8] = {'L', 'I', 'B', 'R', 'A', 'I', 'D', 'X'};  // magic of index file
+constexpr uint32_t kIndexVersion = 1;                                    // version of index file
+constexpr uint32_t kRecordMagic = 0x4345524C;                            // magic of record, "LREC" in little endian
+constexpr size_t kRecordHeaderSize = 16;                                 // record header size, bytes
+constexpr size_t kBlockAlignment = 4096;                                 // alignment of block for O_DIRECT, bytes
+
+/**
+ * @brief Get the segment file name
+ */
+string segmentName(size_t index) { return fmt::format("segment-{:06d}.dat", index); }
+
+/**
+ * @brief List the segment files in container folder by index, the segment deleted in rolling record is empty
+ */
+vector<string> listSegments(const string& folder) {
+    vector<string> segments;
+    boost::system::error_code ec;
+    for (fs::directory_iterator it(folder, ec), end; !ec && it != end; it.increment(ec)) {
+        const string name = it->path().filename().string();
+        if (name.size() != segmentName(0).size() || name.compare(0, 8, "segment-") != 0 ||
+            name.compare(name.size() - 4, 4, ".dat") != 0 ||
+            !all_of(name.begin() + 8, name.end() - 4, [](char c) { return isdigit(c) != 0; })) {
+            continue;
+        }
+        const size_t index = stoul(name.substr(8, name.size() - 12));
+        if (index >= segments.size()) {
+            segments.resize(index + 1);
+        }
+        segments[index] = it->path().string();
+    }
+    return segments;
+}
+
+/**
+ * @brief Write all the data to file descriptor at offset, retry if it's interrupted or partially written
+ */
+bool writeAll(int fd, const void* data, size_t size, uint64_t offset) {
+    const char* p = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = pwrite(fd, p, size, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p += n;
+        size -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+}  // namespace
+
+/**
+ * @brief Opened segment file. It's shared with the in-flight writes of async sink, and is truncated to the used size
+ * and closed when the last owner drops it, i.e., after all the writes to it are completed
+ */
+struct ImageContainerWriter::Segment {
+    int fd = -1;        // file descriptor
+    string file;        // file path
+    uint64_t size = 0;  // used size, it's set when the segment is closed
+
+    ~Segment() {
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            LOG(ERROR) << fmt::format("cannot truncate segment \"{}\": {}", file, strerror(errno));
+        }
+        ::close(fd);
+    }
+};
+
+// Constructor
+ImageContainerWriter::ImageContainerWriter(const ContainerParams& params)
+    : params_(params),
+      blockPool_(params.blockSize + kBlockAlignment),
+      segmentIndex_(0),
+      segmentOffset_(0),
+      blockData_(nullptr),
+      blockOffset_(0),
+      blockUsed_(0),
+      recordNum_(0),
+      segmentStartTime_(0),
+      closedSize_(0),
+      deletedNum_(0) {}
+
+// Destructor
+ImageContainerWriter::~ImageContainerWriter() { close(); }
+
+// Set the async sink to write the segments
+void ImageContainerWriter::setSink(shared_ptr<AsyncFileSink> sink) {
+    lock_guard<mutex> lock(mutex_);
+    CHECK(!segment_) << "the async sink should be set before opening container";
+    CHECK(!sink || (params_.blockSize > 0 && params_.blockSize % kBlockAlignment == 0))
+        << fmt::format("block size should be multiple of {} bytes", kBlockAlignment);
+    sink_ = move(sink);
+}
+
+// Check whether the container is opened
+bool ImageContainerWriter::isOpen() const {
+    lock_guard<mutex> lock(mutex_);
+    return segment_ != nullptr;
+}
+
+// Get the number of appended images
+size_t ImageContainerWriter::recordNum() const {
+    lock_guard<mutex> lock(mutex_);
+    return recordNum_;
+}
+
+// Get the number of segment files
+size_t ImageContainerWriter::segmentNum() const {
+    lock_guard<mutex> lock(mutex_);
+    return folder_.empty() ? 0 : segmentIndex_ + 1;
+}
+
+// Get the number of segments deleted in rolling record
+size_t ImageContainerWriter::deletedSegmentNum() const {
+    lock_guard<mutex> lock(mutex_);
+    return deletedNum_;
+}
+
+// Get the used size of the segments not deleted
+uint64_t ImageContainerWriter::diskSize() const {
+    lock_guard<mutex> lock(mutex_);
+    return closedSize_ + (segment_ ? segmentOffset_ : 0);
+}
+
+// Open the container folder and create the first segment
+bool ImageContainerWriter::open(const string& folder) {
+    close();
+    lock_guard<mutex> lock(mutex_);
+    // remove old container, whose first segments may be deleted in rolling record
+    boost::system::error_code ec;
+    fs::create_directories(folder, ec);
+    for (const auto& file : listSegments(folder)) {
+        if (!file.empty()) {
+            fs::remove(file, ec);
+        }
+    }
+
+    // open index file and write header
+    string indexFile = (fs::path(folder) / "index.bin").string();
+    indexStream_.open(indexFile, ios::out | ios::trunc | ios::binary);
+    if (!indexStream_.is_open()) {
+        LOG(ERROR) << fmt::format("cannot open file \"{}\" to save image index", indexFile);
+        return false;
+    }
+    const uint32_t entrySize = sizeof(ContainerEntry);
+    indexStream_.write(kIndexMagic, sizeof(kIndexMagic));
+    indexStream_.write(reinterpret_cast<const char*>(&kIndexVersion), sizeof(kIndexVersion));
+    indexStream_.write(reinterpret_cast<const char*>(&entrySize), sizeof(entrySize));
+
+    // create the first segment
+    folder_ = folder;
+    segmentIndex_ = 0;
+    recordNum_ = 0;
+    closed_.clear();
+    closedSize_ = 0;
+    deletedNum_ = 0;
+    if (params_.rollingBudget > 0 && !deleter_) {
+        deleter_ = make_unique<util::ThreadPool>(1);
+    }
+    if (!nextSegment()) {
+        indexStream_.close();
+        folder_.clear();
+        return false;
+    }
+    return true;
+}
+
+// Append one image into container
+bool ImageContainerWriter::append(double timestamp, const unsigned char* data, size_t size) {
+    lock_guard<mutex> lock(mutex_);
+    if (!segment_) {
+        return false;
+    }
+    // create next segment if the record cannot fit into current one, or the time span of segment is reached. The
+    // record larger than segment size is written into an empty segment, which grows beyond the segment size
+    const uint64_t recordSize = kRecordHeaderSize + size;
+    if (segmentOffset_ > 0 &&
+        (segmentOffset_ + recordSize > params_.segmentSize ||
+         (params_.segmentDuration > 0 && timestamp - segmentStartTime_ >= params_.segmentDuration)) &&
+        !nextSegment()) {
+        return false;
+    }
+    if (segmentOffset_ == 0) {
+        segmentStartTime_ = timestamp;
+    }
+
+    // write record header and data
+    ContainerEntry entry;
+    entry.timestamp = static_cast<int64_t>(llround(timestamp * 1.0E9));
+    entry.segment = segmentIndex_;
+    entry.offset = segmentOffset_ + kRecordHeaderSize;
+    entry.size = static_cast<uint32_t>(size);
+    char header[kRecordHeaderSize];
+    memcpy(header, &kRecordMagic, 4);
+    memcpy(header + 4, &entry.size, 4);
+    memcpy(header + 8, &entry.timestamp, 8);
+    // rewind to the start of record if the write fails, so the torn record is overwritten by the next one or truncated
+    // when the segment is closed
+    const uint64_t recordOffset = segmentOffset_;
+    if (!writeSegment(header, kRecordHeaderSize) || !writeSegment(data, size)) {
+        segmentOffset_ = recordOffset;
+        LOG(ERROR) << fmt::format("failed to write image to segment {} of container \"{}\": {}", segmentIndex_,
+                                  folder_, strerror(errno));
+        return false;
+    }
+
+    // append index
+    indexStream_.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+    ++recordNum_;
+    return true;
+}
+
+// Flush the index, truncate the segment to used size and close the container
+void ImageContainerWriter::close() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        closeSegment();
+        if (indexStream_.is_open()) {
+            indexStream_.close();
+        }
+    }
+    if (sink_) {
+        sink_->wait();
+    }
+    if (deleter_) {
+        deleter_->wait();
+    }
+}
+
+// Write data to current segment directly, or copy it into block for async sink
+bool ImageContainerWriter::writeSegment(const void* data, size_t size) {
+    if (!sink_) {
+        if (!writeAll(segment_->fd, data, size, segmentOffset_)) {
+            return false;
+        }
+        segmentOffset_ += size;
+        return true;
+    }
+
+    // the block starts at the offset of multiple block size, because only the last block of segment is partial
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    while (size > 0) {
+        if (!block_) {
+            block_ = blockPool_.lease();
+            auto address = reinterpret_cast<uintptr_t>(block_.get());
+            blockData_ = reinterpret_cast<unsigned char*>((address + kBlockAlignment - 1) & ~(kBlockAlignment - 1));
+            blockOffset_ = segmentOffset_;
+            blockUsed_ = 0;
+        }
+        const size_t n = min(size, params_.blockSize - blockUsed_);
+        memcpy(blockData_ + blockUsed_, p, n);
+        blockUsed_ += n;
+        segmentOffset_ += n;
+        p += n;
+        size -= n;
+        if (blockUsed_ == params_.blockSize) {
+            submitBlock();
+        }
+    }
+    return true;
+}
+
+// Submit current block to async sink. The segment and block buffer are held by the write, so the segment is closed
+// and the block is returned to pool after it's completed
+void ImageContainerWriter::submitBlock() {
+    if (!block_) {
+        return;
+    }
+    // pad the partial block to alignment for O_DIRECT, the padding is truncated when the segment is closed
+    const size_t size = (blockUsed_ + kBlockAlignment - 1) / kBlockAlignment * kBlockAlignment;
+    memset(blockData_ + blockUsed_, 0, size - blockUsed_);
+    sink_->write(segment_->fd, blockData_, size, blockOffset_, [segment = segment_, block = move(block_)](bool) {});
+    block_.reset();
+    blockData_ = nullptr;
+    blockUsed_ = 0;
+}
+
+// Close current segment and create the next one
+bool ImageContainerWriter::nextSegment() {
+    if (segment_) {
+        closeSegment();
+        ++segmentIndex_;
+        rollSegments();
+    }
+
+    string file = (fs::path(folder_) / segmentName(segmentIndex_)).string();
+    int flags = O_WRONLY | O_CREAT | O_TRUNC;
+    if (sink_ && params_.directIo) {
+        flags |= O_DIRECT;
+    }
+    int fd = ::open(file.c_str(), flags, 0644);
+    if (fd < 0 && (flags & O_DIRECT) && errno == EINVAL) {
+        LOG_FIRST_N(WARNING, 1) << fmt::format("O_DIRECT isn't supported for \"{}\", use buffered write", file);
+        fd = ::open(file.c_str(), flags & ~O_DIRECT, 0644);
+    }
+    if (fd < 0) {
+        LOG(ERROR) << fmt::format("cannot create segment file \"{}\": {}", file, strerror(errno));
+        return false;
+    }
+    segment_ = make_shared<Segment>();
+    segment_->fd = fd;
+    segment_->file = file;
+    segmentOffset_ = 0;
+    // preallocate the segment, so the file system allocates large contiguous extents and doesn't update the metadata
+    // for each write. It's only a hint, the file system not supporting it still works
+    if (params_.preallocate) {
+        int ret = posix_fallocate(fd, 0, static_cast<off_t>(params_.segmentSize));
+        LOG_IF(WARNING, ret != 0) << fmt::format("cannot preallocate segment file \"{}\": {}", file, strerror(ret));
+    }
+    return true;
+}
+
+// Close current segment, it's truncated to used size after all the writes to it are completed
+void ImageContainerWriter::closeSegment() {
+    if (!segment_) {
+        return;
+    }
+    if (sink_) {
+        submitBlock();
+    }
+    segment_->size = segmentOffset_;
+    segment_.reset();
+    closed_.emplace_back(segmentIndex_, segmentOffset_);
+    closedSize_ += segmentOffset_;
+}
+
+// Delete the oldest closed segments in background until the closed segments and the preallocated new segment fit into
+// the rolling budget. Deleting one segment file is cheap for the file system compared with removing the image files
+// one by one, and the in-flight writes to it are still safe because the opened file descriptor is valid after unlink
+void ImageContainerWriter::rollSegments() {
+    if (params_.rollingBudget == 0) {
+        return;
+    }
+    while (!closed_.empty() && closedSize_ + params_.segmentSize > params_.rollingBudget) {
+        string file = (fs::path(folder_) / segmentName(closed_.front().first)).string();
+        closedSize_ -= closed_.front().second;
+        closed_.pop_front();
+        ++deletedNum_;
+        deleter_->post([file = move(file)]() {
+            boost::system::error_code ec;
+            if (!fs::remove(file, ec) || ec) {
+                LOG(ERROR) << fmt::format("cannot delete segment \"{}\": {}", file, ec.message());
+            }
+        });
+    }
+}
+
+// Open the container folder and load the index
+bool ImageContainerReader::open(const string& folder) {
+    folder_ = folder;
+    segments_.clear();
+    entries_.clear();
+    if (!fs::is_directory(folder)) {
+        LOG(ERROR) << fmt::format("container folder \"{}\" doesn't exist", folder);
+        return false;
+    }
+    segments_ = listSegments(folder);
+
+    // load index
+    bool valid{false};
+    fstream indexStream((fs::path(folder) / "index.bin").string(), ios::in | ios::binary);
+    if (indexStream.is_open()) {
+        char magic[sizeof(kIndexMagic)];
+        uint32_t version{0}, entrySize{0};
+        indexStream.read(magic, sizeof(magic));
+        indexStream.read(reinterpret_cast<char*>(&version), sizeof(version));
+        indexStream.read(reinterpret_cast<char*>(&entrySize), sizeof(entrySize));
+        valid = indexStream && memcmp(magic, kIndexMagic, sizeof(kIndexMagic)) == 0 && version == kIndexVersion &&
+                entrySize == sizeof(ContainerEntry);
+        ContainerEntry entry;
+        while (valid && indexStream.read(reinterpret_cast<char*>(&entry), sizeof(entry))) {
+            if (entry.segment >= segments_.size()) {
+                valid = false;
+                break;
+            }
+            // the segment is deleted in rolling record
+            if (segments_[entry.segment].empty()) {
+                continue;
+            }
+            entries_.emplace_back(entry);
+        }
+    }
+    if (!valid) {
+        LOG(WARNING) << fmt::format("index of container \"{}\" is invalid, rebuild it from segments", folder);
+        scanSegments();
+    }
+
+    // the images may be appended out of order by multiple saver threads
+    stable_sort(entries_.begin(), entries_.end(),
+                [](const ContainerEntry& a, const ContainerEntry& b) { return a.timestamp < b.timestamp; });
+    return true;
+}
+
+// Find the first entry whose timestamp isn't earlier than the given timestamp
+const ContainerEntry* ImageContainerReader::find(double timestamp) const {
+    const int64_t t = static_cast<int64_t>(llround(timestamp * 1.0E9));
+    auto it = lower_bound(entries_.begin(), entries_.end(), t,
+                          [](const ContainerEntry& e, int64_t t) { return e.timestamp < t; });
+    return it == entries_.end() ? nullptr : &*it;
+}
+
+// Read the image data of entry
+bool ImageContainerReader::read(const ContainerEntry& entry, vector<unsigned char>& data) const {
+    if (entry.segment >= segments_.size() || segments_[entry.segment].empty()) {
+        LOG(ERROR) << fmt::format("segment {} doesn't exist in container \"{}\"", entry.segment, folder_);
+        return false;
+    }
+    fstream segmentStream(segments_[entry.segment], ios::in | ios::binary);
+    data.resize(entry.size);
+    if (!segmentStream.seekg(static_cast<streamoff>(entry.offset)) ||
+        !segmentStream.read(reinterpret_cast<char*>(data.data()), static_cast<streamsize>(entry.size))) {
+        LOG(ERROR) << fmt::format("cannot read image at offset {} of segment \"{}\"", entry.offset,
+                                  segments_[entry.segment]);
+        data.clear();
+        return false;
+    }
+    return true;
+}
+
+// Export all the images to folder in kalibr format
+size_t ImageContainerReader::exportKalibr(const string& folder) const {
+    boost::system::error_code ec;
+    fs::create_directories(folder, ec);
+    size_t num{0};
+    vector<unsigned char> data;
+    for (const auto& e : entries_) {
+        if (!read(e, data)) {
+            continue;
+        }
+        string fileName = fmt::format("{}/{}.jpg", folder, e.timestamp);
+        fstream imageStream(fileName, ios::out | ios::binary);
+        if (!imageStream.is_open()) {
+            LOG(ERROR) << fmt::format("cannot create file \"{}\"", fileName);
+            continue;
+        }
+        imageStream.write(reinterpret_cast<const char*>(data.data()), static_cast<streamsize>(data.size()));
+        ++num;
+    }
+    return num;
+}
+
+// Rebuild the index by scanning the records in segments, the scan of segment stops at the first invalid record
+void ImageContainerReader::scanSegments() {
+    entries_.clear();
+    for (size_t i = 0; i < segments_.size(); ++i) {
+        if (segments_[i].empty()) {
+            continue;
+        }
+        fstream segmentStream(segments_[i], ios::in | ios::binary);
+        const uint64_t fileSize = fs::file_size(segments_[i]);
+        uint64_t offset{0};
+        char header[kRecordHeaderSize];
+        while (offset + kRecordHeaderSize <= fileSize && segmentStream.seekg(static_cast<streamoff>(offset)) &&
+               segmentStream.read(header, kRecordHeaderSize)) {
+            uint32_t magic;
+            ContainerEntry entry;
+            memcpy(&magic, header, 4);
+            memcpy(&entry.size, header + 4, 4);
+            memcpy(&entry.timestamp, header + 8, 8);
+            entry.segment = static_cast<uint32_t>(i);
+            entry.offset = offset + kRecordHeaderSize;
+            if (magic != kRecordMagic || entry.offset + entry.size > fileSize) {
+                break;
+            }
+            entries_.emplace_back(entry);
+            offset = entry.offset + entry.size;
+        }
+    }
+}
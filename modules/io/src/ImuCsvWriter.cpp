@@ -0,0 +1,147 @@
+#include "libra/io/ImuCsvWriter.h"
+#include <glog/logging.h>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+
+using namespace std;
+using namespace Eigen;
+using namespace libra::core;
+using namespace libra::io;
+
+namespace {
+
+/**
+ * @brief Append the raw bytes of value to buffer
+ */
+template <typename T>
+void append(fmt::memory_buffer& buffer, const T& value) {
+    const char* p = reinterpret_cast<const char*>(&value);
+    buffer.append(p, p + sizeof(T));
+}
+
+}  // namespace
+
+// Constructor
+ImuCsvWriter::ImuCsvWriter(const ImuWriterParams& params) : params_(params), writtenNum_(0), flushNum_(0) {}
+
+// Destructor
+ImuCsvWriter::~ImuCsvWriter() { close(); }
+
+// Open file and write the header
+bool ImuCsvWriter::open(const string& file) {
+    close();
+    ios::openmode mode = ios::out | ios::trunc;
+    if (params_.format == ImuFileFormat::Binary) {
+        mode |= ios::binary;
+    }
+    fs_.open(file, mode);
+    if (!fs_.is_open()) {
+        LOG(ERROR) << fmt::format("cannot open file \"{}\" to save IMU data", file);
+        return false;
+    }
+    writtenNum_ = 0;
+    flushNum_ = 0;
+    buffer_.clear();
+    buffer_.reserve(params_.flushSize + 256);
+
+    // write header
+    if (params_.format == ImuFileFormat::Binary) {
+        buffer_.append(kBinaryMagic, kBinaryMagic + sizeof(kBinaryMagic));
+        append(buffer_, kBinaryVersion);
+        append(buffer_, kBinaryRecordSize);
+    } else {
+        fmt::format_to(back_inserter(buffer_), "#SensorTimestamp[ns],SystemTimestamp[ns],GyroX[rad/s],GyroY[rad/s],"
+                                               "GyroZ[rad/s],AccX[m/s^2],AccY[m/s^2],AccZ[m/s^2]\n");
+    }
+    flushTime_ = chrono::steady_clock::now();
+    return true;
+}
+
+// Write one IMU into buffer
+void ImuCsvWriter::write(const ImuRecord& imu) {
+    if (!fs_.is_open()) {
+        return;
+    }
+
+    const Vector3d& gyro = imu.reading().gyro();
+    const Vector3d& acc = imu.reading().acc();
+    if (params_.format == ImuFileFormat::Binary) {
+        append(buffer_, static_cast<int64_t>(llround(imu.timestamp() * 1.0E9)));
+        append(buffer_, static_cast<int64_t>(llround(imu.systemTimestamp().value_or(0) * 1.0E9)));
+        for (int i = 0; i < 3; ++i) {
+            append(buffer_, gyro[i]);
+        }
+        for (int i = 0; i < 3; ++i) {
+            append(buffer_, acc[i]);
+        }
+    } else {
+        // format: sensor timestamp(ns), system timstamp(ns), gyro(rad/s), acc(m/s^2)
+        fmt::format_to(back_inserter(buffer_), "{:.0f},{:.0f},{:.10f},{:.10f},{:.10f},{:.10f},{:.10f},{:.10f}\n",
+                       imu.timestamp() * 1.0E9, imu.systemTimestamp().value_or(0) * 1.0E9, gyro[0], gyro[1], gyro[2],
+                       acc[0], acc[1], acc[2]);
+    }
+    ++writtenNum_;
+
+    // flush by size or time, the time is only checked every several IMU to avoid reading clock for each one
+    if (buffer_.size() >= params_.flushSize ||
+        (writtenNum_ % 16 == 0 && chrono::duration<double>(chrono::steady_clock::now() - flushTime_).count() >=
+                                      params_.flushInterval)) {
+        flush();
+    }
+}
+
+// Write all the buffered data to file
+void ImuCsvWriter::flush() {
+    flushTime_ = chrono::steady_clock::now();
+    if (!fs_.is_open() || buffer_.size() == 0) {
+        return;
+    }
+    fs_.write(buffer_.data(), static_cast<streamsize>(buffer_.size()));
+    fs_.flush();
+    LOG_IF(ERROR, !fs_.good()) << fmt::format("failed to write {} bytes IMU data", buffer_.size());
+    buffer_.clear();
+    ++flushNum_;
+}
+
+// Flush and close the file
+void ImuCsvWriter::close() {
+    if (fs_.is_open()) {
+        flush();
+        fs_.close();
+    }
+}
+
+// Read the IMU from binary file
+bool ImuCsvWriter::readBinary(const string& file, vector<ImuRecord>& imus) {
+    imus.clear();
+    fstream fs(file, ios::in | ios::binary);
+    if (!fs.is_open()) {
+        LOG(ERROR) << fmt::format("cannot open IMU file \"{}\"", file);
+        return false;
+    }
+
+    // check header
+    char magic[sizeof(kBinaryMagic)];
+    uint32_t version{0}, recordSize{0};
+    fs.read(magic, sizeof(magic));
+    fs.read(reinterpret_cast<char*>(&version), sizeof(version));
+    fs.read(reinterpret_cast<char*>(&recordSize), sizeof(recordSize));
+    if (!fs || memcmp(magic, kBinaryMagic, sizeof(kBinaryMagic)) != 0 || version != kBinaryVersion ||
+        recordSize != kBinaryRecordSize) {
+        LOG(ERROR) << fmt::format("invalid IMU binary file \"{}\"", file);
+        return false;
+    }
+
+    // read records
+    int64_t timestamps[2];
+    double values[6];
+    while (fs.read(reinterpret_cast<char*>(timestamps), sizeof(timestamps)) &&
+           fs.read(reinterpret_cast<char*>(values), sizeof(values))) {
+        ImuRecord imu(timestamps[0] * 1.0E-9,
+                      ImuReading(Vector3d(values[3], values[4], values[5]), Vector3d(values[0], values[1], values[2])));
+        imu.setSystemTimestamp(timestamps[1] * 1.0E-9);
+        imus.emplace_back(move(imu));
+    }
+    return true;
+}
@@ -1,4 +1,5 @@
 #include "libra/io/MyntEyeRecorder.h"
+#include "libra/io/FrameEncoder.h"
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 #include <glog/logging.h>
@@ -94,6 +95,14 @@ void MyntEyeRecorder::setStreamFormat(mynteyed::StreamFormat streamFormat) {
 // Set the saver thread number
 void MyntEyeRecorder::setSaverThreadNum(const size_t& saverThreadNum) { saverThreadNum_ = saverThreadNum; }
 
+// Set the parameters to encode YUYV image
+void MyntEyeRecorder::setEncodeParams(const YuyvEncodeParams& params) { encodeParams_ = params; }
+
+// Set the controller to adjust encode quality
+void MyntEyeRecorder::setEncodeController(const shared_ptr<AdaptiveEncodeController>& controller) {
+    encodeController_ = controller;
+}
+
 //  Set process function for raw image record of right camera
 void MyntEyeRecorder::setRightProcessFunction(const std::function<void(const core::RawImageRecord&)>& func) {
     processRightRawImg_ = func;
@@ -107,12 +116,12 @@ void MyntEyeRecorder::init() {
     isRightCamEnabled_ = cam_->IsStreamDataEnabled(ImageType::IMAGE_RIGHT_COLOR);
 
     // create image queue
-    leftImageQueue_ = make_shared<JobQueue<RawImage>>(30);
+    leftImageQueue_ = make_shared<MpmcQueue<RawImage>>(30);
     if (isRightCamEnabled_) {
-        rightImageQueue_ = make_shared<JobQueue<RawImage>>(30);
+        rightImageQueue_ = make_shared<MpmcQueue<RawImage>>(30);
     }
     // create IMU queue
-    imuQueue_ = make_shared<JobQueue<RawImu>>(300);
+    imuQueue_ = make_shared<SpscQueue<RawImu>>(300);
 
     // create threads to save image and IMU
     createSaverThread();
@@ -121,9 +130,11 @@ void MyntEyeRecorder::init() {
 // The main run function
 void MyntEyeRecorder::run() {
     LOG(INFO) << fmt::format("Mynt Eye camera recording...");
+    LIBRA_TRACE_THREAD("capture");
 #if defined(DebugTest)
     int lastTime{0};
 #endif
+    vector<RawImu> imuBatch;  // IMU batch read from SDK, pushed to queue together
 
     while (true) {
         if (isStop()) {
@@ -160,12 +171,17 @@ void MyntEyeRecorder::run() {
             // reset image queue and clear thread
             leftImageSaverThreads_.clear();
             rightImageSaverThreads_.clear();
+            LOG(INFO) << fmt::format("image pipeline latency:\n{}", *frameTracer_);
 
             break;
         }
 
         // wait stream
-        cam_->WaitForStreams();
+        {
+            LIBRA_TRACE_SCOPE("MyntEyeRecorder::waitStreams");
+            cam_->WaitForStreams();
+        }
+        LIBRA_TRACE_SCOPE("MyntEyeRecorder::capture");
 
         // capture left image
         auto leftStream = cam_->GetStreamData(ImageType::IMAGE_LEFT_COLOR);
@@ -178,9 +194,12 @@ void MyntEyeRecorder::run() {
             lastTime = leftStream.img_info->timestamp;
 #endif
             RawImage raw;
+            raw.trace.capture = FrameTrace::now();
             raw.timestamp = move(leftStream.img_info->timestamp);
             raw.img = move(leftStream.img);
-            LOG_IF(INFO, leftImageQueue_->size() >= 10) << fmt::format("left queue size = {}", leftImageQueue_->size());
+            LOG_EVERY_N(INFO, 100) << fmt::format("left queue: {}; IMU queue: {}", leftImageQueue_->stats(),
+                                                  imuQueue_->stats());
+            raw.trace.enqueue = FrameTrace::now();
             leftImageQueue_->push(move(raw));
         }
 
@@ -189,23 +208,27 @@ void MyntEyeRecorder::run() {
             auto rightStream = cam_->GetStreamData(ImageType::IMAGE_RIGHT_COLOR);
             if (rightStream.img) {
                 RawImage raw;
+                raw.trace.capture = FrameTrace::now();
                 raw.timestamp = move(rightStream.img_info->timestamp);
                 raw.img = move(rightStream.img);
+                raw.trace.enqueue = FrameTrace::now();
                 rightImageQueue_->push(move(raw));
             }
         }
 
         // read IMU data
         auto motionData = cam_->GetMotionDatas();
+        imuBatch.clear();
         for (auto& motion : motionData) {
             if (motion.imu) {
                 RawImu raw;
                 raw.systemTime = chrono::system_clock::now();
                 raw.imu = motion.imu;
                 // LOG(INFO) << fmt::format("IMU queue size = {}", leftImageQueue_->size());
-                imuQueue_->push(move(raw));
+                imuBatch.emplace_back(move(raw));
             }
         }
+        imuQueue_->pushBatch(make_move_iterator(imuBatch.begin()), make_move_iterator(imuBatch.end()));
     }
 }
 
@@ -257,6 +280,14 @@ void MyntEyeRecorder::openDevice() {
     DLOG(INFO) << fmt::format("IMU intrinsics: {}", motionIntrinsics);
     MotionExtrinsics motionExtrinsics = cam_->GetMotionExtrinsics();
     DLOG(INFO) << fmt::format("IMU extrinsics: {}", motionExtrinsics);
+
+    // geometry of encoded image, the MJPG image is saved without crop and binning
+    const int width = streamIntrinsics.left.width;
+    const int height = streamIntrinsics.left.height;
+    CHECK(YuyvJpegEncoder::geometry(streamFormat_ == StreamFormat::STREAM_YUYV ? encodeParams_ : YuyvEncodeParams(),
+                                    width, height, &encodeGeometry_))
+        << fmt::format("invalid ROI or binning {} for image {}x{}", encodeParams_.binning, width, height);
+    LOG(INFO) << fmt::format("encoded image size = {}x{}", encodeGeometry_.width, encodeGeometry_.height);
 }
 
 // Create thread to save image and IMU
@@ -270,25 +301,31 @@ void MyntEyeRecorder::createSaverThread() {
 // Create thread for save image
 void MyntEyeRecorder::createImageSaverThread() {
     // save function for MJPG format
-    auto jpegFunc = [](shared_ptr<JobQueue<RawImage>>& imageQueue,
-                       const function<void(const RawImageRecord&)>& processFunc) {
+    auto jpegFunc = [](shared_ptr<MpmcQueue<RawImage>>& imageQueue,
+                       const function<void(const RawImageRecord&)>& processFunc, FrameTracer& tracer) {
+        LIBRA_TRACE_THREAD("image saver");
         while (true) {
             // take job and check it's valid
             auto job = imageQueue->pop();
             if (!job.isValid()) {
                 break;
             }
+            FrameTrace trace = job.data().trace;
+            trace.dequeue = FrameTrace::now();
 
-            // convert unit
+            // convert unit, the record keeps the SDK image alive so it's not needed to copy the JPEG data
             RawImageRecord record;
             record.setTimestamp(job.data().timestamp * 1.0E-5);  // 0.01 ms => s
-            record.reading().buffer() = job.data().img->data();
-            record.reading().size() = job.data().img->valid_size();
+            record.reading() = RawImageReading(job.data().img, job.data().img->data(), job.data().img->valid_size());
+            record.reading().setTrace(trace);
 
             // process raw image
             if (processFunc) {
+                LIBRA_TRACE_SCOPE("MyntEyeRecorder::processImage");
                 processFunc(record);
             }
+            trace.sink = FrameTrace::now();
+            tracer.add(trace);
         }
     };
 
@@ -354,65 +391,50 @@ void MyntEyeRecorder::createImageSaverThread() {
         }
     };
 #else
-    // convert YUYV(YUV422 Packed) to YUV(YUV422 Planar), then compress using turbo-jpeg
-    auto yuyvFunc = [](shared_ptr<JobQueue<RawImage>>& imageQueue,
-                       const function<void(const RawImageRecord&)>& processFunc) {
-        tjhandle compressor = tjInitCompress();
-        vector<unsigned char> yuvData;
-
+    // compress YUYV(YUV422 Packed) image using YUYV JPEG encoder
+    auto yuyvFunc = [](shared_ptr<MpmcQueue<RawImage>>& imageQueue,
+                       const function<void(const RawImageRecord&)>& processFunc, FrameEncoder& encoder,
+                       FrameTracer& tracer) {
+        LIBRA_TRACE_THREAD("image saver");
         while (true) {
             // take job and check it's valid
             auto job = imageQueue->pop();
             if (!job.isValid()) {
                 break;
             }
+            FrameTrace trace = job.data().trace;
+            trace.dequeue = FrameTrace::now();
 
-            // resize buffer if don't match
-            int wh = job.data().img->width() * job.data().img->height();
-            int length = 2 * wh;
-            if (yuvData.size() != length) {
-                yuvData.resize(length);
-            }
-
-            // convert YUYV(YUV422 Packed) to YUV(YUV422 Planar)
-            unsigned char* pY = yuvData.data();
-            unsigned char* pU = yuvData.data() + wh;
-            unsigned char* pV = yuvData.data() + wh + wh / 2;
-            uint8_t* imgData = job.data().img->data();
-            for (int i = 0; i < length;) {
-                *pY = imgData[i++];
-                *pU = imgData[i++];
-                ++pY;
-                ++pU;
-                *pY = imgData[i++];
-                *pV = imgData[i++];
-                ++pY;
-                ++pV;
-            }
-
-            // compress image using turbojpeg
+            // compress image
+            int w = job.data().img->width();
+            int h = job.data().img->height();
             RawImageRecord record;
             record.setTimestamp(job.data().timestamp * 1.0E-5);  // 0.01 ms => s
-            if (tjCompressFromYUV(compressor, yuvData.data(), job.data().img->width(), 1, job.data().img->height(),
-                                  TJSAMP_422, &record.reading().buffer(), &record.reading().size(), 95,
-                                  TJFLAG_FASTDCT) != 0) {
-                LOG(ERROR) << fmt::format("turbo jpeg compress error: {}", tjGetErrorStr2(compressor));
+            if (!encoder.encode(job.data().img->data(), w, h, 2 * w, [&] { return imageQueue->size(); }, trace,
+                                record)) {
+                continue;
             }
 
             // process raw image
             if (processFunc) {
+                LIBRA_TRACE_SCOPE("MyntEyeRecorder::processImage");
                 processFunc(record);
             }
-
-            // release turbo jpeg data buffer
-            tjFree(record.reading().buffer());
+            trace.sink = FrameTrace::now();
+            tracer.add(trace);
         }
-
-        // destory compressor
-        tjDestroy(compressor);
     };
 #endif
 
+    // create buffer pool for output JPEG, keep enough free buffers for all saver threads
+    jpegBufferPool_ = make_shared<BufferPool>(0, 2 * (saverThreadNum_ + 1));
+
+    // create thread pool to encode the stripes of one frame in parallel, which is shared by all saver threads
+    if (encodeParams_.mode == YuyvEncodeMode::Stripe) {
+        encodeThreadPool_ = make_shared<ThreadPool>(max(1U, thread::hardware_concurrency()));
+        LOG(INFO) << fmt::format("encode image in stripes, thread num = {}", encodeThreadPool_->threadNum());
+    }
+
     // create thread for left image
     if (isRightCamEnabled_) {
         LOG(INFO) << fmt::format("create image saver thread for left camera, thread num = {}", saverThreadNum_);
@@ -421,9 +443,14 @@ void MyntEyeRecorder::createImageSaverThread() {
     }
     for (size_t i = 0; i < saverThreadNum_; ++i) {
         if (streamFormat_ == StreamFormat::STREAM_MJPG) {
-            leftImageSaverThreads_.emplace_back(thread([&]() { jpegFunc(leftImageQueue_, processRawImg_); }));
+            leftImageSaverThreads_.emplace_back(
+                thread([this, jpegFunc]() { jpegFunc(leftImageQueue_, processRawImg_, *frameTracer_); }));
         } else if (streamFormat_ == StreamFormat::STREAM_YUYV) {
-            leftImageSaverThreads_.emplace_back(thread([&]() { yuyvFunc(leftImageQueue_, processRawImg_); }));
+            leftImageSaverThreads_.emplace_back(
+                thread([this, yuyvFunc]() {
+                    FrameEncoder encoder(encodeParams_, jpegBufferPool_, encodeThreadPool_, encodeController_);
+                    yuyvFunc(leftImageQueue_, processRawImg_, encoder, *frameTracer_);
+                }));
         }
     }
 
@@ -431,9 +458,14 @@ void MyntEyeRecorder::createImageSaverThread() {
     if (isRightCamEnabled_) {
         LOG(INFO) << fmt::format("create image saver thread for right camera, thread num = {}", saverThreadNum_);
         if (streamFormat_ == StreamFormat::STREAM_MJPG) {
-            leftImageSaverThreads_.emplace_back(thread([&]() { jpegFunc(rightImageQueue_, processRightRawImg_); }));
+            leftImageSaverThreads_.emplace_back(
+                thread([this, jpegFunc]() { jpegFunc(rightImageQueue_, processRightRawImg_, *frameTracer_); }));
         } else if (streamFormat_ == StreamFormat::STREAM_YUYV) {
-            leftImageSaverThreads_.emplace_back(thread([&]() { yuyvFunc(rightImageQueue_, processRightRawImg_); }));
+            leftImageSaverThreads_.emplace_back(
+                thread([this, yuyvFunc]() {
+                    FrameEncoder encoder(encodeParams_, jpegBufferPool_, encodeThreadPool_, encodeController_);
+                    yuyvFunc(rightImageQueue_, processRightRawImg_, encoder, *frameTracer_);
+                }));
         }
     }
 }
@@ -442,26 +474,30 @@ void MyntEyeRecorder::createImageSaverThread() {
 void MyntEyeRecorder::createImuSaverThread() {
     LOG(INFO) << "create IMU saver thread";
     imuSaverThread_ = thread([&] {
+        LIBRA_TRACE_THREAD("IMU saver");
+        vector<RawImu> jobs;  // IMU batch popped from queue
         while (true) {
-            // take job and check it's valid
-            auto job = imuQueue_->pop();
-            if (!job.isValid()) {
+            // take jobs in batch and check queue is stopped
+            if (!imuQueue_->popBatch(jobs, 64)) {
                 break;
             }
-
-            // convert unit
-            static const double kDeg2Rad = M_PI / 180.;
-            double sensorTimestamp = job.data().imu->timestamp * 1.0E-5;  // 0.01 ms => s
-            double systemTimestamp =
-                chrono::duration_cast<chrono::nanoseconds>(job.data().systemTime.time_since_epoch()).count() * 1.0E-9;
-            Vector3d acc = Map<Vector3f>(job.data().imu->accel).cast<double>() * Constant::kG;  // g => m/s^2
-            Vector3d gyro = Map<Vector3f>(job.data().imu->gyro).cast<double>() * kDeg2Rad;      // deg/s => rad/s
-            ImuRecord imu(move(sensorTimestamp), ImuReading(move(acc), move(gyro)));
-            imu.setSystemTimestamp(move(systemTimestamp));
-
-            // process IMU
-            if (processImu_) {
-                processImu_(imu);
+            LIBRA_TRACE_SCOPE("MyntEyeRecorder::processImu");
+
+            for (auto& raw : jobs) {
+                // convert unit
+                static const double kDeg2Rad = M_PI / 180.;
+                double sensorTimestamp = raw.imu->timestamp * 1.0E-5;  // 0.01 ms => s
+                double systemTimestamp =
+                    chrono::duration_cast<chrono::nanoseconds>(raw.systemTime.time_since_epoch()).count() * 1.0E-9;
+                Vector3d acc = Map<Vector3f>(raw.imu->accel).cast<double>() * Constant::kG;  // g => m/s^2
+                Vector3d gyro = Map<Vector3f>(raw.imu->gyro).cast<double>() * kDeg2Rad;      // deg/s => rad/s
+                ImuRecord imu(move(sensorTimestamp), ImuReading(move(acc), move(gyro)));
+                imu.setSystemTimestamp(move(systemTimestamp));
+
+                // process IMU
+                if (processImu_) {
+                    processImu_(imu);
+                }
             }
         }
     });
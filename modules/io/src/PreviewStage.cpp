@@ -0,0 +1,153 @@
+#include "libra/io/PreviewStage.h"
+#include <fmt/format.h>
+#include <glog/logging.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <turbojpeg.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include "libra/util/TraceRecorder.h"
+
+using namespace std;
+using namespace libra::core;
+using namespace libra::io;
+
+// Constructor
+PreviewStage::PreviewStage(const PreviewParams& params)
+    : params_(params),
+      decompressor_(tjInitDecompress()),
+      subscriberNum_(0),
+      decodedNum_(0),
+      replacedNum_(0),
+      stop_(false),
+      nextId_(0) {
+    CHECK(params_.scaleDenom == 1 || params_.scaleDenom == 2 || params_.scaleDenom == 4 || params_.scaleDenom == 8)
+        << fmt::format("preview scale denominator should be 1, 2, 4 or 8, but it's {}", params_.scaleDenom);
+    CHECK(decompressor_ != nullptr) << "cannot init turbojpeg decompressor";
+    thread_ = thread(&PreviewStage::run, this);
+}
+
+// Destructor
+PreviewStage::~PreviewStage() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        stop_ = true;
+    }
+    condition_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    tjDestroy(decompressor_);
+}
+
+// Subscribe the preview images
+size_t PreviewStage::subscribe(Callback callback) {
+    lock_guard<mutex> lock(subscriberMutex_);
+    subscribers_[nextId_] = move(callback);
+    subscriberNum_.store(subscribers_.size(), memory_order_relaxed);
+    return nextId_++;
+}
+
+// Unsubscribe the preview images, the subscriber mutex is held when calling subscribers, so the callback isn't called
+// after return
+void PreviewStage::unsubscribe(size_t id) {
+    lock_guard<mutex> lock(subscriberMutex_);
+    subscribers_.erase(id);
+    subscriberNum_.store(subscribers_.size(), memory_order_relaxed);
+}
+
+// Push the encoded JPEG image. The image is held by an owning copy, which doesn't copy the buffer if it's owned by
+// reading, and the check before locking makes the push free without subscriber
+void PreviewStage::push(const RawImageRecord& raw, size_t camera) {
+    if (!isSubscribed()) {
+        return;
+    }
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (camera >= slots_.size()) {
+            slots_.resize(camera + 1);
+            pending_.resize(camera + 1, false);
+            lastTime_.resize(camera + 1, numeric_limits<double>::lowest());
+        }
+        if (raw.timestamp() - lastTime_[camera] < params_.interval) {
+            return;
+        }
+        if (pending_[camera]) {
+            replacedNum_.fetch_add(1, memory_order_relaxed);
+        }
+        slots_[camera] = RawImageRecord(raw.timestamp(), raw.reading().owned());
+        pending_[camera] = true;
+        lastTime_[camera] = raw.timestamp();
+    }
+    condition_.notify_one();
+}
+
+// Loop of preview thread, which takes the pending slots and decodes them out of lock
+void PreviewStage::run() {
+    LIBRA_TRACE_THREAD("preview");
+    // lower the priority of this thread only, the nice value is per thread on Linux
+    if (setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), params_.nice) != 0) {
+        LOG(WARNING) << fmt::format("cannot set nice value of preview thread: {}", strerror(errno));
+    }
+
+    vector<pair<RawImageRecord, size_t>> images;
+    PreviewImage image;
+    while (true) {
+        images.clear();
+        {
+            unique_lock<mutex> lock(mutex_);
+            condition_.wait(lock, [&]() {
+                return stop_ || find(pending_.begin(), pending_.end(), true) != pending_.end();
+            });
+            if (stop_) {
+                break;
+            }
+            for (size_t i = 0; i < slots_.size(); ++i) {
+                if (pending_[i]) {
+                    images.emplace_back(move(slots_[i]), i);
+                    slots_[i] = RawImageRecord();
+                    pending_[i] = false;
+                }
+            }
+        }
+
+        for (const auto& v : images) {
+            if (!isSubscribed() || !decode(v.first, v.second, image)) {
+                continue;
+            }
+            decodedNum_.fetch_add(1, memory_order_relaxed);
+            lock_guard<mutex> lock(subscriberMutex_);
+            for (const auto& s : subscribers_) {
+                s.second(image);
+            }
+        }
+    }
+}
+
+// Decode the downscaled preview of JPEG image. The output size is rounded up like `TJSCALED()`, then turbojpeg chooses
+// the scaling factor by it and only runs the reduced IDCT
+bool PreviewStage::decode(const RawImageRecord& raw, size_t camera, PreviewImage& image) {
+    LIBRA_TRACE_SCOPE("PreviewStage::decode");
+    int width{0}, height{0}, subsampling{0}, colorspace{0};
+    if (tjDecompressHeader3(decompressor_, raw.reading().buffer(), raw.reading().size(), &width, &height,
+                            &subsampling, &colorspace) != 0) {
+        LOG_EVERY_N(ERROR, 100) << fmt::format("cannot read JPEG header of preview: {}",
+                                               tjGetErrorStr2(decompressor_));
+        return false;
+    }
+    image.timestamp = raw.timestamp();
+    image.camera = camera;
+    image.width = (width + params_.scaleDenom - 1) / params_.scaleDenom;
+    image.height = (height + params_.scaleDenom - 1) / params_.scaleDenom;
+    image.channels = params_.gray ? 1 : 3;
+    image.data.resize(static_cast<size_t>(image.width) * image.height * image.channels);
+    if (tjDecompress2(decompressor_, raw.reading().buffer(), raw.reading().size(), image.data.data(), image.width, 0,
+                      image.height, params_.gray ? TJPF_GRAY : TJPF_BGR, TJFLAG_FASTDCT) != 0) {
+        LOG_EVERY_N(ERROR, 100) << fmt::format("cannot decode preview: {}", tjGetErrorStr2(decompressor_));
+        return false;
+    }
+    return true;
+}
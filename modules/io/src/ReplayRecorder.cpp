@@ -0,0 +1,256 @@
+#include "libra/io/ReplayRecorder.h"
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+#include <glog/logging.h>
+#include <algorithm>
+#include <array>
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+using namespace Eigen;
+using namespace libra::util;
+using namespace libra::core;
+using namespace libra::io;
+namespace fs = boost::filesystem;
+
+// Constructor
+ReplayRecorder::ReplayRecorder(const ReplayParams& params)
+    : params_(params), imageNum_(0), imuNum_(0), stallNum_(0) {}
+
+// Destructor
+ReplayRecorder::~ReplayRecorder() {
+    // wait process finish
+    if (isStart()) {
+        stop();
+        wait();
+    }
+    // the prefetch thread is still running if the recorder is initialized but not started
+    if (imageQueue_) {
+        imageQueue_->stop();
+    }
+    if (prefetchThread_.joinable()) {
+        prefetchThread_.join();
+    }
+}
+
+// Set the replay parameters
+void ReplayRecorder::setParams(const ReplayParams& params) { params_ = params; }
+
+// Set process function for raw image record of right camera
+void ReplayRecorder::setRightProcessFunction(const std::function<void(const core::RawImageRecord&)>& func) {
+    processRightRawImg_ = func;
+}
+
+// Initialize recorder
+void ReplayRecorder::init() {
+    CHECK_GE(params_.speed, 0) << "replay speed should not be negative";
+    CHECK_GT(params_.prefetchNum, 0) << "prefetch number should be larger than 0";
+    fs::path rootPath(params_.folder);
+    CHECK(fs::is_directory(rootPath)) << fmt::format("record folder \"{}\" doesn't exist", params_.folder);
+
+    // list images of left and right camera, and sort by timestamp. The left image is before the right one with the same
+    // timestamp
+    imageFiles_.clear();
+    listImages((rootPath / "left").string(), true);
+    listImages((rootPath / "right").string(), false);
+    stable_sort(imageFiles_.begin(), imageFiles_.end(),
+                [](const ImageFile& a, const ImageFile& b) { return a.timestamp < b.timestamp; });
+
+    // load IMU
+    imus_.clear();
+    loadImu((rootPath / "imu.csv").string());
+    LOG(INFO) << fmt::format("replay folder \"{}\", image num = {}, IMU num = {}, speed = {}", params_.folder,
+                             imageFiles_.size(), imus_.size(), params_.speed);
+
+    // read images ahead
+    bufferPool_ = make_shared<BufferPool>(0, params_.prefetchNum + 2);
+    imageQueue_ = make_shared<SpscQueue<RawImageRecord>>(params_.prefetchNum);
+    createPrefetchThread();
+}
+
+// The main run function
+void ReplayRecorder::run() {
+    LOG(INFO) << "replaying...";
+    LIBRA_TRACE_THREAD("replay");
+    imageNum_ = 0;
+    imuNum_ = 0;
+    stallNum_ = 0;
+
+    // the first record is replayed immediately, and the others are paced by their timestamps to the first one
+    double startTimestamp = numeric_limits<double>::max();
+    if (!imageFiles_.empty()) {
+        startTimestamp = imageFiles_.front().timestamp;
+    }
+    if (!imus_.empty()) {
+        startTimestamp = min(startTimestamp, imus_.front().timestamp());
+    }
+    const auto startTime = chrono::steady_clock::now();
+    auto waitUntil = [&](double timestamp) {
+        if (params_.speed > 0) {
+            this_thread::sleep_until(startTime + chrono::duration_cast<chrono::steady_clock::duration>(
+                                                     chrono::duration<double>((timestamp - startTimestamp) /
+                                                                              params_.speed)));
+        }
+    };
+
+    // merge the images and IMU by timestamp, IMU is replayed before the image with the same timestamp
+    size_t imageIndex{0}, imuIndex{0};
+    while (!isStop() && (imageIndex < imageFiles_.size() || imuIndex < imus_.size())) {
+        if (imuIndex < imus_.size() &&
+            (imageIndex >= imageFiles_.size() || imus_[imuIndex].timestamp() <= imageFiles_[imageIndex].timestamp)) {
+            const ImuRecord& imu = imus_[imuIndex++];
+            waitUntil(imu.timestamp());
+            if (processImu_) {
+                processImu_(imu);
+            }
+            ++imuNum_;
+            continue;
+        }
+
+        // take the read ahead image, it's stalled by disk if the image isn't read yet
+        const ImageFile& file = imageFiles_[imageIndex++];
+        waitUntil(file.timestamp);
+        if (imageQueue_->size() == 0) {
+            ++stallNum_;
+        }
+        auto job = imageQueue_->pop();
+        if (!job.isValid()) {
+            break;
+        }
+        if (job.data().reading().size() == 0) {
+            // failed to read file, the warning is logged in prefetch thread
+            continue;
+        }
+        FrameTrace trace = job.data().reading().trace();
+        trace.dequeue = FrameTrace::now();
+        const auto& processFunc = file.isLeft ? processRawImg_ : processRightRawImg_;
+        if (processFunc) {
+            LIBRA_TRACE_SCOPE("ReplayRecorder::processImage");
+            processFunc(job.data());
+        }
+        trace.sink = FrameTrace::now();
+        frameTracer_->add(trace);
+        ++imageNum_;
+    }
+
+    // stop replaying and wait prefetch thread
+    LOG(INFO) << fmt::format("stop replaying, image num = {}, IMU num = {}, stall num = {}", imageNum_.load(),
+                             imuNum_.load(), stallNum_.load());
+    imageQueue_->stop();
+    if (prefetchThread_.joinable()) {
+        prefetchThread_.join();
+    }
+    LOG(INFO) << fmt::format("image pipeline latency:\n{}", *frameTracer_);
+}
+
+// List the image files in folder
+void ReplayRecorder::listImages(const std::string& folder, bool isLeft) {
+    if (!fs::is_directory(folder)) {
+        return;
+    }
+    for (const auto& entry : fs::directory_iterator(folder)) {
+        if (!fs::is_regular_file(entry.path())) {
+            continue;
+        }
+        // the file name is the timestamp in ns
+        string stem = entry.path().stem().string();
+        if (stem.empty() || !all_of(stem.begin(), stem.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            LOG(WARNING) << fmt::format("ignore file \"{}\" which isn't named by timestamp", entry.path().string());
+            continue;
+        }
+        ImageFile file;
+        try {
+            file.timestamp = stoull(stem) * 1.0E-9;
+        } catch (const out_of_range&) {
+            LOG(WARNING) << fmt::format("ignore file \"{}\" whose timestamp is out of range", entry.path().string());
+            continue;
+        }
+        file.isLeft = isLeft;
+        file.path = entry.path().string();
+        imageFiles_.emplace_back(move(file));
+    }
+}
+
+// Load IMU from CSV file
+void ReplayRecorder::loadImu(const std::string& file) {
+    if (!fs::is_regular_file(file)) {
+        return;
+    }
+    fstream fs(file, ios::in);
+    CHECK(fs.is_open()) << fmt::format("cannot open IMU file \"{}\"", file);
+
+    // format: sensor timestamp(ns), system timstamp(ns), gyro(rad/s), acc(m/s^2)
+    string line;
+    size_t lineIndex{0};
+    while (getline(fs, line)) {
+        ++lineIndex;
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        array<double, 8> values{};
+        stringstream ss(line);
+        string value;
+        size_t n{0};
+        try {
+            for (; n < values.size() && getline(ss, value, ','); ++n) {
+                values[n] = stod(value);
+            }
+        } catch (const logic_error&) {
+            // invalid_argument if the value isn't a number, out_of_range if it overflows double
+            n = 0;
+        }
+        if (n != values.size()) {
+            LOG(WARNING) << fmt::format("ignore invalid IMU at line {} of file \"{}\"", lineIndex, file);
+            continue;
+        }
+        ImuRecord imu(values[0] * 1.0E-9, ImuReading(Vector3d(values[5], values[6], values[7]),
+                                                     Vector3d(values[2], values[3], values[4])));
+        // the system timestamp is saved as 0 if it's unavailable
+        if (values[1] != 0) {
+            imu.setSystemTimestamp(values[1] * 1.0E-9);
+        }
+        imus_.emplace_back(move(imu));
+    }
+    stable_sort(imus_.begin(), imus_.end(),
+                [](const ImuRecord& a, const ImuRecord& b) { return a.timestamp() < b.timestamp(); });
+}
+
+// Create thread to read image files ahead
+void ReplayRecorder::createPrefetchThread() {
+    LOG(INFO) << fmt::format("create prefetch thread, prefetch num = {}", params_.prefetchNum);
+    prefetchThread_ = thread([&] {
+        LIBRA_TRACE_THREAD("prefetch");
+        for (const auto& file : imageFiles_) {
+            LIBRA_TRACE_SCOPE("ReplayRecorder::readImage");
+            // read the whole file into buffer leased from pool, the empty record is pushed if failed to keep the order
+            FrameTrace trace;
+            trace.capture = FrameTrace::now();
+            RawImageRecord record;
+            record.setTimestamp(file.timestamp);
+            fstream fs(file.path, ios::in | ios::binary | ios::ate);
+            if (fs.is_open()) {
+                auto size = static_cast<unsigned long>(fs.tellg());
+                shared_ptr<unsigned char> buffer = bufferPool_->lease(size);
+                fs.seekg(0);
+                if (fs.read(reinterpret_cast<char*>(buffer.get()), size)) {
+                    record.reading().setData(move(buffer), size);
+                }
+            }
+            if (record.reading().size() == 0) {
+                LOG(WARNING) << fmt::format("cannot read image file \"{}\"", file.path);
+            }
+
+            // wait if the queue is full, and exit if it's stopped
+            trace.enqueue = FrameTrace::now();
+            record.reading().setTrace(trace);
+            if (!imageQueue_->push(move(record))) {
+                break;
+            }
+        }
+    });
+}
@@ -0,0 +1,283 @@
+#include "libra/io/SyntheticRecorder.h"
+#include "libra/io/FrameEncoder.h"
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+#include <glog/logging.h>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+using namespace std;
+using namespace Eigen;
+using namespace libra::util;
+using namespace libra::core;
+using namespace libra::io;
+
+namespace {
+
+constexpr size_t kPatternNum = 8;  // number of YUYV image patterns
+
+/**
+ * @brief Get the system time in seconds
+ */
+double systemTime() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count() * 1.0E-9;
+}
+
+}  // namespace
+
+// Constructor
+SyntheticRecorder::SyntheticRecorder(const SyntheticParams& params, const size_t& saverThreadNum)
+    : params_(params), saverThreadNum_(saverThreadNum), generatedFrameNum_(0), droppedFrameNum_(0) {}
+
+// Destructor
+SyntheticRecorder::~SyntheticRecorder() {
+    // wait process finish
+    if (isStart()) {
+        stop();
+        wait();
+    }
+}
+
+// Get the statistics of image queue
+QueueStats SyntheticRecorder::imageQueueStats() const { return imageQueue_ ? imageQueue_->stats() : QueueStats(); }
+
+// Get the statistics of IMU queue
+QueueStats SyntheticRecorder::imuQueueStats() const { return imuQueue_ ? imuQueue_->stats() : QueueStats(); }
+
+// Set the synthetic parameters
+void SyntheticRecorder::setParams(const SyntheticParams& params) { params_ = params; }
+
+// Set the saver thread number
+void SyntheticRecorder::setSaverThreadNum(const size_t& saverThreadNum) { saverThreadNum_ = saverThreadNum; }
+
+// Set the parameters to encode YUYV image
+void SyntheticRecorder::setEncodeParams(const YuyvEncodeParams& params) { encodeParams_ = params; }
+
+// Set the controller to adjust encode quality
+void SyntheticRecorder::setEncodeController(const shared_ptr<AdaptiveEncodeController>& controller) {
+    encodeController_ = controller;
+}
+
+// Initialize recorder
+void SyntheticRecorder::init() {
+    CHECK(params_.width > 0 && params_.width % 2 == 0) << fmt::format("invalid image width {}", params_.width);
+    CHECK_GT(params_.height, 0) << "invalid image height";
+    CHECK_GT(params_.fps, 0) << "invalid FPS";
+    CHECK_GT(saverThreadNum_, 0) << "saver thread number should be larger than 0";
+    CHECK(YuyvJpegEncoder::geometry(encodeParams_, params_.width, params_.height, &encodeGeometry_))
+        << fmt::format("invalid ROI or binning {} for image {}x{}", encodeParams_.binning, params_.width,
+                       params_.height);
+    LOG(INFO) << fmt::format("synthetic image size = {}x{}, FPS = {} Hz, IMU rate = {} Hz, real time = {}",
+                             params_.width, params_.height, params_.fps, params_.imuRate, params_.realTime);
+
+    generatePatterns();
+    imageBufferPool_ = make_shared<BufferPool>(2 * params_.width * params_.height, 2 * (saverThreadNum_ + 1));
+
+    // create image and IMU queue. Drop data in real time mode like the camera recorders, otherwise wait for the saver
+    // threads. The oldest image is dropped, while the SPSC IMU queue drops the incoming IMU
+    imageQueue_ = make_shared<MpmcQueue<RawImage>>(1000);
+    imageQueue_->enableDropJob(params_.realTime);
+    imuQueue_ = make_shared<SpscQueue<RawImu>>(3000);
+    imuQueue_->enableDropJob(params_.realTime);
+
+    // create threads to save image and IMU
+    createImageSaverThread();
+    createImuSaverThread();
+}
+
+// The main run function
+void SyntheticRecorder::run() {
+    LOG(INFO) << "synthetic recording...";
+    LIBRA_TRACE_THREAD("capture");
+    generatedFrameNum_ = 0;
+    droppedFrameNum_ = 0;
+
+    mt19937 rng(params_.seed + 1);
+    normal_distribution<double> jitter(0, max(params_.jitter, 1.0E-9));
+    normal_distribution<double> noise(0, 0.01);
+    uniform_real_distribution<double> drop(0, 1);
+    const auto startTime = chrono::steady_clock::now();
+    const double startTimestamp = systemTime();
+    size_t imuIndex{0};
+    vector<RawImu> imuBatch;  // IMU generated before one frame, pushed to queue together
+
+    for (size_t index = 0; params_.frameNum == 0 || index < params_.frameNum; ++index) {
+        if (isStop()) {
+            break;
+        }
+
+        // generate the IMU before this frame, it's a slow sine motion with noise
+        const double t = index / params_.fps;
+        imuBatch.clear();
+        for (; params_.imuRate > 0 && imuIndex / params_.imuRate <= t; ++imuIndex) {
+            if (params_.imuDropRate > 0 && drop(rng) < params_.imuDropRate) {
+                continue;
+            }
+            double ti = imuIndex / params_.imuRate;
+            RawImu imu;
+            imu.timestamp = startTimestamp + ti;
+            imu.systemTimestamp = systemTime();
+            imu.acc = Vector3d(0.5 * sin(ti), 0.3 * cos(0.7 * ti), 9.81);
+            imu.gyro = Vector3d(0.1 * cos(ti), 0.2 * sin(0.5 * ti), 0.05);
+            for (int k = 0; k < 3; ++k) {
+                imu.acc[k] += noise(rng);
+                imu.gyro[k] += noise(rng);
+            }
+            imuBatch.emplace_back(move(imu));
+        }
+        imuQueue_->pushBatch(make_move_iterator(imuBatch.begin()), make_move_iterator(imuBatch.end()));
+
+        // wait until the frame arrives
+        if (params_.realTime) {
+            double arrival = t + (params_.jitter > 0 ? jitter(rng) : 0);
+            this_thread::sleep_until(startTime + chrono::duration_cast<chrono::steady_clock::duration>(
+                                                     chrono::duration<double>(max(0.0, arrival))));
+        }
+        ++generatedFrameNum_;
+
+        // drop frame at sensor
+        if (params_.frameDropRate > 0 && drop(rng) < params_.frameDropRate) {
+            ++droppedFrameNum_;
+            continue;
+        }
+
+        // copy the pattern into buffer, like the image copied from camera SDK
+        LIBRA_TRACE_SCOPE("SyntheticRecorder::captureImage");
+        RawImage image;
+        image.trace.capture = FrameTrace::now();
+        image.data = imageBufferPool_->lease();
+        image.timestamp = startTimestamp + t;
+        const vector<unsigned char>& pattern = patterns_[index % patterns_.size()];
+        memcpy(image.data.get(), pattern.data(), pattern.size());
+        LOG_EVERY_N(INFO, 100) << fmt::format("image queue: {}; IMU queue: {}", imageQueue_->stats(),
+                                              imuQueue_->stats());
+        image.trace.enqueue = FrameTrace::now();
+        imageQueue_->push(move(image));
+    }
+
+    // stop recording, wait queue and saver threads
+    LOG(INFO) << "stop synthetic recording";
+    imageQueue_->wait();
+    imageQueue_->stop();
+    imuQueue_->wait();
+    imuQueue_->stop();
+    for (auto& t : imageSaverThreads_) {
+        if (t.joinable()) {
+            t.join();
+        }
+    }
+    if (imuSaverThread_.joinable()) {
+        imuSaverThread_.join();
+    }
+    imageSaverThreads_.clear();
+    LOG(INFO) << fmt::format("image pipeline latency:\n{}", *frameTracer_);
+}
+
+// Generate one YUYV image pattern
+void SyntheticRecorder::generatePattern(int width, int height, int shift, mt19937& rng, unsigned char* yuyv) {
+    uniform_int_distribution<int> noise(-6, 6);
+    for (int i = 0; i < height; ++i) {
+        unsigned char* p = yuyv + static_cast<size_t>(i) * 2 * width;
+        for (int j = 0; j < width; j += 2) {
+            int y0 = 128 + static_cast<int>(100 * sin((j + shift) * 0.01) * cos((i + shift) * 0.013));
+            int y1 = 128 + static_cast<int>(100 * sin((j + 1 + shift) * 0.01) * cos((i + shift) * 0.013));
+            int u = 128 + static_cast<int>(40 * sin((i + j) * 0.005));
+            int v = 128 + static_cast<int>(40 * cos((i - j + shift) * 0.004));
+            p[2 * j + 0] = static_cast<unsigned char>(min(255, max(0, y0 + noise(rng))));
+            p[2 * j + 1] = static_cast<unsigned char>(min(255, max(0, u + noise(rng) / 2)));
+            p[2 * j + 2] = static_cast<unsigned char>(min(255, max(0, y1 + noise(rng))));
+            p[2 * j + 3] = static_cast<unsigned char>(min(255, max(0, v + noise(rng) / 2)));
+        }
+    }
+}
+
+// Generate the YUYV image patterns, each pattern is shifted from the previous one to simulate moving scene
+void SyntheticRecorder::generatePatterns() {
+    const int w = params_.width, h = params_.height;
+    mt19937 rng(params_.seed);
+    patterns_.resize(kPatternNum);
+    for (size_t n = 0; n < kPatternNum; ++n) {
+        patterns_[n].resize(2 * w * h);
+        generatePattern(w, h, static_cast<int>(n) * 8, rng, patterns_[n].data());
+    }
+}
+
+// Create thread for save image
+void SyntheticRecorder::createImageSaverThread() {
+    // compress YUYV(YUV422 Packed) image using YUYV JPEG encoder, the same with camera recorders
+    auto yuyvFunc = [](shared_ptr<MpmcQueue<RawImage>>& imageQueue,
+                       const function<void(const RawImageRecord&)>& processFunc, FrameEncoder& encoder, int width,
+                       int height, FrameTracer& tracer) {
+        while (true) {
+            // take job and check it's valid
+            auto job = imageQueue->pop();
+            if (!job.isValid()) {
+                break;
+            }
+            FrameTrace trace = job.data().trace;
+            trace.dequeue = FrameTrace::now();
+
+            // compress image
+            RawImageRecord record;
+            record.setTimestamp(job.data().timestamp);
+            if (!encoder.encode(job.data().data.get(), width, height, 2 * width, [&] { return imageQueue->size(); },
+                                trace, record)) {
+                continue;
+            }
+
+            // process raw image
+            if (processFunc) {
+                LIBRA_TRACE_SCOPE("SyntheticRecorder::processImage");
+                processFunc(record);
+            }
+            trace.sink = FrameTrace::now();
+            tracer.add(trace);
+        }
+    };
+
+    // create buffer pool for output JPEG, keep enough free buffers for all saver threads
+    jpegBufferPool_ = make_shared<BufferPool>(0, 2 * (saverThreadNum_ + 1));
+
+    // create thread pool to encode the stripes of one frame in parallel, which is shared by all saver threads
+    if (encodeParams_.mode == YuyvEncodeMode::Stripe) {
+        encodeThreadPool_ = make_shared<ThreadPool>(max(1U, thread::hardware_concurrency()));
+        LOG(INFO) << fmt::format("encode image in stripes, thread num = {}", encodeThreadPool_->threadNum());
+    }
+
+    LOG(INFO) << fmt::format("create image saver thread, thread num = {}", saverThreadNum_);
+    for (size_t i = 0; i < saverThreadNum_; ++i) {
+        imageSaverThreads_.emplace_back(thread([this, yuyvFunc]() {
+            LIBRA_TRACE_THREAD("image saver");
+            FrameEncoder encoder(encodeParams_, jpegBufferPool_, encodeThreadPool_, encodeController_);
+            yuyvFunc(imageQueue_, processRawImg_, encoder, params_.width, params_.height, *frameTracer_);
+        }));
+    }
+}
+
+// Create thread for save IMU
+void SyntheticRecorder::createImuSaverThread() {
+    LOG(INFO) << "create IMU saver thread";
+    imuSaverThread_ = thread([&] {
+        LIBRA_TRACE_THREAD("IMU saver");
+        vector<RawImu> jobs;  // IMU batch popped from queue
+        while (true) {
+            // take jobs in batch and check queue is stopped
+            if (!imuQueue_->popBatch(jobs, 64)) {
+                break;
+            }
+            LIBRA_TRACE_SCOPE("SyntheticRecorder::processImu");
+
+            for (auto& raw : jobs) {
+                ImuRecord imu(move(raw.timestamp), ImuReading(move(raw.acc), move(raw.gyro)));
+                imu.setSystemTimestamp(move(raw.systemTimestamp));
+
+                // process IMU
+                if (processImu_) {
+                    processImu_(imu);
+                }
+            }
+        }
+    });
+}
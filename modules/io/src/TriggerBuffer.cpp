@@ -0,0 +1,152 @@
+#include "libra/io/TriggerBuffer.h"
+#include <cstring>
+#include <limits>
+
+using namespace std;
+using namespace libra::core;
+using namespace libra::io;
+
+// Constructor
+TriggerBuffer::TriggerBuffer(const TriggerParams& params, ImageHandler imageHandler, ImuHandler imuHandler)
+    : params_(params),
+      imageHandler_(move(imageHandler)),
+      imuHandler_(move(imuHandler)),
+      triggerRequest_(false),
+      imageBytes_(0),
+      latestTime_(numeric_limits<double>::lowest()),
+      triggerTime_(numeric_limits<double>::lowest()),
+      postEnd_(numeric_limits<double>::lowest()),
+      imageFlush_(false),
+      imuFlush_(false),
+      triggerNum_(0),
+      droppedImageNum_(0) {}
+
+// Push image. The flush and the passed image are saved out of the lock, so the other threads could push meanwhile
+void TriggerBuffer::push(const RawImageRecord& raw, size_t camera) {
+    deque<pair<RawImageRecord, size_t>> flushed;
+    double triggerTime;
+    bool passed;
+    {
+        lock_guard<mutex> lock(mutex_);
+        update(raw.timestamp());
+        if (imageFlush_) {
+            flushed.swap(images_);
+            imageBytes_ = 0;
+            imageFlush_ = false;
+        }
+        triggerTime = triggerTime_;
+        passed = raw.timestamp() <= postEnd_;
+        if (!passed) {
+            // hold the owned buffer without copying, otherwise copy into pooled buffer
+            images_.emplace_back(raw, camera);
+            if (!raw.reading().isOwned() && raw.reading().buffer() != nullptr) {
+                shared_ptr<unsigned char> data = pool_.lease(raw.reading().size());
+                memcpy(data.get(), raw.reading().buffer(), raw.reading().size());
+                images_.back().first.reading().setData(move(data), raw.reading().size());
+            }
+            imageBytes_ += raw.reading().size();
+
+            // drop the oldest images out of window or budget, the latest one is always kept
+            while (images_.size() > 1 && (imageBytes_ > params_.byteBudget ||
+                                          images_.front().first.timestamp() < latestTime_ - params_.preTrigger)) {
+                if (images_.front().first.timestamp() >= latestTime_ - params_.preTrigger) {
+                    ++droppedImageNum_;
+                }
+                imageBytes_ -= images_.front().first.reading().size();
+                images_.pop_front();
+            }
+        }
+    }
+
+    for (const auto& r : flushed) {
+        if (r.first.timestamp() >= triggerTime - params_.preTrigger) {
+            imageHandler_(r.first, r.second);
+        }
+    }
+    if (passed) {
+        imageHandler_(raw, camera);
+    }
+}
+
+// Push IMU
+void TriggerBuffer::push(const ImuRecord& imu) {
+    if ((params_.accThreshold > 0 && imu.reading().acc().norm() > params_.accThreshold) ||
+        (params_.gyroThreshold > 0 && imu.reading().gyro().norm() > params_.gyroThreshold)) {
+        trigger();
+    }
+
+    deque<ImuRecord> flushed;
+    double triggerTime;
+    bool passed;
+    {
+        lock_guard<mutex> lock(mutex_);
+        update(imu.timestamp());
+        if (imuFlush_) {
+            flushed.swap(imus_);
+            imuFlush_ = false;
+        }
+        triggerTime = triggerTime_;
+        passed = imu.timestamp() <= postEnd_;
+        if (!passed) {
+            imus_.emplace_back(imu);
+            while (!imus_.empty() && imus_.front().timestamp() < latestTime_ - params_.preTrigger) {
+                imus_.pop_front();
+            }
+        }
+    }
+
+    for (const auto& r : flushed) {
+        if (r.timestamp() >= triggerTime - params_.preTrigger) {
+            imuHandler_(r);
+        }
+    }
+    if (passed) {
+        imuHandler_(imu);
+    }
+}
+
+// Check whether it's in the post-trigger window
+bool TriggerBuffer::isTriggered() const {
+    lock_guard<mutex> lock(mutex_);
+    return latestTime_ <= postEnd_;
+}
+
+// Get the number of triggers
+size_t TriggerBuffer::triggerNum() const {
+    lock_guard<mutex> lock(mutex_);
+    return triggerNum_;
+}
+
+// Get the number of buffered images
+size_t TriggerBuffer::bufferedImageNum() const {
+    lock_guard<mutex> lock(mutex_);
+    return images_.size();
+}
+
+// Get the size of buffered images
+size_t TriggerBuffer::bufferedBytes() const {
+    lock_guard<mutex> lock(mutex_);
+    return imageBytes_;
+}
+
+// Get the number of images dropped by byte budget
+size_t TriggerBuffer::droppedImageNum() const {
+    lock_guard<mutex> lock(mutex_);
+    return droppedImageNum_;
+}
+
+// Update the latest timestamp and handle the trigger request. The new trigger flushes both the image and IMU buffers at
+// their next push, and the trigger in the post-trigger window only extends the window
+void TriggerBuffer::update(double timestamp) {
+    latestTime_ = max(latestTime_, timestamp);
+    if (!triggerRequest_.exchange(false, memory_order_acquire)) {
+        return;
+    }
+    if (latestTime_ > postEnd_) {
+        triggerTime_ = latestTime_;
+        imageFlush_ = true;
+        imuFlush_ = true;
+        ++triggerNum_;
+    }
+    postEnd_ = latestTime_ + params_.postTrigger;
+}
@@ -0,0 +1,789 @@
+#include "libra/io/YuyvJpegEncoder.h"
+#include <fmt/format.h>
+#include <glog/logging.h>
+#include <condition_variable>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <jpeglib.h>
+#include <jerror.h>
+#include "libra/util/TraceRecorder.h"
+#include "libra/util/YuyvConvert.h"
+
+using namespace std;
+using namespace libra::util;
+using namespace libra::core;
+using namespace libra::io;
+
+namespace {
+
+/**
+ * @brief Error manager for libjpeg, jump back to the compress function instead of calling `exit()`
+ */
+struct ErrorManager {
+    jpeg_error_mgr pub;                      // libjpeg error manager
+    jmp_buf jump;                            // jump buffer for error
+    char message[JMSG_LENGTH_MAX] = {'\0'};  // last error message
+};
+
+// error exit for libjpeg
+void errorExit(j_common_ptr cinfo) {
+    ErrorManager* err = reinterpret_cast<ErrorManager*>(cinfo->err);
+    (*cinfo->err->format_message)(cinfo, err->message);
+    longjmp(err->jump, 1);
+}
+
+// output message for libjpeg, keep the message instead of print to stderr
+void outputMessage(j_common_ptr cinfo) {
+    ErrorManager* err = reinterpret_cast<ErrorManager*>(cinfo->err);
+    (*cinfo->err->format_message)(cinfo, err->message);
+}
+
+/**
+ * @brief Destination manager for libjpeg which writes into a fixed size buffer, raise error if the buffer is full
+ */
+struct FixedDestination {
+    jpeg_destination_mgr pub;         // libjpeg destination manager
+    unsigned char* buffer = nullptr;  // output buffer
+    unsigned long capacity = 0;       // output buffer size
+
+    FixedDestination() {
+        pub.init_destination = initDestination;
+        pub.empty_output_buffer = emptyOutputBuffer;
+        pub.term_destination = termDestination;
+    }
+
+    // initialize destination, called by `jpeg_start_compress()`
+    static void initDestination(j_compress_ptr cinfo) {
+        FixedDestination* dest = reinterpret_cast<FixedDestination*>(cinfo->dest);
+        dest->pub.next_output_byte = dest->buffer;
+        dest->pub.free_in_buffer = dest->capacity;
+    }
+
+    // the buffer is full, cannot grow the fixed buffer so raise error
+    static boolean emptyOutputBuffer(j_compress_ptr cinfo) {
+        ERREXIT(cinfo, JERR_BUFFER_SIZE);
+        return FALSE;
+    }
+
+    // terminate destination, nothing to do
+    static void termDestination(j_compress_ptr) {}
+
+    // the size of written data
+    unsigned long size() const { return capacity - pub.free_in_buffer; }
+};
+
+/**
+ * @brief Extract the Y channel of one row of YUYV image
+ *
+ * @param yuyv  YUYV row
+ * @param width Image width
+ * @param y     Output Y row
+ */
+void yuyvToYRow(const unsigned char* yuyv, int width, unsigned char* y) {
+    for (int i = 0; i < width; ++i) {
+        y[i] = yuyv[2 * i];
+    }
+}
+
+/**
+ * @brief Average two chroma rows with rounding to get the chroma row of YUV420, the output could be the same with
+ * input
+ *
+ * @param row0  The first row
+ * @param row1  The second row
+ * @param width Row width
+ * @param dst   Output row
+ */
+void averageRows(const unsigned char* row0, const unsigned char* row1, int width, unsigned char* dst) {
+    for (int i = 0; i < width; ++i) {
+        dst[i] = static_cast<unsigned char>((row0[i] + row1[i] + 1) >> 1);
+    }
+}
+
+/**
+ * @brief Convert one output row of YUYV image to YUV422 planar, the row and the next one are binned if binning is 2
+ *
+ * @param yuyv      YUYV row
+ * @param stride    Row stride of YUYV image in bytes
+ * @param width     Output width
+ * @param binning   Binning factor, 1 or 2
+ * @param y         Output Y row
+ * @param u         Output U row
+ * @param v         Output V row
+ */
+inline void convertRow(const unsigned char* yuyv, int stride, int width, int binning, unsigned char* y,
+                       unsigned char* u, unsigned char* v) {
+    if (binning == 2) {
+        yuyvBin2x2Row(yuyv, yuyv + stride, 2 * width, y, u, v);
+    } else {
+        yuyvToYuv422pRow(yuyv, width, y, u, v);
+    }
+}
+
+/**
+ * @brief Extract the Y channel of one output row of YUYV image, the row and the next one are binned if binning is 2
+ *
+ * @param yuyv      YUYV row
+ * @param stride    Row stride of YUYV image in bytes
+ * @param width     Output width
+ * @param binning   Binning factor, 1 or 2
+ * @param y         Output Y row
+ */
+inline void convertYRow(const unsigned char* yuyv, int stride, int width, int binning, unsigned char* y) {
+    if (binning == 2) {
+        yuyvBin2x2Row(yuyv, yuyv + stride, 2 * width, y, nullptr, nullptr);
+    } else {
+        yuyvToYRow(yuyv, width, y);
+    }
+}
+
+/**
+ * @brief Get the turbojpeg subsampling
+ *
+ * @param subsampling   Chroma subsampling
+ * @return Turbojpeg subsampling
+ */
+int toTjSubsampling(JpegSubsampling subsampling) {
+    switch (subsampling) {
+        case JpegSubsampling::S420:
+            return TJSAMP_420;
+        case JpegSubsampling::Gray:
+            return TJSAMP_GRAY;
+        default:
+            return TJSAMP_422;
+    }
+}
+
+/**
+ * @brief Find the start of entropy-coded data in JPEG, which is after the SOS segment
+ *
+ * @param jpeg      JPEG data
+ * @param size      JPEG size
+ * @param sofPos    Output position of SOF0 marker
+ * @param sosPos    Output position of SOS marker
+ * @return The start of entropy-coded data, 0 if not found
+ */
+size_t findScanData(const unsigned char* jpeg, size_t size, size_t* sofPos, size_t* sosPos) {
+    // skip SOI, then walk through the marker segments
+    size_t pos{2};
+    while (pos + 4 <= size && jpeg[pos] == 0xFF) {
+        unsigned char marker = jpeg[pos + 1];
+        size_t length = (jpeg[pos + 2] << 8) | jpeg[pos + 3];
+        if (marker == 0xC0) {
+            *sofPos = pos;
+        } else if (marker == 0xDA) {
+            *sosPos = pos;
+            return pos + 2 + length;
+        }
+        pos += 2 + length;
+    }
+    return 0;
+}
+
+/**
+ * @brief Guard of the task posted to thread pool, which decreases the remaining task number when the task is destroyed,
+ * so the waiting thread is notified even if the task is dropped without running
+ */
+struct FinishGuard {
+    mutex* finishMutex;                   // mutex for remaining number
+    condition_variable* finishCondition;  // condition variable when all tasks are finished
+    int* remainNum;                       // remaining task number, null if moved
+
+    FinishGuard(mutex* m, condition_variable* c, int* num) : finishMutex(m), finishCondition(c), remainNum(num) {}
+
+    FinishGuard(FinishGuard&& other) noexcept
+        : finishMutex(other.finishMutex), finishCondition(other.finishCondition), remainNum(other.remainNum) {
+        other.remainNum = nullptr;
+    }
+
+    // notify under the lock, so the condition variable is still alive
+    ~FinishGuard() {
+        if (remainNum != nullptr) {
+            lock_guard<mutex> lock(*finishMutex);
+            if (--*remainNum == 0) {
+                finishCondition->notify_one();
+            }
+        }
+    }
+
+    FinishGuard(const FinishGuard&) = delete;
+    FinishGuard& operator=(const FinishGuard&) = delete;
+    FinishGuard& operator=(FinishGuard&&) = delete;
+};
+
+}  // namespace
+
+namespace libra {
+namespace io {
+
+// Convert encode geometry to json
+void to_json(nlohmann::json& j, const EncodeGeometry& geometry) {
+    j = nlohmann::json{{"InputWidth", geometry.inputWidth},
+                       {"InputHeight", geometry.inputHeight},
+                       {"Roi", {geometry.roi.x, geometry.roi.y, geometry.roi.width, geometry.roi.height}},
+                       {"Binning", geometry.binning},
+                       {"Width", geometry.width},
+                       {"Height", geometry.height},
+                       {"Scale", geometry.scale},
+                       {"Offset", {geometry.offsetX, geometry.offsetY}}};
+}
+
+// Convert json to encode geometry
+void from_json(const nlohmann::json& j, EncodeGeometry& geometry) {
+    geometry.inputWidth = j["InputWidth"].get<int>();
+    geometry.inputHeight = j["InputHeight"].get<int>();
+    vector<int> roi = j["Roi"].get<vector<int>>();
+    geometry.roi = ImageRoi{roi.at(0), roi.at(1), roi.at(2), roi.at(3)};
+    geometry.binning = j["Binning"].get<int>();
+    geometry.width = j["Width"].get<int>();
+    geometry.height = j["Height"].get<int>();
+    geometry.scale = j["Scale"].get<double>();
+    vector<double> offset = j["Offset"].get<vector<double>>();
+    geometry.offsetX = offset.at(0);
+    geometry.offsetY = offset.at(1);
+}
+
+}  // namespace io
+}  // namespace libra
+
+/**
+ * @brief libjpeg compressor for direct mode
+ */
+struct YuyvJpegEncoder::DirectCompressor {
+    jpeg_compress_struct cinfo;             // compress info
+    ErrorManager err;                       // error manager
+    FixedDestination fixedDest;             // destination for output buffer
+    std::vector<unsigned char> mcuRowData;  // buffer for one MCU row
+    unsigned char* allocBuf = nullptr;      // output buffer allocated in last call without capacity
+    unsigned long allocSize = 0;            // size of allocated output buffer
+
+    DirectCompressor() {
+        cinfo.err = jpeg_std_error(&err.pub);
+        err.pub.error_exit = errorExit;
+        err.pub.output_message = outputMessage;
+        jpeg_create_compress(&cinfo);
+    }
+
+    ~DirectCompressor() { jpeg_destroy_compress(&cinfo); }
+};
+
+/**
+ * @brief Compressor and output buffer of one stripe in stripe mode
+ */
+struct YuyvJpegEncoder::Stripe {
+    DirectCompressor direct;            // compressor
+    std::vector<unsigned char> buffer;  // output JPEG of stripe, it only grows
+    unsigned long size = 0;             // output JPEG size
+    bool success = false;               // whether compress success
+    bool done = false;                  // whether compress is done, false if it's dropped by the stopped thread pool
+};
+
+// Constructor
+YuyvJpegEncoder::YuyvJpegEncoder(const YuyvEncodeParams& params, const shared_ptr<ThreadPool>& threadPool)
+    : params_(params),
+      compressor_(tjInitCompress()),
+      direct_(new DirectCompressor),
+      threadPool_(threadPool),
+      convertDoneTime_(0) {}
+
+// Destructor
+YuyvJpegEncoder::~YuyvJpegEncoder() { tjDestroy(compressor_); }
+
+// Set the encode parameters
+void YuyvJpegEncoder::setParams(const YuyvEncodeParams& params) { params_ = params; }
+
+// Set the thread pool to encode stripes in stripe mode
+void YuyvJpegEncoder::setThreadPool(const shared_ptr<ThreadPool>& threadPool) { threadPool_ = threadPool; }
+
+// Compress YUYV image to JPEG
+bool YuyvJpegEncoder::encode(const unsigned char* yuyv, int width, int height, int stride, unsigned char** jpegBuf,
+                             unsigned long* jpegSize) {
+    if (!crop(&yuyv, &width, &height, stride)) {
+        tjFree(*jpegBuf);
+        *jpegBuf = nullptr;
+        *jpegSize = 0;
+        return false;
+    }
+
+    LIBRA_TRACE_SCOPE("YuyvJpegEncoder::encode");
+    convertDoneTime_ = FrameTrace::now();
+    bool ret{false};
+    switch (params_.mode) {
+        case YuyvEncodeMode::Planar:
+            ret = encodePlanar(yuyv, width, height, stride, jpegBuf, jpegSize, 0);
+            break;
+        case YuyvEncodeMode::Direct:
+            ret = encodeDirect(*direct_, yuyv, width, height, stride, jpegBuf, jpegSize, 0, params_.restartRows);
+            break;
+        case YuyvEncodeMode::Stripe:
+            ret = encodeStripe(yuyv, width, height, stride, jpegBuf, jpegSize, 0);
+            break;
+        default:
+            break;
+    }
+
+    // release buffer if failed
+    if (!ret) {
+        tjFree(*jpegBuf);
+        *jpegBuf = nullptr;
+        *jpegSize = 0;
+    }
+    return ret;
+}
+
+// Compress YUYV image to JPEG into a preallocated buffer
+bool YuyvJpegEncoder::encodeTo(const unsigned char* yuyv, int width, int height, int stride, unsigned char* jpegBuf,
+                               unsigned long capacity, unsigned long* jpegSize) {
+    // turbojpeg don't check the buffer size if not reallocate, so the buffer should be large enough for worst case
+    if (jpegBuf == nullptr || capacity < bufferSize(width, height)) {
+        LOG(ERROR) << fmt::format("JPEG buffer is too small, size = {}, required = {}", capacity,
+                                  bufferSize(width, height));
+        *jpegSize = 0;
+        return false;
+    }
+    if (!crop(&yuyv, &width, &height, stride)) {
+        *jpegSize = 0;
+        return false;
+    }
+
+    LIBRA_TRACE_SCOPE("YuyvJpegEncoder::encode");
+    convertDoneTime_ = FrameTrace::now();
+    bool ret{false};
+    switch (params_.mode) {
+        case YuyvEncodeMode::Planar:
+            ret = encodePlanar(yuyv, width, height, stride, &jpegBuf, jpegSize, capacity);
+            break;
+        case YuyvEncodeMode::Direct:
+            ret = encodeDirect(*direct_, yuyv, width, height, stride, &jpegBuf, jpegSize, capacity,
+                               params_.restartRows);
+            break;
+        case YuyvEncodeMode::Stripe:
+            ret = encodeStripe(yuyv, width, height, stride, &jpegBuf, jpegSize, capacity);
+            break;
+        default:
+            break;
+    }
+    if (!ret) {
+        *jpegSize = 0;
+    }
+    return ret;
+}
+
+// Get the worst case JPEG buffer size
+unsigned long YuyvJpegEncoder::bufferSize(int width, int height) { return tjBufSize(width, height, TJSAMP_422); }
+
+// Get the geometry of encoded image after ROI crop and binning
+bool YuyvJpegEncoder::geometry(const YuyvEncodeParams& params, int width, int height, EncodeGeometry* geometry) {
+    const int binning = params.binning;
+    ImageRoi roi = params.roi;
+    roi.width = roi.width > 0 ? roi.width : width - roi.x;
+    roi.height = roi.height > 0 ? roi.height : height - roi.y;
+    roi.width = roi.width / (2 * binning) * (2 * binning);
+    roi.height = roi.height / binning * binning;
+    if ((binning != 1 && binning != 2) || roi.x < 0 || roi.y < 0 || roi.x % 2 != 0 || roi.width <= 0 ||
+        roi.height <= 0 || roi.x + roi.width > width || roi.y + roi.height > height) {
+        return false;
+    }
+
+    geometry->inputWidth = width;
+    geometry->inputHeight = height;
+    geometry->roi = roi;
+    geometry->binning = binning;
+    geometry->width = roi.width / binning;
+    geometry->height = roi.height / binning;
+    // the pixel center u of input image is at (u - x + 0.5) / binning - 0.5 of encoded image
+    geometry->scale = 1.0 / binning;
+    geometry->offsetX = (0.5 - roi.x) / binning - 0.5;
+    geometry->offsetY = (0.5 - roi.y) / binning - 0.5;
+    return true;
+}
+
+// Crop the ROI of input image, the output size is the size after binning, and the binning is done with conversion
+bool YuyvJpegEncoder::crop(const unsigned char** yuyv, int* width, int* height, int stride) const {
+    EncodeGeometry geometry;
+    if (!YuyvJpegEncoder::geometry(params_, *width, *height, &geometry)) {
+        LOG(ERROR) << fmt::format("invalid ROI ({}, {}, {}, {}) or binning {} for image {}x{}", params_.roi.x,
+                                  params_.roi.y, params_.roi.width, params_.roi.height, params_.binning, *width,
+                                  *height);
+        return false;
+    }
+    *yuyv += static_cast<size_t>(geometry.roi.y) * stride + 2 * geometry.roi.x;
+    *width = geometry.width;
+    *height = geometry.height;
+    return true;
+}
+
+// Compress using planar mode
+bool YuyvJpegEncoder::encodePlanar(const unsigned char* yuyv, int width, int height, int stride,
+                                   unsigned char** jpegBuf, unsigned long* jpegSize, unsigned long capacity) {
+    // resize buffer if don't match. The Y plane of YUV420 is padded to even rows as `tjPlaneHeight()`, and two more
+    // half rows are used to keep the chroma of odd row before averaging
+    const int chromaWidth = width / 2;
+    const int chromaHeight = (height + 1) / 2;
+    size_t length{0};
+    switch (params_.subsampling) {
+        case JpegSubsampling::S420:
+            length = static_cast<size_t>(width) * (2 * chromaHeight) + 2 * chromaWidth * (chromaHeight + 1);
+            break;
+        case JpegSubsampling::Gray:
+            length = static_cast<size_t>(width) * height;
+            break;
+        default:
+            length = static_cast<size_t>(2) * width * height;
+            break;
+    }
+    if (yuvData_.size() != length) {
+        yuvData_.resize(length);
+    }
+
+    // each output row is converted from `binning` input rows
+    const int binning = params_.binning;
+    const size_t rowStep = static_cast<size_t>(stride) * binning;
+    if (params_.subsampling == JpegSubsampling::Gray) {
+        // only extract the Y channel
+        for (int i = 0; i < height; ++i) {
+            convertYRow(yuyv + i * rowStep, stride, width, binning, yuvData_.data() + static_cast<size_t>(i) * width);
+        }
+    } else if (params_.subsampling == JpegSubsampling::S420) {
+        // convert each row, and average the chroma of two rows
+        unsigned char* y = yuvData_.data();
+        unsigned char* u = y + static_cast<size_t>(width) * (2 * chromaHeight);
+        unsigned char* v = u + static_cast<size_t>(chromaWidth) * chromaHeight;
+        unsigned char* uOdd = v + static_cast<size_t>(chromaWidth) * chromaHeight;  // chroma of odd row
+        unsigned char* vOdd = uOdd + chromaWidth;
+        for (int i = 0; i < height; ++i) {
+            unsigned char* uRow = u + static_cast<size_t>(i / 2) * chromaWidth;
+            unsigned char* vRow = v + static_cast<size_t>(i / 2) * chromaWidth;
+            if (i % 2 == 0) {
+                convertRow(yuyv + i * rowStep, stride, width, binning, y + static_cast<size_t>(i) * width, uRow, vRow);
+            } else {
+                convertRow(yuyv + i * rowStep, stride, width, binning, y + static_cast<size_t>(i) * width, uOdd, vOdd);
+                averageRows(uRow, uOdd, chromaWidth, uRow);
+                averageRows(vRow, vOdd, chromaWidth, vRow);
+            }
+        }
+        // duplicate last row to fill the padded Y plane
+        if (height % 2 == 1) {
+            memcpy(y + static_cast<size_t>(height) * width, y + static_cast<size_t>(height - 1) * width, width);
+        }
+    } else if (binning == 1) {
+        // convert YUYV(YUV422 Packed) to YUV(YUV422 Planar)
+        yuyvToYuv422p(yuyv, width, height, stride, yuvData_.data());
+    } else {
+        // bin and convert each row into the planes
+        unsigned char* y = yuvData_.data();
+        unsigned char* u = y + static_cast<size_t>(width) * height;
+        unsigned char* v = u + static_cast<size_t>(width / 2) * height;
+        for (int i = 0; i < height; ++i) {
+            convertRow(yuyv + i * rowStep, stride, width, binning, y + static_cast<size_t>(i) * width,
+                       u + static_cast<size_t>(i) * (width / 2), v + static_cast<size_t>(i) * (width / 2));
+        }
+    }
+    convertDoneTime_ = FrameTrace::now();
+
+    // compress image using turbojpeg, the float DCT isn't supported and the accurate one is used instead
+    int flags = capacity == 0 ? 0 : TJFLAG_NOREALLOC;
+    flags |= params_.dctMethod == JpegDctMethod::Slow || params_.dctMethod == JpegDctMethod::Float ? TJFLAG_ACCURATEDCT
+                                                                                                     : TJFLAG_FASTDCT;
+    if (tjCompressFromYUV(compressor_, yuvData_.data(), width, 1, height, toTjSubsampling(params_.subsampling),
+                          jpegBuf, jpegSize, params_.quality, flags) != 0) {
+        LOG(ERROR) << fmt::format("turbo jpeg compress error: {}", tjGetErrorStr2(compressor_));
+        return false;
+    }
+    return true;
+}
+
+// Compress using direct mode. The compress setting is the same with `tjCompressFromYUV()`, and the MCU row is padded
+// with the same way, so the output is the same
+bool YuyvJpegEncoder::encodeDirect(DirectCompressor& direct, const unsigned char* yuyv, int width, int height,
+                                   int stride, unsigned char** jpegBuf, unsigned long* jpegSize, unsigned long capacity,
+                                   int restartRows) {
+    // allocate the worst case buffer like turbojpeg if it's not preallocated, so the output is always written into the
+    // fixed buffer owned by caller, and nothing is leaked when libjpeg jumps back on error. The JPEG size is output, so
+    // the size of buffer allocated here is tracked to reuse it in next call
+    if (capacity == 0) {
+        const unsigned long size = bufferSize(width, height);
+        capacity = *jpegBuf != nullptr && *jpegBuf == direct.allocBuf ? direct.allocSize : *jpegSize;
+        if (*jpegBuf == nullptr || capacity < size) {
+            tjFree(*jpegBuf);
+            *jpegBuf = tjAlloc(size);
+            capacity = size;
+            direct.allocBuf = *jpegBuf;
+            direct.allocSize = size;
+        }
+    }
+
+    jpeg_compress_struct* cinfo = &direct.cinfo;
+    if (setjmp(direct.err.jump)) {
+        jpeg_abort_compress(cinfo);
+        LOG(ERROR) << fmt::format("jpeg compress error: {}", direct.err.message);
+        return false;
+    }
+
+    // set destination
+    direct.fixedDest.buffer = *jpegBuf;
+    direct.fixedDest.capacity = capacity;
+    cinfo->dest = &direct.fixedDest.pub;
+
+    // compress setting, same with `tjCompressFromYUV(..., TJFLAG_FASTDCT)` for the auto DCT method without restart
+    const JpegSubsampling subsampling = params_.subsampling;
+    cinfo->image_width = width;
+    cinfo->image_height = height;
+    cinfo->input_components = 3;
+    cinfo->in_color_space = JCS_RGB;
+    jpeg_set_defaults(cinfo);
+    jpeg_set_quality(cinfo, params_.quality, TRUE);
+    switch (params_.dctMethod) {
+        case JpegDctMethod::Slow:
+            cinfo->dct_method = JDCT_ISLOW;
+            break;
+        case JpegDctMethod::Fast:
+            cinfo->dct_method = JDCT_IFAST;
+            break;
+        case JpegDctMethod::Float:
+            cinfo->dct_method = JDCT_FLOAT;
+            break;
+        default:
+            cinfo->dct_method = params_.quality >= 96 ? JDCT_ISLOW : JDCT_FASTEST;
+            break;
+    }
+    cinfo->restart_in_rows = max(0, restartRows);
+    if (subsampling == JpegSubsampling::Gray) {
+        jpeg_set_colorspace(cinfo, JCS_GRAYSCALE);
+    } else {
+        jpeg_set_colorspace(cinfo, JCS_YCbCr);
+        cinfo->comp_info[0].h_samp_factor = 2;
+        cinfo->comp_info[0].v_samp_factor = subsampling == JpegSubsampling::S420 ? 2 : 1;
+        for (int i = 1; i < 3; ++i) {
+            cinfo->comp_info[i].h_samp_factor = 1;
+            cinfo->comp_info[i].v_samp_factor = 1;
+        }
+    }
+    cinfo->raw_data_in = TRUE;
+    jpeg_start_compress(cinfo, TRUE);
+
+    // buffer for one MCU row, the width is padded to the whole blocks. For YUV420, two more half rows are used to
+    // keep the chroma of odd row before averaging
+    const int compNum = cinfo->num_components;
+    const int mcuRows = cinfo->max_v_samp_factor * DCTSIZE;
+    const int planeWidth[3] = {width, width / 2, width / 2};
+    int padWidth[3] = {0, 0, 0};  // padded width of each component
+    int compRows[3] = {0, 0, 0};  // rows of each component in one MCU row
+    size_t length{0};
+    for (int c = 0; c < compNum; ++c) {
+        padWidth[c] = static_cast<int>(cinfo->comp_info[c].width_in_blocks * DCTSIZE);
+        compRows[c] = cinfo->comp_info[c].v_samp_factor * DCTSIZE;
+        length += padWidth[c] * compRows[c];
+    }
+    if (subsampling == JpegSubsampling::S420) {
+        length += width;
+    }
+    if (direct.mcuRowData.size() < length) {
+        direct.mcuRowData.resize(length);
+    }
+    JSAMPROW rows[3][2 * DCTSIZE];
+    JSAMPARRAY planes[3] = {rows[0], rows[1], rows[2]};
+    unsigned char* p = direct.mcuRowData.data();
+    for (int c = 0; c < compNum; ++c) {
+        for (int j = 0; j < compRows[c]; ++j) {
+            rows[c][j] = p;
+            p += padWidth[c];
+        }
+    }
+    unsigned char* oddRow[2] = {p, p + width / 2};  // chroma of odd row for YUV420
+
+    // convert and compress each MCU row
+    const int binning = params_.binning;
+    const size_t rowStep = static_cast<size_t>(stride) * binning;  // each output row is from `binning` input rows
+    for (int row = 0; row < height; row += mcuRows) {
+        int validRows = min(mcuRows, height - row);
+        for (int j = 0; j < validRows; ++j) {
+            const unsigned char* src = yuyv + (row + j) * rowStep;
+            if (subsampling == JpegSubsampling::Gray) {
+                convertYRow(src, stride, width, binning, rows[0][j]);
+            } else if (subsampling == JpegSubsampling::S420 && j % 2 == 1) {
+                convertRow(src, stride, width, binning, rows[0][j], oddRow[0], oddRow[1]);
+                for (int c = 1; c < 3; ++c) {
+                    averageRows(rows[c][j / 2], oddRow[c - 1], planeWidth[c], rows[c][j / 2]);
+                }
+            } else {
+                int k = subsampling == JpegSubsampling::S420 ? j / 2 : j;
+                convertRow(src, stride, width, binning, rows[0][j], rows[1][k], rows[2][k]);
+            }
+        }
+        for (int c = 0; c < compNum; ++c) {
+            // duplicate last sample in row to fill out MCU
+            int validCompRows = (validRows * compRows[c] + mcuRows - 1) / mcuRows;
+            for (int j = 0; j < validCompRows; ++j) {
+                memset(rows[c][j] + planeWidth[c], rows[c][j][planeWidth[c] - 1], padWidth[c] - planeWidth[c]);
+            }
+            // duplicate last row to fill out MCU
+            for (int j = validCompRows; j < compRows[c]; ++j) {
+                memcpy(rows[c][j], rows[c][validCompRows - 1], padWidth[c]);
+            }
+        }
+        jpeg_write_raw_data(cinfo, planes, mcuRows);
+    }
+    jpeg_finish_compress(cinfo);
+    *jpegSize = direct.fixedDest.size();
+
+    return true;
+}
+
+// Compress using stripe mode. Each stripe is compressed as a standalone JPEG with direct mode, whose entropy-coded data
+// is the same with one restart interval, because the DC prediction is reset and the data is padded to byte at each
+// restart marker. So the output is stitched by the header of first stripe with DRI marker inserted and the frame height
+// patched, then the entropy-coded data of stripes separated by RST markers. If restart is enabled, the stripe height is
+// the multiple of restart interval, the DRI marker is already in the header, and the RST markers in stripes are
+// renumbered
+bool YuyvJpegEncoder::encodeStripe(const unsigned char* yuyv, int width, int height, int stride,
+                                   unsigned char** jpegBuf, unsigned long* jpegSize, unsigned long capacity) {
+    // the MCU of YUV422 is 16x8, YUV420 is 16x16 and grayscale is 8x8, and the restart interval should be less than
+    // 65536 MCUs
+    const int mcuWidth = params_.subsampling == JpegSubsampling::Gray ? 8 : 16;
+    const int mcuHeight = params_.subsampling == JpegSubsampling::S420 ? 16 : 8;
+    const int mcuCols = (width + mcuWidth - 1) / mcuWidth;
+    const int mcuRows = (height + mcuHeight - 1) / mcuHeight;
+    int stripeNum{params_.stripeNum};
+    if (stripeNum <= 0) {
+        stripeNum = threadPool_ ? static_cast<int>(threadPool_->threadNum()) : 1;
+    }
+    // with restart enabled, each stripe has several restart intervals, otherwise it's one restart interval
+    const int restartRows = params_.restartRows > 0 ? min(params_.restartRows, max(1, 65535 / mcuCols)) : 0;
+    int stripeMcuRows = (mcuRows + stripeNum - 1) / stripeNum;
+    if (restartRows > 0) {
+        stripeMcuRows = (stripeMcuRows + restartRows - 1) / restartRows * restartRows;
+    } else {
+        stripeMcuRows = min(stripeMcuRows, max(1, 65535 / mcuCols));
+    }
+    stripeNum = (mcuRows + stripeMcuRows - 1) / stripeMcuRows;
+    if (stripeNum <= 1) {
+        return encodeDirect(*direct_, yuyv, width, height, stride, jpegBuf, jpegSize, capacity, restartRows);
+    }
+
+    // compress stripes, the last one is compressed in calling thread
+    while (stripes_.size() < static_cast<size_t>(stripeNum)) {
+        stripes_.emplace_back(new Stripe);
+    }
+    auto compress = [&](int i) {
+        Stripe& stripe = *stripes_[i];
+        int row = i * stripeMcuRows * mcuHeight;
+        int rows = min(stripeMcuRows * mcuHeight, height - row);
+        unsigned long size = bufferSize(width, rows);
+        if (stripe.buffer.size() < size) {
+            stripe.buffer.resize(size);
+        }
+        unsigned char* buffer = stripe.buffer.data();
+        LIBRA_TRACE_SCOPE("YuyvJpegEncoder::encodeStripe");
+        const unsigned char* src = yuyv + static_cast<size_t>(row) * params_.binning * stride;
+        stripe.success = encodeDirect(stripe.direct, src, width, rows, stride, &buffer, &stripe.size, size,
+                                      restartRows);
+        stripe.done = true;
+    };
+    for (int i = 0; i < stripeNum; ++i) {
+        stripes_[i]->done = false;
+    }
+    if (threadPool_) {
+        // the remaining number is decreased when the posted task is destroyed, either after it's done, or it's dropped
+        // because the pool is stopped, so the wait always ends
+        mutex finishMutex;
+        condition_variable finishCondition;
+        int remainNum{0};
+        try {
+            for (int i = 0; i < stripeNum - 1; ++i) {
+                {
+                    lock_guard<mutex> lock(finishMutex);
+                    ++remainNum;
+                }
+                threadPool_->post([&compress, i, guard = FinishGuard(&finishMutex, &finishCondition, &remainNum)]() {
+                    compress(i);
+                });
+            }
+        } catch (const exception& e) {
+            LOG_EVERY_N(WARNING, 100) << fmt::format("cannot post stripe to thread pool, compress in place: {}",
+                                                     e.what());
+        }
+        compress(stripeNum - 1);
+        unique_lock<mutex> lock(finishMutex);
+        finishCondition.wait(lock, [&]() { return remainNum == 0; });
+    }
+    // compress the stripes without thread pool, or not posted or dropped by the stopped pool, in calling thread
+    for (int i = 0; i < stripeNum; ++i) {
+        if (!stripes_[i]->done) {
+            compress(i);
+        }
+    }
+
+    // find the entropy-coded data of each stripe, which is between the SOS segment and EOI marker. The headers of all
+    // stripes have the same length, so the marker positions are the same
+    vector<pair<size_t, size_t>> scans(stripeNum);  // start and end of entropy-coded data
+    size_t sofPos{0}, sosPos{0};
+    for (int i = 0; i < stripeNum; ++i) {
+        const Stripe& stripe = *stripes_[i];
+        size_t start = stripe.success ? findScanData(stripe.buffer.data(), stripe.size, &sofPos, &sosPos) : 0;
+        if (start == 0 || stripe.size < start + 2) {
+            LOG(ERROR) << fmt::format("compress stripe {} error", i);
+            return false;
+        }
+        scans[i] = {start, stripe.size - 2};
+    }
+
+    // allocate output buffer
+    constexpr size_t kRstSize{2};
+    const size_t driSize = restartRows > 0 ? 0 : 6;  // the stripes have DRI marker already if restart is enabled
+    size_t totalSize = scans[0].second + driSize + (stripeNum - 1) * kRstSize + 2;
+    for (int i = 1; i < stripeNum; ++i) {
+        totalSize += scans[i].second - scans[i].first;
+    }
+    if (capacity == 0) {
+        if (*jpegBuf == nullptr || *jpegSize < totalSize) {
+            tjFree(*jpegBuf);
+            *jpegBuf = tjAlloc(totalSize);
+        }
+    } else if (capacity < totalSize) {
+        LOG(ERROR) << fmt::format("JPEG buffer is too small, size = {}, required = {}", capacity, totalSize);
+        return false;
+    }
+
+    // header of first stripe, with the frame height patched and DRI marker inserted before SOS
+    unsigned char* p = *jpegBuf;
+    const unsigned char* first = stripes_[0]->buffer.data();
+    memcpy(p, first, sosPos);
+    p[sofPos + 5] = static_cast<unsigned char>(height >> 8);
+    p[sofPos + 6] = static_cast<unsigned char>(height & 0xFF);
+    p += sosPos;
+    if (restartRows == 0) {
+        const int interval = mcuCols * stripeMcuRows;
+        const unsigned char dri[6] = {0xFF, 0xDD, 0x00, 0x04, static_cast<unsigned char>(interval >> 8),
+                                      static_cast<unsigned char>(interval & 0xFF)};
+        memcpy(p, dri, driSize);
+        p += driSize;
+    }
+    memcpy(p, first + sosPos, scans[0].second - sosPos);
+    p += scans[0].second - sosPos;
+
+    // entropy-coded data of other stripes, and EOI. The RST markers are numbered in modulo 8 through the whole image,
+    // so the RST markers inside stripes are renumbered if restart is enabled
+    const int stripeIntervals = restartRows > 0 ? stripeMcuRows / restartRows : 1;  // restart intervals of one stripe
+    for (int i = 1; i < stripeNum; ++i) {
+        int index = i * stripeIntervals - 1;  // index of RST marker
+        *p++ = 0xFF;
+        *p++ = static_cast<unsigned char>(0xD0 + index % 8);
+        const size_t length = scans[i].second - scans[i].first;
+        memcpy(p, stripes_[i]->buffer.data() + scans[i].first, length);
+        // the 0xFF in entropy-coded data is followed by 0x00, so 0xFF 0xD0-0xD7 is always RST marker
+        for (size_t k = 0; restartRows > 0 && k + 1 < length; ++k) {
+            if (p[k] == 0xFF && (p[k + 1] & 0xF8) == 0xD0) {
+                p[++k] = static_cast<unsigned char>(0xD0 + (++index) % 8);
+            }
+        }
+        p += length;
+    }
+    *p++ = 0xFF;
+    *p++ = 0xD9;
+    *jpegSize = totalSize;
+
+    return true;
+}
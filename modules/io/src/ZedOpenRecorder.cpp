@@ -1,4 +1,5 @@
 #include "libra/io/ZedOpenRecorder.h"
+#include "libra/io/FrameEncoder.h"
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 #include <glog/logging.h>
@@ -81,6 +82,14 @@ void ZedOpenRecorder::setResolution(sl_oc::video::RESOLUTION resolution) {
 // Set the saver thread number
 void ZedOpenRecorder::setSaverThreadNum(const size_t& saverThreadNum) { saverThreadNum_ = saverThreadNum; }
 
+// Set the parameters to encode YUYV image
+void ZedOpenRecorder::setEncodeParams(const YuyvEncodeParams& params) { encodeParams_ = params; }
+
+// Set the controller to adjust encode quality
+void ZedOpenRecorder::setEncodeController(const shared_ptr<AdaptiveEncodeController>& controller) {
+    encodeController_ = controller;
+}
+
 //  Set process function for raw image record of right camera
 void ZedOpenRecorder::setRightProcessFunction(const std::function<void(const core::RawImageRecord&)>& func) {
     processRightRawImg_ = func;
@@ -93,6 +102,7 @@ void ZedOpenRecorder::init() {
     // create IMU capture thread
     LOG(INFO) << "create IMU capture thread";
     imuCaptureThread_ = thread([&] {
+        LIBRA_TRACE_THREAD("IMU capture");
         // wait camera thread start
         while (!isStart()) {
             this_thread::sleep_for(std::chrono::milliseconds(10));
@@ -103,6 +113,7 @@ void ZedOpenRecorder::init() {
         imuCapture_->getImuData();
 
         double lastImuTimestamp{0};  // last timestamp
+        vector<RawImu> imuBatch;     // IMU batch read from SDK, pushed to queue together
         while (true) {
             if (isStop()) {
                 LOG(INFO) << "stop IMU recording";
@@ -110,7 +121,9 @@ void ZedOpenRecorder::init() {
             }
 
             // read IMU data
+            LIBRA_TRACE_SCOPE("ZedOpenRecorder::captureImu");
             auto imus = imuCapture_->getImuData();
+            imuBatch.clear();
             for (auto& imu : imus) {
                 if (imu->valid == data::Imu::ImuStatus::NEW_VAL) {
                     // // sync only valid if IMU and image are collected at almost the same time
@@ -135,9 +148,10 @@ void ZedOpenRecorder::init() {
                     lastImuTimestamp = imuTimestamp;
 
                     raw.imu = move(imu);
-                    imuQueue_->push(move(raw));
+                    imuBatch.emplace_back(move(raw));
                 }
             }
+            imuQueue_->pushBatch(make_move_iterator(imuBatch.begin()), make_move_iterator(imuBatch.end()));
         }
     });
 
@@ -145,14 +159,14 @@ void ZedOpenRecorder::init() {
     isRightCamEnabled_ = processRightRawImg_.operator bool();
 
     // create image queue
-    leftImageQueue_ = make_shared<JobQueue<shared_ptr<ImageFrame>>>(1000);
+    leftImageQueue_ = make_shared<MpmcQueue<RawImage>>(1000);
     leftImageQueue_->enableDropJob(true);
     if (isRightCamEnabled_) {
-        rightImageQueue_ = make_shared<JobQueue<shared_ptr<ImageFrame>>>(1000);
+        rightImageQueue_ = make_shared<MpmcQueue<RawImage>>(1000);
         rightImageQueue_->enableDropJob(true);
     }
-    // create IMU queue
-    imuQueue_ = make_shared<JobQueue<RawImu>>(3000);
+    // create IMU queue, the incoming IMU is dropped if it's full
+    imuQueue_ = make_shared<SpscQueue<RawImu>>(3000);
     imuQueue_->enableDropJob(true);
 
     // create threads to save image and IMU
@@ -162,6 +176,7 @@ void ZedOpenRecorder::init() {
 // The main run function
 void ZedOpenRecorder::run() {
     LOG(INFO) << fmt::format("ZED camera recording using Open Capture library...");
+    LIBRA_TRACE_THREAD("capture");
 #if defined(DebugTest)
     double lastTime{0};
 #endif
@@ -208,12 +223,17 @@ void ZedOpenRecorder::run() {
             // reset image queue and clear thread
             leftImageSaverThreads_.clear();
             rightImageSaverThreads_.clear();
+            LOG(INFO) << fmt::format("image pipeline latency:\n{}", *frameTracer_);
 
             break;
         }
 
         // capture image
+        LIBRA_TRACE_SCOPE("ZedOpenRecorder::captureImage");
         auto frames = cameraCapture_->getImageFrames();
+        const int64_t captureTime = FrameTrace::now();
+        vector<RawImage> images;
+        images.reserve(frames.size());
         for (auto& frame : frames) {
 #if defined(DebugTest)
             // LOG(INFO) << fmt::format("obtain left frame, t = {} ns", frame.timestamp);
@@ -223,10 +243,18 @@ void ZedOpenRecorder::run() {
                                                        lastTime, timestamp, delta, delta * 0.033);
             lastTime = timestamp;
 #endif
-            LOG_EVERY_N(INFO, 10) << fmt::format("left queue size = {}, IMU queue size = {}", leftImageQueue_->size(),
-                                                 imuQueue_->size());
-            leftImageQueue_->push(move(frame));
+            LOG_EVERY_N(INFO, 100) << fmt::format("left queue: {}; IMU queue: {}", leftImageQueue_->stats(),
+                                                  imuQueue_->stats());
+            RawImage image;
+            image.frame = move(frame);
+            image.trace.capture = captureTime;
+            images.emplace_back(move(image));
         }
+        const int64_t enqueueTime = FrameTrace::now();
+        for (auto& image : images) {
+            image.trace.enqueue = enqueueTime;
+        }
+        leftImageQueue_->pushBatch(make_move_iterator(images.begin()), make_move_iterator(images.end()));
 
         // TODO, capture right image if enable
         // if (isRightCamEnabled_) {
@@ -269,6 +297,11 @@ void ZedOpenRecorder::openDevice() {
     // logging
     LOG(INFO) << fmt::format("frame rate = {} Hz", static_cast<int>(fps_));
     LOG(INFO) << fmt::format("frame size = {}x{}", width, height);
+
+    // geometry of encoded image, only the left part of side-by-side image is encoded
+    CHECK(YuyvJpegEncoder::geometry(encodeParams_, width / 2, height, &encodeGeometry_))
+        << fmt::format("invalid ROI or binning {} for image {}x{}", encodeParams_.binning, width / 2, height);
+    LOG(INFO) << fmt::format("encoded image size = {}x{}", encodeGeometry_.width, encodeGeometry_.height);
 }
 
 // Create thread to save image and IMU
@@ -342,12 +375,10 @@ void ZedOpenRecorder::createImageSaverThread() {
         }
     };
 #else
-    // convert YUYV(YUV422 Packed) to YUV(YUV422 Planar), then compress using turbo-jpeg
-    auto yuyvFunc = [](shared_ptr<JobQueue<shared_ptr<ImageFrame>>>& imageQueue,
-                       const function<void(const RawImageRecord&)>& processFunc) {
-        tjhandle compressor = tjInitCompress();
-        vector<unsigned char> yuvData;
-
+    // compress YUYV(YUV422 Packed) image using YUYV JPEG encoder
+    auto yuyvFunc = [](shared_ptr<MpmcQueue<RawImage>>& imageQueue,
+                       const function<void(const RawImageRecord&)>& processFunc, FrameEncoder& encoder,
+                       FrameTracer& tracer) {
         while (true) {
             // take job and check it's valid
             auto job = imageQueue->pop();
@@ -355,51 +386,39 @@ void ZedOpenRecorder::createImageSaverThread() {
                 break;
             }
 
-            // resize buffer if don't match
-            int w = job.data()->width / 2;
-            int h = job.data()->height;
-            int wh = w * h;
-            int length = 2 * wh;
-            if (yuvData.size() != length) {
-                yuvData.resize(length);
-            }
-
-            // convert YUYV(YUV422 Packed) to YUV(YUV422 Planar)
-            unsigned char* pY = yuvData.data();
-            unsigned char* pU = yuvData.data() + wh;
-            unsigned char* pV = yuvData.data() + wh * 3 / 2;
-            for (int i = 0; i < h; ++i) {
-                unsigned char* pRaw = job.data()->data.data() + i * w * 4;
-                for (int j = 0; j < w / 2; ++j) {
-                    *pY++ = *(pRaw++);
-                    *pU++ = *(pRaw++);
-                    *pY++ = *(pRaw++);
-                    *pV++ = *(pRaw++);
-                }
-            }
+            const shared_ptr<ImageFrame>& frame = job.data().frame;
+            FrameTrace trace = job.data().trace;
+            trace.dequeue = FrameTrace::now();
 
-            // compress image using turbojpeg
+            // compress image, only the left part of side-by-side image
+            int w = frame->width / 2;
+            int h = frame->height;
             RawImageRecord record;
-            record.setTimestamp(job.data()->timestamp * 1.0E-9);  // ns => s
-            if (tjCompressFromYUV(compressor, yuvData.data(), w, 1, h, TJSAMP_422, &record.reading().buffer(),
-                                  &record.reading().size(), 95, TJFLAG_FASTDCT) != 0) {
-                LOG(ERROR) << fmt::format("turbo jpeg compress error: {}", tjGetErrorStr2(compressor));
+            record.setTimestamp(frame->timestamp * 1.0E-9);  // ns => s
+            if (!encoder.encode(frame->data.data(), w, h, w * 4, [&] { return imageQueue->size(); }, trace, record)) {
+                continue;
             }
 
             // process raw image
             if (processFunc) {
+                LIBRA_TRACE_SCOPE("ZedOpenRecorder::processImage");
                 processFunc(record);
             }
-
-            // release turbo jpeg data buffer
-            tjFree(record.reading().buffer());
+            trace.sink = FrameTrace::now();
+            tracer.add(trace);
         }
-
-        // destory compressor
-        tjDestroy(compressor);
     };
 #endif
 
+    // create buffer pool for output JPEG, keep enough free buffers for all saver threads
+    jpegBufferPool_ = make_shared<BufferPool>(0, 2 * (saverThreadNum_ + 1));
+
+    // create thread pool to encode the stripes of one frame in parallel, which is shared by all saver threads
+    if (encodeParams_.mode == YuyvEncodeMode::Stripe) {
+        encodeThreadPool_ = make_shared<ThreadPool>(max(1U, thread::hardware_concurrency()));
+        LOG(INFO) << fmt::format("encode image in stripes, thread num = {}", encodeThreadPool_->threadNum());
+    }
+
     // create thread for left image
     if (isRightCamEnabled_) {
         LOG(INFO) << fmt::format("create image saver thread for left camera, thread num = {}", saverThreadNum_);
@@ -407,13 +426,23 @@ void ZedOpenRecorder::createImageSaverThread() {
         LOG(INFO) << fmt::format("create image saver thread, thread num = {}", saverThreadNum_);
     }
     for (size_t i = 0; i < saverThreadNum_; ++i) {
-        leftImageSaverThreads_.emplace_back(thread([&]() { yuyvFunc(leftImageQueue_, processRawImg_); }));
+        leftImageSaverThreads_.emplace_back(
+            thread([this, yuyvFunc]() {
+                LIBRA_TRACE_THREAD("left image saver");
+                FrameEncoder encoder(encodeParams_, jpegBufferPool_, encodeThreadPool_, encodeController_);
+                yuyvFunc(leftImageQueue_, processRawImg_, encoder, *frameTracer_);
+            }));
     }
 
     // create stread for right image
     if (isRightCamEnabled_) {
         LOG(INFO) << fmt::format("create image saver thread for right camera, thread num = {}", saverThreadNum_);
-        leftImageSaverThreads_.emplace_back(thread([&]() { yuyvFunc(rightImageQueue_, processRightRawImg_); }));
+        leftImageSaverThreads_.emplace_back(
+            thread([this, yuyvFunc]() {
+                LIBRA_TRACE_THREAD("right image saver");
+                FrameEncoder encoder(encodeParams_, jpegBufferPool_, encodeThreadPool_, encodeController_);
+                yuyvFunc(rightImageQueue_, processRightRawImg_, encoder, *frameTracer_);
+            }));
     }
 }
 
@@ -421,27 +450,31 @@ void ZedOpenRecorder::createImageSaverThread() {
 void ZedOpenRecorder::createImuSaverThread() {
     LOG(INFO) << "create IMU saver thread";
     imuSaverThread_ = thread([&] {
+        LIBRA_TRACE_THREAD("IMU saver");
+        vector<RawImu> jobs;  // IMU batch popped from queue
         while (true) {
-            // take job and check it's valid
-            auto job = imuQueue_->pop();
-            if (!job.isValid()) {
+            // take jobs in batch and check queue is stopped
+            if (!imuQueue_->popBatch(jobs, 64)) {
                 break;
             }
-
-            // convert unit
-            static const double kDeg2Rad = M_PI / 180.;
-            double sensorTimestamp = job.data().imu->timestamp * 1.0E-9;  // ns => s
-            double systemTimestamp =
-                chrono::duration_cast<chrono::nanoseconds>(job.data().systemTime.time_since_epoch()).count() * 1.0E-9;
-            Vector3d acc(job.data().imu->aX, job.data().imu->aY, job.data().imu->aZ);
-            Vector3d gyro(job.data().imu->gX, job.data().imu->gY, job.data().imu->gZ);
-            gyro = gyro * kDeg2Rad;
-            ImuRecord imu(move(sensorTimestamp), ImuReading(move(acc), move(gyro)));
-            imu.setSystemTimestamp(move(systemTimestamp));
-
-            // process IMU
-            if (processImu_) {
-                processImu_(imu);
+            LIBRA_TRACE_SCOPE("ZedOpenRecorder::processImu");
+
+            for (auto& raw : jobs) {
+                // convert unit
+                static const double kDeg2Rad = M_PI / 180.;
+                double sensorTimestamp = raw.imu->timestamp * 1.0E-9;  // ns => s
+                double systemTimestamp =
+                    chrono::duration_cast<chrono::nanoseconds>(raw.systemTime.time_since_epoch()).count() * 1.0E-9;
+                Vector3d acc(raw.imu->aX, raw.imu->aY, raw.imu->aZ);
+                Vector3d gyro(raw.imu->gX, raw.imu->gY, raw.imu->gZ);
+                gyro = gyro * kDeg2Rad;
+                ImuRecord imu(move(sensorTimestamp), ImuReading(move(acc), move(gyro)));
+                imu.setSystemTimestamp(move(systemTimestamp));
+
+                // process IMU
+                if (processImu_) {
+                    processImu_(imu);
+                }
             }
         }
     });
@@ -0,0 +1,109 @@
+/**
+ * @brief Test code for adaptive encode controller
+ *
+ */
+
+#include <gtest/gtest.h>
+#include "libra/io/AdaptiveEncodeController.h"
+
+using namespace std;
+using namespace libra::core;
+using namespace libra::io;
+
+// step down when the queue is full, and step up after the queue is empty for a long time
+TEST(AdaptiveEncodeController, QueueSize) {
+    AdaptiveEncodeParams params;
+    params.highWaterSize = 10;
+    params.lowWaterSize = 2;
+    params.downFrameNum = 3;
+    params.upFrameNum = 5;
+    AdaptiveEncodeController controller(params);
+    EXPECT_EQ(controller.level(), 0);
+
+    // the queue size between low water and high water doesn't change level
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_FALSE(controller.update(5, 0.01));
+    }
+    EXPECT_EQ(controller.level(), 0);
+
+    // step down after several overloaded frames, and the level is applied to encode parameters
+    EXPECT_FALSE(controller.update(20, 0.01));
+    EXPECT_FALSE(controller.update(20, 0.01));
+    EXPECT_TRUE(controller.update(20, 0.01));
+    EXPECT_EQ(controller.level(), 1);
+    YuyvEncodeParams encodeParams;
+    EncodeInfo info = controller.apply(encodeParams);
+    EXPECT_EQ(info.level, 1);
+    EXPECT_EQ(encodeParams.quality, params.levels[1].quality);
+    EXPECT_EQ(encodeParams.subsampling, params.levels[1].subsampling);
+
+    // the level doesn't exceed the last one
+    for (int i = 0; i < 100; ++i) {
+        controller.update(20, 0.01);
+    }
+    EXPECT_EQ(controller.level(), static_cast<int>(params.levels.size()) - 1);
+    EXPECT_EQ(controller.encodeInfo().subsampling, JpegSubsampling::Gray);
+
+    // step up one by one, and stop at the best level
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_FALSE(controller.update(0, 0.01));
+    }
+    EXPECT_TRUE(controller.update(0, 0.01));
+    EXPECT_EQ(controller.level(), static_cast<int>(params.levels.size()) - 2);
+    for (int i = 0; i < 1000; ++i) {
+        controller.update(0, 0.01);
+    }
+    EXPECT_EQ(controller.level(), 0);
+    EXPECT_EQ(controller.changeNum(), 2 * (params.levels.size() - 1));
+}
+
+// step down when the encode time is over budget even if the queue isn't full, and don't step up until the encode time
+// is well within budget
+TEST(AdaptiveEncodeController, EncodeBudget) {
+    AdaptiveEncodeParams params;
+    params.encodeBudget = 0.01;
+    params.downFrameNum = 3;
+    params.upFrameNum = 5;
+    AdaptiveEncodeController controller(params);
+
+    for (int i = 0; i < 3; ++i) {
+        controller.update(0, 0.02);
+    }
+    EXPECT_EQ(controller.level(), 1);
+
+    // the encode time is within budget, but not enough to step up
+    for (int i = 0; i < 20; ++i) {
+        controller.update(0, 0.009);
+    }
+    EXPECT_EQ(controller.level(), 1);
+
+    // the encode time is much less than budget, step up after the moving average of encode time is decreased
+    for (int i = 0; i < 20; ++i) {
+        controller.update(0, 0.002);
+    }
+    EXPECT_EQ(controller.level(), 0);
+}
+
+// only the quality is adjusted in grayscale mode, and the levels with the same quality are collapsed, so each step
+// changes the quality
+TEST(AdaptiveEncodeController, Gray) {
+    AdaptiveEncodeParams params;
+    params.downFrameNum = 1;
+    params.gray = true;
+    AdaptiveEncodeController controller(params);
+    const auto& levels = controller.params().levels;
+    ASSERT_EQ(levels.size(), 4);
+    int lastQuality{101};
+    for (size_t i = 0; i < levels.size(); ++i) {
+        YuyvEncodeParams encodeParams;
+        EncodeInfo info = controller.apply(encodeParams);
+        EXPECT_EQ(info.level, static_cast<int>(i));
+        EXPECT_EQ(info.subsampling, JpegSubsampling::Gray);
+        EXPECT_EQ(encodeParams.subsampling, JpegSubsampling::Gray);
+        EXPECT_EQ(encodeParams.quality, levels[i].quality);
+        EXPECT_LT(info.quality, lastQuality);
+        lastQuality = info.quality;
+        controller.update(20, 0.01);
+    }
+    EXPECT_EQ(controller.level(), 3);
+}
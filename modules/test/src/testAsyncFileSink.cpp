@@ -0,0 +1,135 @@
+/**
+ * @brief Test code for asynchronous file sink
+ *
+ */
+
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+#include <boost/filesystem.hpp>
+#include <atomic>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <vector>
+#include "libra/io/AsyncFileSink.h"
+#include "libra/io/ImageContainer.h"
+#include "libra/util/BufferPool.h"
+
+using namespace std;
+using namespace libra::core;
+using namespace libra::io;
+using namespace libra::util;
+namespace fs = boost::filesystem;
+
+/**
+ * @brief Test fixture for async file sink, run with io_uring(if it's supported) and thread pool backend, and the
+ * temporary folder is removed after test
+ */
+class AsyncFileSinkTest : public testing::TestWithParam<bool> {
+  protected:
+    void SetUp() override {
+        folder_ = fs::temp_directory_path() / fs::unique_path("libra-sink-%%%%-%%%%");
+        fs::create_directories(folder_);
+    }
+
+    void TearDown() override { fs::remove_all(folder_); }
+
+    // read file content
+    static vector<unsigned char> readFile(const fs::path& file) {
+        fstream fs(file.string(), ios::in | ios::binary);
+        return vector<unsigned char>((istreambuf_iterator<char>(fs)), istreambuf_iterator<char>());
+    }
+
+  protected:
+    fs::path folder_;  // temporary folder
+};
+
+// write image files, and the pooled buffers are recycled after written
+TEST_P(AsyncFileSinkTest, WriteFile) {
+    AsyncSinkParams params;
+    params.useIoUring = GetParam();
+    params.queueDepth = 4;
+    AsyncFileSink sink(params);
+    if (!GetParam()) {
+        EXPECT_EQ(sink.backend(), AsyncSinkBackend::ThreadPool);
+    }
+
+    const size_t kImageNum = 50;
+    BufferPool pool(1000, kImageNum);
+    atomic<size_t> successNum{0};
+    for (size_t i = 0; i < kImageNum; ++i) {
+        shared_ptr<unsigned char> buffer = pool.lease();
+        fill(buffer.get(), buffer.get() + 1000, static_cast<unsigned char>(i));
+        RawImageReading reading(move(buffer), 100 + i);
+        sink.writeFile((folder_ / fmt::format("{}.jpg", i)).string(), reading, [&](bool success) {
+            if (success) {
+                ++successNum;
+            }
+        });
+    }
+    sink.wait();
+    EXPECT_EQ(sink.inflightNum(), 0);
+    EXPECT_EQ(sink.completedNum(), kImageNum);
+    EXPECT_EQ(sink.errorNum(), 0);
+    EXPECT_EQ(successNum, kImageNum);
+    EXPECT_EQ(pool.freeNum(), pool.allocatedNum());
+    EXPECT_LE(pool.allocatedNum(), params.queueDepth + 1);
+    for (size_t i = 0; i < kImageNum; ++i) {
+        EXPECT_EQ(readFile(folder_ / fmt::format("{}.jpg", i)), vector<unsigned char>(100 + i, i));
+    }
+
+    // the buffer not owned by reading is copied
+    vector<unsigned char> data(10, 0xAB);
+    sink.writeFile((folder_ / "copy.jpg").string(), RawImageReading(data.data(), data.size()));
+    data.assign(data.size(), 0);
+    sink.wait();
+    EXPECT_EQ(readFile(folder_ / "copy.jpg"), vector<unsigned char>(10, 0xAB));
+}
+
+// write the image container through sink with O_DIRECT, which is read back by reader
+TEST_P(AsyncFileSinkTest, Container) {
+    AsyncSinkParams sinkParams;
+    sinkParams.useIoUring = GetParam();
+    sinkParams.queueDepth = 8;
+    auto sink = make_shared<AsyncFileSink>(sinkParams);
+
+    ContainerParams params;
+    params.segmentSize = 64 * 1024;
+    params.blockSize = 8192;
+    params.directIo = true;
+    ImageContainerWriter writer(params);
+    writer.setSink(sink);
+    ASSERT_TRUE(writer.open((folder_ / "left").string()));
+    const size_t kImageNum = 100;
+    vector<vector<unsigned char>> images;
+    uintmax_t expectSize{0};
+    for (size_t i = 0; i < kImageNum; ++i) {
+        images.emplace_back(1000 + (i * 997) % 5000, static_cast<unsigned char>(i));
+        ASSERT_TRUE(writer.append(1.0 + i * 0.05, images.back().data(), images.back().size()));
+        expectSize += 16 + images.back().size();
+    }
+    writer.close();
+    EXPECT_EQ(sink->inflightNum(), 0);
+    EXPECT_EQ(sink->errorNum(), 0);
+    EXPECT_GT(writer.segmentNum(), 1);
+
+    // the padding of last block is truncated
+    uintmax_t totalSize{0};
+    for (size_t i = 0; i < writer.segmentNum(); ++i) {
+        totalSize += fs::file_size(folder_ / "left" / fmt::format("segment-{:06d}.dat", i));
+    }
+    EXPECT_EQ(totalSize, expectSize);
+
+    ImageContainerReader reader;
+    ASSERT_TRUE(reader.open((folder_ / "left").string()));
+    ASSERT_EQ(reader.entries().size(), kImageNum);
+    vector<unsigned char> data;
+    for (size_t i = 0; i < kImageNum; ++i) {
+        ASSERT_TRUE(reader.read(reader.entries()[i], data));
+        EXPECT_EQ(data, images[i]);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Backend, AsyncFileSinkTest, testing::Bool(), [](const testing::TestParamInfo<bool>& info) {
+    return info.param ? "IoUring" : "ThreadPool";
+});
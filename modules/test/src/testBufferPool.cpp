@@ -0,0 +1,84 @@
+/**
+ * @brief Test code for buffer pool
+ *
+ */
+
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include "libra/util/BufferPool.h"
+
+using namespace std;
+using namespace libra::util;
+
+// the returned buffer should be reused
+TEST(BufferPool, Reuse) {
+    BufferPool pool(1024, 2);
+    unsigned char* p{nullptr};
+    {
+        auto buffer = pool.lease();
+        p = buffer.get();
+        EXPECT_EQ(pool.allocatedNum(), 1);
+        EXPECT_EQ(pool.freeNum(), 0);
+    }
+    EXPECT_EQ(pool.freeNum(), 1);
+    auto buffer = pool.lease();
+    EXPECT_EQ(buffer.get(), p);
+    EXPECT_EQ(pool.allocatedNum(), 1);
+
+    // the extra buffers more than maximum free number will be released
+    {
+        vector<shared_ptr<unsigned char>> buffers;
+        for (int i = 0; i < 4; ++i) {
+            buffers.emplace_back(pool.lease());
+        }
+    }
+    EXPECT_EQ(pool.allocatedNum(), 5);
+    EXPECT_EQ(pool.freeNum(), 2);
+}
+
+// enlarge the buffer size, the old buffers shouldn't be returned to pool
+TEST(BufferPool, Enlarge) {
+    BufferPool pool(16);
+    auto small = pool.lease();
+    auto large = pool.lease(1024);
+    EXPECT_EQ(pool.bufferSize(), 1024);
+    small.reset();
+    EXPECT_EQ(pool.freeNum(), 0);
+    large.reset();
+    EXPECT_EQ(pool.freeNum(), 1);
+
+    // smaller size won't shrink the pool
+    auto buffer = pool.lease(32);
+    EXPECT_EQ(pool.bufferSize(), 1024);
+    EXPECT_EQ(pool.freeNum(), 0);
+
+    // set smaller size also releases the free buffers
+    buffer.reset();
+    EXPECT_EQ(pool.freeNum(), 1);
+    pool.setBufferSize(512);
+    EXPECT_EQ(pool.freeNum(), 0);
+}
+
+// lease and return buffers in multiple threads, and the buffer could outlive the pool
+TEST(BufferPool, MultiThread) {
+    shared_ptr<unsigned char> kept;
+    {
+        BufferPool pool(256, 4);
+        vector<thread> threads;
+        for (int n = 0; n < 4; ++n) {
+            threads.emplace_back([&pool, n]() {
+                for (int i = 0; i < 1000; ++i) {
+                    auto buffer = pool.lease();
+                    buffer.get()[i % 256] = static_cast<unsigned char>(n);
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        EXPECT_LE(pool.allocatedNum(), 4);
+        kept = pool.lease();
+    }
+    kept.get()[0] = 0;
+}
@@ -0,0 +1,191 @@
+/**
+ * @brief Test code for image container
+ *
+ */
+
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <vector>
+#include "libra/io/ImageContainer.h"
+
+using namespace std;
+using namespace libra::io;
+namespace fs = boost::filesystem;
+
+/**
+ * @brief Test fixture for image container, which writes the images into container in temporary folder from several
+ * threads, and the folder is removed after test
+ */
+class ImageContainerTest : public testing::Test {
+  protected:
+    void SetUp() override {
+        folder_ = fs::temp_directory_path() / fs::unique_path("libra-container-%%%%-%%%%");
+        // the image content is filled by its index, and the size varies
+        for (size_t i = 0; i < kImageNum; ++i) {
+            images_.emplace_back(100 + (i * 37) % 500, static_cast<unsigned char>(i));
+        }
+
+        ContainerParams params;
+        params.segmentSize = 4096;
+        ImageContainerWriter writer(params);
+        ASSERT_TRUE(writer.open((folder_ / "left").string()));
+        vector<thread> threads;
+        for (size_t n = 0; n < kThreadNum; ++n) {
+            threads.emplace_back([&, n]() {
+                for (size_t i = n; i < kImageNum; i += kThreadNum) {
+                    EXPECT_TRUE(writer.append(timestamp(i), images_[i].data(), images_[i].size()));
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        EXPECT_EQ(writer.recordNum(), kImageNum);
+        segmentNum_ = writer.segmentNum();
+        writer.close();
+        EXPECT_FALSE(writer.isOpen());
+    }
+
+    void TearDown() override { fs::remove_all(folder_); }
+
+    // timestamp of image, s
+    static double timestamp(size_t i) { return 1.0 + i * 0.05; }
+
+    // check the container is read back
+    void check(const ImageContainerReader& reader) {
+        ASSERT_EQ(reader.entries().size(), kImageNum);
+        vector<unsigned char> data;
+        for (size_t i = 0; i < kImageNum; ++i) {
+            const ContainerEntry& e = reader.entries()[i];
+            EXPECT_EQ(e.timestamp, static_cast<int64_t>(llround(timestamp(i) * 1.0E9)));
+            ASSERT_TRUE(reader.read(e, data));
+            EXPECT_EQ(data, images_[i]);
+        }
+    }
+
+  protected:
+    static constexpr size_t kImageNum = 200;  // image number
+    static constexpr size_t kThreadNum = 3;   // writer thread number
+    fs::path folder_;                         // temporary folder
+    vector<vector<unsigned char>> images_;    // images
+    size_t segmentNum_{0};                    // segment number
+};
+
+// the images are split into segments, and read back in the order of timestamp
+TEST_F(ImageContainerTest, ReadBack) {
+    EXPECT_GT(segmentNum_, 1);
+    // the segments are truncated to the used size
+    uintmax_t totalSize{0};
+    for (size_t i = 0; i < segmentNum_; ++i) {
+        uintmax_t size = fs::file_size(folder_ / "left" / fmt::format("segment-{:06d}.dat", i));
+        EXPECT_LE(size, 4096);
+        totalSize += size;
+    }
+    uintmax_t expectSize{0};
+    for (auto& image : images_) {
+        expectSize += 16 + image.size();
+    }
+    EXPECT_EQ(totalSize, expectSize);
+
+    ImageContainerReader reader;
+    ASSERT_TRUE(reader.open((folder_ / "left").string()));
+    check(reader);
+
+    // find by timestamp
+    const ContainerEntry* entry = reader.find(timestamp(10) - 0.01);
+    ASSERT_NE(entry, nullptr);
+    EXPECT_EQ(entry, &reader.entries()[10]);
+    EXPECT_EQ(reader.find(timestamp(kImageNum)), nullptr);
+}
+
+// the index is rebuilt from segments if it's lost
+TEST_F(ImageContainerTest, RebuildIndex) {
+    fs::remove(folder_ / "left" / "index.bin");
+    ImageContainerReader reader;
+    ASSERT_TRUE(reader.open((folder_ / "left").string()));
+    check(reader);
+}
+
+// export to kalibr format
+TEST_F(ImageContainerTest, ExportKalibr) {
+    ImageContainerReader reader;
+    ASSERT_TRUE(reader.open((folder_ / "left").string()));
+    fs::path exportPath = folder_ / "export" / "left";
+    EXPECT_EQ(reader.exportKalibr(exportPath.string()), kImageNum);
+    for (size_t i = 0; i < kImageNum; i += 17) {
+        fstream fs((exportPath / fmt::format("{:.0f}.jpg", timestamp(i) * 1.0E9)).string(), ios::in | ios::binary);
+        ASSERT_TRUE(fs.is_open());
+        vector<unsigned char> data((istreambuf_iterator<char>(fs)), istreambuf_iterator<char>());
+        EXPECT_EQ(data, images_[i]);
+    }
+}
+
+// the failed record is rolled back, so the segment could be scanned to rebuild index
+TEST(ImageContainer, WriteFailure) {
+    fs::path folder = fs::temp_directory_path() / fs::unique_path("libra-container-%%%%-%%%%");
+    vector<unsigned char> image(300, 1);
+    ImageContainerWriter writer{ContainerParams()};
+    ASSERT_TRUE(writer.open(folder.string()));
+    ASSERT_TRUE(writer.append(1.0, image.data(), image.size()));
+    // the header is written, while the data write fails with bad address
+    EXPECT_FALSE(writer.append(1.1, nullptr, image.size()));
+    ASSERT_TRUE(writer.append(1.2, image.data(), image.size()));
+    EXPECT_EQ(writer.recordNum(), 2);
+    writer.close();
+    EXPECT_EQ(fs::file_size(folder / "segment-000000.dat"), 2 * (16 + image.size()));
+
+    fs::remove(folder / "index.bin");
+    ImageContainerReader reader;
+    ASSERT_TRUE(reader.open(folder.string()));
+    ASSERT_EQ(reader.entries().size(), 2);
+    EXPECT_EQ(reader.entries()[1].timestamp, 1'200'000'000);
+    vector<unsigned char> data;
+    ASSERT_TRUE(reader.read(reader.entries()[1], data));
+    EXPECT_EQ(data, image);
+    fs::remove_all(folder);
+}
+
+// rolling record, the segments are bounded by time span, and the oldest ones are deleted to fit into budget
+TEST(ImageContainer, Rolling) {
+    fs::path folder = fs::temp_directory_path() / fs::unique_path("libra-container-%%%%-%%%%");
+    ContainerParams params;
+    params.segmentSize = 8192;
+    params.segmentDuration = 1.0;
+    // 10 images in each segment, and 3 closed segments are kept with the preallocated current one
+    const size_t kImageNum = 200;
+    vector<unsigned char> image(300);
+    params.rollingBudget = 3 * 10 * (16 + image.size()) + params.segmentSize;
+    ImageContainerWriter writer(params);
+    ASSERT_TRUE(writer.open(folder.string()));
+    for (size_t i = 0; i < kImageNum; ++i) {
+        fill(image.begin(), image.end(), static_cast<unsigned char>(i));
+        ASSERT_TRUE(writer.append(i * 0.1, image.data(), image.size()));
+        EXPECT_LE(writer.diskSize(), params.rollingBudget);
+    }
+    EXPECT_EQ(writer.segmentNum(), kImageNum / 10);
+    EXPECT_EQ(writer.deletedSegmentNum(), writer.segmentNum() - 4);
+    writer.close();
+    EXPECT_FALSE(fs::exists(folder / "segment-000000.dat"));
+
+    // the entries of deleted segments are skipped
+    ImageContainerReader reader;
+    ASSERT_TRUE(reader.open(folder.string()));
+    ASSERT_EQ(reader.entries().size(), 40);
+    vector<unsigned char> data;
+    for (size_t i = 0; i < reader.entries().size(); ++i) {
+        const ContainerEntry& e = reader.entries()[i];
+        EXPECT_EQ(e.timestamp, static_cast<int64_t>(llround((kImageNum - 40 + i) * 0.1 * 1.0E9)));
+        ASSERT_TRUE(reader.read(e, data));
+        EXPECT_EQ(data, vector<unsigned char>(image.size(), static_cast<unsigned char>(kImageNum - 40 + i)));
+    }
+
+    // the index is also rebuilt without the deleted segments
+    fs::remove(folder / "index.bin");
+    ASSERT_TRUE(reader.open(folder.string()));
+    EXPECT_EQ(reader.entries().size(), 40);
+    fs::remove_all(folder);
+}
@@ -0,0 +1,105 @@
+/**
+ * @brief Test code for buffered IMU writer
+ *
+ */
+
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "libra/io/ImuCsvWriter.h"
+
+using namespace std;
+using namespace Eigen;
+using namespace libra::core;
+using namespace libra::io;
+namespace fs = boost::filesystem;
+
+/**
+ * @brief Test fixture for IMU writer, which provides the IMU records and temporary folder removed after test
+ */
+class ImuCsvWriterTest : public testing::Test {
+  protected:
+    void SetUp() override {
+        folder_ = fs::temp_directory_path() / fs::unique_path("libra-imu-%%%%-%%%%");
+        fs::create_directories(folder_);
+        for (size_t i = 0; i < kImuNum; ++i) {
+            ImuRecord imu(1.0 + i * 5.0E-3, ImuReading(Vector3d(0.1 * i, -9.8, 0.3), Vector3d(0.01, 0.02 * i, -0.03)));
+            imu.setSystemTimestamp(2.0 + i * 5.0E-3);
+            imus_.emplace_back(move(imu));
+        }
+    }
+
+    void TearDown() override { fs::remove_all(folder_); }
+
+  protected:
+    static constexpr size_t kImuNum = 1000;  // IMU number
+    fs::path folder_;                        // temporary folder
+    vector<ImuRecord> imus_;                 // IMU records
+};
+
+// the CSV file is the same with the one formatted line by line, and flushed in blocks
+TEST_F(ImuCsvWriterTest, Csv) {
+    string file = (folder_ / "imu.csv").string();
+    ImuWriterParams params;
+    params.flushSize = 4096;
+    ImuCsvWriter writer(params);
+    ASSERT_TRUE(writer.open(file));
+    for (auto& imu : imus_) {
+        writer.write(imu);
+    }
+    writer.close();
+    EXPECT_FALSE(writer.isOpen());
+    EXPECT_EQ(writer.writtenNum(), kImuNum);
+    EXPECT_GT(writer.flushNum(), 1);
+    EXPECT_LT(writer.flushNum(), kImuNum / 10);
+
+    // expected content
+    stringstream expected;
+    expected << "#SensorTimestamp[ns],SystemTimestamp[ns],GyroX[rad/s],GyroY[rad/s],GyroZ[rad/s]"
+                ",AccX[m/s^2],AccY[m/s^2],AccZ[m/s^2]"
+             << endl;
+    for (auto& imu : imus_) {
+        expected << fmt::format("{:.0f},{:.0f},{:.10f},{:.10f},{:.10f},{:.10f},{:.10f},{:.10f}",
+                                imu.timestamp() * 1.0E9, imu.systemTimestamp().value_or(0) * 1.0E9,
+                                imu.reading().gyro()[0], imu.reading().gyro()[1], imu.reading().gyro()[2],
+                                imu.reading().acc()[0], imu.reading().acc()[1], imu.reading().acc()[2])
+                 << endl;
+    }
+    stringstream content;
+    content << fstream(file, ios::in).rdbuf();
+    EXPECT_EQ(content.str(), expected.str());
+}
+
+// the binary file could be read back
+TEST_F(ImuCsvWriterTest, Binary) {
+    string file = (folder_ / "imu.bin").string();
+    ImuWriterParams params;
+    params.format = ImuFileFormat::Binary;
+    {
+        ImuCsvWriter writer(params);
+        ASSERT_TRUE(writer.open(file));
+        for (auto& imu : imus_) {
+            writer.write(imu);
+        }
+    }
+    EXPECT_EQ(fs::file_size(file), 16 + kImuNum * ImuCsvWriter::kBinaryRecordSize);
+
+    vector<ImuRecord> imus;
+    ASSERT_TRUE(ImuCsvWriter::readBinary(file, imus));
+    ASSERT_EQ(imus.size(), kImuNum);
+    for (size_t i = 0; i < kImuNum; ++i) {
+        EXPECT_NEAR(imus[i].timestamp(), imus_[i].timestamp(), 1.0E-9);
+        EXPECT_NEAR(imus[i].systemTimestamp().value_or(0), imus_[i].systemTimestamp().value_or(0), 1.0E-9);
+        EXPECT_EQ(imus[i].reading().acc(), imus_[i].reading().acc());
+        EXPECT_EQ(imus[i].reading().gyro(), imus_[i].reading().gyro());
+    }
+
+    // CSV file isn't valid binary file
+    string csvFile = (folder_ / "imu.csv").string();
+    fstream(csvFile, ios::out) << "#SensorTimestamp[ns],SystemTimestamp[ns]" << endl;
+    EXPECT_FALSE(ImuCsvWriter::readBinary(csvFile, imus));
+}
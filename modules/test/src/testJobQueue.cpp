@@ -0,0 +1,130 @@
+/**
+ * @brief Test code for job queue
+ *
+ */
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "libra/util/JobQueue.hpp"
+#include "libra/util/MpmcQueue.hpp"
+#include "libra/util/SpscQueue.hpp"
+
+using namespace std;
+using namespace libra::util;
+
+template <typename Queue>
+class JobQueueTest : public testing::Test {};
+
+using QueueTypes = testing::Types<JobQueue<unique_ptr<int>>, SpscQueue<unique_ptr<int>>, MpmcQueue<unique_ptr<int>>>;
+TYPED_TEST_SUITE(JobQueueTest, QueueTypes);
+
+// push and pop in batch, the order should be kept
+TYPED_TEST(JobQueueTest, Batch) {
+    constexpr int kNum = 10000, kBatchSize = 7;
+    TypeParam queue(16);
+
+    thread producer([&]() {
+        vector<unique_ptr<int>> batch;
+        for (int i = 0; i < kNum;) {
+            batch.clear();
+            for (int j = 0; j < kBatchSize && i < kNum; ++j, ++i) {
+                batch.emplace_back(make_unique<int>(i));
+            }
+            EXPECT_EQ(queue.pushBatch(make_move_iterator(batch.begin()), make_move_iterator(batch.end())),
+                      batch.size());
+        }
+        queue.wait();
+        queue.stop();
+    });
+
+    int expected{0};
+    vector<unique_ptr<int>> jobs;
+    while (queue.popBatch(jobs, 5)) {
+        EXPECT_LE(jobs.size(), 5);
+        for (auto& v : jobs) {
+            ASSERT_EQ(*v, expected);
+            ++expected;
+        }
+    }
+    producer.join();
+    EXPECT_EQ(expected, kNum);
+}
+
+// pop batch should return empty jobs if timeout, and return false if stopped
+TYPED_TEST(JobQueueTest, BatchTimeout) {
+    TypeParam queue(16);
+    vector<unique_ptr<int>> jobs;
+    EXPECT_TRUE(queue.popBatch(jobs, 5, chrono::milliseconds(5)));
+    EXPECT_TRUE(jobs.empty());
+
+    queue.push(make_unique<int>(1));
+    EXPECT_TRUE(queue.popBatch(jobs, 5, chrono::milliseconds(5)));
+    ASSERT_EQ(jobs.size(), 1);
+    EXPECT_EQ(*jobs[0], 1);
+
+    queue.stop();
+    EXPECT_FALSE(queue.popBatch(jobs, 5, chrono::milliseconds(5)));
+}
+
+// drop the new job when queue is full, and count the pushed, popped and dropped jobs
+TYPED_TEST(JobQueueTest, DropNewest) {
+    TypeParam queue(4);
+    queue.setOverflowPolicy(OverflowPolicy::DropNewest);
+    for (int i = 0; i < 6; ++i) {
+        EXPECT_EQ(queue.push(make_unique<int>(i)), i < 4);
+    }
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(*queue.pop().data(), i);
+    }
+
+    auto stats = queue.stats();
+    EXPECT_EQ(stats.pushNum, 4);
+    EXPECT_EQ(stats.popNum, 4);
+    EXPECT_EQ(stats.dropNum, 2);
+    EXPECT_EQ(stats.highWaterMark, 4);
+}
+
+template <typename Queue>
+class OverflowPolicyTest : public testing::Test {};
+
+using DropOldQueueTypes = testing::Types<JobQueue<int>, MpmcQueue<int>>;
+TYPED_TEST_SUITE(OverflowPolicyTest, DropOldQueueTypes);
+
+// drop the oldest job when queue is full
+TYPED_TEST(OverflowPolicyTest, DropOldest) {
+    TypeParam queue(4);
+    queue.setOverflowPolicy(OverflowPolicy::DropOldest);
+    for (int i = 0; i < 6; ++i) {
+        EXPECT_TRUE(queue.push(i));
+    }
+    for (int i = 2; i < 6; ++i) {
+        EXPECT_EQ(queue.pop().data(), i);
+    }
+    EXPECT_EQ(queue.stats().pushNum, 6);
+    EXPECT_EQ(queue.stats().dropNum, 2);
+}
+
+// keep one of every 3 new jobs when queue is full, and restart counting after the queue isn't full
+TYPED_TEST(OverflowPolicyTest, KeepEveryNth) {
+    TypeParam queue(4);
+    queue.setOverflowPolicy(OverflowPolicy::KeepEveryNth, 3);
+    vector<int> kept;
+    for (int i = 0; i < 11; ++i) {
+        if (queue.push(i)) {
+            kept.emplace_back(i);
+        }
+    }
+    // 0~3 fill the queue, then keep 4, 7 and 10
+    EXPECT_EQ(kept, vector<int>({0, 1, 2, 3, 4, 7, 10}));
+    for (int i : {3, 4, 7, 10}) {
+        EXPECT_EQ(queue.pop().data(), i);
+    }
+    EXPECT_EQ(queue.stats().dropNum, 7);
+
+    // the queue isn't full, keep all new jobs
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_TRUE(queue.push(i));
+    }
+}
@@ -0,0 +1,112 @@
+/**
+ * @brief Test code for latency histogram and frame tracer
+ *
+ */
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "libra/io/FrameTracer.h"
+#include "libra/util/LatencyHistogram.h"
+
+using namespace std;
+using namespace libra::util;
+using namespace libra::core;
+using namespace libra::io;
+
+// the buckets should be continuous, and each value should be in the range of its bucket
+TEST(LatencyHistogram, Bucket) {
+    int64_t lastUpper{0};
+    for (int i = 0; i < LatencyHistogram::kBucketNum; ++i) {
+        int64_t lower{0}, upper{0};
+        LatencyHistogram::bucketRange(i, &lower, &upper);
+        EXPECT_EQ(lower, lastUpper) << "index = " << i;
+        EXPECT_GT(upper, lower) << "index = " << i;
+        EXPECT_EQ(LatencyHistogram::bucketIndex(lower), i);
+        EXPECT_EQ(LatencyHistogram::bucketIndex(upper - 1), i);
+        lastUpper = upper;
+    }
+    // the too large value is put in the last bucket
+    EXPECT_EQ(LatencyHistogram::bucketIndex(INT64_MAX), LatencyHistogram::kBucketNum - 1);
+}
+
+// the percentile should be within the relative error of sub-bucket
+TEST(LatencyHistogram, Percentile) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.count(), 0);
+    EXPECT_EQ(histogram.percentile(0.5), 0);
+
+    // 1 us ~ 10 ms
+    for (int64_t v = 1; v <= 10000; ++v) {
+        histogram.record(v * 1000);
+    }
+    LatencyStats stats = histogram.stats();
+    EXPECT_EQ(stats.count, 10000);
+    EXPECT_EQ(stats.min, 1000);
+    EXPECT_EQ(stats.max, 1.0E7);
+    EXPECT_NEAR(stats.mean, 5000.5 * 1000, 1.0);
+    EXPECT_NEAR(stats.p50, 5.0E6, 5.0E6 / 32);
+    EXPECT_NEAR(stats.p90, 9.0E6, 9.0E6 / 32);
+    EXPECT_NEAR(stats.p99, 9.9E6, 9.9E6 / 32);
+    EXPECT_NEAR(stats.p999, 9.99E6, 9.99E6 / 32);
+    EXPECT_LE(stats.p999, stats.max);
+
+    histogram.reset();
+    EXPECT_EQ(histogram.count(), 0);
+    EXPECT_EQ(histogram.stats().max, 0);
+}
+
+// record in several threads without lock
+TEST(LatencyHistogram, MultiThread) {
+    LatencyHistogram histogram;
+    constexpr int kThreadNum = 4;
+    constexpr int kNum = 10000;
+    vector<thread> threads;
+    for (int n = 0; n < kThreadNum; ++n) {
+        threads.emplace_back([&, n]() {
+            for (int i = 0; i < kNum; ++i) {
+                histogram.record(n * kNum + i);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    LatencyStats stats = histogram.stats();
+    EXPECT_EQ(stats.count, kThreadNum * kNum);
+    EXPECT_EQ(stats.min, 0);
+    EXPECT_EQ(stats.max, kThreadNum * kNum - 1);
+}
+
+// the stage is skipped if its timestamp isn't traced
+TEST(FrameTracer, Add) {
+    FrameTracer tracer;
+    FrameTrace trace;
+    trace.capture = 1000;
+    trace.enqueue = 2000;
+    trace.dequeue = 5000;
+    trace.convert = 6000;
+    trace.encode = 10000;
+    trace.sink = 12000;
+    tracer.add(trace);
+    EXPECT_EQ(tracer.histogram(PipelineStage::Enqueue).stats().max, 1000);
+    EXPECT_EQ(tracer.histogram(PipelineStage::Queue).stats().max, 3000);
+    EXPECT_EQ(tracer.histogram(PipelineStage::Convert).stats().max, 1000);
+    EXPECT_EQ(tracer.histogram(PipelineStage::Encode).stats().max, 4000);
+    EXPECT_EQ(tracer.histogram(PipelineStage::Sink).stats().max, 2000);
+    EXPECT_EQ(tracer.histogram(PipelineStage::Total).stats().max, 11000);
+
+    // the frame isn't encoded, the sink starts at dequeue
+    trace.convert = 0;
+    trace.encode = 0;
+    tracer.add(trace);
+    EXPECT_EQ(tracer.histogram(PipelineStage::Convert).count(), 1);
+    EXPECT_EQ(tracer.histogram(PipelineStage::Encode).count(), 1);
+    EXPECT_EQ(tracer.histogram(PipelineStage::Sink).count(), 2);
+    EXPECT_EQ(tracer.histogram(PipelineStage::Sink).stats().max, 7000);
+    EXPECT_EQ(tracer.histogram(PipelineStage::Total).count(), 2);
+
+    tracer.reset();
+    EXPECT_EQ(tracer.histogram(PipelineStage::Total).count(), 0);
+}
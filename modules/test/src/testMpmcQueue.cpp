@@ -0,0 +1,97 @@
+/**
+ * @brief Test code for MPMC queue
+ *
+ */
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "libra/util/MpmcQueue.hpp"
+
+using namespace std;
+using namespace libra::util;
+
+// all the jobs pushed by several producers should be popped exactly once by several consumers
+TEST(MpmcQueue, MultiThread) {
+    constexpr size_t kProducerNum = 4, kConsumerNum = 4, kNum = 50000;
+    MpmcQueue<unique_ptr<size_t>> queue(64);
+    vector<atomic<int>> popped(kProducerNum * kNum);
+    for (auto& v : popped) {
+        v = 0;
+    }
+
+    vector<thread> consumers;
+    for (size_t n = 0; n < kConsumerNum; ++n) {
+        consumers.emplace_back([&]() {
+            while (true) {
+                auto job = queue.pop();
+                if (!job.isValid()) {
+                    break;
+                }
+                ++popped[*job.data()];
+            }
+        });
+    }
+    vector<thread> producers;
+    for (size_t n = 0; n < kProducerNum; ++n) {
+        producers.emplace_back([&, n]() {
+            for (size_t i = 0; i < kNum; ++i) {
+                EXPECT_TRUE(queue.push(make_unique<size_t>(n * kNum + i)));
+            }
+        });
+    }
+
+    for (auto& t : producers) {
+        t.join();
+    }
+    queue.wait();
+    queue.stop();
+    for (auto& t : consumers) {
+        t.join();
+    }
+    for (size_t i = 0; i < popped.size(); ++i) {
+        ASSERT_EQ(popped[i], 1) << "job " << i;
+    }
+}
+
+// the oldest job should be dropped if queue is full
+TEST(MpmcQueue, DropJob) {
+    MpmcQueue<unique_ptr<int>> queue(4);
+    queue.enableDropJob(true);
+    for (int i = 0; i < 6; ++i) {
+        EXPECT_TRUE(queue.push(make_unique<int>(i)));
+    }
+    EXPECT_EQ(queue.size(), 4);
+    EXPECT_EQ(queue.stats().dropNum, 2);
+    for (int i = 2; i < 6; ++i) {
+        EXPECT_EQ(*queue.pop().data(), i);
+    }
+
+    // try push and pop
+    unique_ptr<int> data = make_unique<int>(10);
+    EXPECT_TRUE(queue.tryPush(move(data)));
+    EXPECT_TRUE(queue.tryPop(data));
+    EXPECT_EQ(*data, 10);
+    EXPECT_FALSE(queue.tryPop(data));
+
+    queue.push(make_unique<int>(0));
+    queue.clear();
+    EXPECT_EQ(queue.size(), 0);
+}
+
+// stop the queue should wake up the waiting consumers
+TEST(MpmcQueue, Stop) {
+    MpmcQueue<int> queue;
+    vector<thread> consumers;
+    for (int n = 0; n < 2; ++n) {
+        consumers.emplace_back([&]() { EXPECT_FALSE(queue.pop().isValid()); });
+    }
+    this_thread::sleep_for(chrono::milliseconds(10));
+    queue.stop();
+    for (auto& t : consumers) {
+        t.join();
+    }
+    EXPECT_FALSE(queue.push(1));
+}
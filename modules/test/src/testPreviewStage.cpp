@@ -0,0 +1,117 @@
+/**
+ * @brief Test code for preview stage
+ *
+ */
+
+#include <gtest/gtest.h>
+#include <turbojpeg.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "libra/io/PreviewStage.h"
+#include "libra/io/YuyvJpegEncoder.h"
+
+using namespace std;
+using namespace libra::core;
+using namespace libra::io;
+
+/**
+ * @brief Test fixture for preview stage, which encodes a YUYV image with horizontal gradient of Y channel, and collects
+ * the subscribed previews
+ */
+class PreviewStageTest : public testing::Test {
+  protected:
+    void SetUp() override {
+        vector<unsigned char> yuyv(kWidth * kHeight * 2);
+        for (int r = 0; r < kHeight; ++r) {
+            for (int c = 0; c < kWidth; ++c) {
+                yuyv[(r * kWidth + c) * 2] = static_cast<unsigned char>(c * 255 / (kWidth - 1));
+                yuyv[(r * kWidth + c) * 2 + 1] = 128;
+            }
+        }
+        YuyvJpegEncoder encoder;
+        unsigned char* jpeg = nullptr;
+        unsigned long size{0};
+        ASSERT_TRUE(encoder.encode(yuyv.data(), kWidth, kHeight, 2 * kWidth, &jpeg, &size));
+        jpeg_.assign(jpeg, jpeg + size);
+        tjFree(jpeg);
+    }
+
+    // push the JPEG image with timestamp and camera index
+    void push(PreviewStage& preview, double timestamp, size_t camera = 0) {
+        preview.push(RawImageRecord(timestamp, RawImageReading(jpeg_.data(), jpeg_.size())), camera);
+    }
+
+    // subscribe the preview, and save the previews into vector
+    size_t subscribe(PreviewStage& preview) {
+        return preview.subscribe([&](const PreviewImage& image) {
+            lock_guard<mutex> lock(mutex_);
+            images_.emplace_back(image);
+            condition_.notify_all();
+        });
+    }
+
+    // wait the preview number reaches the expected one
+    bool wait(size_t num) {
+        unique_lock<mutex> lock(mutex_);
+        return condition_.wait_for(lock, chrono::seconds(5), [&]() { return images_.size() >= num; });
+    }
+
+  protected:
+    static constexpr int kWidth = 320;   // image width
+    static constexpr int kHeight = 240;  // image height
+    vector<unsigned char> jpeg_;         // JPEG image
+    mutex mutex_;                        // mutex for previews
+    condition_variable condition_;       // condition variable when preview is received
+    vector<PreviewImage> images_;        // received previews
+};
+
+// nothing is decoded without subscriber
+TEST_F(PreviewStageTest, NoSubscriber) {
+    PreviewStage preview;
+    EXPECT_FALSE(preview.isSubscribed());
+    for (int i = 0; i < 10; ++i) {
+        push(preview, i * 1.0);
+    }
+    this_thread::sleep_for(chrono::milliseconds(50));
+    EXPECT_EQ(preview.decodedNum(), 0);
+}
+
+// the downscaled previews are decoded by the interval of each camera
+TEST_F(PreviewStageTest, Decode) {
+    for (bool gray : {false, true}) {
+        images_.clear();
+        PreviewParams params;
+        params.scaleDenom = 4;
+        params.gray = gray;
+        params.interval = 0.5;
+        PreviewStage preview(params);
+        size_t id = subscribe(preview);
+        EXPECT_TRUE(preview.isSubscribed());
+        // only the images at 0 s and 0.5 s of each camera are held
+        for (int i = 0; i < 8; ++i) {
+            push(preview, i * 0.1, 0);
+            push(preview, i * 0.1, 1);
+            this_thread::sleep_for(chrono::milliseconds(20));
+        }
+        ASSERT_TRUE(wait(4));
+        preview.unsubscribe(id);
+        EXPECT_FALSE(preview.isSubscribed());
+        EXPECT_EQ(preview.decodedNum() + preview.replacedNum(), 4);
+
+        lock_guard<mutex> lock(mutex_);
+        for (const auto& image : images_) {
+            EXPECT_TRUE(image.timestamp == 0 || image.timestamp == 0.5);
+            EXPECT_LE(image.camera, 1);
+            EXPECT_EQ(image.width, kWidth / 4);
+            EXPECT_EQ(image.height, kHeight / 4);
+            EXPECT_EQ(image.channels, gray ? 1 : 3);
+            ASSERT_EQ(image.data.size(), kWidth / 4 * kHeight / 4 * image.channels);
+            // the gradient is kept
+            EXPECT_LT(image.data[image.channels * 2], 30);
+            EXPECT_GT(image.data[image.channels * (kWidth / 4 - 3)], 225);
+        }
+    }
+}
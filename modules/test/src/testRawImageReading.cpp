@@ -0,0 +1,59 @@
+/**
+ * @brief Test code for raw image reading
+ *
+ */
+
+#include <gtest/gtest.h>
+#include <vector>
+#include "libra/core/Record.hpp"
+
+using namespace std;
+using namespace libra::core;
+
+// the buffer isn't owned, and should be copied to keep it
+TEST(RawImageReading, NotOwned) {
+    vector<unsigned char> data{1, 2, 3, 4};
+    RawImageReading reading(data.data(), data.size());
+    EXPECT_FALSE(reading.isOwned());
+
+    RawImageReading owned = reading.owned();
+    EXPECT_TRUE(owned.isOwned());
+    EXPECT_NE(owned.buffer(), reading.buffer());
+    data.assign(data.size(), 0);
+    EXPECT_EQ(vector<unsigned char>(owned.buffer(), owned.buffer() + owned.size()),
+              (vector<unsigned char>{1, 2, 3, 4}));
+}
+
+// the releaser should be called once when the last copy is destroyed
+TEST(RawImageReading, Releaser) {
+    int releaseNum{0};
+    {
+        RawImageRecord record;
+        {
+            RawImageReading reading(new unsigned char[16], 16, [&releaseNum](unsigned char* p) {
+                ++releaseNum;
+                delete[] p;
+            });
+            EXPECT_TRUE(reading.isOwned());
+            EXPECT_EQ(reading.owned().buffer(), reading.buffer());
+            record.setReading(move(reading));
+        }
+        RawImageRecord copied = record;
+        EXPECT_EQ(copied.reading().buffer(), record.reading().buffer());
+        EXPECT_EQ(releaseNum, 0);
+    }
+    EXPECT_EQ(releaseNum, 1);
+}
+
+// keep the owner alive
+TEST(RawImageReading, Owner) {
+    auto owner = make_shared<vector<unsigned char>>(8, 1);
+    weak_ptr<vector<unsigned char>> weak = owner;
+    RawImageReading reading(owner, owner->data(), owner->size());
+    owner.reset();
+    EXPECT_FALSE(weak.expired());
+    EXPECT_TRUE(reading.isOwned());
+    EXPECT_EQ(reading.buffer()[7], 1);
+    reading = RawImageReading();
+    EXPECT_TRUE(weak.expired());
+}
@@ -0,0 +1,122 @@
+/**
+ * @brief Test code for replay recorder
+ *
+ */
+
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <fstream>
+#include <vector>
+#include "libra/io/ReplayRecorder.h"
+
+using namespace std;
+using namespace libra::core;
+using namespace libra::io;
+namespace fs = boost::filesystem;
+
+/**
+ * @brief Record folder in kalibr format for test, which is removed after test
+ */
+class ReplayRecorderTest : public testing::Test {
+  protected:
+    void SetUp() override {
+        folder_ = fs::temp_directory_path() / fs::unique_path("libra-replay-%%%%-%%%%");
+        fs::create_directories(folder_ / "left");
+        fs::create_directories(folder_ / "right");
+
+        // image at 20 Hz, the content is the image index
+        for (size_t i = 0; i < kImageNum; ++i) {
+            unsigned long long t = kStartTime + i * 50'000'000ULL;
+            for (const char* side : {"left", "right"}) {
+                fstream fs((folder_ / side / fmt::format("{}.jpg", t)).string(), ios::out | ios::binary);
+                fs << side << i;
+            }
+        }
+        // file not named by timestamp should be ignored
+        fstream((folder_ / "left" / "readme.txt").string(), ios::out) << "readme";
+        // file whose timestamp overflows should be ignored
+        fstream((folder_ / "left" / "99999999999999999999999.jpg").string(), ios::out) << "overflow";
+
+        // IMU at 100 Hz
+        fstream fs((folder_ / "imu.csv").string(), ios::out);
+        fs << "#SensorTimestamp[ns],SystemTimestamp[ns],GyroX[rad/s],GyroY[rad/s],GyroZ[rad/s],AccX[m/s^2],AccY[m/s^2]"
+              ",AccZ[m/s^2]"
+           << endl;
+        for (size_t i = 0; i < kImuNum; ++i) {
+            fs << fmt::format("{},0,0.1,0.2,0.3,1,2,{}", kStartTime + i * 10'000'000ULL, i) << endl;
+        }
+        // IMU which isn't a number or overflows should be ignored
+        fs << "invalid,0,0.1,0.2,0.3,1,2,0" << endl;
+        fs << "1e999,0,0.1,0.2,0.3,1,2,0" << endl;
+    }
+
+    void TearDown() override { fs::remove_all(folder_); }
+
+  protected:
+    static constexpr size_t kImageNum = 10;                          // image number of each camera
+    static constexpr size_t kImuNum = 46;                            // IMU number
+    static constexpr unsigned long long kStartTime = 1'000'000'000;  // start time, ns
+    fs::path folder_;                                                // record folder
+};
+
+// replay as fast as possible, all records are replayed in the order of timestamp
+TEST_F(ReplayRecorderTest, MaxSpeed) {
+    ReplayParams params;
+    params.folder = folder_.string();
+    params.speed = 0;
+    params.prefetchNum = 4;
+    ReplayRecorder recorder(params);
+
+    vector<pair<string, double>> records;  // name and timestamp of replayed records
+    recorder.setProcessFunction([&](const RawImageRecord& raw) {
+        records.emplace_back(string(raw.reading().buffer(), raw.reading().buffer() + raw.reading().size()),
+                             raw.timestamp());
+    });
+    recorder.setRightProcessFunction([&](const RawImageRecord& raw) {
+        records.emplace_back(string(raw.reading().buffer(), raw.reading().buffer() + raw.reading().size()),
+                             raw.timestamp());
+    });
+    recorder.setProcessFunction([&](const ImuRecord& imu) {
+        EXPECT_FALSE(imu.systemTimestamp());
+        EXPECT_DOUBLE_EQ(imu.reading().gyro()[2], 0.3);
+        EXPECT_DOUBLE_EQ(imu.reading().acc()[0], 1);
+        records.emplace_back(fmt::format("imu{:.0f}", imu.reading().acc()[2]), imu.timestamp());
+    });
+    recorder.init();
+    recorder.start();
+    recorder.wait();
+
+    EXPECT_EQ(recorder.imageNum(), 2 * kImageNum);
+    EXPECT_EQ(recorder.imuNum(), kImuNum);
+    ASSERT_EQ(records.size(), 2 * kImageNum + kImuNum);
+    for (size_t i = 1; i < records.size(); ++i) {
+        EXPECT_LE(records[i - 1].second, records[i].second);
+    }
+    // IMU first, then left and right image at the same time
+    EXPECT_EQ(records[0].first, "imu0");
+    EXPECT_EQ(records[1].first, "left0");
+    EXPECT_EQ(records[2].first, "right0");
+    EXPECT_DOUBLE_EQ(records[2].second, 1.0);
+    EXPECT_EQ(records[records.size() - 3].first, "imu45");
+    EXPECT_EQ(records.back().first, "right9");
+}
+
+// replay at N times speed, the used time is paced to the timestamps
+TEST_F(ReplayRecorderTest, Speed) {
+    ReplayParams params;
+    params.folder = folder_.string();
+    params.speed = 5;
+    ReplayRecorder recorder(params);
+    recorder.init();
+    auto t0 = chrono::steady_clock::now();
+    recorder.start();
+    recorder.wait();
+    double usedTime = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    EXPECT_EQ(recorder.imageNum(), 2 * kImageNum);
+    EXPECT_EQ(recorder.imuNum(), kImuNum);
+    // the record lasts 0.45 s
+    EXPECT_GE(usedTime, 0.45 / params.speed);
+    EXPECT_LT(usedTime, 0.45 / params.speed + 0.5);
+}
@@ -0,0 +1,67 @@
+/**
+ * @brief Test code for SPSC queue
+ *
+ */
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+#include "libra/util/SpscQueue.hpp"
+
+using namespace std;
+using namespace libra::util;
+
+// the jobs should be popped in order, and the producer should wait if queue is full
+TEST(SpscQueue, Order) {
+    constexpr size_t kNum = 200000;
+    SpscQueue<size_t> queue(16);
+    EXPECT_EQ(queue.capacity(), 16);
+
+    thread producer([&]() {
+        for (size_t i = 0; i < kNum; ++i) {
+            EXPECT_TRUE(queue.push(i));
+        }
+        queue.wait();
+        queue.stop();
+    });
+
+    size_t expected{0};
+    while (true) {
+        auto job = queue.pop();
+        if (!job.isValid()) {
+            break;
+        }
+        ASSERT_EQ(job.data(), expected);
+        ++expected;
+    }
+    producer.join();
+    EXPECT_EQ(expected, kNum);
+    EXPECT_EQ(queue.stats().dropNum, 0);
+}
+
+// the newest job should be dropped if queue is full
+TEST(SpscQueue, DropJob) {
+    SpscQueue<unique_ptr<int>> queue(3);
+    queue.enableDropJob(true);
+    for (int i = 0; i < 6; ++i) {
+        EXPECT_EQ(queue.push(make_unique<int>(i)), i < 4);
+    }
+    EXPECT_EQ(queue.size(), 4);
+    EXPECT_EQ(queue.stats().dropNum, 2);
+    EXPECT_EQ(*queue.pop().data(), 0);
+
+    queue.clear();
+    EXPECT_EQ(queue.size(), 0);
+    EXPECT_TRUE(queue.push(make_unique<int>(10)));
+    EXPECT_EQ(*queue.pop().data(), 10);
+}
+
+// stop the queue should wake up the waiting consumer
+TEST(SpscQueue, Stop) {
+    SpscQueue<int> queue;
+    thread consumer([&]() { EXPECT_FALSE(queue.pop().isValid()); });
+    this_thread::sleep_for(chrono::milliseconds(10));
+    queue.stop();
+    consumer.join();
+    EXPECT_FALSE(queue.push(1));
+}
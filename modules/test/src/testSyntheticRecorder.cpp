@@ -0,0 +1,91 @@
+/**
+ * @brief Test code for synthetic recorder
+ *
+ */
+
+#include <gtest/gtest.h>
+#include <mutex>
+#include <vector>
+#include "libra/io/SyntheticRecorder.h"
+
+using namespace std;
+using namespace libra::core;
+using namespace libra::io;
+
+/**
+ * @brief Output of synthetic recorder
+ */
+struct Output {
+    vector<double> imageTimestamps;        // image timestamps
+    vector<vector<unsigned char>> images;  // JPEG images
+    vector<double> imuTimestamps;          // IMU timestamps
+};
+
+/**
+ * @brief Run synthetic recorder until it's finished
+ *
+ * @param params    Synthetic parameters
+ * @return Output of recorder
+ */
+Output record(const SyntheticParams& params) {
+    Output output;
+    mutex outputMutex;
+    SyntheticRecorder recorder(params, 1);
+    recorder.setProcessFunction([&](const RawImageRecord& raw) {
+        lock_guard<mutex> lock(outputMutex);
+        output.imageTimestamps.emplace_back(raw.timestamp());
+        output.images.emplace_back(raw.reading().buffer(), raw.reading().buffer() + raw.reading().size());
+    });
+    recorder.setProcessFunction([&](const ImuRecord& imu) {
+        lock_guard<mutex> lock(outputMutex);
+        output.imuTimestamps.emplace_back(imu.timestamp());
+    });
+    recorder.init();
+    recorder.start();
+    recorder.wait();
+    EXPECT_EQ(recorder.generatedFrameNum(), params.frameNum);
+    EXPECT_EQ(recorder.droppedFrameNum() + output.images.size(), params.frameNum);
+    // all the stages of each processed image are traced
+    for (size_t i = 0; i < FrameTracer::kStageNum; ++i) {
+        EXPECT_EQ(recorder.frameTracer()->histogram(static_cast<PipelineStage>(i)).count(), output.images.size());
+    }
+    return output;
+}
+
+// all the generated data should be processed in non real time mode, and the content is the same for the same seed
+TEST(SyntheticRecorder, Deterministic) {
+    SyntheticParams params;
+    params.width = 64;
+    params.height = 48;
+    params.fps = 20;
+    params.imuRate = 100;
+    params.realTime = false;
+    params.frameNum = 40;
+    auto output = record(params);
+    ASSERT_EQ(output.images.size(), params.frameNum);
+    // IMU before the last frame, include the one at the same time
+    EXPECT_EQ(output.imuTimestamps.size(), (params.frameNum - 1) * 5 + 1);
+    for (size_t i = 1; i < output.images.size(); ++i) {
+        EXPECT_NEAR(output.imageTimestamps[i] - output.imageTimestamps[i - 1], 1 / params.fps, 1.0E-6);
+    }
+
+    auto output2 = record(params);
+    EXPECT_EQ(output2.images, output.images);
+}
+
+// the dropped frames and IMU leave gaps in timestamps
+TEST(SyntheticRecorder, Drop) {
+    SyntheticParams params;
+    params.width = 64;
+    params.height = 48;
+    params.fps = 100;
+    params.imuRate = 200;
+    params.frameDropRate = 0.2;
+    params.imuDropRate = 0.2;
+    params.jitter = 0.002;
+    params.frameNum = 50;
+    auto output = record(params);
+    EXPECT_LT(output.images.size(), params.frameNum);
+    EXPECT_GT(output.images.size(), 0);
+    EXPECT_LT(output.imuTimestamps.size(), (params.frameNum - 1) * 2 + 1);
+}
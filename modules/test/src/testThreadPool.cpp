@@ -0,0 +1,104 @@
+/**
+ * @brief Test code for thread pool
+ *
+ */
+
+#include <gtest/gtest.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "libra/util/ThreadPool.h"
+
+using namespace std;
+using namespace libra::util;
+
+// small callable is stored in inline buffer, large callable is on heap, and move-only callable is supported
+TEST(Task, Storage) {
+    int value{0};
+    Task small([&value]() { ++value; });
+    EXPECT_TRUE(small.isInline());
+    small();
+    EXPECT_EQ(value, 1);
+
+    array<int, 64> large{};
+    Task heap([large, &value]() { value += large.size(); });
+    EXPECT_FALSE(heap.isInline());
+    Task moved(move(heap));
+    EXPECT_FALSE(heap);
+    moved();
+    EXPECT_EQ(value, 65);
+
+    auto p = make_unique<int>(10);
+    Task moveOnly([p = move(p), &value]() { value += *p; });
+    moveOnly = move(small);
+    moveOnly();
+    EXPECT_EQ(value, 66);
+}
+
+// the result of all tasks should be returned
+TEST(ThreadPool, AddTask) {
+    ThreadPool pool(4);
+    vector<future<int>> results;
+    for (int i = 0; i < 1000; ++i) {
+        results.emplace_back(pool.addTask([](int v) { return v * v; }, i));
+    }
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(results[i].get(), i * i);
+    }
+}
+
+// post tasks from outside and from worker threads, all tasks should be finished after wait
+TEST(ThreadPool, PostAndWait) {
+    ThreadPool pool(3);
+    atomic<int> count{0};
+    for (int i = 0; i < 100; ++i) {
+        pool.post([&]() {
+            // fan out from worker thread, which is pushed to its own queue and may be stolen by others
+            for (int j = 0; j < 10; ++j) {
+                pool.post([&]() { ++count; });
+            }
+        });
+    }
+    pool.wait();
+    EXPECT_EQ(count, 1000);
+
+    // the pool could be reused after wait, and the exception of posted task doesn't kill the worker
+    pool.post([]() { throw runtime_error("task error"); });
+    pool.post([&]() { ++count; });
+    pool.wait();
+    EXPECT_EQ(count, 1001);
+}
+
+// add task to stopped pool should throw exception
+TEST(ThreadPool, Stop) {
+    ThreadPool pool(2);
+    pool.stop();
+    EXPECT_THROW(pool.post([]() {}), runtime_error);
+    EXPECT_THROW(pool.addTask([]() { return 0; }), runtime_error);
+    pool.wait();
+}
+
+// stop while other thread is adding tasks, each task is either rejected, finished or cleared, and wait doesn't block
+TEST(ThreadPool, StopWhileAdding) {
+    for (int n = 0; n < 20; ++n) {
+        ThreadPool pool(2);
+        auto token = make_shared<int>(0);
+        thread producer([&pool, token]() {
+            try {
+                while (true) {
+                    pool.post([token]() {});
+                }
+            } catch (const runtime_error&) {
+            }
+        });
+        this_thread::sleep_for(chrono::milliseconds(1));
+        pool.stop();
+        producer.join();
+        pool.wait();
+        // the tasks holding the token are all released
+        EXPECT_EQ(token.use_count(), 1);
+    }
+}
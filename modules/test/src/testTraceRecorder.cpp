@@ -0,0 +1,109 @@
+/**
+ * @brief Test code for trace recorder
+ *
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <nlohmann/json.hpp>
+#include <thread>
+#include <vector>
+#include "libra/util/TraceRecorder.h"
+
+using namespace std;
+using namespace libra::util;
+using json = nlohmann::json;
+
+/**
+ * @brief Test fixture for trace recorder, the global recorder is cleared and disabled after each test
+ */
+class TraceRecorderTest : public ::testing::Test {
+  protected:
+    void SetUp() override { TraceRecorder::instance().clear(); }
+
+    void TearDown() override {
+        TraceRecorder::instance().setEnabled(false);
+        TraceRecorder::instance().setCapacity(16384);
+        TraceRecorder::instance().clear();
+    }
+};
+
+// nothing is recorded if the recorder is disabled
+TEST_F(TraceRecorderTest, Disabled) {
+    TraceRecorder& recorder = TraceRecorder::instance();
+    EXPECT_FALSE(recorder.isEnabled());
+    thread([]() {
+        TraceRecorder::instance().setThreadName("disabled");
+        TraceScope scope("span");
+    }).join();
+    EXPECT_EQ(recorder.eventNum(), 0);
+}
+
+// the spans of threads are exported as Chrome trace
+TEST_F(TraceRecorderTest, ChromeTrace) {
+    TraceRecorder& recorder = TraceRecorder::instance();
+    recorder.setEnabled(true);
+    vector<thread> threads;
+    for (int i = 0; i < 2; ++i) {
+        threads.emplace_back([i]() {
+            TraceRecorder::instance().setThreadName(i == 0 ? "first" : "second");
+            for (int n = 0; n < 3; ++n) {
+                TraceScope outer("outer");
+                {
+                    TraceScope inner("inner");
+                    this_thread::sleep_for(chrono::microseconds(100));
+                }
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(recorder.eventNum(), 12);
+
+    json j = json::parse(recorder.toJson());
+    ASSERT_TRUE(j["traceEvents"].is_array());
+    vector<string> threadNames;
+    size_t spanNum{0};
+    for (auto& e : j["traceEvents"]) {
+        if (e["ph"] == "M") {
+            threadNames.emplace_back(e["args"]["name"].get<string>());
+        } else {
+            EXPECT_EQ(e["ph"], "X");
+            EXPECT_GE(e["ts"].get<double>(), 0);
+            EXPECT_GE(e["dur"].get<double>(), e["name"] == "inner" ? 100 : 0);
+            ++spanNum;
+        }
+    }
+    EXPECT_EQ(spanNum, 12);
+    EXPECT_EQ(threadNames.size(), 2);
+    EXPECT_NE(find(threadNames.begin(), threadNames.end(), "first"), threadNames.end());
+    EXPECT_NE(find(threadNames.begin(), threadNames.end(), "second"), threadNames.end());
+
+    // the buffers of exited threads are released
+    recorder.clear();
+    EXPECT_EQ(recorder.eventNum(), 0);
+    EXPECT_EQ(json::parse(recorder.toJson())["traceEvents"].size(), 0);
+}
+
+// only the latest events are kept if the ring buffer is full
+TEST_F(TraceRecorderTest, RingBuffer) {
+    TraceRecorder& recorder = TraceRecorder::instance();
+    recorder.setEnabled(true);
+    recorder.setCapacity(4);
+    thread([&]() {
+        for (int i = 0; i < 10; ++i) {
+            recorder.record("span", 1000 * i, 10);
+        }
+    }).join();
+    EXPECT_EQ(recorder.eventNum(), 4);
+
+    json j = json::parse(recorder.toJson());
+    vector<double> starts;
+    for (auto& e : j["traceEvents"]) {
+        if (e["ph"] == "X") {
+            starts.emplace_back(e["ts"].get<double>());
+        }
+    }
+    EXPECT_EQ(starts, vector<double>({0, 1, 2, 3}));
+}
@@ -0,0 +1,124 @@
+/**
+ * @brief Test code for pre-trigger buffer
+ *
+ */
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+#include "libra/io/TriggerBuffer.h"
+
+using namespace std;
+using namespace Eigen;
+using namespace libra::core;
+using namespace libra::io;
+
+/**
+ * @brief Test fixture for pre-trigger buffer, which pushes IMU at 64 Hz and images at 8 Hz, the timestamps are exact
+ * in binary. The image content is filled by its tick, and the buffer isn't owned by reading
+ */
+class TriggerBufferTest : public testing::Test {
+  protected:
+    void SetUp() override {
+        params_.preTrigger = 1.0;
+        params_.postTrigger = 0.5;
+    }
+
+    // create buffer with current parameters, which saves the data into vectors
+    void create() {
+        buffer_ = make_unique<TriggerBuffer>(
+            params_,
+            [&](const RawImageRecord& raw, size_t) {
+                const unsigned char* data = raw.reading().buffer();
+                images_.emplace_back(raw.timestamp(), vector<unsigned char>(data, data + raw.reading().size()));
+            },
+            [&](const ImuRecord& imu) { imus_.emplace_back(imu.timestamp()); });
+    }
+
+    // push the data of tick [begin, end)
+    void push(int begin, int end, const Vector3d& acc = Vector3d(0, 0, 9.8)) {
+        vector<unsigned char> image(1000);
+        for (int i = begin; i < end; ++i) {
+            buffer_->push(ImuRecord(i / 64.0, ImuReading(acc, Vector3d::Zero())));
+            if (i % 8 == 0) {
+                fill(image.begin(), image.end(), static_cast<unsigned char>(i));
+                buffer_->push(RawImageRecord(i / 64.0, RawImageReading(image.data(), image.size())));
+            }
+        }
+    }
+
+  protected:
+    TriggerParams params_;                                // trigger parameters
+    unique_ptr<TriggerBuffer> buffer_;                    // pre-trigger buffer
+    vector<pair<double, vector<unsigned char>>> images_;  // saved images
+    vector<double> imus_;                                 // saved IMU timestamp
+};
+
+// nothing is saved before trigger, and the data around trigger is saved
+TEST_F(TriggerBufferTest, Trigger) {
+    create();
+    push(0, 129);
+    EXPECT_TRUE(images_.empty());
+    EXPECT_TRUE(imus_.empty());
+    EXPECT_EQ(buffer_->bufferedImageNum(), 9);
+    EXPECT_EQ(buffer_->bufferedBytes(), 9000);
+
+    // the trigger is handled at the IMU of tick 129, i.e., the window of tick [65, 161]
+    buffer_->trigger();
+    EXPECT_FALSE(buffer_->isTriggered());
+    push(129, 140);
+    EXPECT_TRUE(buffer_->isTriggered());
+    // trigger again in post-trigger window only extends it to tick 172
+    buffer_->trigger();
+    push(140, 400);
+    EXPECT_FALSE(buffer_->isTriggered());
+    EXPECT_EQ(buffer_->triggerNum(), 1);
+
+    ASSERT_EQ(imus_.size(), 172 - 65 + 1);
+    for (size_t i = 0; i < imus_.size(); ++i) {
+        EXPECT_EQ(imus_[i], (65 + i) / 64.0);
+    }
+    ASSERT_EQ(images_.size(), 13);
+    for (size_t i = 0; i < images_.size(); ++i) {
+        const int tick = 72 + 8 * i;
+        EXPECT_EQ(images_[i].first, tick / 64.0);
+        EXPECT_EQ(images_[i].second, vector<unsigned char>(1000, static_cast<unsigned char>(tick)));
+    }
+
+    // trigger again after post-trigger window
+    images_.clear();
+    imus_.clear();
+    buffer_->trigger();
+    push(400, 500);
+    EXPECT_EQ(buffer_->triggerNum(), 2);
+    EXPECT_EQ(imus_.size(), 64 + 32 + 1);
+    EXPECT_EQ(images_.size(), 13);
+}
+
+// the oldest images are dropped if the budget is exceeded
+TEST_F(TriggerBufferTest, Budget) {
+    params_.byteBudget = 4500;
+    create();
+    push(0, 200);
+    EXPECT_EQ(buffer_->bufferedImageNum(), 4);
+    EXPECT_EQ(buffer_->bufferedBytes(), 4000);
+    EXPECT_EQ(buffer_->droppedImageNum(), 25 - 4);
+
+    buffer_->trigger();
+    push(200, 201);
+    ASSERT_EQ(images_.size(), 5);
+    EXPECT_EQ(images_.front().first, 168 / 64.0);
+    EXPECT_EQ(imus_.size(), 65);
+}
+
+// trigger by IMU threshold
+TEST_F(TriggerBufferTest, ImuThreshold) {
+    params_.accThreshold = 30;
+    create();
+    push(0, 200);
+    EXPECT_EQ(buffer_->triggerNum(), 0);
+    push(200, 201, Vector3d(0, 20, 30));
+    EXPECT_EQ(buffer_->triggerNum(), 1);
+    EXPECT_TRUE(buffer_->isTriggered());
+    EXPECT_EQ(imus_.size(), 65);
+}
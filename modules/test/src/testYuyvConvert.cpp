@@ -0,0 +1,188 @@
+/**
+ * @brief Test code for YUYV(YUV422 Packed) to YUV422 Planar conversion kernels
+ *
+ */
+
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+#include <fstream>
+#include <random>
+#include <vector>
+#include "libra/util/YuyvConvert.h"
+
+using namespace std;
+using namespace libra::util;
+
+class YuyvConvertTest : public testing::Test {
+  protected:
+    /**
+     * @brief Set up
+     *
+     */
+    void SetUp() override;
+
+    /**
+     * @brief Reference conversion, copied from the scalar loop used by the recorders
+     *
+     * @param raw       YUYV image
+     * @param width     Image width
+     * @param height    Image height
+     * @param stride    Row stride of YUYV image in bytes
+     * @return YUV422 Planar image
+     */
+    static vector<unsigned char> reference(const vector<unsigned char>& raw, int width, int height, int stride);
+
+  protected:
+    vector<SimdLevel> levels;  // supported SIMD levels
+    mt19937 rng{20210101};     // random generator
+};
+
+// set up
+void YuyvConvertTest::SetUp() {
+    for (auto l : {SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::NEON}) {
+        if (isSimdSupported(l)) {
+            levels.emplace_back(l);
+        }
+    }
+}
+
+// Reference conversion
+vector<unsigned char> YuyvConvertTest::reference(const vector<unsigned char>& raw, int width, int height,
+                                                 int stride) {
+    vector<unsigned char> yuv(2 * width * height);
+    unsigned char* pY = yuv.data();
+    unsigned char* pU = yuv.data() + width * height;
+    unsigned char* pV = yuv.data() + width * height * 3 / 2;
+    for (int i = 0; i < height; ++i) {
+        const unsigned char* pRaw = raw.data() + i * stride;
+        for (int j = 0; j < width / 2; ++j) {
+            *pY++ = *(pRaw++);
+            *pU++ = *(pRaw++);
+            *pY++ = *(pRaw++);
+            *pV++ = *(pRaw++);
+        }
+    }
+    return yuv;
+}
+
+// golden output for a small row
+TEST_F(YuyvConvertTest, GoldenRow) {
+    const vector<unsigned char> yuyv{10, 20, 11, 30, 12, 21, 13, 31, 14, 22, 15, 32};
+    const vector<unsigned char> goldenY{10, 11, 12, 13, 14, 15};
+    const vector<unsigned char> goldenU{20, 21, 22};
+    const vector<unsigned char> goldenV{30, 31, 32};
+
+    for (auto l : levels) {
+        vector<unsigned char> y(6), u(3), v(3);
+        yuyvToYuv422pRow(yuyv.data(), 6, y.data(), u.data(), v.data(), l);
+        EXPECT_EQ(y, goldenY) << toString(l);
+        EXPECT_EQ(u, goldenU) << toString(l);
+        EXPECT_EQ(v, goldenV) << toString(l);
+    }
+}
+
+// all SIMD levels should give the same result with reference code, for any width(SIMD body + scalar tail)
+TEST_F(YuyvConvertTest, MatchReference) {
+    uniform_int_distribution<int> dist(0, 255);
+    for (int width = 2; width <= 260; width += 2) {
+        const int height = 3;
+        const int stride = 2 * width + 6;  // stride larger than row size
+        vector<unsigned char> raw(stride * height);
+        for (auto& r : raw) {
+            r = static_cast<unsigned char>(dist(rng));
+        }
+        auto golden = reference(raw, width, height, stride);
+
+        for (auto l : levels) {
+            vector<unsigned char> yuv(2 * width * height, 0);
+            yuyvToYuv422p(raw.data(), width, height, stride, yuv.data(), l);
+            ASSERT_EQ(yuv, golden) << fmt::format("level = {}, width = {}", toString(l), width);
+        }
+    }
+}
+
+// the row kernel should not write outside the output rows
+TEST_F(YuyvConvertTest, NoOverwrite) {
+    constexpr int kWidth = 70;
+    constexpr unsigned char kGuard = 0xA5;
+    vector<unsigned char> raw(2 * kWidth, 0x11);
+    for (auto l : levels) {
+        vector<unsigned char> y(kWidth + 32, kGuard), u(kWidth / 2 + 32, kGuard), v(kWidth / 2 + 32, kGuard);
+        yuyvToYuv422pRow(raw.data(), kWidth, y.data(), u.data(), v.data(), l);
+        for (size_t i = kWidth; i < y.size(); ++i) {
+            ASSERT_EQ(y[i], kGuard) << toString(l);
+        }
+        for (size_t i = kWidth / 2; i < u.size(); ++i) {
+            ASSERT_EQ(u[i], kGuard) << toString(l);
+            ASSERT_EQ(v[i], kGuard) << toString(l);
+        }
+    }
+}
+
+// convert the left part of the recorded image, same as the usage in ZED recorder
+TEST_F(YuyvConvertTest, RecordedImageLeft) {
+    int width = 1280;  // image width
+    int height = 720;  // image height
+    fstream fs("./data/yuyv.bin", ios::in | ios::binary);
+    if (!fs.is_open()) {
+        return;
+    }
+    vector<unsigned char> raw = vector<unsigned char>(istreambuf_iterator<char>(fs), {});
+    fs.close();
+    ASSERT_GE(raw.size(), 2 * width * height);
+
+    auto golden = reference(raw, width / 2, height, 2 * width);
+    for (auto l : levels) {
+        vector<unsigned char> yuv(width * height);
+        yuyvToYuv422p(raw.data(), width / 2, height, 2 * width, yuv.data(), l);
+        EXPECT_EQ(yuv, golden) << toString(l);
+    }
+}
+
+// 2x2 binning gives the rounded average of 4 samples for all SIMD levels, and the Y only output is the same
+TEST_F(YuyvConvertTest, Bin2x2) {
+    // golden output for a small image of 4x2 pixels
+    const vector<unsigned char> row0{10, 20, 11, 30, 12, 21, 13, 31};
+    const vector<unsigned char> row1{20, 40, 22, 60, 24, 43, 26, 62};
+    for (auto l : levels) {
+        vector<unsigned char> y(2), u(1), v(1);
+        yuyvBin2x2Row(row0.data(), row1.data(), 4, y.data(), u.data(), v.data(), l);
+        EXPECT_EQ(y, vector<unsigned char>({16, 19})) << toString(l);
+        EXPECT_EQ(u, vector<unsigned char>({31})) << toString(l);
+        EXPECT_EQ(v, vector<unsigned char>({46})) << toString(l);
+    }
+
+    // random rows, for any width(SIMD body + scalar tail)
+    uniform_int_distribution<int> dist(0, 255);
+    for (int width = 4; width <= 260; width += 4) {
+        vector<unsigned char> raw(4 * width);
+        for (auto& r : raw) {
+            r = static_cast<unsigned char>(dist(rng));
+        }
+        const unsigned char* p0 = raw.data();
+        const unsigned char* p1 = raw.data() + 2 * width;
+        // rounded average of the samples at index k and k + step of two rows
+        auto average = [&](int k, int step) {
+            return static_cast<unsigned char>((p0[k] + p0[k + step] + p1[k] + p1[k + step] + 2) / 4);
+        };
+        vector<unsigned char> goldenY(width / 2), goldenU(width / 4), goldenV(width / 4);
+        for (int i = 0; i < width / 2; ++i) {
+            goldenY[i] = average(4 * i, 2);
+        }
+        for (int i = 0; i < width / 4; ++i) {
+            goldenU[i] = average(8 * i + 1, 4);
+            goldenV[i] = average(8 * i + 3, 4);
+        }
+
+        for (auto l : levels) {
+            string info = fmt::format("level = {}, width = {}", toString(l), width);
+            vector<unsigned char> y(width / 2), u(width / 4), v(width / 4), yOnly(width / 2);
+            yuyvBin2x2Row(p0, p1, width, y.data(), u.data(), v.data(), l);
+            yuyvBin2x2Row(p0, p1, width, yOnly.data(), nullptr, nullptr, l);
+            ASSERT_EQ(y, goldenY) << info;
+            ASSERT_EQ(u, goldenU) << info;
+            ASSERT_EQ(v, goldenV) << info;
+            ASSERT_EQ(yOnly, goldenY) << info;
+        }
+    }
+}
@@ -0,0 +1,495 @@
+/**
+ * @brief Test code for YUYV JPEG encoder
+ *
+ */
+
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+#include <turbojpeg.h>
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <vector>
+#include "libra/io/YuyvJpegEncoder.h"
+#include "libra/util/YuyvConvert.h"
+
+using namespace std;
+using namespace libra::util;
+using namespace libra::core;
+using namespace libra::io;
+
+class YuyvJpegEncoderTest : public testing::Test {
+  protected:
+    /**
+     * @brief Generate a smooth YUYV image with some noise, which is more like a real image than pure random data
+     *
+     * @param width     Image width
+     * @param height    Image height
+     * @return YUYV image
+     */
+    vector<unsigned char> generate(int width, int height);
+
+    /**
+     * @brief Compress image using turbojpeg, the same code used by recorders before
+     *
+     * @param yuyv      YUYV image
+     * @param width     Image width
+     * @param height    Image height
+     * @param stride    Row stride of YUYV image in bytes
+     * @param quality   JPEG quality
+     * @return JPEG data
+     */
+    static vector<unsigned char> compressWithTurboJpeg(const vector<unsigned char>& yuyv, int width, int height,
+                                                       int stride, int quality);
+
+    /**
+     * @brief Compress image using YUYV JPEG encoder
+     *
+     * @param mode      Encode mode
+     * @param yuyv      YUYV image
+     * @param width     Image width
+     * @param height    Image height
+     * @param stride    Row stride of YUYV image in bytes
+     * @param quality   JPEG quality
+     * @return JPEG data
+     */
+    static vector<unsigned char> compressWithEncoder(YuyvEncodeMode mode, const vector<unsigned char>& yuyv, int width,
+                                                     int height, int stride, int quality);
+
+  protected:
+    mt19937 rng{20210101};  // random generator
+};
+
+// Generate a smooth YUYV image with some noise
+vector<unsigned char> YuyvJpegEncoderTest::generate(int width, int height) {
+    uniform_int_distribution<int> noise(-8, 8);
+    vector<unsigned char> yuyv(2 * width * height);
+    for (int i = 0; i < height; ++i) {
+        for (int j = 0; j < 2 * width; ++j) {
+            int v = (j % 2 == 0) ? (i + j) % 256 : 128 + (j % 4 == 1 ? i % 64 : -(j / 4) % 64);
+            yuyv[i * 2 * width + j] = static_cast<unsigned char>(min(255, max(0, v + noise(rng))));
+        }
+    }
+    return yuyv;
+}
+
+// Compress image using turbojpeg
+vector<unsigned char> YuyvJpegEncoderTest::compressWithTurboJpeg(const vector<unsigned char>& yuyv, int width,
+                                                                 int height, int stride, int quality) {
+    vector<unsigned char> yuvData(2 * width * height);
+    yuyvToYuv422p(yuyv.data(), width, height, stride, yuvData.data(), SimdLevel::Scalar);
+
+    tjhandle compressor = tjInitCompress();
+    unsigned char* dest = nullptr;  // dest buffer
+    unsigned long destSize{0};      // dest size
+    EXPECT_EQ(tjCompressFromYUV(compressor, yuvData.data(), width, 1, height, TJSAMP_422, &dest, &destSize, quality,
+                                TJFLAG_FASTDCT),
+              0);
+    vector<unsigned char> jpeg(dest, dest + destSize);
+    tjFree(dest);
+    tjDestroy(compressor);
+    return jpeg;
+}
+
+// Compress image using YUYV JPEG encoder
+vector<unsigned char> YuyvJpegEncoderTest::compressWithEncoder(YuyvEncodeMode mode, const vector<unsigned char>& yuyv,
+                                                               int width, int height, int stride, int quality) {
+    YuyvEncodeParams params;
+    params.mode = mode;
+    params.quality = quality;
+    YuyvJpegEncoder encoder(params);
+    unsigned char* dest = nullptr;  // dest buffer
+    unsigned long destSize{0};      // dest size
+    EXPECT_TRUE(encoder.encode(yuyv.data(), width, height, stride, &dest, &destSize));
+    vector<unsigned char> jpeg(dest, dest + destSize);
+    tjFree(dest);
+    return jpeg;
+}
+
+// the output of both mode should be the same with turbojpeg, include the size not aligned to MCU
+TEST_F(YuyvJpegEncoderTest, SameWithTurboJpeg) {
+    for (int width : {2, 16, 38, 640}) {
+        for (int height : {1, 8, 13, 480}) {
+            auto yuyv = generate(width, height);
+            auto golden = compressWithTurboJpeg(yuyv, width, height, 2 * width, 95);
+            for (auto mode : {YuyvEncodeMode::Planar, YuyvEncodeMode::Direct}) {
+                auto jpeg = compressWithEncoder(mode, yuyv, width, height, 2 * width, 95);
+                ASSERT_EQ(jpeg, golden) << fmt::format("mode = {}, size = {}x{}", static_cast<int>(mode), width,
+                                                       height);
+            }
+        }
+    }
+}
+
+// the output should be the same for different quality(fast DCT or accurate DCT)
+TEST_F(YuyvJpegEncoderTest, Quality) {
+    constexpr int kWidth = 320, kHeight = 240;
+    auto yuyv = generate(kWidth, kHeight);
+    for (int quality : {50, 80, 95, 100}) {
+        auto golden = compressWithTurboJpeg(yuyv, kWidth, kHeight, 2 * kWidth, quality);
+        auto jpeg = compressWithEncoder(YuyvEncodeMode::Direct, yuyv, kWidth, kHeight, 2 * kWidth, quality);
+        EXPECT_EQ(jpeg, golden) << fmt::format("quality = {}", quality);
+    }
+}
+
+// compress left part of side-by-side image
+TEST_F(YuyvJpegEncoderTest, LeftPart) {
+    constexpr int kWidth = 1280, kHeight = 72;
+    auto yuyv = generate(kWidth, kHeight);
+    auto golden = compressWithTurboJpeg(yuyv, kWidth / 2, kHeight, 2 * kWidth, 95);
+    auto jpeg = compressWithEncoder(YuyvEncodeMode::Direct, yuyv, kWidth / 2, kHeight, 2 * kWidth, 95);
+    EXPECT_EQ(jpeg, golden);
+}
+
+// compress into preallocated buffer, the output should be the same with the allocated one
+TEST_F(YuyvJpegEncoderTest, PreallocatedBuffer) {
+    constexpr int kWidth = 640, kHeight = 480;
+    auto yuyv = generate(kWidth, kHeight);
+    auto golden = compressWithTurboJpeg(yuyv, kWidth, kHeight, 2 * kWidth, 95);
+    for (auto mode : {YuyvEncodeMode::Planar, YuyvEncodeMode::Direct}) {
+        YuyvEncodeParams params;
+        params.mode = mode;
+        YuyvJpegEncoder encoder(params);
+        vector<unsigned char> buffer(YuyvJpegEncoder::bufferSize(kWidth, kHeight));
+        // compress twice to check the buffer could be reused
+        for (int n = 0; n < 2; ++n) {
+            unsigned long size{0};
+            ASSERT_TRUE(encoder.encodeTo(yuyv.data(), kWidth, kHeight, 2 * kWidth, buffer.data(), buffer.size(), &size));
+            EXPECT_EQ(vector<unsigned char>(buffer.begin(), buffer.begin() + size), golden);
+        }
+
+        // the buffer is too small
+        unsigned long size{0};
+        EXPECT_FALSE(encoder.encodeTo(yuyv.data(), kWidth, kHeight, 2 * kWidth, buffer.data(), 1024, &size));
+        EXPECT_EQ(size, 0);
+
+        // switch back to allocated buffer with the same encoder, then to preallocated buffer again
+        unsigned char* dest = nullptr;
+        unsigned long destSize{0};
+        ASSERT_TRUE(encoder.encode(yuyv.data(), kWidth, kHeight, 2 * kWidth, &dest, &destSize));
+        EXPECT_EQ(vector<unsigned char>(dest, dest + destSize), golden);
+        // the allocated buffer is reused in direct mode, though the output size is less than the allocated one
+        unsigned char* lastDest = dest;
+        ASSERT_TRUE(encoder.encode(yuyv.data(), kWidth, kHeight, 2 * kWidth, &dest, &destSize));
+        EXPECT_EQ(vector<unsigned char>(dest, dest + destSize), golden);
+        if (mode == YuyvEncodeMode::Direct) {
+            EXPECT_EQ(dest, lastDest);
+        }
+        tjFree(dest);
+        ASSERT_TRUE(encoder.encodeTo(yuyv.data(), kWidth, kHeight, 2 * kWidth, buffer.data(), buffer.size(), &size));
+        EXPECT_EQ(vector<unsigned char>(buffer.begin(), buffer.begin() + size), golden);
+    }
+}
+
+// compress in stripe mode, the output should be decoded to the same image with direct mode, and has restart markers
+TEST_F(YuyvJpegEncoderTest, Stripe) {
+    const vector<unsigned char> kDri = {0xFF, 0xDD, 0x00, 0x04};  // DRI marker and its length
+    auto threadPool = make_shared<ThreadPool>(3);
+    // the stripes are compressed in calling thread if the thread pool is stopped
+    auto stoppedPool = make_shared<ThreadPool>(2);
+    stoppedPool->stop();
+    tjhandle decompressor = tjInitDecompress();
+    auto decode = [&](const vector<unsigned char>& jpeg, int width, int height) {
+        vector<unsigned char> image(3 * width * height);
+        EXPECT_EQ(tjDecompress2(decompressor, jpeg.data(), jpeg.size(), image.data(), width, 0, height, TJPF_RGB, 0),
+                  0);
+        return image;
+    };
+
+    for (auto size : {make_pair(38, 13), make_pair(640, 480), make_pair(2208, 1242)}) {
+        int width = size.first, height = size.second;
+        auto yuyv = generate(width, height);
+        auto golden = decode(compressWithEncoder(YuyvEncodeMode::Direct, yuyv, width, height, 2 * width, 95), width,
+                             height);
+        for (int stripeNum : {0, 1, 2, 5}) {
+            YuyvEncodeParams params;
+            params.mode = YuyvEncodeMode::Stripe;
+            params.stripeNum = stripeNum;
+            for (auto pool : {shared_ptr<ThreadPool>(), threadPool, stoppedPool}) {
+                YuyvJpegEncoder encoder(params, pool);
+                vector<unsigned char> buffer(YuyvJpegEncoder::bufferSize(width, height));
+                unsigned long jpegSize{0};
+                ASSERT_TRUE(encoder.encodeTo(yuyv.data(), width, height, 2 * width, buffer.data(), buffer.size(),
+                                             &jpegSize));
+                buffer.resize(jpegSize);
+                EXPECT_EQ(decode(buffer, width, height), golden)
+                    << fmt::format("size = {}x{}, stripe number = {}", width, height, stripeNum);
+
+                // check DRI marker is inserted if there are several stripes
+                bool hasDri = search(buffer.begin(), buffer.end(), kDri.begin(), kDri.end()) != buffer.end();
+                EXPECT_EQ(hasDri, height > 8 && (stripeNum > 1 || (stripeNum == 0 && pool)));
+            }
+        }
+    }
+    tjDestroy(decompressor);
+}
+
+// the output of YUV420 and grayscale should be the same for planar and direct mode, and the stripe mode should be
+// decoded to the same image
+TEST_F(YuyvJpegEncoderTest, Subsampling) {
+    tjhandle decompressor = tjInitDecompress();
+    auto threadPool = make_shared<ThreadPool>(2);
+    for (auto subsampling : {JpegSubsampling::S420, JpegSubsampling::Gray}) {
+        for (auto size : {make_pair(2, 1), make_pair(38, 13), make_pair(640, 480)}) {
+            int width = size.first, height = size.second;
+            auto yuyv = generate(width, height);
+            vector<vector<unsigned char>> jpegs;
+            for (auto mode : {YuyvEncodeMode::Planar, YuyvEncodeMode::Direct, YuyvEncodeMode::Stripe}) {
+                YuyvEncodeParams params;
+                params.mode = mode;
+                params.subsampling = subsampling;
+                YuyvJpegEncoder encoder(params, threadPool);
+                unsigned char* dest = nullptr;  // dest buffer
+                unsigned long destSize{0};      // dest size
+                ASSERT_TRUE(encoder.encode(yuyv.data(), width, height, 2 * width, &dest, &destSize));
+                jpegs.emplace_back(dest, dest + destSize);
+                tjFree(dest);
+            }
+            string info = fmt::format("subsampling = {}, size = {}x{}", toString(subsampling), width, height);
+            EXPECT_EQ(jpegs[0], jpegs[1]) << info;
+
+            // decode direct and stripe output
+            vector<vector<unsigned char>> images;
+            for (size_t i = 1; i < jpegs.size(); ++i) {
+                vector<unsigned char> image(3 * width * height);
+                EXPECT_EQ(tjDecompress2(decompressor, jpegs[i].data(), jpegs[i].size(), image.data(), width, 0, height,
+                                        TJPF_RGB, 0),
+                          0);
+                images.emplace_back(move(image));
+            }
+            EXPECT_EQ(images[0], images[1]) << info;
+        }
+    }
+    tjDestroy(decompressor);
+}
+
+// the restart interval doesn't change the decoded image, and the stripe mode with restart is the same with direct mode
+TEST_F(YuyvJpegEncoderTest, Restart) {
+    const vector<unsigned char> kDri = {0xFF, 0xDD, 0x00, 0x04};  // DRI marker and its length
+    tjhandle decompressor = tjInitDecompress();
+    auto threadPool = make_shared<ThreadPool>(3);
+    auto encode = [&](const vector<unsigned char>& yuyv, int width, int height, const YuyvEncodeParams& params) {
+        YuyvJpegEncoder encoder(params, threadPool);
+        unsigned char* dest = nullptr;  // dest buffer
+        unsigned long destSize{0};      // dest size
+        EXPECT_TRUE(encoder.encode(yuyv.data(), width, height, 2 * width, &dest, &destSize));
+        vector<unsigned char> jpeg(dest, dest + destSize);
+        tjFree(dest);
+        return jpeg;
+    };
+    auto decode = [&](const vector<unsigned char>& jpeg, int width, int height) {
+        vector<unsigned char> image(3 * width * height);
+        EXPECT_EQ(tjDecompress2(decompressor, jpeg.data(), jpeg.size(), image.data(), width, 0, height, TJPF_RGB, 0),
+                  0);
+        return image;
+    };
+
+    for (auto subsampling : {JpegSubsampling::S422, JpegSubsampling::S420, JpegSubsampling::Gray}) {
+        for (auto size : {make_pair(38, 13), make_pair(640, 480)}) {
+            int width = size.first, height = size.second;
+            auto yuyv = generate(width, height);
+            YuyvEncodeParams params;
+            params.subsampling = subsampling;
+            auto golden = decode(encode(yuyv, width, height, params), width, height);
+            for (int restartRows : {1, 3}) {
+                string info = fmt::format("subsampling = {}, size = {}x{}, restart rows = {}", toString(subsampling),
+                                          width, height, restartRows);
+                params.mode = YuyvEncodeMode::Direct;
+                params.restartRows = restartRows;
+                auto direct = encode(yuyv, width, height, params);
+                EXPECT_NE(search(direct.begin(), direct.end(), kDri.begin(), kDri.end()), direct.end()) << info;
+                EXPECT_EQ(decode(direct, width, height), golden) << info;
+
+                params.mode = YuyvEncodeMode::Stripe;
+                for (int stripeNum : {0, 2, 5}) {
+                    params.stripeNum = stripeNum;
+                    EXPECT_EQ(encode(yuyv, width, height, params), direct)
+                        << fmt::format("{}, stripe number = {}", info, stripeNum);
+                }
+            }
+        }
+    }
+    tjDestroy(decompressor);
+}
+
+// all DCT methods could be decoded to the similar image, and the auto method is the fast one for quality < 96
+TEST_F(YuyvJpegEncoderTest, DctMethod) {
+    constexpr int kWidth = 320, kHeight = 240;
+    auto yuyv = generate(kWidth, kHeight);
+    auto encode = [&](JpegDctMethod method, int quality) {
+        YuyvEncodeParams params;
+        params.quality = quality;
+        params.dctMethod = method;
+        YuyvJpegEncoder encoder(params);
+        unsigned char* dest = nullptr;  // dest buffer
+        unsigned long destSize{0};      // dest size
+        EXPECT_TRUE(encoder.encode(yuyv.data(), kWidth, kHeight, 2 * kWidth, &dest, &destSize));
+        vector<unsigned char> jpeg(dest, dest + destSize);
+        tjFree(dest);
+        return jpeg;
+    };
+    EXPECT_EQ(encode(JpegDctMethod::Auto, 90), encode(JpegDctMethod::Fast, 90));
+    EXPECT_EQ(encode(JpegDctMethod::Auto, 98), encode(JpegDctMethod::Slow, 98));
+    EXPECT_NE(encode(JpegDctMethod::Slow, 90), encode(JpegDctMethod::Fast, 90));
+
+    tjhandle decompressor = tjInitDecompress();
+    vector<unsigned char> golden(kWidth * kHeight);
+    auto slow = encode(JpegDctMethod::Slow, 90);
+    ASSERT_EQ(tjDecompress2(decompressor, slow.data(), slow.size(), golden.data(), kWidth, 0, kHeight, TJPF_GRAY, 0),
+              0);
+    for (auto method : {JpegDctMethod::Fast, JpegDctMethod::Float}) {
+        auto jpeg = encode(method, 90);
+        vector<unsigned char> image(kWidth * kHeight);
+        ASSERT_EQ(tjDecompress2(decompressor, jpeg.data(), jpeg.size(), image.data(), kWidth, 0, kHeight, TJPF_GRAY, 0),
+                  0);
+        double diff{0};  // mean absolute difference of luma
+        for (size_t i = 0; i < image.size(); ++i) {
+            diff += abs(image[i] - golden[i]);
+        }
+        EXPECT_LT(diff / image.size(), 2.0) << fmt::format("DCT method = {}", toString(method));
+    }
+    tjDestroy(decompressor);
+}
+
+// the ROI crop and binning give the same output with encoding the cropped and binned image, in all modes and
+// subsampling, and for both allocated and preallocated buffer
+TEST_F(YuyvJpegEncoderTest, CropAndBinning) {
+    constexpr int kWidth = 640, kHeight = 480;
+    auto yuyv = generate(kWidth, kHeight);
+    tjhandle decompressor = tjInitDecompress();
+    auto threadPool = make_shared<ThreadPool>(2);
+    for (int binning : {1, 2}) {
+        for (auto roi : {ImageRoi(), ImageRoi{100, 50, 0, 0}, ImageRoi{38, 7, 262, 133}}) {
+            EncodeGeometry geometry;
+            YuyvEncodeParams params;
+            params.roi = roi;
+            params.binning = binning;
+            ASSERT_TRUE(YuyvJpegEncoder::geometry(params, kWidth, kHeight, &geometry));
+            const int width = geometry.width, height = geometry.height;
+
+            // crop and bin the image with scalar code, then pack to YUYV
+            vector<unsigned char> binned(2 * width * height);
+            vector<unsigned char> y(width), u(width / 2), v(width / 2);
+            for (int i = 0; i < height; ++i) {
+                const int row = geometry.roi.y + i * binning;
+                const unsigned char* src = yuyv.data() + row * 2 * kWidth + 2 * geometry.roi.x;
+                if (binning == 2) {
+                    yuyvBin2x2Row(src, src + 2 * kWidth, 2 * width, y.data(), u.data(), v.data(), SimdLevel::Scalar);
+                } else {
+                    yuyvToYuv422pRow(src, width, y.data(), u.data(), v.data(), SimdLevel::Scalar);
+                }
+                for (int j = 0; j < width / 2; ++j) {
+                    unsigned char* dst = binned.data() + (i * width + 2 * j) * 2;
+                    dst[0] = y[2 * j];
+                    dst[1] = u[j];
+                    dst[2] = y[2 * j + 1];
+                    dst[3] = v[j];
+                }
+            }
+
+            for (auto subsampling : {JpegSubsampling::S422, JpegSubsampling::Gray}) {
+                string info = fmt::format("binning = {}, ROI = ({}, {}, {}, {}), subsampling = {}", binning, roi.x,
+                                          roi.y, roi.width, roi.height, toString(subsampling));
+                YuyvEncodeParams goldenParams;
+                goldenParams.subsampling = subsampling;
+                YuyvJpegEncoder goldenEncoder(goldenParams);
+                unsigned char* dest = nullptr;  // dest buffer
+                unsigned long destSize{0};      // dest size
+                ASSERT_TRUE(goldenEncoder.encode(binned.data(), width, height, 2 * width, &dest, &destSize));
+                vector<unsigned char> golden(dest, dest + destSize);
+                tjFree(dest);
+                dest = nullptr;
+
+                for (auto mode : {YuyvEncodeMode::Planar, YuyvEncodeMode::Direct, YuyvEncodeMode::Stripe}) {
+                    params.mode = mode;
+                    params.subsampling = subsampling;
+                    YuyvJpegEncoder encoder(params, threadPool);
+                    // encode into preallocated buffer, then into allocated buffer with the same encoder
+                    vector<unsigned char> buffer(YuyvJpegEncoder::bufferSize(kWidth, kHeight));
+                    unsigned long size{0};
+                    ASSERT_TRUE(encoder.encodeTo(yuyv.data(), kWidth, kHeight, 2 * kWidth, buffer.data(),
+                                                 buffer.size(), &size))
+                        << info;
+                    buffer.resize(size);
+                    ASSERT_TRUE(encoder.encode(yuyv.data(), kWidth, kHeight, 2 * kWidth, &dest, &destSize)) << info;
+                    vector<unsigned char> allocated(dest, dest + destSize);
+                    tjFree(dest);
+                    dest = nullptr;
+                    EXPECT_EQ(allocated, buffer) << info;
+
+                    if (mode != YuyvEncodeMode::Stripe) {
+                        EXPECT_EQ(buffer, golden) << info;
+                        continue;
+                    }
+                    // the stripe output is decoded to the same image
+                    vector<unsigned char> image(3 * width * height), goldenImage(3 * width * height);
+                    EXPECT_EQ(tjDecompress2(decompressor, buffer.data(), buffer.size(), image.data(), width, 0,
+                                            height, TJPF_RGB, 0),
+                              0);
+                    EXPECT_EQ(tjDecompress2(decompressor, golden.data(), golden.size(), goldenImage.data(), width, 0,
+                                            height, TJPF_RGB, 0),
+                              0);
+                    EXPECT_EQ(image, goldenImage) << info;
+                }
+            }
+        }
+    }
+    tjDestroy(decompressor);
+}
+
+// the geometry of encoded image gives the intrinsics after crop and binning, and the invalid ROI is rejected
+TEST_F(YuyvJpegEncoderTest, Geometry) {
+    YuyvEncodeParams params;
+    params.roi = ImageRoi{100, 50, 0, 0};
+    params.binning = 2;
+    EncodeGeometry geometry;
+    ASSERT_TRUE(YuyvJpegEncoder::geometry(params, 641, 481, &geometry));
+    EXPECT_EQ(geometry.roi.width, 540);
+    EXPECT_EQ(geometry.roi.height, 430);
+    EXPECT_EQ(geometry.width, 270);
+    EXPECT_EQ(geometry.height, 215);
+    // the center of the 2x2 pixels is the center of binned pixel
+    EXPECT_DOUBLE_EQ(geometry.scale * 100.5 + geometry.offsetX, 0);
+    EXPECT_DOUBLE_EQ(geometry.scale * 52.5 + geometry.offsetY, 1);
+    EXPECT_DOUBLE_EQ(geometry.scale * 300 + geometry.offsetX, 99.75);
+
+    // json
+    nlohmann::json j = geometry;
+    EncodeGeometry loaded = j.get<EncodeGeometry>();
+    EXPECT_EQ(loaded.roi.width, geometry.roi.width);
+    EXPECT_EQ(loaded.width, geometry.width);
+    EXPECT_EQ(loaded.height, geometry.height);
+    EXPECT_DOUBLE_EQ(loaded.offsetX, geometry.offsetX);
+    EXPECT_DOUBLE_EQ(loaded.offsetY, geometry.offsetY);
+
+    // invalid ROI or binning
+    vector<unsigned char> yuyv(2 * 64 * 32);
+    for (auto roi : {ImageRoi{1, 0, 0, 0}, ImageRoi{0, 0, 68, 0}, ImageRoi{0, 30, 0, 4}, ImageRoi{-2, 0, 0, 0}}) {
+        params.roi = roi;
+        EXPECT_FALSE(YuyvJpegEncoder::geometry(params, 64, 32, &geometry));
+        YuyvJpegEncoder encoder(params);
+        unsigned char* dest = nullptr;  // dest buffer
+        unsigned long destSize{0};      // dest size
+        EXPECT_FALSE(encoder.encode(yuyv.data(), 64, 32, 128, &dest, &destSize));
+        EXPECT_EQ(dest, nullptr);
+    }
+    params.roi = ImageRoi();
+    params.binning = 3;
+    EXPECT_FALSE(YuyvJpegEncoder::geometry(params, 64, 32, &geometry));
+}
+
+// compress the recorded image
+TEST_F(YuyvJpegEncoderTest, RecordedImage) {
+    int width = 1280;  // image width
+    int height = 720;  // image height
+    fstream fs("./data/yuyv.bin", ios::in | ios::binary);
+    if (!fs.is_open()) {
+        return;
+    }
+    vector<unsigned char> raw = vector<unsigned char>(istreambuf_iterator<char>(fs), {});
+    fs.close();
+
+    auto golden = compressWithTurboJpeg(raw, width, height, 2 * width, 95);
+    auto jpeg = compressWithEncoder(YuyvEncodeMode::Direct, raw, width, height, 2 * width, 95);
+    EXPECT_EQ(jpeg, golden);
+}
@@ -1,10 +1,18 @@
 #pragma once
+#include "util/BufferPool.h"
 #include "util/Constant.h"
 #include "util/EigenEx.hpp"
 #include "util/Heading.hpp"
 #include "util/JobQueue.hpp"
+#include "util/LatencyHistogram.h"
 #include "util/Misc.h"
+#include "util/MpmcQueue.hpp"
 #include "util/NullDeleter.hpp"
+#include "util/QueueStats.hpp"
 #include "util/Serialization.hpp"
+#include "util/SpscQueue.hpp"
+#include "util/Task.hpp"
 #include "util/Thread.h"
-#include "util/ThreadPool.h"
\ No newline at end of file
+#include "util/ThreadPool.h"
+#include "util/TraceRecorder.h"
+#include "util/YuyvConvert.h"
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+#include <memory>
+
+namespace libra {
+namespace util {
+
+/**
+ * @brief Thread safe pool of preallocated memory buffers with the same size.
+ *
+ * The buffer is leased as a shared pointer, and it will be returned to the pool automatically when the last owner drops
+ * it, so the buffer could be passed to other threads freely. The pool could be destroyed before all leased buffers are
+ * returned, the remaining buffers will be released when their last owner drops them.
+ *
+ * It's used to avoid allocating and page faulting a new buffer for each frame in the hot path, for example, the output
+ * buffer of JPEG compression.
+ */
+class BufferPool {
+  public:
+    /**
+     * @brief Constructor
+     * @param bufferSize    Buffer size in bytes
+     * @param maxFreeNum    Maximum number of free buffers kept in the pool, the extra returned buffers will be released
+     */
+    explicit BufferPool(std::size_t bufferSize = 0, std::size_t maxFreeNum = 8);
+
+    /**
+     * @brief Destructor
+     */
+    ~BufferPool() = default;
+
+  public:
+    /**
+     * @brief Get the buffer size
+     * @return Buffer size in bytes
+     */
+    std::size_t bufferSize() const;
+
+    /**
+     * @brief Get the number of free buffers in the pool
+     * @return Free buffer number
+     */
+    std::size_t freeNum() const;
+
+    /**
+     * @brief Get the total number of buffers allocated by this pool, used for statistics
+     * @return Total allocated buffer number
+     */
+    std::size_t allocatedNum() const;
+
+    /**
+     * @brief Set the buffer size. If the size is changed, all free buffers will be released and the leased buffers will
+     * be released instead of returned to pool
+     * @param bufferSize Buffer size in bytes
+     */
+    void setBufferSize(std::size_t bufferSize);
+
+    /**
+     * @brief Lease a buffer from pool, allocate a new one if there is no free buffer
+     * @return Buffer with `bufferSize()` bytes
+     */
+    std::shared_ptr<unsigned char> lease();
+
+    /**
+     * @brief Lease a buffer with at least the specified size, the buffer size of pool will be enlarged if it's smaller
+     * @param size  Minimum buffer size in bytes
+     * @return Buffer with the buffer size of pool when leasing, which isn't less than `size`
+     */
+    std::shared_ptr<unsigned char> lease(std::size_t size);
+
+  private:
+    struct Storage;                     // buffer storage, shared with leased buffers
+    std::shared_ptr<Storage> storage_;  // buffer storage
+};
+
+}  // namespace util
+}  // namespace libra
@@ -1,5 +1,6 @@
 #pragma once
 #include <Eigen/Core>
+#include <cstddef>
 
 namespace libra {
 namespace util {
@@ -9,9 +10,10 @@ namespace util {
  */
 class Constant {
   public:
-    static constexpr double kG{9.81};     //!< gravitational constant
-    static constexpr double kEps{1e-10};  //!< the minimum variable
-    static const Eigen::Vector3d kGVec;   //!< gravitational vector in ENU frame
+    static constexpr double kG{9.81};                 //!< gravitational constant
+    static constexpr double kEps{1e-10};              //!< the minimum variable
+    static const Eigen::Vector3d kGVec;               //!< gravitational vector in ENU frame
+    static constexpr std::size_t kCacheLineSize{64};  //!< cache line size, used to avoid false sharing
 };
 
 }  // namespace util
@@ -1,8 +1,12 @@
 #pragma once
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 #include <queue>
+#include <vector>
+#include "QueueStats.hpp"
+#include "TraceRecorder.h"
 
 namespace libra {
 namespace util {
@@ -21,7 +25,7 @@ class JobQueue {
       public:
         Job() : valid_(false) {}
         explicit Job(const T& data) : data_(data), valid_(true) {}
-        explicit Job(T&& data) : data_(data), valid_(true) {}
+        explicit Job(T&& data) : data_(std::move(data)), valid_(true) {}
 
       public:
         // check whether the data is valid
@@ -70,35 +74,77 @@ class JobQueue {
      *
      * @return  True if drop job data when queue if full, otherwise return false
      */
-    inline bool dropJob() const { return dropJob_; }
+    inline bool dropJob() const { return policy_ != OverflowPolicy::Block; }
 
     /**
-     * @brief Enable/disable drop job data when queue if full
+     * @brief Enable/disable drop job data when queue if full, the oldest job will be dropped if enabled
      *
      * @param drop  True for enable, false for disable
      */
     void enableDropJob(bool enable = true);
 
     /**
-     * @brief Push a new job to the queue, waits if the number of jobs is exceeded
+     * @brief Get the policy to push job when queue is full
+     * @return Overflow policy
+     */
+    inline OverflowPolicy overflowPolicy() const { return policy_; }
+
+    /**
+     * @brief Set the policy to push job when queue is full
+     * @param policy        Overflow policy
+     * @param keepEveryN    Keep one of every N new jobs, only used for `OverflowPolicy::KeepEveryNth`
+     */
+    void setOverflowPolicy(OverflowPolicy policy, std::size_t keepEveryN = 2);
+
+    /**
+     * @brief Get the statistics of queue, it's read from lock-free counters without taking the lock
+     * @return Queue statistics
+     */
+    inline QueueStats stats() const { return counter_.stats(); }
+
+    /**
+     * @brief Push a new job to the queue, waits or drops job according to the overflow policy if the number of jobs is
+     * exceeded
      * @param data New job data
-     * @return True if push success, false for push fail
+     * @return True if push success, false if the queue is stopped or the new job is dropped
      */
     bool push(const T& data);
 
     /**
-     * @brief Push a new job to the queue with move, waits if the number of jobs is exceeded
+     * @brief Push a new job to the queue with move, waits or drops job according to the overflow policy if the number
+     * of jobs is exceeded
      * @param data New job data
-     * @return True if push success, false for push fail
+     * @return True if push success, false if the queue is stopped or the new job is dropped
      */
     bool push(T&& data);
 
+    /**
+     * @brief Push a batch of jobs to the queue, waits if the number of jobs is exceeded. The lock is taken and the
+     * consumers are notified once per batch instead of per job
+     * @param first Iterator to the first job, use `std::make_move_iterator()` to move the jobs into queue
+     * @param last  Iterator after the last job
+     * @return The number of pushed jobs, it's less than the batch size if the queue is stopped or some jobs are dropped
+     */
+    template <typename Iterator>
+    std::size_t pushBatch(Iterator first, Iterator last);
+
     /**
      * @brief Pop a job from the queue, wait if there is no job in the queue
      * @return Job popped from the queue
      */
     Job pop();
 
+    /**
+     * @brief Pop at most `maxNum` jobs from the queue, wait until there is any job in the queue or timeout. The lock is
+     * taken and the producers are notified once per batch instead of per job
+     * @param jobs      Popped job data, it's cleared before pop
+     * @param maxNum    Maximum job numbers to pop
+     * @param timeout   Maximum time to wait if there is no job in the queue
+     * @return False if the queue is stopped, otherwise return true, and the jobs may be empty if timeout
+     */
+    bool popBatch(std::vector<T>& jobs, std::size_t maxNum,
+                  const std::chrono::microseconds& timeout = std::chrono::microseconds::max());
+
     /**
      * @brief Wait for all jobs to bo popped and then stop the queue
      */
@@ -114,15 +160,26 @@ class JobQueue {
      */
     void clear();
 
+  private:
+    /**
+     * @brief Push a new job to the queue with the lock taken, waits or drops job according to the overflow policy
+     * @return True if push success, false if the queue is stopped or the new job is dropped
+     */
+    template <typename U>
+    bool emplace(std::unique_lock<std::mutex>& lock, U&& data);
+
   private:
     std::size_t maxJobNums_;                  // maximum job numbers
-    bool dropJob_;                            // drop last job data if queue is full
+    OverflowPolicy policy_;                   // policy to push job when queue is full
+    std::size_t keepEveryN_;                  // keep one of every N new jobs when queue is full
+    std::size_t overflowNum_;                 // number of new jobs since the queue is full
     std::atomic<bool> stop_;                  // flag to indict whether to stop queue
     std::queue<T> jobs_;                      // job queue
     mutable std::mutex mutex_;                // mutex
     std::condition_variable pushCondition_;   // condition variable after push a jpb
     std::condition_variable popCondition_;    // condition variable after pop a job
     std::condition_variable emptyCondition_;  // condition variable when jos queue is empty
+    QueueCounter counter_;                    // lock-free counters
 };
 
 }  // namespace util
@@ -0,0 +1,119 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+
+namespace libra {
+namespace util {
+
+/**
+ * @brief Statistics of latency histogram, the unit is ns
+ */
+struct LatencyStats {
+    std::uint64_t count = 0;  //!< number of recorded values
+    double min = 0;           //!< minimum value
+    double max = 0;           //!< maximum value
+    double mean = 0;          //!< mean value
+    double p50 = 0;           //!< 50th percentile
+    double p90 = 0;           //!< 90th percentile
+    double p99 = 0;           //!< 99th percentile
+    double p999 = 0;          //!< 99.9th percentile
+
+    /**
+     * @brief Print latency statistics to output stream, in ms
+     * @param os    Output stream
+     * @param stats Latency statistics
+     * @return Output stream
+     */
+    friend std::ostream& operator<<(std::ostream& os, const LatencyStats& stats);
+};
+
+/**
+ * @brief Lock-free histogram of latency with the log-linear buckets like HDR histogram.
+ *
+ * The values less than 64 ns are recorded exactly, and the larger values are put in 32 linear sub-buckets of each power
+ * of 2, so the relative error of percentile is less than 1/32. The values larger than about 18 minutes are recorded in
+ * the last bucket. Each bucket is an atomic counter, so the histogram could be recorded by several threads without
+ * lock, and read at any time. The statistics read during recording may be slightly inconsistent, for example, the count
+ * is updated before the buckets.
+ */
+class LatencyHistogram {
+  public:
+    static constexpr int kSubBucketBits = 5;                   //!< bits of sub-bucket number
+    static constexpr int kSubBucketNum = 1 << kSubBucketBits;  //!< sub-bucket number of each power of 2
+    static constexpr int kMaxExponent = 40;                    //!< the maximum value is about 2^40 ns
+    //! total bucket number
+    static constexpr int kBucketNum = (kMaxExponent - kSubBucketBits + 2) * kSubBucketNum;
+
+  public:
+    /**
+     * @brief Constructor
+     */
+    LatencyHistogram();
+
+    /**
+     * @brief Destructor
+     */
+    ~LatencyHistogram() = default;
+
+    // non-copyable
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+  public:
+    /**
+     * @brief Record one value, the negative value is recorded as 0
+     * @param value Latency, ns
+     */
+    void record(std::int64_t value);
+
+    /**
+     * @brief Get the number of recorded values
+     * @return Recorded value number
+     */
+    inline std::uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get the value at percentile, which is the middle of bucket
+     * @param p Percentile, [0, 1]
+     * @return Value at percentile, 0 if there is no value, ns
+     */
+    double percentile(double p) const;
+
+    /**
+     * @brief Get the statistics of histogram
+     * @return Latency statistics
+     */
+    LatencyStats stats() const;
+
+    /**
+     * @brief Clear all recorded values, it shouldn't be called with `record()` at the same time
+     */
+    void reset();
+
+    /**
+     * @brief Get the bucket index of value
+     * @param value Latency, ns
+     * @return Bucket index
+     */
+    static int bucketIndex(std::int64_t value);
+
+    /**
+     * @brief Get the range of bucket
+     * @param index Bucket index
+     * @param lower Lower bound of bucket, included
+     * @param upper Upper bound of bucket, excluded
+     */
+    static void bucketRange(int index, std::int64_t* lower, std::int64_t* upper);
+
+  private:
+    std::array<std::atomic<std::uint64_t>, kBucketNum> buckets_;  // counter of each bucket
+    std::atomic<std::uint64_t> count_;                            // number of recorded values
+    std::atomic<std::uint64_t> sum_;                              // sum of recorded values
+    std::atomic<std::int64_t> min_;                               // minimum value
+    std::atomic<std::int64_t> max_;                               // maximum value
+};
+
+}  // namespace util
+}  // namespace libra
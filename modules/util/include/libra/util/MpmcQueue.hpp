@@ -0,0 +1,242 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "Constant.h"
+#include "JobQueue.hpp"
+#include "QueueStats.hpp"
+#include "TraceRecorder.h"
+
+namespace libra {
+namespace util {
+
+/**
+ * @brief Bounded lock-free job queue for multiple producers and multiple consumers, which has the same push/pop/stop
+ * semantics with `JobQueue`, and could be used to replace it when several threads contend on the queue, for example,
+ * the image queue shared by several image saver threads.
+ *
+ * The queue is based on the bounded MPMC queue of Dmitry Vyukov, each slot has a sequence number to indict whether it's
+ * ready to push or pop, so push and pop only need one CAS on the position. The job data is moved in and out of the
+ * queue, so move-only data is supported. When queue is full, the producer waits or drops job according to the overflow
+ * policy, the oldest job is popped and dropped by producer without any lock. Thread only parks on condition variable
+ * when it has to wait(empty or full).
+ *
+ * @tparam T Job data type, should be default constructable and movable
+ */
+template <typename T>
+class MpmcQueue {
+  public:
+    using Job = typename JobQueue<T>::Job;  // job data, the same with `JobQueue`
+
+  public:
+    /**
+     * @brief Constructor with maximum job numbers
+     * @param maxJobNums Maximum job numbers, it will be rounded up to power of 2
+     */
+    explicit MpmcQueue(const std::size_t& maxJobNums = 1024);
+
+    /**
+     * @brief Destructor, stop the job queue and exit
+     */
+    ~MpmcQueue();
+
+    // non-copyable
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+  public:
+    /**
+     * @brief Get the maximum job numbers
+     * @return Maximum job numbers
+     */
+    inline std::size_t capacity() const { return mask_ + 1; }
+
+    /**
+     * @brief Get the number of pushed but not popped jobs in the queue, it's approximate if other threads are pushing
+     * or popping
+     * @return The number of pushed but not popped jobs in the queue
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief Return whether the job queue is stopped
+     * @return True if the job queue is stopped, otherwise return false
+     */
+    inline bool isStop() const { return stop_; }
+
+    /**
+     * @brief Return whether to drop job data when queue is full
+     *
+     * @return  True if drop job data when queue if full, otherwise return false
+     */
+    inline bool dropJob() const { return policy_ != OverflowPolicy::Block; }
+
+    /**
+     * @brief Enable/disable drop job data when queue if full, the oldest job will be dropped if enabled
+     *
+     * @param drop  True for enable, false for disable
+     */
+    void enableDropJob(bool enable = true);
+
+    /**
+     * @brief Get the policy to push job when queue is full
+     * @return Overflow policy
+     */
+    inline OverflowPolicy overflowPolicy() const { return policy_; }
+
+    /**
+     * @brief Set the policy to push job when queue is full, it should be set before pushing jobs
+     * @param policy        Overflow policy
+     * @param keepEveryN    Keep one of every N new jobs, only used for `OverflowPolicy::KeepEveryNth`
+     */
+    void setOverflowPolicy(OverflowPolicy policy, std::size_t keepEveryN = 2);
+
+    /**
+     * @brief Get the statistics of queue
+     * @return Queue statistics
+     */
+    inline QueueStats stats() const { return counter_.stats(); }
+
+    /**
+     * @brief Push a new job to the queue, waits or drops job according to the overflow policy if the queue is full
+     * @param data New job data
+     * @return True if push success, false if the queue is stopped or the new job is dropped
+     */
+    bool push(const T& data);
+
+    /**
+     * @brief Push a new job to the queue with move, waits or drops job according to the overflow policy if the queue
+     * is full
+     * @param data New job data
+     * @return True if push success, false if the queue is stopped or the new job is dropped
+     */
+    bool push(T&& data);
+
+    /**
+     * @brief Try to push a new job to the queue without waiting
+     * @param data New job data, it's only moved if push success
+     * @return True if push success, false if the queue is full
+     */
+    bool tryPush(T&& data);
+
+    /**
+     * @brief Push a batch of jobs to the queue, waits or drops job according to the overflow policy if the queue is
+     * full. The consumers are notified once per batch
+     * @param first Iterator to the first job, use `std::make_move_iterator()` to move the jobs into queue
+     * @param last  Iterator after the last job
+     * @return The number of pushed jobs, it's less than the batch size if the queue is stopped or some jobs are dropped
+     */
+    template <typename Iterator>
+    std::size_t pushBatch(Iterator first, Iterator last);
+
+    /**
+     * @brief Pop a job from the queue, wait if there is no job in the queue
+     * @return Job popped from the queue
+     */
+    Job pop();
+
+    /**
+     * @brief Pop at most `maxNum` jobs from the queue, wait until there is any job in the queue or timeout. The
+     * producers are notified once per batch
+     * @param jobs      Popped job data, it's cleared before pop
+     * @param maxNum    Maximum job numbers to pop
+     * @param timeout   Maximum time to wait if there is no job in the queue
+     * @return False if the queue is stopped, otherwise return true, and the jobs may be empty if timeout
+     */
+    bool popBatch(std::vector<T>& jobs, std::size_t maxNum,
+                  const std::chrono::microseconds& timeout = std::chrono::microseconds::max());
+
+    /**
+     * @brief Try to pop a job from the queue without waiting
+     * @param data Job data popped from queue
+     * @return True if pop success, false if the queue is empty
+     */
+    bool tryPop(T& data);
+
+    /**
+     * @brief Wait for all jobs to bo popped
+     */
+    void wait();
+
+    /**
+     * @brief Stop the queue
+     */
+    void stop();
+
+    /**
+     * @brief Clear all pushed and not popped jobs from the queue
+     */
+    void clear();
+
+  private:
+    /**
+     * @brief Queue slot, include the sequence number and job data
+     */
+    struct Cell {
+        std::atomic<std::size_t> sequence;  // sequence number
+        T data;                             // job data
+    };
+
+    /**
+     * @brief Push a new job to the queue, waits or drops job according to the overflow policy if the queue is full. The
+     * job is forwarded into queue slot only if push success, and the consumers aren't notified
+     */
+    template <typename U>
+    bool enqueue(U&& data);
+
+    /**
+     * @brief Try to push a new job to the queue without waiting, the job is forwarded into queue slot only if success
+     */
+    template <typename U>
+    bool tryEnqueue(U&& data);
+
+    /**
+     * @brief Try to pop a job from the queue without waiting, and the producers aren't notified
+     */
+    bool tryDequeue(T& data);
+
+    /**
+     * @brief Wait until there is any job in the queue or timeout, return the popped job data
+     * @return False if the queue is stopped or timeout
+     */
+    bool waitDequeue(T& data, const std::chrono::microseconds& timeout);
+
+    /**
+     * @brief Notify the threads waiting for job
+     * @param num   The number of pushed jobs, only one thread is notified if it's 1
+     */
+    void notifyPush(std::size_t num);
+
+    /**
+     * @brief Notify the thread waiting for popping job
+     */
+    void notifyPop();
+
+  private:
+    alignas(Constant::kCacheLineSize) std::atomic<std::size_t> enqueuePos_;  // position to push next job
+    alignas(Constant::kCacheLineSize) std::atomic<std::size_t> dequeuePos_;  // position to pop next job
+
+    // shared and rarely changed
+    alignas(Constant::kCacheLineSize) std::unique_ptr<Cell[]> cells_;  // job slots
+    std::size_t mask_;                                                 // mask to get slot index
+    OverflowPolicy policy_;                                            // policy to push job when queue is full
+    std::size_t keepEveryN_;                                           // keep one of every N new jobs when full
+    std::atomic<bool> stop_;                                           // flag to indict whether to stop queue
+    std::atomic<std::size_t> overflowNum_;                             // number of new jobs since the queue is full
+    QueueCounter counter_;                                             // lock-free counters
+
+    // slow path to park the waiting thread
+    std::atomic<int> popWaiting_;            // number of threads waiting for new job
+    std::atomic<int> pushWaiting_;           // number of threads waiting for popping job(full or wait empty)
+    std::mutex mutex_;                       // mutex for condition variables
+    std::condition_variable pushCondition_;  // condition variable after push a job
+    std::condition_variable popCondition_;   // condition variable after pop a job
+};
+
+}  // namespace util
+}  // namespace libra
+
+#include "implementation/MpmcQueue.hpp"
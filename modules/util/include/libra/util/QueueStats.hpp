@@ -0,0 +1,111 @@
+#pragma once
+#include <fmt/format.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include "Constant.h"
+
+namespace libra {
+namespace util {
+
+/**
+ * @brief Policy to push job to a full queue
+ */
+enum class OverflowPolicy {
+    Block,         //!< wait until there is free slot in queue
+    DropOldest,    //!< drop the oldest job in queue, then push the new job
+    DropNewest,    //!< drop the new job
+    KeepEveryNth,  //!< keep one of every N new jobs by dropping the oldest job in queue, and drop the others
+};
+
+/**
+ * @brief Statistics of job queue
+ */
+struct QueueStats {
+    std::size_t pushNum = 0;        //!< number of pushed jobs
+    std::size_t popNum = 0;         //!< number of popped jobs
+    std::size_t dropNum = 0;        //!< number of dropped jobs, include the dropped new jobs and old jobs in queue
+    std::size_t highWaterMark = 0;  //!< maximum number of jobs in queue
+    double waitTime = 0;            //!< total time of producers waiting for free slot, s
+
+    /**
+     * @brief Print queue statistics to output stream
+     * @param os    Output stream
+     * @param stats Queue statistics
+     * @return Output stream
+     */
+    friend std::ostream& operator<<(std::ostream& os, const QueueStats& stats) {
+        os << fmt::format("push = {}, pop = {}, drop = {}, high water = {}, wait = {:.3f} s", stats.pushNum,
+                          stats.popNum, stats.dropNum, stats.highWaterMark, stats.waitTime);
+        return os;
+    }
+};
+
+/**
+ * @brief Lock-free counters of job queue, which could be read without taking the lock of queue. The counters updated by
+ * producers and consumers are in separated cache lines
+ */
+class QueueCounter {
+  public:
+    /**
+     * @brief Add pushed jobs
+     * @param num   Pushed job number
+     * @param size  Job number in queue after pushed, used to update the high-water mark
+     */
+    inline void addPush(std::size_t num, std::size_t size) {
+        pushNum_.fetch_add(num, std::memory_order_relaxed);
+        std::size_t highWaterMark = highWaterMark_.load(std::memory_order_relaxed);
+        while (size > highWaterMark &&
+               !highWaterMark_.compare_exchange_weak(highWaterMark, size, std::memory_order_relaxed)) {
+        }
+    }
+
+    /**
+     * @brief Add popped jobs
+     * @param num Popped job number
+     */
+    inline void addPop(std::size_t num) { popNum_.fetch_add(num, std::memory_order_relaxed); }
+
+    /**
+     * @brief Add dropped jobs
+     * @param num Dropped job number
+     */
+    inline void addDrop(std::size_t num) { dropNum_.fetch_add(num, std::memory_order_relaxed); }
+
+    /**
+     * @brief Add the time of producer waiting for free slot
+     * @param dt Wait time
+     */
+    inline void addWaitTime(const std::chrono::steady_clock::duration& dt) {
+        waitTime_.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(dt).count(),
+                            std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the statistics
+     * @return Queue statistics
+     */
+    inline QueueStats stats() const {
+        QueueStats stats;
+        stats.pushNum = pushNum_.load(std::memory_order_relaxed);
+        stats.popNum = popNum_.load(std::memory_order_relaxed);
+        stats.dropNum = dropNum_.load(std::memory_order_relaxed);
+        stats.highWaterMark = highWaterMark_.load(std::memory_order_relaxed);
+        stats.waitTime = waitTime_.load(std::memory_order_relaxed) * 1.0E-9;
+        return stats;
+    }
+
+  private:
+    // updated by producers
+    alignas(Constant::kCacheLineSize) std::atomic<std::size_t> pushNum_{0};  // number of pushed jobs
+    std::atomic<std::size_t> dropNum_{0};                                    // number of dropped jobs
+    std::atomic<std::size_t> highWaterMark_{0};                              // maximum number of jobs in queue
+    std::atomic<std::int64_t> waitTime_{0};                                  // total wait time of producers, ns
+
+    // updated by consumers
+    alignas(Constant::kCacheLineSize) std::atomic<std::size_t> popNum_{0};  // number of popped jobs
+};
+
+}  // namespace util
+}  // namespace libra
@@ -0,0 +1,212 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+#include "Constant.h"
+#include "JobQueue.hpp"
+#include "QueueStats.hpp"
+#include "TraceRecorder.h"
+
+namespace libra {
+namespace util {
+
+/**
+ * @brief Bounded lock-free job queue for single producer and single consumer, which has the same push/pop/stop
+ * semantics with `JobQueue` except the job dropped when the queue is full, and could be used to replace it in the path
+ * with exactly one producer and one consumer, for example, the IMU capture and saver thread.
+ *
+ * The push and pop don't take any lock if the queue isn't full or empty, they only touch the indices of the other side,
+ * which are padded in separated cache lines to avoid false sharing. The consumer(or the producer if the queue is full)
+ * only park on condition variable when it has to wait, and the other side only notifies it if it's waiting.
+ *
+ * @note Different from `JobQueue`, only `OverflowPolicy::Block` and `OverflowPolicy::DropNewest` are supported, and the
+ * incoming(newest) job is dropped if drop job is enabled, while `JobQueue` drops the oldest one. Only the consumer
+ * could remove job from the queue, dropping the oldest one in producer would race with the consumer reading the slot
+ *
+ * @tparam T Job data type, should be default constructable and movable
+ */
+template <typename T>
+class SpscQueue {
+  public:
+    using Job = typename JobQueue<T>::Job;  // job data, the same with `JobQueue`
+
+  public:
+    /**
+     * @brief Constructor with maximum job numbers
+     * @param maxJobNums Maximum job numbers, it will be rounded up to power of 2
+     */
+    explicit SpscQueue(const std::size_t& maxJobNums = 1024);
+
+    /**
+     * @brief Destructor, stop the job queue and exit
+     */
+    ~SpscQueue();
+
+    // non-copyable
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+  public:
+    /**
+     * @brief Get the maximum job numbers
+     * @return Maximum job numbers
+     */
+    inline std::size_t capacity() const { return jobs_.size(); }
+
+    /**
+     * @brief Get the number of pushed but not popped jobs in the queue
+     * @return The number of pushed but not popped jobs in the queue
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief Return whether the job queue is stopped
+     * @return True if the job queue is stopped, otherwise return false
+     */
+    inline bool isStop() const { return stop_; }
+
+    /**
+     * @brief Return whether to drop job data when queue is full
+     *
+     * @return  True if drop job data when queue if full, otherwise return false
+     */
+    inline bool dropJob() const { return policy_ != OverflowPolicy::Block; }
+
+    /**
+     * @brief Enable/disable drop job data when queue if full, the incoming(newest) job will be dropped if enabled,
+     * which is different from `JobQueue::enableDropJob()` dropping the oldest one
+     *
+     * @param drop  True for enable, false for disable
+     */
+    void enableDropJob(bool enable = true);
+
+    /**
+     * @brief Get the policy to push job when queue is full
+     * @return Overflow policy
+     */
+    inline OverflowPolicy overflowPolicy() const { return policy_; }
+
+    /**
+     * @brief Set the policy to push job when queue is full, should be `OverflowPolicy::Block` or
+     * `OverflowPolicy::DropNewest`
+     * @param policy Overflow policy
+     */
+    void setOverflowPolicy(OverflowPolicy policy);
+
+    /**
+     * @brief Get the statistics of queue
+     * @return Queue statistics
+     */
+    inline QueueStats stats() const { return counter_.stats(); }
+
+    /**
+     * @brief Push a new job to the queue, waits if the queue is full. Should be only called by producer thread
+     * @param data New job data
+     * @return True if push success, false if the queue is stopped or the job is dropped
+     */
+    bool push(const T& data);
+
+    /**
+     * @brief Push a new job to the queue with move, waits if the queue is full. Should be only called by producer
+     * thread
+     * @param data New job data
+     * @return True if push success, false if the queue is stopped or the job is dropped
+     */
+    bool push(T&& data);
+
+    /**
+     * @brief Push a batch of jobs to the queue, waits if the queue is full. The consumer is notified once per batch.
+     * Should be only called by producer thread
+     * @param first Iterator to the first job, use `std::make_move_iterator()` to move the jobs into queue
+     * @param last  Iterator after the last job
+     * @return The number of pushed jobs, it's less than the batch size if the queue is stopped or some jobs are dropped
+     */
+    template <typename Iterator>
+    std::size_t pushBatch(Iterator first, Iterator last);
+
+    /**
+     * @brief Pop a job from the queue, wait if there is no job in the queue. Should be only called by consumer thread
+     * @return Job popped from the queue
+     */
+    Job pop();
+
+    /**
+     * @brief Pop at most `maxNum` jobs from the queue, wait until there is any job in the queue or timeout. The producer
+     * is notified once per batch. Should be only called by consumer thread
+     * @param jobs      Popped job data, it's cleared before pop
+     * @param maxNum    Maximum job numbers to pop
+     * @param timeout   Maximum time to wait if there is no job in the queue
+     * @return False if the queue is stopped, otherwise return true, and the jobs may be empty if timeout
+     */
+    bool popBatch(std::vector<T>& jobs, std::size_t maxNum,
+                  const std::chrono::microseconds& timeout = std::chrono::microseconds::max());
+
+    /**
+     * @brief Wait for all jobs to bo popped
+     */
+    void wait();
+
+    /**
+     * @brief Stop the queue
+     */
+    void stop();
+
+    /**
+     * @brief Clear all pushed and not popped jobs from the queue. Should be only called by consumer thread, or when the
+     * consumer is stopped
+     */
+    void clear();
+
+  private:
+    /**
+     * @brief Push a new job to the queue, the job is forwarded into queue slot, and the consumer isn't notified
+     */
+    template <typename U>
+    bool enqueue(U&& data);
+
+    /**
+     * @brief Wait until there is any job in the queue or timeout
+     * @return False if the queue is still empty
+     */
+    bool waitNotEmpty(const std::chrono::microseconds& timeout);
+
+    /**
+     * @brief Notify the consumer if it's waiting for job
+     */
+    void notifyPush();
+
+    /**
+     * @brief Notify the threads waiting for popping job
+     */
+    void notifyPop();
+
+  private:
+    // producer side
+    alignas(Constant::kCacheLineSize) std::atomic<std::size_t> tail_;  // index to push next job
+    std::size_t cachedHead_;                                            // cached head index, only used by producer
+
+    // consumer side
+    alignas(Constant::kCacheLineSize) std::atomic<std::size_t> head_;  // index to pop next job
+    std::size_t cachedTail_;                                            // cached tail index, only used by consumer
+
+    // shared and rarely changed
+    alignas(Constant::kCacheLineSize) std::vector<T> jobs_;  // job slots
+    std::size_t mask_;                                       // mask to get slot index
+    OverflowPolicy policy_;                                  // policy to push job when queue is full
+    std::atomic<bool> stop_;                                 // flag to indict whether to stop queue
+    QueueCounter counter_;                                   // lock-free counters
+
+    // slow path to park the waiting thread
+    std::atomic<bool> popWaiting_;           // flag to indict whether consumer is waiting for new job
+    std::atomic<int> pushWaiting_;           // number of threads waiting for popping job(full or wait empty)
+    std::mutex mutex_;                       // mutex for condition variables
+    std::condition_variable pushCondition_;  // condition variable after push a job
+    std::condition_variable popCondition_;   // condition variable after pop a job
+};
+
+}  // namespace util
+}  // namespace libra
+
+#include "implementation/SpscQueue.hpp"
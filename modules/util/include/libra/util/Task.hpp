@@ -0,0 +1,121 @@
+#pragma once
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace libra {
+namespace util {
+
+/**
+ * @brief Move-only task with signature `void()`, used to store the task in thread pool.
+ *
+ * Different from `std::function`, the callable is stored in the inline buffer if it's small enough(lambda captures
+ * a few pointers or a `std::packaged_task`), so no heap allocation is needed to submit a task. The larger callable is
+ * allocated on heap. Move-only callable is supported.
+ */
+class Task {
+  public:
+    static constexpr std::size_t kBufferSize{48};  //!< inline buffer size, the callable larger than it is on heap
+
+  public:
+    /**
+     * @brief Default constructor, empty task
+     */
+    Task() = default;
+
+    /**
+     * @brief Construct task from callable
+     * @tparam F    Callable type, should be `void()` and movable
+     * @param f     Callable
+     */
+    template <typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, Task>::value &&
+                                                      std::is_invocable<std::decay_t<F>&>::value>>
+    Task(F&& f);
+
+    /**
+     * @brief Move constructor
+     */
+    Task(Task&& task) noexcept;
+
+    /**
+     * @brief Move assignment
+     */
+    Task& operator=(Task&& task) noexcept;
+
+    /**
+     * @brief Destructor
+     */
+    ~Task();
+
+    // non-copyable
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+  public:
+    /**
+     * @brief Return whether the task is empty
+     * @return True if task isn't empty
+     */
+    inline explicit operator bool() const { return ops_ != nullptr; }
+
+    /**
+     * @brief Return whether the callable is stored in the inline buffer
+     * @return True if the callable is stored in the inline buffer, false for heap or empty
+     */
+    inline bool isInline() const { return ops_ != nullptr && ops_->isInline; }
+
+    /**
+     * @brief Run the task
+     */
+    inline void operator()() { ops_->invoke(buffer_); }
+
+    /**
+     * @brief Reset to empty task, the callable is destroyed
+     */
+    void reset();
+
+  private:
+    /**
+     * @brief Operations for the stored callable
+     */
+    struct Ops {
+        void (*invoke)(void* buffer);        // invoke the callable
+        void (*move)(void* dst, void* src);  // move the callable to another buffer and destroy the source
+        void (*destroy)(void* buffer);       // destroy the callable
+        bool isInline;                       // whether the callable is stored in the inline buffer
+    };
+
+    /**
+     * @brief Operations for the callable stored in inline buffer
+     */
+    template <typename F>
+    struct InlineOps {
+        static void invoke(void* buffer) { (*static_cast<F*>(buffer))(); }
+        static void move(void* dst, void* src) {
+            new (dst) F(std::move(*static_cast<F*>(src)));
+            static_cast<F*>(src)->~F();
+        }
+        static void destroy(void* buffer) { static_cast<F*>(buffer)->~F(); }
+        static constexpr Ops kOps{invoke, move, destroy, true};
+    };
+
+    /**
+     * @brief Operations for the callable stored on heap, the inline buffer keeps the pointer
+     */
+    template <typename F>
+    struct HeapOps {
+        static void invoke(void* buffer) { (**static_cast<F**>(buffer))(); }
+        static void move(void* dst, void* src) { *static_cast<F**>(dst) = *static_cast<F**>(src); }
+        static void destroy(void* buffer) { delete *static_cast<F**>(buffer); }
+        static constexpr Ops kOps{invoke, move, destroy, false};
+    };
+
+  private:
+    alignas(std::max_align_t) unsigned char buffer_[kBufferSize];  // inline buffer for callable
+    const Ops* ops_{nullptr};                                       // operations for stored callable, null if empty
+};
+
+}  // namespace util
+}  // namespace libra
+
+#include "implementation/Task.hpp"
@@ -1,24 +1,31 @@
 #pragma once
+#include <atomic>
 #include <condition_variable>
 #include <functional>
 #include <future>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <thread>
 #include <vector>
+#include "Task.hpp"
 
 namespace libra {
 namespace util {
 
 /**
- * @brief Thread pool with server workers to do a mount of task
+ * @brief Thread pool with server workers to do a mount of task.
+ *
+ * Each worker has its own task queue, the task added by outside thread is distributed to workers in round robin, and
+ * the task added by worker thread is pushed to its own queue. The worker takes task from its own queue first, and
+ * steals from the other workers if its queue is empty, so the workers don't contend on one global lock to take task.
+ * Adding task only holds the global lock briefly to check the stop flag with pushing. The task is stored in `Task` with
+ * inline buffer, so `post()` a small closure doesn't need heap allocation.
  */
 class ThreadPool {
   public:
     /**
      * @brief Construct thread pool with thread number
-     * @param threadNum Thread number
+     * @param threadNum Thread number, should be larger than 0
      */
     explicit ThreadPool(const std::size_t& threadNum);
 
@@ -27,7 +34,17 @@ class ThreadPool {
      */
     ~ThreadPool();
 
+    // non-copyable
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
   public:
+    /**
+     * @brief Get the thread number
+     * @return Thread number
+     */
+    inline std::size_t threadNum() const { return workers_.size(); }
+
     /**
      * @brief Add task to thread pool
      * @tparam F    Task function/class type
@@ -39,6 +56,15 @@ class ThreadPool {
     template <class F, class... Args>
     auto addTask(F&& f, Args&&... args) -> std::future<std::result_of_t<F(Args...)>>;
 
+    /**
+     * @brief Add task to thread pool without returning result, it doesn't allocate memory if the task is small. The
+     * exception thrown by task is logged and ignored
+     * @tparam F    Task function/class type, should be `void()`
+     * @param f     Task function
+     */
+    template <class F>
+    void post(F&& f);
+
     /**
      * @brief Stop thread pool
      */
@@ -50,14 +76,41 @@ class ThreadPool {
     void wait();
 
   private:
-    std::vector<std::thread> workers_;         // work thread
-    std::queue<std::function<void()>> tasks_;  // task queue
+    /**
+     * @brief Add task to the queue of current worker if it's called from worker thread, otherwise add to the workers
+     * in round robin
+     * @param task  Task
+     */
+    void submit(Task&& task);
+
+    /**
+     * @brief Take task from own queue, or steal from other workers
+     * @param index Worker index
+     * @param task  Output task
+     * @return True if get task, otherwise return false
+     */
+    bool take(std::size_t index, Task& task);
+
+    /**
+     * @brief Worker thread function
+     * @param index Worker index
+     */
+    void work(std::size_t index);
+
+  private:
+    struct WorkQueue;  // task queue for each worker
+
+    std::vector<std::thread> workers_;                // work thread
+    std::vector<std::unique_ptr<WorkQueue>> queues_;  // task queue for each worker
+    std::atomic<std::size_t> nextQueue_;              // next queue to add task from outside thread
 
-    bool stop_;                                // stop flag
-    int activeWorkerNum_;                      // active worker numbers
-    std::mutex mutex_;                         // mutex for synchronization
+    std::atomic<bool> stop_;                   // stop flag
+    std::atomic<std::size_t> queuedNum_;       // number of tasks in queues
+    std::atomic<std::size_t> pendingNum_;      // number of tasks not finished, include queued and running tasks
+    std::atomic<int> idleWorkerNum_;           // number of idle workers waiting for task
+    std::mutex mutex_;                         // mutex for condition variables
     std::condition_variable taskCondition_;    // condition variable when new task added
-    std::condition_variable finishCondition_;  // condition variable when task is finished
+    std::condition_variable finishCondition_;  // condition variable when all tasks are finished
 };
 
 }  // namespace util
@@ -0,0 +1,193 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace libra {
+namespace util {
+
+/**
+ * @brief Recorder of the timeline of threads, which could be dumped as Chrome trace JSON file and viewed in
+ * `chrome://tracing` or Perfetto UI.
+ *
+ * Each thread records the spans into its own ring buffer, which is created when the thread records the first span, so
+ * the threads don't contend with each other, and only the latest events are kept if the buffer is full. The recorder
+ * is disabled by default, then each trace point only loads one atomic flag. The trace points are placed by
+ * `LIBRA_TRACE_SCOPE()`, which is compiled only if `WITH_TRACE` is defined.
+ */
+class TraceRecorder {
+  public:
+    /**
+     * @brief Span of one thread
+     */
+    struct Event {
+        const char* name = nullptr;  //!< span name, should be string literal
+        std::int64_t start = 0;      //!< start time of steady clock, ns
+        std::int64_t duration = 0;   //!< duration, ns
+    };
+
+  private:
+    /**
+     * @brief Constructor
+     */
+    TraceRecorder();
+
+  public:
+    /**
+     * @brief Destructor
+     */
+    ~TraceRecorder();
+
+    // non-copyable
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+  public:
+    /**
+     * @brief Get the global trace recorder
+     * @return Trace recorder
+     */
+    static TraceRecorder& instance();
+
+    /**
+     * @brief Check whether the recorder is enabled
+     * @return True if enabled
+     */
+    inline bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Enable or disable the recorder
+     * @param enabled True to enable
+     */
+    inline void setEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+
+    /**
+     * @brief Get the event capacity of the ring buffer of each thread
+     * @return Event capacity
+     */
+    std::size_t capacity() const;
+
+    /**
+     * @brief Set the event capacity of the ring buffer of each thread, it's only applied to the threads which don't
+     * record any span yet
+     * @param capacity Event capacity, should be larger than 0
+     */
+    void setCapacity(std::size_t capacity);
+
+    /**
+     * @brief Set the name of current thread which is shown in the timeline, it doesn't create the buffer of thread
+     * @param name Thread name
+     */
+    void setThreadName(const std::string& name);
+
+    /**
+     * @brief Record one span of current thread
+     *
+     * @param name      Span name, should be string literal because only the pointer is kept
+     * @param start     Start time of steady clock, ns
+     * @param duration  Duration, ns
+     */
+    void record(const char* name, std::int64_t start, std::int64_t duration);
+
+    /**
+     * @brief Get the number of kept events of all threads
+     * @return Event number
+     */
+    std::size_t eventNum() const;
+
+    /**
+     * @brief Clear all the events, and release the buffers of exited threads
+     */
+    void clear();
+
+    /**
+     * @brief Export all the events as Chrome trace JSON
+     * @return JSON string
+     */
+    std::string toJson() const;
+
+    /**
+     * @brief Save all the events to Chrome trace JSON file
+     * @param file  JSON file
+     * @return True if success
+     */
+    bool save(const std::string& file) const;
+
+    /**
+     * @brief Get the current time of steady clock
+     * @return Current time, ns
+     */
+    static inline std::int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+  private:
+    struct ThreadBuffer;  // ring buffer of events for each thread
+
+    /**
+     * @brief Get the buffer handle of current thread, it's empty before the thread records the first span
+     */
+    static std::shared_ptr<ThreadBuffer>& currentBuffer();
+
+    /**
+     * @brief Get the buffer of current thread, create it if not exist
+     */
+    ThreadBuffer& threadBuffer();
+
+  private:
+    std::atomic<bool> enabled_;                           // the recorder is enabled or not
+    std::size_t capacity_;                                // event capacity of each thread
+    mutable std::mutex mutex_;                            // mutex for buffer list
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;  // buffers of all threads
+    int nextThreadId_;                                    // thread ID for next buffer
+};
+
+/**
+ * @brief Record the span from construction to destruction if the trace recorder is enabled
+ */
+class TraceScope {
+  public:
+    /**
+     * @brief Constructor, start the span
+     * @param name Span name, should be string literal
+     */
+    explicit TraceScope(const char* name)
+        : name_(TraceRecorder::instance().isEnabled() ? name : nullptr), start_(name_ ? TraceRecorder::now() : 0) {}
+
+    /**
+     * @brief Destructor, end the span
+     */
+    ~TraceScope() {
+        if (name_) {
+            TraceRecorder::instance().record(name_, start_, TraceRecorder::now() - start_);
+        }
+    }
+
+    // non-copyable
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+  private:
+    const char* name_;    // span name, null if recorder is disabled
+    std::int64_t start_;  // start time, ns
+};
+
+}  // namespace util
+}  // namespace libra
+
+#if defined(WITH_TRACE)
+#define LIBRA_TRACE_CONCAT_IMPL(a, b) a##b
+#define LIBRA_TRACE_CONCAT(a, b) LIBRA_TRACE_CONCAT_IMPL(a, b)
+// record the span of current scope
+#define LIBRA_TRACE_SCOPE(name) libra::util::TraceScope LIBRA_TRACE_CONCAT(libraTraceScope, __LINE__)(name)
+// set the name of current thread
+#define LIBRA_TRACE_THREAD(name) libra::util::TraceRecorder::instance().setThreadName(name)
+#else
+#define LIBRA_TRACE_SCOPE(name)
+#define LIBRA_TRACE_THREAD(name)
+#endif
@@ -0,0 +1,115 @@
+#pragma once
+#include <string>
+
+namespace libra {
+namespace util {
+
+/**
+ * @brief SIMD instruction set used by the image conversion kernels
+ */
+enum class SimdLevel {
+    Scalar,  //!< plain C++ code, always supported
+    SSE2,    //!< x86 SSE2
+    AVX2,    //!< x86 AVX2
+    NEON,    //!< ARM NEON
+};
+
+/**
+ * @brief Get the name of SIMD level
+ * @param level SIMD level
+ * @return Name of SIMD level
+ */
+std::string toString(SimdLevel level);
+
+/**
+ * @brief Check whether the SIMD level is supported by current build and CPU
+ * @param level SIMD level
+ * @return True if supported, otherwise return false
+ */
+bool isSimdSupported(SimdLevel level);
+
+/**
+ * @brief Get the best SIMD level supported by current build and CPU, it's detected once at runtime
+ * @return The best SIMD level
+ */
+SimdLevel bestSimdLevel();
+
+/**
+ * @brief Convert one row of YUYV(YUV422 Packed) to YUV422 Planar using the best SIMD level
+ * @param yuyv  YUYV row, 2 * width bytes
+ * @param width Pixel number of this row, should be even
+ * @param y     Output Y row, width bytes
+ * @param u     Output U row, width / 2 bytes
+ * @param v     Output V row, width / 2 bytes
+ */
+void yuyvToYuv422pRow(const unsigned char* yuyv, int width, unsigned char* y, unsigned char* u, unsigned char* v);
+
+/**
+ * @brief Convert one row of YUYV(YUV422 Packed) to YUV422 Planar using specified SIMD level
+ * @param yuyv  YUYV row, 2 * width bytes
+ * @param width Pixel number of this row, should be even
+ * @param y     Output Y row, width bytes
+ * @param u     Output U row, width / 2 bytes
+ * @param v     Output V row, width / 2 bytes
+ * @param level SIMD level, it will fall back to scalar code if it's not supported
+ */
+void yuyvToYuv422pRow(const unsigned char* yuyv, int width, unsigned char* y, unsigned char* u, unsigned char* v,
+                      SimdLevel level);
+
+/**
+ * @brief Convert YUYV(YUV422 Packed) image to YUV422 Planar image using the best SIMD level.
+ *
+ * The output planes are stored continuously(Y, U, V) without row padding, which is the input format of
+ * `tjCompressFromYUV(..., pad = 1, ..., TJSAMP_422, ...)`
+ *
+ * @param yuyv      YUYV image
+ * @param width     Image width, should be even
+ * @param height    Image height
+ * @param stride    Row stride of YUYV image in bytes, could be larger than 2 * width to convert only the left part of
+ * a side-by-side stereo image
+ * @param yuv       Output YUV422 Planar buffer, 2 * width * height bytes
+ */
+void yuyvToYuv422p(const unsigned char* yuyv, int width, int height, int stride, unsigned char* yuv);
+
+/**
+ * @brief Convert YUYV(YUV422 Packed) image to YUV422 Planar image using specified SIMD level
+ * @param yuyv      YUYV image
+ * @param width     Image width, should be even
+ * @param height    Image height
+ * @param stride    Row stride of YUYV image in bytes
+ * @param yuv       Output YUV422 Planar buffer, 2 * width * height bytes
+ * @param level     SIMD level, it will fall back to scalar code if it's not supported
+ */
+void yuyvToYuv422p(const unsigned char* yuyv, int width, int height, int stride, unsigned char* yuv,
+                   SimdLevel level);
+
+/**
+ * @brief Bin two rows of YUYV(YUV422 Packed) image by 2x2 and convert to one row of YUV422 Planar using the best SIMD
+ * level. Each output sample is the rounded average of 4 input samples, i.e., the Y of 2x2 pixels, and the U or V of
+ * 2x2 macro pixels which cover 4x2 pixels, so the output is still YUV422
+ * @param row0  The first YUYV row, 2 * width bytes
+ * @param row1  The second YUYV row, 2 * width bytes
+ * @param width Pixel number of input row, should be multiple of 4
+ * @param y     Output Y row, width / 2 bytes
+ * @param u     Output U row, width / 4 bytes, only the Y row is output if it's null
+ * @param v     Output V row, width / 4 bytes, only the Y row is output if it's null
+ */
+void yuyvBin2x2Row(const unsigned char* row0, const unsigned char* row1, int width, unsigned char* y, unsigned char* u,
+                   unsigned char* v);
+
+/**
+ * @brief Bin two rows of YUYV(YUV422 Packed) image by 2x2 and convert to one row of YUV422 Planar using specified SIMD
+ * level
+ * @param row0  The first YUYV row, 2 * width bytes
+ * @param row1  The second YUYV row, 2 * width bytes
+ * @param width Pixel number of input row, should be multiple of 4
+ * @param y     Output Y row, width / 2 bytes
+ * @param u     Output U row, width / 4 bytes, only the Y row is output if it's null
+ * @param v     Output V row, width / 4 bytes, only the Y row is output if it's null
+ * @param level SIMD level, it will fall back to scalar code if it's not supported
+ */
+void yuyvBin2x2Row(const unsigned char* row0, const unsigned char* row1, int width, unsigned char* y, unsigned char* u,
+                   unsigned char* v, SimdLevel level);
+
+}  // namespace util
+}  // namespace libra
@@ -9,7 +9,8 @@ JobQueue<T>::JobQueue() : JobQueue(std::numeric_limits<std::size_t>::max()) {}
 
 // Constructor with maximum job numbers
 template <typename T>
-JobQueue<T>::JobQueue(const std::size_t& maxJobNums) : maxJobNums_(maxJobNums), dropJob_(false), stop_(false) {}
+JobQueue<T>::JobQueue(const std::size_t& maxJobNums)
+    : maxJobNums_(maxJobNums), policy_(OverflowPolicy::Block), keepEveryN_(1), overflowNum_(0), stop_(false) {}
 
 // Destructor, stop all job queue and exit
 template <typename T>
@@ -27,66 +28,81 @@ std::size_t JobQueue<T>::size() const {
 // Enable/disable drop job data when queue if full
 template <typename T>
 void JobQueue<T>::enableDropJob(bool enable) {
-    dropJob_ = enable;
+    setOverflowPolicy(enable ? OverflowPolicy::DropOldest : OverflowPolicy::Block);
 }
 
-// Push a new job to the queue, waits if the number of jobs is exceeded
+// Set the policy to push job when queue is full
 template <typename T>
-bool JobQueue<T>::push(const T& data) {
+void JobQueue<T>::setOverflowPolicy(OverflowPolicy policy, std::size_t keepEveryN) {
+    CHECK_GT(keepEveryN, 0) << "keep every N should be larger than 0";
     std::unique_lock<std::mutex> lock(mutex_);
-    while (jobs_.size() >= maxJobNums_ && !stop_) {
-        LOG(WARNING) << "queue is full";
-        if (dropJob_) {
-            jobs_.pop();
-        } else {
-            popCondition_.wait(lock);
-        }
-    }
+    policy_ = policy;
+    keepEveryN_ = keepEveryN;
+    overflowNum_ = 0;
+}
 
-    if (stop_) {
+// Push a new job to the queue, waits or drops job according to the overflow policy if the number of jobs is exceeded
+template <typename T>
+bool JobQueue<T>::push(const T& data) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!emplace(lock, data)) {
         return false;
-    } else {
-        jobs_.emplace(data);
-        pushCondition_.notify_one();
-        return true;
     }
+    pushCondition_.notify_one();
+    return true;
 }
 
-// Push a new job to the queue with move, waits if the number of jobs is exceeded
+// Push a new job to the queue with move, waits or drops job according to the overflow policy if the number of jobs is
+// exceeded
 template <typename T>
 bool JobQueue<T>::push(T&& data) {
     std::unique_lock<std::mutex> lock(mutex_);
-    while (jobs_.size() >= maxJobNums_ && !stop_) {
-        LOG(WARNING) << "queue is full";
-        if (dropJob_) {
-            jobs_.pop();
-        } else {
-            popCondition_.wait(lock);
+    if (!emplace(lock, std::move(data))) {
+        return false;
+    }
+    pushCondition_.notify_one();
+    return true;
+}
+
+// Push a batch of jobs to the queue, waits if the number of jobs is exceeded
+template <typename T>
+template <typename Iterator>
+std::size_t JobQueue<T>::pushBatch(Iterator first, Iterator last) {
+    std::size_t num{0};
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (; first != last && !stop_; ++first) {
+            if (emplace(lock, *first)) {
+                ++num;
+            }
         }
     }
 
-    if (stop_) {
-        return false;
-    } else {
-        jobs_.emplace(std::move(data));
+    if (num == 1) {
         pushCondition_.notify_one();
-        return true;
+    } else if (num > 1) {
+        pushCondition_.notify_all();
     }
+    return num;
 }
 
 // Pop a job from the queue, wait if there is no job in the queue
 template <typename T>
 typename JobQueue<T>::Job JobQueue<T>::pop() {
     std::unique_lock<std::mutex> lock(mutex_);
-    while (jobs_.empty() && !stop_) {
-        pushCondition_.wait(lock);
+    if (jobs_.empty() && !stop_) {
+        LIBRA_TRACE_SCOPE("JobQueue::waitPop");
+        while (jobs_.empty() && !stop_) {
+            pushCondition_.wait(lock);
+        }
     }
 
     if (stop_) {
         return Job();
     } else {
-        Job job(jobs_.front());
+        Job job(std::move(jobs_.front()));
         jobs_.pop();
+        counter_.addPop(1);
         popCondition_.notify_one();
         if (jobs_.empty()) {
             emptyCondition_.notify_all();
@@ -95,6 +111,42 @@ typename JobQueue<T>::Job JobQueue<T>::pop() {
     }
 }
 
+// Pop at most `maxNum` jobs from the queue, wait until there is any job in the queue or timeout
+template <typename T>
+bool JobQueue<T>::popBatch(std::vector<T>& jobs, std::size_t maxNum, const std::chrono::microseconds& timeout) {
+    jobs.clear();
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (timeout == std::chrono::microseconds::max()) {
+        while (jobs_.empty() && !stop_) {
+            pushCondition_.wait(lock);
+        }
+    } else {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (jobs_.empty() && !stop_) {
+            if (pushCondition_.wait_until(lock, deadline) == std::cv_status::timeout) {
+                break;
+            }
+        }
+    }
+
+    if (stop_) {
+        return false;
+    }
+
+    while (!jobs_.empty() && jobs.size() < maxNum) {
+        jobs.emplace_back(std::move(jobs_.front()));
+        jobs_.pop();
+    }
+    if (!jobs.empty()) {
+        counter_.addPop(jobs.size());
+        popCondition_.notify_all();
+        if (jobs_.empty()) {
+            emptyCondition_.notify_all();
+        }
+    }
+    return true;
+}
+
 // Wait for all jobs to bo popped and then stop the queue
 template <typename T>
 void JobQueue<T>::wait() {
@@ -116,9 +168,54 @@ void JobQueue<T>::stop() {
 template <typename T>
 void JobQueue<T>::clear() {
     std::unique_lock<std::mutex> lock(mutex_);
+    counter_.addDrop(jobs_.size());
     std::queue<T> emptyJobs;
     std::swap(jobs_, emptyJobs);
 }
 
+// Push a new job to the queue with the lock taken, waits or drops job according to the overflow policy
+template <typename T>
+template <typename U>
+bool JobQueue<T>::emplace(std::unique_lock<std::mutex>& lock, U&& data) {
+    if (jobs_.size() < maxJobNums_) {
+        overflowNum_ = 0;
+    } else if (!stop_) {
+        switch (policy_) {
+            case OverflowPolicy::Block: {
+                // notify consumers before waiting, the pushed jobs in batch may not be notified yet
+                LIBRA_TRACE_SCOPE("JobQueue::waitPush");
+                auto t0 = std::chrono::steady_clock::now();
+                pushCondition_.notify_all();
+                while (jobs_.size() >= maxJobNums_ && !stop_) {
+                    popCondition_.wait(lock);
+                }
+                counter_.addWaitTime(std::chrono::steady_clock::now() - t0);
+                break;
+            }
+            case OverflowPolicy::DropOldest:
+                jobs_.pop();
+                counter_.addDrop(1);
+                break;
+            case OverflowPolicy::DropNewest:
+                counter_.addDrop(1);
+                return false;
+            case OverflowPolicy::KeepEveryNth:
+                counter_.addDrop(1);
+                if (overflowNum_++ % keepEveryN_ != 0) {
+                    return false;
+                }
+                jobs_.pop();
+                break;
+        }
+    }
+
+    if (stop_) {
+        return false;
+    }
+    jobs_.emplace(std::forward<U>(data));
+    counter_.addPush(1, jobs_.size());
+    return true;
+}
+
 }  // namespace util
-}  // namespace libra
\ No newline at end of file
+}  // namespace libra
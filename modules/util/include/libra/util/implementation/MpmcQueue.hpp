@@ -0,0 +1,355 @@
+#include <glog/logging.h>
+#include <cstdint>
+#include <thread>
+
+namespace libra {
+namespace util {
+
+// Constructor with maximum job numbers
+template <typename T>
+MpmcQueue<T>::MpmcQueue(const std::size_t& maxJobNums)
+    : enqueuePos_(0),
+      dequeuePos_(0),
+      policy_(OverflowPolicy::Block),
+      keepEveryN_(1),
+      stop_(false),
+      overflowNum_(0),
+      popWaiting_(0),
+      pushWaiting_(0) {
+    std::size_t capacity{2};
+    while (capacity < maxJobNums) {
+        capacity <<= 1;
+    }
+    cells_.reset(new Cell[capacity]);
+    for (std::size_t i = 0; i < capacity; ++i) {
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    mask_ = capacity - 1;
+}
+
+// Destructor, stop the job queue and exit
+template <typename T>
+MpmcQueue<T>::~MpmcQueue() {
+    stop();
+}
+
+// Get the number of pushed but not popped jobs in the queue
+template <typename T>
+std::size_t MpmcQueue<T>::size() const {
+    // load dequeue position first, so the enqueue position is always not less than it
+    std::size_t dequeuePos = dequeuePos_.load();
+    std::size_t enqueuePos = enqueuePos_.load();
+    return enqueuePos - dequeuePos;
+}
+
+// Enable/disable drop job data when queue if full
+template <typename T>
+void MpmcQueue<T>::enableDropJob(bool enable) {
+    setOverflowPolicy(enable ? OverflowPolicy::DropOldest : OverflowPolicy::Block);
+}
+
+// Set the policy to push job when queue is full
+template <typename T>
+void MpmcQueue<T>::setOverflowPolicy(OverflowPolicy policy, std::size_t keepEveryN) {
+    CHECK_GT(keepEveryN, 0) << "keep every N should be larger than 0";
+    policy_ = policy;
+    keepEveryN_ = keepEveryN;
+    overflowNum_.store(0, std::memory_order_relaxed);
+}
+
+// Push a new job to the queue, waits or drops job according to the overflow policy if the queue is full
+template <typename T>
+bool MpmcQueue<T>::push(const T& data) {
+    if (!enqueue(data)) {
+        return false;
+    }
+    notifyPush(1);
+    return true;
+}
+
+// Push a new job to the queue with move, waits or drops job according to the overflow policy if the queue is full
+template <typename T>
+bool MpmcQueue<T>::push(T&& data) {
+    if (!enqueue(std::move(data))) {
+        return false;
+    }
+    notifyPush(1);
+    return true;
+}
+
+// Try to push a new job to the queue without waiting
+template <typename T>
+bool MpmcQueue<T>::tryPush(T&& data) {
+    if (stop_ || !tryEnqueue(std::move(data))) {
+        return false;
+    }
+    counter_.addPush(1, size());
+    notifyPush(1);
+    return true;
+}
+
+// Push a batch of jobs to the queue, waits or drops job according to the overflow policy if the queue is full
+template <typename T>
+template <typename Iterator>
+std::size_t MpmcQueue<T>::pushBatch(Iterator first, Iterator last) {
+    std::size_t num{0};
+    for (; first != last && !stop_; ++first) {
+        if (enqueue(*first)) {
+            ++num;
+        }
+    }
+    if (num > 0) {
+        notifyPush(num);
+    }
+    return num;
+}
+
+// Pop a job from the queue, wait if there is no job in the queue
+template <typename T>
+typename MpmcQueue<T>::Job MpmcQueue<T>::pop() {
+    T data;
+    if (!waitDequeue(data, std::chrono::microseconds::max())) {
+        return Job();
+    }
+    counter_.addPop(1);
+    notifyPop();
+    return Job(std::move(data));
+}
+
+// Pop at most `maxNum` jobs from the queue, wait until there is any job in the queue or timeout
+template <typename T>
+bool MpmcQueue<T>::popBatch(std::vector<T>& jobs, std::size_t maxNum, const std::chrono::microseconds& timeout) {
+    jobs.clear();
+    if (maxNum == 0) {
+        return !stop_;
+    }
+
+    T data;
+    if (!waitDequeue(data, timeout)) {
+        return !stop_;
+    }
+    jobs.emplace_back(std::move(data));
+    while (jobs.size() < maxNum && tryDequeue(data)) {
+        jobs.emplace_back(std::move(data));
+    }
+    counter_.addPop(jobs.size());
+    notifyPop();
+    return true;
+}
+
+// Try to pop a job from the queue without waiting
+template <typename T>
+bool MpmcQueue<T>::tryPop(T& data) {
+    if (!tryDequeue(data)) {
+        return false;
+    }
+    counter_.addPop(1);
+    notifyPop();
+    return true;
+}
+
+// Wait for all jobs to bo popped
+template <typename T>
+void MpmcQueue<T>::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    pushWaiting_.fetch_add(1);
+    while (!stop_ && size() != 0) {
+        popCondition_.wait(lock);
+    }
+    pushWaiting_.fetch_sub(1);
+}
+
+// Stop the queue
+template <typename T>
+void MpmcQueue<T>::stop() {
+    stop_ = true;
+    // lock to avoid the waiting thread miss the notification
+    std::lock_guard<std::mutex> lock(mutex_);
+    pushCondition_.notify_all();
+    popCondition_.notify_all();
+}
+
+// Clear all pushed and not popped jobs from the queue
+template <typename T>
+void MpmcQueue<T>::clear() {
+    T data;
+    while (tryDequeue(data)) {
+        counter_.addDrop(1);
+    }
+    notifyPop();
+}
+
+// Push a new job to the queue, waits or drops job according to the overflow policy if the queue is full
+template <typename T>
+template <typename U>
+bool MpmcQueue<T>::enqueue(U&& data) {
+    bool overflow{false};  // whether the queue has been full for this job
+    while (!stop_) {
+        // the data is only forwarded if success, so it's safe to forward it again in the loop
+        if (tryEnqueue(std::forward<U>(data))) {
+            if (!overflow && overflowNum_.load(std::memory_order_relaxed) != 0) {
+                overflowNum_.store(0, std::memory_order_relaxed);
+            }
+            counter_.addPush(1, size());
+            return true;
+        }
+
+        // the queue is full, drop job according to policy or wait consumer to pop
+        if (policy_ == OverflowPolicy::DropNewest) {
+            counter_.addDrop(1);
+            return false;
+        }
+        if (policy_ == OverflowPolicy::KeepEveryNth && !overflow &&
+            overflowNum_.fetch_add(1, std::memory_order_relaxed) % keepEveryN_ != 0) {
+            counter_.addDrop(1);
+            return false;
+        }
+        overflow = true;
+        if (policy_ != OverflowPolicy::Block) {
+            T dropped;
+            if (tryDequeue(dropped)) {
+                counter_.addDrop(1);
+            }
+            continue;
+        }
+
+        // some consumer is reading the job, wait it to finish
+        if (size() < capacity()) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // notify consumers before waiting, the previous jobs in batch may not be notified
+        notifyPush(capacity());
+        LIBRA_TRACE_SCOPE("MpmcQueue::waitPush");
+        auto t0 = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(mutex_);
+        pushWaiting_.fetch_add(1);
+        while (!stop_ && size() >= capacity()) {
+            popCondition_.wait(lock);
+        }
+        pushWaiting_.fetch_sub(1);
+        counter_.addWaitTime(std::chrono::steady_clock::now() - t0);
+    }
+    return false;
+}
+
+// Try to push a new job to the queue without waiting, the job is forwarded into queue slot only if success
+template <typename T>
+template <typename U>
+bool MpmcQueue<T>::tryEnqueue(U&& data) {
+    Cell* cell{nullptr};
+    std::size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+    while (true) {
+        cell = &cells_[pos & mask_];
+        std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        std::intptr_t diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // full
+            return false;
+        } else {
+            pos = enqueuePos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->data = std::forward<U>(data);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+// Try to pop a job from the queue without waiting, and the producers aren't notified
+template <typename T>
+bool MpmcQueue<T>::tryDequeue(T& data) {
+    Cell* cell{nullptr};
+    std::size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+    while (true) {
+        cell = &cells_[pos & mask_];
+        std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        std::intptr_t diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos + 1);
+        if (diff == 0) {
+            if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // empty
+            return false;
+        } else {
+            pos = dequeuePos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    data = std::move(cell->data);
+    cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+    return true;
+}
+
+// Wait until there is any job in the queue or timeout, return the popped job data
+template <typename T>
+bool MpmcQueue<T>::waitDequeue(T& data, const std::chrono::microseconds& timeout) {
+    const bool forever = timeout == std::chrono::microseconds::max();
+    const auto deadline = forever ? std::chrono::steady_clock::time_point::max()
+                                  : std::chrono::steady_clock::now() + timeout;
+    while (!stop_) {
+        if (tryDequeue(data)) {
+            return true;
+        }
+
+        // some producer is writing the job, wait it to finish unless timeout
+        if (size() != 0) {
+            if (!forever && std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+            std::this_thread::yield();
+            continue;
+        }
+
+        // the queue is empty, park on condition variable until producer notify
+        LIBRA_TRACE_SCOPE("MpmcQueue::waitPop");
+        std::unique_lock<std::mutex> lock(mutex_);
+        popWaiting_.fetch_add(1);
+        bool expired{false};
+        while (!stop_ && size() == 0 && !expired) {
+            if (forever) {
+                pushCondition_.wait(lock);
+            } else {
+                expired = pushCondition_.wait_until(lock, deadline) == std::cv_status::timeout;
+            }
+        }
+        popWaiting_.fetch_sub(1);
+        if (expired) {
+            return false;
+        }
+    }
+    return false;
+}
+
+// Notify the thread waiting for job
+template <typename T>
+void MpmcQueue<T>::notifyPush(std::size_t num) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (popWaiting_.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (num == 1) {
+            pushCondition_.notify_one();
+        } else {
+            pushCondition_.notify_all();
+        }
+    }
+}
+
+// Notify the thread waiting for popping job
+template <typename T>
+void MpmcQueue<T>::notifyPop() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (pushWaiting_.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        popCondition_.notify_all();
+    }
+}
+
+}  // namespace util
+}  // namespace libra
@@ -0,0 +1,254 @@
+#include <glog/logging.h>
+#include <algorithm>
+namespace libra {
+namespace util {
+
+// Constructor with maximum job numbers
+template <typename T>
+SpscQueue<T>::SpscQueue(const std::size_t& maxJobNums)
+    : tail_(0),
+      cachedHead_(0),
+      head_(0),
+      cachedTail_(0),
+      policy_(OverflowPolicy::Block),
+      stop_(false),
+      popWaiting_(false),
+      pushWaiting_(0) {
+    std::size_t capacity{1};
+    while (capacity < maxJobNums) {
+        capacity <<= 1;
+    }
+    jobs_.resize(capacity);
+    mask_ = capacity - 1;
+}
+
+// Destructor, stop the job queue and exit
+template <typename T>
+SpscQueue<T>::~SpscQueue() {
+    stop();
+}
+
+// Get the number of pushed but not popped jobs in the queue
+template <typename T>
+std::size_t SpscQueue<T>::size() const {
+    // load head first, so the tail is always not less than head
+    std::size_t head = head_.load(std::memory_order_acquire);
+    std::size_t tail = tail_.load(std::memory_order_acquire);
+    return tail - head;
+}
+
+// Enable/disable drop job data when queue if full
+template <typename T>
+void SpscQueue<T>::enableDropJob(bool enable) {
+    setOverflowPolicy(enable ? OverflowPolicy::DropNewest : OverflowPolicy::Block);
+}
+
+// Set the policy to push job when queue is full
+template <typename T>
+void SpscQueue<T>::setOverflowPolicy(OverflowPolicy policy) {
+    CHECK(policy == OverflowPolicy::Block || policy == OverflowPolicy::DropNewest)
+        << "only block and drop newest policy are supported by SPSC queue";
+    policy_ = policy;
+}
+
+// Push a new job to the queue, waits if the queue is full
+template <typename T>
+bool SpscQueue<T>::push(const T& data) {
+    if (!enqueue(data)) {
+        return false;
+    }
+    notifyPush();
+    return true;
+}
+
+// Push a new job to the queue with move, waits if the queue is full
+template <typename T>
+bool SpscQueue<T>::push(T&& data) {
+    if (!enqueue(std::move(data))) {
+        return false;
+    }
+    notifyPush();
+    return true;
+}
+
+// Push a batch of jobs to the queue, waits if the queue is full
+template <typename T>
+template <typename Iterator>
+std::size_t SpscQueue<T>::pushBatch(Iterator first, Iterator last) {
+    std::size_t num{0};
+    for (; first != last && !stop_; ++first) {
+        if (enqueue(*first)) {
+            ++num;
+        }
+    }
+    if (num > 0) {
+        notifyPush();
+    }
+    return num;
+}
+
+// Pop a job from the queue, wait if there is no job in the queue
+template <typename T>
+typename SpscQueue<T>::Job SpscQueue<T>::pop() {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    if (!waitNotEmpty(std::chrono::microseconds::max()) || stop_) {
+        return Job();
+    }
+
+    Job job(std::move(jobs_[head & mask_]));
+    head_.store(head + 1, std::memory_order_release);
+    counter_.addPop(1);
+    notifyPop();
+    return job;
+}
+
+// Pop at most `maxNum` jobs from the queue, wait until there is any job in the queue or timeout
+template <typename T>
+bool SpscQueue<T>::popBatch(std::vector<T>& jobs, std::size_t maxNum, const std::chrono::microseconds& timeout) {
+    jobs.clear();
+    bool notEmpty = waitNotEmpty(timeout);
+    if (stop_) {
+        return false;
+    }
+    if (!notEmpty) {
+        return true;
+    }
+
+    // pop all available jobs and only update the head once
+    std::size_t head = head_.load(std::memory_order_relaxed);
+    std::size_t num = std::min(cachedTail_ - head, maxNum);
+    for (std::size_t i = 0; i < num; ++i) {
+        jobs.emplace_back(std::move(jobs_[(head + i) & mask_]));
+    }
+    head_.store(head + num, std::memory_order_release);
+    counter_.addPop(num);
+    notifyPop();
+    return true;
+}
+
+// Wait for all jobs to bo popped
+template <typename T>
+void SpscQueue<T>::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    pushWaiting_.fetch_add(1);
+    while (!stop_ && head_.load() != tail_.load()) {
+        popCondition_.wait(lock);
+    }
+    pushWaiting_.fetch_sub(1);
+}
+
+// Stop the queue
+template <typename T>
+void SpscQueue<T>::stop() {
+    stop_ = true;
+    // lock to avoid the waiting thread miss the notification
+    std::lock_guard<std::mutex> lock(mutex_);
+    pushCondition_.notify_all();
+    popCondition_.notify_all();
+}
+
+// Clear all pushed and not popped jobs from the queue
+template <typename T>
+void SpscQueue<T>::clear() {
+    const std::size_t tail = tail_.load(std::memory_order_acquire);
+    std::size_t head = head_.load(std::memory_order_relaxed);
+    counter_.addDrop(tail - head);
+    for (; head != tail; ++head) {
+        jobs_[head & mask_] = T();
+    }
+    head_.store(tail, std::memory_order_release);
+    notifyPop();
+}
+
+// Push a new job to the queue, the job is forwarded into queue slot, and the consumer isn't notified
+template <typename T>
+template <typename U>
+bool SpscQueue<T>::enqueue(U&& data) {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cachedHead_ > mask_) {
+        cachedHead_ = head_.load(std::memory_order_acquire);
+        if (tail - cachedHead_ > mask_) {
+            // the queue is full, drop the newest job or wait consumer to pop
+            if (policy_ == OverflowPolicy::DropNewest) {
+                counter_.addDrop(1);
+                return false;
+            }
+            // notify consumer before waiting, the previous jobs in batch may not be notified
+            notifyPush();
+            LIBRA_TRACE_SCOPE("SpscQueue::waitPush");
+            auto t0 = std::chrono::steady_clock::now();
+            std::unique_lock<std::mutex> lock(mutex_);
+            pushWaiting_.fetch_add(1);
+            while (!stop_ && tail - (cachedHead_ = head_.load()) > mask_) {
+                popCondition_.wait(lock);
+            }
+            pushWaiting_.fetch_sub(1);
+            counter_.addWaitTime(std::chrono::steady_clock::now() - t0);
+        }
+    }
+
+    if (stop_) {
+        return false;
+    }
+
+    jobs_[tail & mask_] = std::forward<U>(data);
+    tail_.store(tail + 1, std::memory_order_release);
+    counter_.addPush(1, tail + 1 - cachedHead_);
+    return true;
+}
+
+// Wait until there is any job in the queue or timeout
+template <typename T>
+bool SpscQueue<T>::waitNotEmpty(const std::chrono::microseconds& timeout) {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    if (cachedTail_ != head) {
+        return true;
+    }
+    cachedTail_ = tail_.load(std::memory_order_acquire);
+    if (cachedTail_ != head || stop_) {
+        return cachedTail_ != head;
+    }
+
+    // the queue is empty, park on condition variable until producer notify
+    LIBRA_TRACE_SCOPE("SpscQueue::waitPop");
+    std::unique_lock<std::mutex> lock(mutex_);
+    popWaiting_.store(true);
+    if (timeout == std::chrono::microseconds::max()) {
+        while (!stop_ && (cachedTail_ = tail_.load()) == head) {
+            pushCondition_.wait(lock);
+        }
+    } else {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!stop_ && (cachedTail_ = tail_.load()) == head) {
+            if (pushCondition_.wait_until(lock, deadline) == std::cv_status::timeout) {
+                cachedTail_ = tail_.load();
+                break;
+            }
+        }
+    }
+    popWaiting_.store(false, std::memory_order_relaxed);
+    return cachedTail_ != head;
+}
+
+// Notify the consumer if it's waiting for job
+template <typename T>
+void SpscQueue<T>::notifyPush() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (popWaiting_.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pushCondition_.notify_one();
+    }
+}
+
+// Notify the threads waiting for popping job
+template <typename T>
+void SpscQueue<T>::notifyPop() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (pushWaiting_.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        popCondition_.notify_all();
+    }
+}
+
+}  // namespace util
+}  // namespace libra
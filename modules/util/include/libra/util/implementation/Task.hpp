@@ -0,0 +1,53 @@
+#include <new>
+
+namespace libra {
+namespace util {
+
+// Construct task from callable
+template <typename F, typename>
+Task::Task(F&& f) {
+    using Callable = std::decay_t<F>;
+    if constexpr (sizeof(Callable) <= kBufferSize && alignof(Callable) <= alignof(std::max_align_t) &&
+                  std::is_nothrow_move_constructible<Callable>::value) {
+        new (buffer_) Callable(std::forward<F>(f));
+        ops_ = &InlineOps<Callable>::kOps;
+    } else {
+        *reinterpret_cast<Callable**>(buffer_) = new Callable(std::forward<F>(f));
+        ops_ = &HeapOps<Callable>::kOps;
+    }
+}
+
+// Move constructor
+inline Task::Task(Task&& task) noexcept : ops_(task.ops_) {
+    if (ops_ != nullptr) {
+        ops_->move(buffer_, task.buffer_);
+        task.ops_ = nullptr;
+    }
+}
+
+// Move assignment
+inline Task& Task::operator=(Task&& task) noexcept {
+    if (this != &task) {
+        reset();
+        if (task.ops_ != nullptr) {
+            task.ops_->move(buffer_, task.buffer_);
+            ops_ = task.ops_;
+            task.ops_ = nullptr;
+        }
+    }
+    return *this;
+}
+
+// Destructor
+inline Task::~Task() { reset(); }
+
+// Reset to empty task
+inline void Task::reset() {
+    if (ops_ != nullptr) {
+        ops_->destroy(buffer_);
+        ops_ = nullptr;
+    }
+}
+
+}  // namespace util
+}  // namespace libra
@@ -5,24 +5,18 @@ namespace util {
 template <class F, class... Args>
 auto ThreadPool::addTask(F&& f, Args&&... args) -> std::future<std::result_of_t<F(Args...)>> {
     using ReturnType = std::result_of_t<F(Args...)>;
-    auto task =
-        std::make_shared<std::packaged_task<ReturnType()>>(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
-    std::future<ReturnType> result = task->get_future();
-
-    // add task to task queue
-    {
-        std::unique_lock<std::mutex> lock(mutex_);
-        if (stop_) {
-            throw std::runtime_error("cannot add task to stopped thread pool");
-        }
-        tasks_.emplace([task]() { (*task)(); });
-    }
-
-    // notify one worker
-    taskCondition_.notify_one();
-
+    // the packaged task is small enough to store in the inline buffer of task, only its shared state is allocated
+    std::packaged_task<ReturnType()> task(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+    std::future<ReturnType> result = task.get_future();
+    submit(Task(std::move(task)));
     return result;
 }
 
+// Add task to thread pool without returning result
+template <class F>
+void ThreadPool::post(F&& f) {
+    submit(Task(std::forward<F>(f)));
+}
+
 }  // namespace util
-}  // namespace libra
\ No newline at end of file
+}  // namespace libra
@@ -0,0 +1,93 @@
+#include "libra/util/BufferPool.h"
+#include <mutex>
+#include <vector>
+
+using namespace std;
+using namespace libra::util;
+
+/**
+ * @brief Buffer storage, it's shared by the pool and all the leased buffers
+ */
+struct BufferPool::Storage {
+    mutable mutex freeMutex;                          // mutex for free buffers and settings
+    size_t bufferSize;                                // buffer size
+    size_t maxFreeNum;                                // maximum free buffer number
+    size_t allocatedNum = 0;                          // total allocated buffer number
+    vector<unique_ptr<unsigned char[]>> freeBuffers;  // free buffers
+
+    Storage(size_t size, size_t maxNum) : bufferSize(size), maxFreeNum(maxNum) {}
+
+    // return buffer to storage
+    void giveBack(unsigned char* buffer, size_t size) {
+        unique_ptr<unsigned char[]> p(buffer);
+        unique_lock<mutex> lock(freeMutex);
+        if (size == bufferSize && freeBuffers.size() < maxFreeNum) {
+            freeBuffers.emplace_back(move(p));
+        }
+    }
+};
+
+// Constructor
+BufferPool::BufferPool(size_t bufferSize, size_t maxFreeNum) : storage_(make_shared<Storage>(bufferSize, maxFreeNum)) {}
+
+// Get the buffer size
+size_t BufferPool::bufferSize() const {
+    unique_lock<mutex> lock(storage_->freeMutex);
+    return storage_->bufferSize;
+}
+
+// Get the number of free buffers in the pool
+size_t BufferPool::freeNum() const {
+    unique_lock<mutex> lock(storage_->freeMutex);
+    return storage_->freeBuffers.size();
+}
+
+// Get the total number of buffers allocated by this pool
+size_t BufferPool::allocatedNum() const {
+    unique_lock<mutex> lock(storage_->freeMutex);
+    return storage_->allocatedNum;
+}
+
+// Set the buffer size
+void BufferPool::setBufferSize(size_t bufferSize) {
+    vector<unique_ptr<unsigned char[]>> oldBuffers;  // release old buffers outside the lock
+    unique_lock<mutex> lock(storage_->freeMutex);
+    if (bufferSize != storage_->bufferSize) {
+        storage_->bufferSize = bufferSize;
+        swap(oldBuffers, storage_->freeBuffers);
+    }
+}
+
+// Lease a buffer from pool
+shared_ptr<unsigned char> BufferPool::lease() { return lease(0); }
+
+// Lease a buffer with at least the specified size. The size is decided and the free buffer is taken in one lock, so
+// the buffer isn't shrunk by `setBufferSize()` in another thread
+shared_ptr<unsigned char> BufferPool::lease(size_t size) {
+    vector<unique_ptr<unsigned char[]>> oldBuffers;  // release old buffers outside the lock
+    unique_ptr<unsigned char[]> buffer;
+    {
+        unique_lock<mutex> lock(storage_->freeMutex);
+        if (storage_->bufferSize < size) {
+            storage_->bufferSize = size;
+            swap(oldBuffers, storage_->freeBuffers);
+        }
+        size = storage_->bufferSize;
+        if (!storage_->freeBuffers.empty()) {
+            buffer = move(storage_->freeBuffers.back());
+            storage_->freeBuffers.pop_back();
+        } else {
+            ++storage_->allocatedNum;
+        }
+    }
+
+    // allocate new buffer outside the lock
+    if (!buffer) {
+        buffer.reset(new unsigned char[size]);
+    }
+
+    // the deleter keeps the storage alive, and returns buffer to it
+    shared_ptr<Storage> storage = storage_;
+    return shared_ptr<unsigned char>(buffer.release(),
+                                     [storage, size](unsigned char* p) { storage->giveBack(p, size); });
+}
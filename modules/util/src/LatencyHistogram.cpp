@@ -0,0 +1,122 @@
+#include "libra/util/LatencyHistogram.h"
+#include <fmt/format.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+using namespace libra::util;
+
+namespace libra {
+namespace util {
+
+// Print latency statistics to output stream
+ostream& operator<<(ostream& os, const LatencyStats& stats) {
+    os << fmt::format("count = {}, mean = {:.3f} ms, min = {:.3f} ms, P50 = {:.3f} ms, P90 = {:.3f} ms, "
+                      "P99 = {:.3f} ms, P999 = {:.3f} ms, max = {:.3f} ms",
+                      stats.count, stats.mean * 1.0E-6, stats.min * 1.0E-6, stats.p50 * 1.0E-6, stats.p90 * 1.0E-6,
+                      stats.p99 * 1.0E-6, stats.p999 * 1.0E-6, stats.max * 1.0E-6);
+    return os;
+}
+
+}  // namespace util
+}  // namespace libra
+
+// Constructor
+LatencyHistogram::LatencyHistogram() { reset(); }
+
+// Record one value
+void LatencyHistogram::record(int64_t value) {
+    value = max<int64_t>(0, value);
+    buckets_[bucketIndex(value)].fetch_add(1, memory_order_relaxed);
+    count_.fetch_add(1, memory_order_relaxed);
+    sum_.fetch_add(static_cast<uint64_t>(value), memory_order_relaxed);
+    int64_t v = min_.load(memory_order_relaxed);
+    while (value < v && !min_.compare_exchange_weak(v, value, memory_order_relaxed)) {
+    }
+    v = max_.load(memory_order_relaxed);
+    while (value > v && !max_.compare_exchange_weak(v, value, memory_order_relaxed)) {
+    }
+}
+
+// Get the value at percentile
+double LatencyHistogram::percentile(double p) const {
+    // take a snapshot of buckets, the count is summed from buckets to be consistent with them
+    array<uint64_t, kBucketNum> counts;
+    uint64_t total{0};
+    for (int i = 0; i < kBucketNum; ++i) {
+        counts[i] = buckets_[i].load(memory_order_relaxed);
+        total += counts[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    // find the bucket of the rank, and clamp the value to the recorded range
+    uint64_t rank = max<uint64_t>(1, static_cast<uint64_t>(ceil(min(1.0, max(0.0, p)) * total)));
+    uint64_t accumulated{0};
+    for (int i = 0; i < kBucketNum; ++i) {
+        accumulated += counts[i];
+        if (accumulated >= rank) {
+            int64_t lower{0}, upper{0};
+            bucketRange(i, &lower, &upper);
+            double value = upper - lower <= 1 ? lower : 0.5 * (lower + upper);
+            return min<double>(max<double>(value, min_.load(memory_order_relaxed)), max_.load(memory_order_relaxed));
+        }
+    }
+    return max_.load(memory_order_relaxed);
+}
+
+// Get the statistics of histogram
+LatencyStats LatencyHistogram::stats() const {
+    LatencyStats stats;
+    stats.count = count();
+    if (stats.count == 0) {
+        return stats;
+    }
+    stats.min = min_.load(memory_order_relaxed);
+    stats.max = max_.load(memory_order_relaxed);
+    stats.mean = static_cast<double>(sum_.load(memory_order_relaxed)) / stats.count;
+    stats.p50 = percentile(0.5);
+    stats.p90 = percentile(0.9);
+    stats.p99 = percentile(0.99);
+    stats.p999 = percentile(0.999);
+    return stats;
+}
+
+// Clear all recorded values
+void LatencyHistogram::reset() {
+    for (auto& b : buckets_) {
+        b.store(0, memory_order_relaxed);
+    }
+    count_.store(0, memory_order_relaxed);
+    sum_.store(0, memory_order_relaxed);
+    min_.store(numeric_limits<int64_t>::max(), memory_order_relaxed);
+    max_.store(0, memory_order_relaxed);
+}
+
+// Get the bucket index of value. The values less than 2 * kSubBucketNum use one bucket for each, and the values in
+// [2^e, 2^(e+1)) are divided into kSubBucketNum buckets with the width 2^(e - kSubBucketBits)
+int LatencyHistogram::bucketIndex(int64_t value) {
+    if (value < 2 * kSubBucketNum) {
+        return static_cast<int>(max<int64_t>(0, value));
+    }
+    int exponent = 63 - __builtin_clzll(static_cast<uint64_t>(value));
+    if (exponent > kMaxExponent) {
+        return kBucketNum - 1;
+    }
+    int shift = exponent - kSubBucketBits;
+    return (shift + 1) * kSubBucketNum + static_cast<int>((value >> shift) - kSubBucketNum);
+}
+
+// Get the range of bucket
+void LatencyHistogram::bucketRange(int index, int64_t* lower, int64_t* upper) {
+    if (index < 2 * kSubBucketNum) {
+        *lower = index;
+        *upper = index + 1;
+        return;
+    }
+    int shift = index / kSubBucketNum - 1;
+    *lower = static_cast<int64_t>(index % kSubBucketNum + kSubBucketNum) << shift;
+    *upper = *lower + (int64_t{1} << shift);
+}
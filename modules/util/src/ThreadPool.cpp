@@ -1,41 +1,77 @@
 #include "libra/util/ThreadPool.h"
+#include <fmt/format.h>
 #include <glog/logging.h>
+#include "libra/util/Constant.h"
+#include "libra/util/TraceRecorder.h"
 
 using namespace std;
 using namespace libra::util;
 
-// Construct thread pool with thread number
-ThreadPool::ThreadPool(const std::size_t& threadNum) : stop_(false), activeWorkerNum_(0) {
-    for (size_t i = 0; i < threadNum; ++i) {
-        workers_.emplace_back([this] {
-            while (true) {
-                // take task from task queue
-                function<void()> task;
-                {
-                    unique_lock<mutex> lock(mutex_);
-                    taskCondition_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
-
-                    if (stop_ && tasks_.empty()) {
-                        return;
-                    }
-
-                    task = move(tasks_.front());
-                    tasks_.pop();
-                    ++activeWorkerNum_;
-                }
-
-                // do task
-                task();
+namespace {
 
-                // set active worker number after finished
-                {
-                    unique_lock<mutex> lock(mutex_);
-                    --activeWorkerNum_;
-                }
+thread_local const ThreadPool* currentPool = nullptr;  // thread pool of current worker thread
+thread_local size_t currentIndex = 0;                  // worker index of current worker thread
 
-                finishCondition_.notify_all();
+}  // namespace
+
+/**
+ * @brief Task queue for each worker, it's a ring buffer which only grows, so push task doesn't allocate memory once the
+ * capacity is enough. The queue is locked by its own mutex, which is only contended when other worker steals task
+ */
+struct alignas(Constant::kCacheLineSize) ThreadPool::WorkQueue {
+    mutex queueMutex;                       // mutex for task queue
+    vector<Task> tasks = vector<Task>(64);  // ring buffer of tasks
+    size_t head = 0;                        // index of the first task
+    size_t size = 0;                        // task number
+
+    // push task to the back
+    void push(Task&& task) {
+        lock_guard<mutex> lock(queueMutex);
+        if (size == tasks.size()) {
+            vector<Task> newTasks(2 * tasks.size());
+            for (size_t i = 0; i < size; ++i) {
+                newTasks[i] = move(tasks[(head + i) % tasks.size()]);
             }
-        });
+            swap(tasks, newTasks);
+            head = 0;
+        }
+        tasks[(head + size) % tasks.size()] = move(task);
+        ++size;
+    }
+
+    // pop task from the front, the owner and the thieves both take the oldest task to keep the order of tasks
+    bool pop(Task& task) {
+        lock_guard<mutex> lock(queueMutex);
+        if (size == 0) {
+            return false;
+        }
+        task = move(tasks[head]);
+        head = (head + 1) % tasks.size();
+        --size;
+        return true;
+    }
+
+    // clear all tasks, return the number of cleared tasks
+    size_t clear() {
+        lock_guard<mutex> lock(queueMutex);
+        size_t num = size;
+        for (; size > 0; --size) {
+            tasks[head].reset();
+            head = (head + 1) % tasks.size();
+        }
+        return num;
+    }
+};
+
+// Construct thread pool with thread number
+ThreadPool::ThreadPool(const std::size_t& threadNum)
+    : nextQueue_(0), stop_(false), queuedNum_(0), pendingNum_(0), idleWorkerNum_(0) {
+    CHECK_GT(threadNum, 0) << "thread number of thread pool should be larger than 0";
+    for (size_t i = 0; i < threadNum; ++i) {
+        queues_.emplace_back(new WorkQueue);
+    }
+    for (size_t i = 0; i < threadNum; ++i) {
+        workers_.emplace_back([this, i] { work(i); });
     }
 }
 
@@ -51,26 +87,103 @@ void ThreadPool::stop() {
             return;
         }
         stop_ = true;
-
-        queue<function<void()>> emptyTasks;
-        swap(tasks_, emptyTasks);
+    }
+    for (auto& q : queues_) {
+        size_t num = q->clear();
+        queuedNum_.fetch_sub(num);
+        pendingNum_.fetch_sub(num);
     }
 
-    // notify active tasks
-    taskCondition_.notify_all();
+    // notify idle workers
+    {
+        unique_lock<mutex> lock(mutex_);
+        taskCondition_.notify_all();
+    }
 
     // wait active task finish
     for (auto& w : workers_) {
         w.join();
     }
 
-    finishCondition_.notify_all();
+    // all workers exited, notify the waiting threads
+    {
+        unique_lock<mutex> lock(mutex_);
+        pendingNum_ = 0;
+        finishCondition_.notify_all();
+    }
 }
 
 // Wait all task finish
 void ThreadPool::wait() {
     unique_lock<mutex> lock(mutex_);
-    if (!tasks_.empty() || activeWorkerNum_ > 0) {
-        finishCondition_.wait(lock, [this] { return tasks_.empty() && activeWorkerNum_ == 0; });
+    finishCondition_.wait(lock, [this] { return pendingNum_ == 0; });
+}
+
+// Add task to the queue of current worker or the workers in round robin
+void ThreadPool::submit(Task&& task) {
+    size_t index = currentPool == this ? currentIndex : nextQueue_.fetch_add(1, memory_order_relaxed) % queues_.size();
+    {
+        // check the stop flag and push under the lock, so the task is either rejected or pushed before `stop()` clears
+        // the queues and resets the counters. It also makes sure the idle worker is either waiting or will see the new
+        // task
+        lock_guard<mutex> lock(mutex_);
+        if (stop_) {
+            throw runtime_error("cannot add task to stopped thread pool");
+        }
+        // count the task before pushing, so the counters never underflow if the task is taken immediately
+        pendingNum_.fetch_add(1);
+        queuedNum_.fetch_add(1);
+        queues_[index]->push(move(task));
     }
-}
\ No newline at end of file
+
+    // notify one idle worker after unlock, so the woken worker doesn't block on the mutex
+    if (idleWorkerNum_.load() > 0) {
+        taskCondition_.notify_one();
+    }
+}
+
+// Take task from own queue, or steal from other workers
+bool ThreadPool::take(size_t index, Task& task) {
+    for (size_t i = 0; i < queues_.size(); ++i) {
+        if (queues_[(index + i) % queues_.size()]->pop(task)) {
+            queuedNum_.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Worker thread function
+void ThreadPool::work(size_t index) {
+    currentPool = this;
+    currentIndex = index;
+    LIBRA_TRACE_THREAD(fmt::format("thread pool worker {}", index));
+
+    Task task;
+    while (!stop_) {
+        // take task and do it
+        if (take(index, task)) {
+            try {
+                task();
+            } catch (const exception& e) {
+                LOG(ERROR) << "exception in thread pool task: " << e.what();
+            } catch (...) {
+                LOG(ERROR) << "unknown exception in thread pool task";
+            }
+            task.reset();
+
+            // notify the waiting threads if all tasks are finished
+            if (pendingNum_.fetch_sub(1) == 1) {
+                lock_guard<mutex> lock(mutex_);
+                finishCondition_.notify_all();
+            }
+            continue;
+        }
+
+        // no task, wait until new task added
+        unique_lock<mutex> lock(mutex_);
+        idleWorkerNum_.fetch_add(1);
+        taskCondition_.wait(lock, [this] { return stop_ || queuedNum_ > 0; });
+        idleWorkerNum_.fetch_sub(1);
+    }
+}
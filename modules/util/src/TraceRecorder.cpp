@@ -0,0 +1,190 @@
+#include "libra/util/TraceRecorder.h"
+#include <fmt/format.h>
+#include <glog/logging.h>
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <nlohmann/json.hpp>
+
+using namespace std;
+using namespace libra::util;
+
+/**
+ * @brief Ring buffer of events for each thread. It's written by its owner thread and read by the thread exporting
+ * events, the mutex is only contended when exporting
+ */
+struct TraceRecorder::ThreadBuffer {
+    mutex bufferMutex;     // mutex for events
+    int id = 0;            // thread ID shown in timeline
+    string name;           // thread name
+    vector<Event> events;  // ring buffer of events
+    size_t writeNum = 0;   // total written event number
+
+    // get the kept events in recorded order
+    vector<Event> snapshot() {
+        lock_guard<mutex> lock(bufferMutex);
+        vector<Event> kept;
+        size_t num = min(writeNum, events.size());
+        kept.reserve(num);
+        for (size_t i = writeNum - num; i < writeNum; ++i) {
+            kept.emplace_back(events[i % events.size()]);
+        }
+        return kept;
+    }
+};
+
+namespace {
+
+thread_local string currentThreadName;  // name of current thread, it's applied when the buffer is created
+
+}  // namespace
+
+// Constructor
+TraceRecorder::TraceRecorder() : enabled_(false), capacity_(16384), nextThreadId_(1) {}
+
+// Destructor
+TraceRecorder::~TraceRecorder() = default;
+
+// Get the global trace recorder
+TraceRecorder& TraceRecorder::instance() {
+    static TraceRecorder recorder;
+    return recorder;
+}
+
+// Get the event capacity of each thread
+size_t TraceRecorder::capacity() const {
+    lock_guard<mutex> lock(mutex_);
+    return capacity_;
+}
+
+// Set the event capacity of each thread
+void TraceRecorder::setCapacity(size_t capacity) {
+    CHECK_GT(capacity, 0) << "event capacity should be larger than 0";
+    lock_guard<mutex> lock(mutex_);
+    capacity_ = capacity;
+}
+
+// Set the name of current thread
+void TraceRecorder::setThreadName(const string& name) {
+    currentThreadName = name;
+    if (currentBuffer()) {
+        lock_guard<mutex> lock(currentBuffer()->bufferMutex);
+        currentBuffer()->name = name;
+    }
+}
+
+// Record one span of current thread
+void TraceRecorder::record(const char* name, int64_t start, int64_t duration) {
+    ThreadBuffer& buffer = threadBuffer();
+    lock_guard<mutex> lock(buffer.bufferMutex);
+    Event& event = buffer.events[buffer.writeNum % buffer.events.size()];
+    event.name = name;
+    event.start = start;
+    event.duration = duration;
+    ++buffer.writeNum;
+}
+
+// Get the number of kept events of all threads
+size_t TraceRecorder::eventNum() const {
+    lock_guard<mutex> lock(mutex_);
+    size_t num{0};
+    for (auto& b : buffers_) {
+        lock_guard<mutex> bufferLock(b->bufferMutex);
+        num += min(b->writeNum, b->events.size());
+    }
+    return num;
+}
+
+// Clear all the events, and release the buffers of exited threads which are only referenced by recorder
+void TraceRecorder::clear() {
+    lock_guard<mutex> lock(mutex_);
+    buffers_.erase(remove_if(buffers_.begin(), buffers_.end(), [](const shared_ptr<ThreadBuffer>& b) {
+                       return b.use_count() == 1;
+                   }),
+                   buffers_.end());
+    for (auto& b : buffers_) {
+        lock_guard<mutex> bufferLock(b->bufferMutex);
+        b->writeNum = 0;
+    }
+}
+
+// Export all the events as Chrome trace JSON. The complete event("X") is used for each span, and the time is in us
+// relative to the earliest event
+string TraceRecorder::toJson() const {
+    // take snapshot of all threads
+    vector<shared_ptr<ThreadBuffer>> buffers;
+    {
+        lock_guard<mutex> lock(mutex_);
+        buffers = buffers_;
+    }
+    vector<vector<Event>> events(buffers.size());
+    int64_t startTime = numeric_limits<int64_t>::max();
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        events[i] = buffers[i]->snapshot();
+        // the events are in the order of end time, so the nested span is before its parent
+        for (const auto& e : events[i]) {
+            startTime = min(startTime, e.start);
+        }
+    }
+
+    nlohmann::json traceEvents = nlohmann::json::array();
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        string name;
+        {
+            lock_guard<mutex> lock(buffers[i]->bufferMutex);
+            name = buffers[i]->name;
+        }
+        const int tid = buffers[i]->id;
+        traceEvents.push_back({{"name", "thread_name"},
+                               {"ph", "M"},
+                               {"pid", 1},
+                               {"tid", tid},
+                               {"args", {{"name", name.empty() ? fmt::format("thread {}", tid) : name}}}});
+        for (const auto& e : events[i]) {
+            traceEvents.push_back({{"name", e.name},
+                                   {"cat", "libra"},
+                                   {"ph", "X"},
+                                   {"pid", 1},
+                                   {"tid", tid},
+                                   {"ts", (e.start - startTime) * 1.0E-3},
+                                   {"dur", e.duration * 1.0E-3}});
+        }
+    }
+
+    nlohmann::json j;
+    j["traceEvents"] = move(traceEvents);
+    j["displayTimeUnit"] = "ms";
+    return j.dump();
+}
+
+// Save all the events to Chrome trace JSON file
+bool TraceRecorder::save(const string& file) const {
+    fstream fs(file, ios::out);
+    if (!fs.is_open()) {
+        LOG(ERROR) << fmt::format("cannot open file \"{}\" to save trace", file);
+        return false;
+    }
+    fs << toJson() << endl;
+    return true;
+}
+
+// Get the buffer handle of current thread
+shared_ptr<TraceRecorder::ThreadBuffer>& TraceRecorder::currentBuffer() {
+    thread_local shared_ptr<ThreadBuffer> buffer;
+    return buffer;
+}
+
+// Get the buffer of current thread, create and register it when the thread records the first event
+TraceRecorder::ThreadBuffer& TraceRecorder::threadBuffer() {
+    shared_ptr<ThreadBuffer>& current = currentBuffer();
+    if (!current) {
+        auto buffer = make_shared<ThreadBuffer>();
+        buffer->name = currentThreadName;
+        lock_guard<mutex> lock(mutex_);
+        buffer->id = nextThreadId_++;
+        buffer->events.resize(capacity_);
+        buffers_.emplace_back(buffer);
+        current = move(buffer);
+    }
+    return *current;
+}
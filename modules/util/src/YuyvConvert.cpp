@@ -0,0 +1,364 @@
+#include "libra/util/YuyvConvert.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LIBRA_SIMD_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define LIBRA_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace std;
+
+namespace libra {
+namespace util {
+
+namespace {
+
+// function type to convert one YUYV row to YUV422 planar
+using RowFunc = void (*)(const unsigned char*, int, unsigned char*, unsigned char*, unsigned char*);
+
+// function type to bin two YUYV rows to one YUV422 planar row
+using BinRowFunc = void (*)(const unsigned char*, const unsigned char*, int, unsigned char*, unsigned char*,
+                            unsigned char*);
+
+// convert the row from pixel index `start` using scalar code, width should be even
+inline void yuyvToYuv422pRowTail(const unsigned char* yuyv, int start, int width, unsigned char* y, unsigned char* u,
+                                 unsigned char* v) {
+    const unsigned char* pRaw = yuyv + 2 * start;
+    unsigned char* pY = y + start;
+    unsigned char* pU = u + start / 2;
+    unsigned char* pV = v + start / 2;
+    for (int i = start; i < width; i += 2) {
+        *pY++ = *(pRaw++);
+        *pU++ = *(pRaw++);
+        *pY++ = *(pRaw++);
+        *pV++ = *(pRaw++);
+    }
+}
+
+// scalar code
+void yuyvToYuv422pRowScalar(const unsigned char* yuyv, int width, unsigned char* y, unsigned char* u,
+                            unsigned char* v) {
+    yuyvToYuv422pRowTail(yuyv, 0, width, y, u, v);
+}
+
+// bin the rows from pixel index `start` using scalar code, width should be multiple of 4. The chroma isn't output if
+// `kChroma` is false
+template <bool kChroma>
+inline void yuyvBin2x2RowTail(const unsigned char* row0, const unsigned char* row1, int start, int width,
+                              unsigned char* y, unsigned char* u, unsigned char* v) {
+    for (int i = start; i + 4 <= width; i += 4) {
+        const unsigned char* p0 = row0 + 2 * i;  // Y0 U0 Y1 V0 Y2 U1 Y3 V1
+        const unsigned char* p1 = row1 + 2 * i;
+        y[i / 2] = static_cast<unsigned char>((p0[0] + p0[2] + p1[0] + p1[2] + 2) >> 2);
+        y[i / 2 + 1] = static_cast<unsigned char>((p0[4] + p0[6] + p1[4] + p1[6] + 2) >> 2);
+        if constexpr (kChroma) {
+            u[i / 4] = static_cast<unsigned char>((p0[1] + p0[5] + p1[1] + p1[5] + 2) >> 2);
+            v[i / 4] = static_cast<unsigned char>((p0[3] + p0[7] + p1[3] + p1[7] + 2) >> 2);
+        }
+    }
+}
+
+// scalar code of binning
+template <bool kChroma>
+void yuyvBin2x2RowScalar(const unsigned char* row0, const unsigned char* row1, int width, unsigned char* y,
+                         unsigned char* u, unsigned char* v) {
+    yuyvBin2x2RowTail<kChroma>(row0, row1, 0, width, y, u, v);
+}
+
+#if defined(LIBRA_SIMD_X86)
+// SSE2 code, process 32 pixels(64 bytes) each loop
+__attribute__((target("sse2"))) void yuyvToYuv422pRowSse2(const unsigned char* yuyv, int width, unsigned char* y,
+                                                          unsigned char* u, unsigned char* v) {
+    const __m128i mask = _mm_set1_epi16(0x00FF);
+    int i = 0;
+    for (; i + 32 <= width; i += 32) {
+        const __m128i* src = reinterpret_cast<const __m128i*>(yuyv + 2 * i);
+        __m128i a = _mm_loadu_si128(src);      // Y0 U0 Y1 V0 ... of pixel [0, 8)
+        __m128i b = _mm_loadu_si128(src + 1);  // pixel [8, 16)
+        __m128i c = _mm_loadu_si128(src + 2);  // pixel [16, 24)
+        __m128i d = _mm_loadu_si128(src + 3);  // pixel [24, 32)
+
+        // Y is the low byte of each 16 bits
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(y + i),
+                         _mm_packus_epi16(_mm_and_si128(a, mask), _mm_and_si128(b, mask)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(y + i + 16),
+                         _mm_packus_epi16(_mm_and_si128(c, mask), _mm_and_si128(d, mask)));
+
+        // UV is the high byte of each 16 bits, then split U and V
+        __m128i uv0 = _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8));  // U0 V0 ... U7 V7
+        __m128i uv1 = _mm_packus_epi16(_mm_srli_epi16(c, 8), _mm_srli_epi16(d, 8));  // U8 V8 ... U15 V15
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(u + i / 2),
+                         _mm_packus_epi16(_mm_and_si128(uv0, mask), _mm_and_si128(uv1, mask)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(v + i / 2),
+                         _mm_packus_epi16(_mm_srli_epi16(uv0, 8), _mm_srli_epi16(uv1, 8)));
+    }
+    yuyvToYuv422pRowTail(yuyv, i, width, y, u, v);
+}
+
+// AVX2 code, process 64 pixels(128 bytes) each loop. The pack instruction works in each 128 bits lane, so permute is
+// needed to fix the order of 64 bits blocks
+__attribute__((target("avx2"))) void yuyvToYuv422pRowAvx2(const unsigned char* yuyv, int width, unsigned char* y,
+                                                          unsigned char* u, unsigned char* v) {
+    const __m256i mask = _mm256_set1_epi16(0x00FF);
+    int i = 0;
+    for (; i + 64 <= width; i += 64) {
+        const __m256i* src = reinterpret_cast<const __m256i*>(yuyv + 2 * i);
+        __m256i a = _mm256_loadu_si256(src);      // pixel [0, 16)
+        __m256i b = _mm256_loadu_si256(src + 1);  // pixel [16, 32)
+        __m256i c = _mm256_loadu_si256(src + 2);  // pixel [32, 48)
+        __m256i d = _mm256_loadu_si256(src + 3);  // pixel [48, 64)
+
+        // Y
+        __m256i y0 = _mm256_packus_epi16(_mm256_and_si256(a, mask), _mm256_and_si256(b, mask));
+        __m256i y1 = _mm256_packus_epi16(_mm256_and_si256(c, mask), _mm256_and_si256(d, mask));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(y + i), _mm256_permute4x64_epi64(y0, 0xD8));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(y + i + 32), _mm256_permute4x64_epi64(y1, 0xD8));
+
+        // UV
+        __m256i uv0 = _mm256_permute4x64_epi64(_mm256_packus_epi16(_mm256_srli_epi16(a, 8), _mm256_srli_epi16(b, 8)),
+                                               0xD8);  // U0 V0 ... U15 V15
+        __m256i uv1 = _mm256_permute4x64_epi64(_mm256_packus_epi16(_mm256_srli_epi16(c, 8), _mm256_srli_epi16(d, 8)),
+                                               0xD8);  // U16 V16 ... U31 V31
+        __m256i pu = _mm256_packus_epi16(_mm256_and_si256(uv0, mask), _mm256_and_si256(uv1, mask));
+        __m256i pv = _mm256_packus_epi16(_mm256_srli_epi16(uv0, 8), _mm256_srli_epi16(uv1, 8));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(u + i / 2), _mm256_permute4x64_epi64(pu, 0xD8));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(v + i / 2), _mm256_permute4x64_epi64(pv, 0xD8));
+    }
+    yuyvToYuv422pRowTail(yuyv, i, width, y, u, v);
+}
+
+// SSE2 code of binning, process 32 input pixels(64 bytes of each row) each loop. The samples of two rows are summed in
+// 16 bits, then the neighbor Y or neighbor macro pixels are summed, rounded and packed
+template <bool kChroma>
+__attribute__((target("sse2"))) void yuyvBin2x2RowSse2(const unsigned char* row0, const unsigned char* row1,
+                                                       int width, unsigned char* y, unsigned char* u,
+                                                       unsigned char* v) {
+    const __m128i mask = _mm_set1_epi16(0x00FF);
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i two = _mm_set1_epi16(2);
+    int i = 0;
+    for (; i + 32 <= width; i += 32) {
+        const __m128i* src0 = reinterpret_cast<const __m128i*>(row0 + 2 * i);
+        const __m128i* src1 = reinterpret_cast<const __m128i*>(row1 + 2 * i);
+        __m128i sumY[4];   // Y sum of 4 output pixels in 32 bits
+        __m128i sumUV[4];  // U V sum of 2 output macro pixels in the low 64 bits, U0 V0 U1 V1 in 16 bits
+        for (int k = 0; k < 4; ++k) {
+            __m128i a = _mm_loadu_si128(src0 + k);  // Y0 U0 Y1 V0 ... of 8 pixels in row 0
+            __m128i b = _mm_loadu_si128(src1 + k);  // 8 pixels in row 1
+            sumY[k] = _mm_madd_epi16(_mm_add_epi16(_mm_and_si128(a, mask), _mm_and_si128(b, mask)), one);
+            if constexpr (kChroma) {
+                // the sum of neighbor macro pixels is in 16 bits [0, 1] and [4, 5], then move them to low 64 bits
+                __m128i uv = _mm_add_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8));
+                uv = _mm_add_epi16(uv, _mm_srli_epi64(uv, 32));
+                sumUV[k] = _mm_shuffle_epi32(uv, _MM_SHUFFLE(3, 1, 2, 0));
+            }
+        }
+
+        // Y of 16 output pixels
+        __m128i y0 = _mm_srli_epi16(_mm_add_epi16(_mm_packs_epi32(sumY[0], sumY[1]), two), 2);
+        __m128i y1 = _mm_srli_epi16(_mm_add_epi16(_mm_packs_epi32(sumY[2], sumY[3]), two), 2);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(y + i / 2), _mm_packus_epi16(y0, y1));
+
+        // U V of 8 output macro pixels, then split U and V
+        if constexpr (kChroma) {
+            __m128i uv0 = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(sumUV[0], sumUV[1]), two), 2);
+            __m128i uv1 = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(sumUV[2], sumUV[3]), two), 2);
+            __m128i uv = _mm_packus_epi16(uv0, uv1);  // U0 V0 ... U7 V7
+            const __m128i zero = _mm_setzero_si128();
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(u + i / 4), _mm_packus_epi16(_mm_and_si128(uv, mask), zero));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(v + i / 4), _mm_packus_epi16(_mm_srli_epi16(uv, 8), zero));
+        }
+    }
+    yuyvBin2x2RowTail<kChroma>(row0, row1, i, width, y, u, v);
+}
+#endif
+
+#if defined(LIBRA_SIMD_NEON)
+// NEON code, process 32 pixels(64 bytes) each loop
+void yuyvToYuv422pRowNeon(const unsigned char* yuyv, int width, unsigned char* y, unsigned char* u,
+                          unsigned char* v) {
+    int i = 0;
+    for (; i + 32 <= width; i += 32) {
+        uint8x16x4_t src = vld4q_u8(yuyv + 2 * i);  // Y0, U, Y1, V
+        uint8x16x2_t dstY;
+        dstY.val[0] = src.val[0];
+        dstY.val[1] = src.val[2];
+        vst2q_u8(y + i, dstY);
+        vst1q_u8(u + i / 2, src.val[1]);
+        vst1q_u8(v + i / 2, src.val[3]);
+    }
+    yuyvToYuv422pRowTail(yuyv, i, width, y, u, v);
+}
+
+// NEON code of binning, process 32 input pixels(64 bytes of each row) each loop. The rounding shift gives the same
+// result with scalar code
+template <bool kChroma>
+void yuyvBin2x2RowNeon(const unsigned char* row0, const unsigned char* row1, int width, unsigned char* y,
+                       unsigned char* u, unsigned char* v) {
+    int i = 0;
+    for (; i + 32 <= width; i += 32) {
+        uint8x16x4_t a = vld4q_u8(row0 + 2 * i);  // Y0, U, Y1, V of row 0
+        uint8x16x4_t b = vld4q_u8(row1 + 2 * i);  // Y0, U, Y1, V of row 1
+        uint16x8_t low = vaddq_u16(vaddl_u8(vget_low_u8(a.val[0]), vget_low_u8(a.val[2])),
+                                   vaddl_u8(vget_low_u8(b.val[0]), vget_low_u8(b.val[2])));
+        uint16x8_t high = vaddq_u16(vaddl_u8(vget_high_u8(a.val[0]), vget_high_u8(a.val[2])),
+                                    vaddl_u8(vget_high_u8(b.val[0]), vget_high_u8(b.val[2])));
+        vst1q_u8(y + i / 2, vcombine_u8(vrshrn_n_u16(low, 2), vrshrn_n_u16(high, 2)));
+        if constexpr (kChroma) {
+            vst1_u8(u + i / 4, vrshrn_n_u16(vpadalq_u8(vpaddlq_u8(a.val[1]), b.val[1]), 2));
+            vst1_u8(v + i / 4, vrshrn_n_u16(vpadalq_u8(vpaddlq_u8(a.val[3]), b.val[3]), 2));
+        }
+    }
+    yuyvBin2x2RowTail<kChroma>(row0, row1, i, width, y, u, v);
+}
+#endif
+
+// get the row convert function for SIMD level, return scalar function if not supported
+RowFunc rowFunc(SimdLevel level) {
+    if (!isSimdSupported(level)) {
+        return yuyvToYuv422pRowScalar;
+    }
+    switch (level) {
+#if defined(LIBRA_SIMD_X86)
+        case SimdLevel::SSE2:
+            return yuyvToYuv422pRowSse2;
+        case SimdLevel::AVX2:
+            return yuyvToYuv422pRowAvx2;
+#endif
+#if defined(LIBRA_SIMD_NEON)
+        case SimdLevel::NEON:
+            return yuyvToYuv422pRowNeon;
+#endif
+        default:
+            return yuyvToYuv422pRowScalar;
+    }
+}
+
+// get the row convert function with the best SIMD level
+RowFunc bestRowFunc() {
+    static const RowFunc func = rowFunc(bestSimdLevel());
+    return func;
+}
+
+// get the binning function for SIMD level, return scalar function if not supported. The AVX2 level uses the SSE2 code,
+// because the pack instructions of AVX2 work in 128 bits lanes and the binning is bound by memory
+template <bool kChroma>
+BinRowFunc binRowFunc(SimdLevel level) {
+    if (!isSimdSupported(level)) {
+        return yuyvBin2x2RowScalar<kChroma>;
+    }
+    switch (level) {
+#if defined(LIBRA_SIMD_X86)
+        case SimdLevel::SSE2:
+        case SimdLevel::AVX2:
+            return yuyvBin2x2RowSse2<kChroma>;
+#endif
+#if defined(LIBRA_SIMD_NEON)
+        case SimdLevel::NEON:
+            return yuyvBin2x2RowNeon<kChroma>;
+#endif
+        default:
+            return yuyvBin2x2RowScalar<kChroma>;
+    }
+}
+
+}  // namespace
+
+// Get the name of SIMD level
+string toString(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::Scalar:
+            return "Scalar";
+        case SimdLevel::SSE2:
+            return "SSE2";
+        case SimdLevel::AVX2:
+            return "AVX2";
+        case SimdLevel::NEON:
+            return "NEON";
+        default:
+            return "Unknown";
+    }
+}
+
+// Check whether the SIMD level is supported by current build and CPU
+bool isSimdSupported(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::Scalar:
+            return true;
+#if defined(LIBRA_SIMD_X86)
+        case SimdLevel::SSE2:
+            return __builtin_cpu_supports("sse2");
+        case SimdLevel::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+#if defined(LIBRA_SIMD_NEON)
+        case SimdLevel::NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+// Get the best SIMD level supported by current build and CPU
+SimdLevel bestSimdLevel() {
+    static const SimdLevel level = [] {
+        for (auto l : {SimdLevel::AVX2, SimdLevel::NEON, SimdLevel::SSE2}) {
+            if (isSimdSupported(l)) {
+                return l;
+            }
+        }
+        return SimdLevel::Scalar;
+    }();
+    return level;
+}
+
+// Convert one row of YUYV(YUV422 Packed) to YUV422 Planar using the best SIMD level
+void yuyvToYuv422pRow(const unsigned char* yuyv, int width, unsigned char* y, unsigned char* u, unsigned char* v) {
+    bestRowFunc()(yuyv, width, y, u, v);
+}
+
+// Convert one row of YUYV(YUV422 Packed) to YUV422 Planar using specified SIMD level
+void yuyvToYuv422pRow(const unsigned char* yuyv, int width, unsigned char* y, unsigned char* u, unsigned char* v,
+                      SimdLevel level) {
+    rowFunc(level)(yuyv, width, y, u, v);
+}
+
+// Convert YUYV(YUV422 Packed) image to YUV422 Planar image using the best SIMD level
+void yuyvToYuv422p(const unsigned char* yuyv, int width, int height, int stride, unsigned char* yuv) {
+    yuyvToYuv422p(yuyv, width, height, stride, yuv, bestSimdLevel());
+}
+
+// Convert YUYV(YUV422 Packed) image to YUV422 Planar image using specified SIMD level
+void yuyvToYuv422p(const unsigned char* yuyv, int width, int height, int stride, unsigned char* yuv,
+                   SimdLevel level) {
+    RowFunc func = rowFunc(level);
+    unsigned char* pY = yuv;
+    unsigned char* pU = yuv + width * height;
+    unsigned char* pV = pU + width / 2 * height;
+    for (int i = 0; i < height; ++i) {
+        func(yuyv + i * stride, width, pY, pU, pV);
+        pY += width;
+        pU += width / 2;
+        pV += width / 2;
+    }
+}
+
+// Bin two rows of YUYV(YUV422 Packed) image by 2x2 and convert to YUV422 Planar using the best SIMD level
+void yuyvBin2x2Row(const unsigned char* row0, const unsigned char* row1, int width, unsigned char* y, unsigned char* u,
+                   unsigned char* v) {
+    static const BinRowFunc func = binRowFunc<true>(bestSimdLevel());
+    static const BinRowFunc funcY = binRowFunc<false>(bestSimdLevel());
+    (u == nullptr || v == nullptr ? funcY : func)(row0, row1, width, y, u, v);
+}
+
+// Bin two rows of YUYV(YUV422 Packed) image by 2x2 and convert to YUV422 Planar using specified SIMD level
+void yuyvBin2x2Row(const unsigned char* row0, const unsigned char* row1, int width, unsigned char* y, unsigned char* u,
+                   unsigned char* v, SimdLevel level) {
+    (u == nullptr || v == nullptr ? binRowFunc<false>(level) : binRowFunc<true>(level))(row0, row1, width, y, u, v);
+}
+
+}  // namespace util
+}  // namespace libra